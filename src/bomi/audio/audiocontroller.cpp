@@ -11,6 +11,7 @@
 #include "enum/channellayout.hpp"
 #include "misc/log.hpp"
 #include "misc/speedmeasure.hpp"
+#include "misc/latencystats.hpp"
 extern "C" {
 #include <audio/filter/af.h>
 }
@@ -60,7 +61,7 @@ struct AudioController::Data {
     int srate = 0;
     quint64 samples = 0;
     bool normalizerActivated = false, tempoScalerActivated = false, eof = false;
-    double scale = 1.0, amp = 1.0, gain = 1.0;
+    double scale = 1.0, syncSpeed = 1.0, amp = 1.0, gain = 1.0;
     mp_chmap chmap;
     af_instance *af = nullptr;
     AudioNormalizerOption normalizerOption;
@@ -83,6 +84,8 @@ struct AudioController::Data {
     QVector<AudioBufferPtr> forFft;
     QVector<AudioFilter*> filters;
     QVector<AudioFilter*> chain;
+    LatencyStats *stats = nullptr;
+    bool output = false;
 
     QMutex mutex;
 };
@@ -131,9 +134,27 @@ auto AudioController::open(af_instance *af) -> int
     af->control = [] (af_instance *af, int cmd, void *arg) -> int
         { return priv(af)->control(cmd, arg); };
     af->uninit = [] (af_instance *af) -> void { priv(af)->uninit(); };
-    af->filter_frame = [] (af_instance *af, mp_audio *data) -> int
-        { return priv(af)->filter(data); };
-    af->filter_out = [] (af_instance *af) -> int { return priv(af)->output(); };
+    af->filter_frame = [] (af_instance *af, mp_audio *data) -> int {
+        auto stats = priv(af)->d->stats;
+        if (!stats)
+            return priv(af)->filter(data);
+        stats->start();
+        const int ret = priv(af)->filter(data);
+        stats->stop();
+        return ret;
+    };
+    af->filter_out = [] (af_instance *af) -> int {
+        auto d = priv(af)->d;
+        if (!d->stats)
+            return priv(af)->output();
+        d->stats->start();
+        const int ret = priv(af)->output();
+        d->stats->stop();
+        if (d->output)
+            d->stats->commit();
+        d->output = false;
+        return ret;
+    };
     af->delay = 0.0;
 
     return AF_OK;
@@ -266,7 +287,7 @@ auto AudioController::filter(mp_audio *data) -> int
         if (d->dirty & Scale) {
             d->scaler.setActive(d->tempoScalerActivated);
             for (auto filter : d->filters)
-                filter->setScale(d->scale);
+                filter->setScale(d->scale * d->syncSpeed);
         }
         if (d->dirty & ChMap)
             d->mixer.setChannelLayoutMap(d->map);
@@ -307,6 +328,7 @@ auto AudioController::output() -> int
         auto audio = buffer->take();
         Q_ASSERT(mp_audio_config_equals(&d->af->fmt_out, audio));
         af_add_output_frame(d->af, audio);
+        d->output = true;
     } while (false);
 
     d->af->delay = 0;
@@ -315,6 +337,11 @@ auto AudioController::output() -> int
     return 0;
 }
 
+auto AudioController::setLatencyStats(LatencyStats *stats) -> void
+{
+    d->stats = stats;
+}
+
 auto AudioController::setAnalyzeSpectrum(bool on) -> void
 {
     d->vis.setActive(on);
@@ -398,6 +425,14 @@ auto AudioController::setEqualizer(const AudioEqualizer &eq) -> void
     d->mutex.unlock();
 }
 
+auto AudioController::setSyncSpeed(double speed) -> void
+{
+    d->mutex.lock();
+    d->syncSpeed = speed;
+    d->dirty |= Scale;
+    d->mutex.unlock();
+}
+
 auto AudioController::visualizer() const -> AudioVisualizer*
 {
     return &d->vis;
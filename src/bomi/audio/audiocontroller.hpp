@@ -6,7 +6,7 @@ struct af_cfg;                          struct af_info;
 struct mp_chmap;                        struct AudioNormalizerOption;
 class ChannelLayoutMap;                 class AudioFormat;
 class AudioEqualizer;                   class AudioVisualizer;
-enum class ChannelLayout;
+enum class ChannelLayout;               class LatencyStats;
 
 class AudioController : public QObject {
     Q_OBJECT
@@ -21,12 +21,17 @@ public:
     auto setChannelLayoutMap(const ChannelLayoutMap &map) -> void;
     auto setOutputChannelLayout(ChannelLayout layout) -> void;
     auto setEqualizer(const AudioEqualizer &eq) -> void;
+    // extra speed applied by tempo scaler on top of playback speed
+    // mpv doesn't know about it, so video follows audio clock
+    auto setSyncSpeed(double speed) -> void;
     auto chmap() const -> mp_chmap*;
     auto inputFormat() const -> AudioFormat;
     auto outputFormat() const -> AudioFormat;
     auto samplerate() const -> int;
     auto setAnalyzeSpectrum(bool on) -> void;
     auto visualizer() const -> AudioVisualizer*;
+    // measures filtering time per output chunk if not null
+    auto setLatencyStats(LatencyStats *stats) -> void;
 signals:
     void inputFormatChanged();
     void outputFormatChanged();
@@ -0,0 +1,15 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+// measurements of bomi components, run by bomi-benchmark
+class Benchmark {
+public:
+    // results are written here
+    static auto out() -> QTextStream&;
+    static auto history(int rows) -> void;
+    static auto jsonRpc(const QString &server, int requests) -> void;
+    static auto dirIndex(int files) -> void;
+    static auto playback(const QStringList &files, const QString &report) -> void;
+};
+
+#endif // BENCHMARK_HPP
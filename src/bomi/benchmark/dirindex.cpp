@@ -0,0 +1,62 @@
+#include "benchmark.hpp"
+#include "misc/dirindex.hpp"
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+// Creates a directory with synthetic episode files and reports how long a
+// plain listing, a background index, a cached lookup and prefix matching take.
+auto Benchmark::dirIndex(int files) -> void
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        out() << "Cannot create temporary directory" << endl;
+        return;
+    }
+    const auto path = dir.path();
+    for (int i = 0; i < files; ++i) {
+        QFile file(path % "/Show - "_a % _N(i + 1, 10, 6, '0'_q)
+                   % (i % 10 ? " [1080p].mkv"_a : " [1080p].srt"_a));
+        if (!file.open(QFile::WriteOnly)) {
+            out() << "Cannot create " << file.fileName() << ": "
+                  << file.errorString() << endl;
+            return;
+        }
+    }
+    auto ms = [] (const QElapsedTimer &timer) { return timer.nsecsElapsed() * 1e-6; };
+    QElapsedTimer timer;
+
+    timer.start();
+    const auto filter = _ToNameFilter(MediaExt);
+    const auto infos = QDir(path).entryInfoList(filter, QDir::Files, QDir::Name);
+    out() << "QDir::entryInfoList(): " << infos.size() << " files in "
+          << ms(timer) << "ms" << endl;
+
+    auto &index = DirIndex::instance();
+    bool done = false;
+    timer.restart();
+    index.request(path, &index, [&] (const DirListingPtr &) { done = true; });
+    const auto posted = ms(timer);
+    while (!done)
+        qApp->processEvents(QEventLoop::WaitForMoreEvents);
+    out() << "background index: request returned in " << posted
+          << "ms, listing arrived in " << ms(timer) << "ms" << endl;
+
+    const int lookups = 1000;
+    timer.restart();
+    DirListingPtr listing;
+    for (int i = 0; i < lookups; ++i)
+        listing = index.listing(path);
+    out() << "cached lookup: " << ms(timer) * 1e3 / lookups << "us" << endl;
+
+    if (listing->files.isEmpty())
+        return;
+    timer.restart();
+    const auto &ref = listing->files[listing->files.size() / 2];
+    int matched = 0;
+    for (auto &e : listing->files) {
+        if ((e.type & MediaExt) && e.numbered && e.head == ref.head)
+            ++matched;
+    }
+    out() << "prefix matching: " << matched << " files in "
+          << ms(timer) << "ms" << endl;
+}
@@ -0,0 +1,89 @@
+#include "benchmark.hpp"
+#include "player/historymodel.hpp"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+// Fills a temporary database with synthetic rows and reports the latency of
+// the first page, the complete row count, uncached pages and cached rows.
+auto Benchmark::history(int rows) -> void
+{
+    QTemporaryDir dir;
+    const auto path = dir.path() % "/history.db"_a;
+    const auto conn = u"history-benchmark"_q;
+    { HistoryModel schema(path); }
+    {
+        auto db = QSqlDatabase::addDatabase(u"QSQLITE"_q, conn);
+        db.setDatabaseName(path);
+        if (!db.open()) {
+            out() << "Cannot open " << path << ": " << db.lastError().text() << endl;
+            return;
+        }
+        QSqlQuery query(db);
+        db.transaction();
+        query.prepare("INSERT INTO "_a % MrlState::table()
+                      % " (mrl, name, last_played_date_time, device, star)"
+                        " VALUES (?, ?, ?, ?, ?)"_a);
+        const auto now = QDateTime::currentMSecsSinceEpoch();
+        for (int i = 0; i < rows; ++i) {
+            query.addBindValue(u"file:///benchmark/%1/%2.mkv"_q.arg(i % 1000).arg(i));
+            query.addBindValue(QString());
+            query.addBindValue(now - (i / 4) * 1000); // ties are broken by mrl
+            query.addBindValue(QString());
+            query.addBindValue(int(i % 1000 == 0));
+            query.exec();
+        }
+        if (!db.commit()) {
+            out() << "Cannot fill " << path << ": " << db.lastError().text() << endl;
+            return;
+        }
+    }
+    QSqlDatabase::removeDatabase(conn);
+
+    auto waitFor = [] (std::function<bool(void)> &&done) {
+        while (!done())
+            qApp->processEvents(QEventLoop::WaitForMoreEvents);
+    };
+    auto ms = [] (const QElapsedTimer &timer) { return timer.nsecsElapsed() * 1e-6; };
+    QElapsedTimer timer;
+    timer.start();
+    HistoryModel model(path);
+    waitFor([&] () { return model.rowCount() > 0 || !model.isLoading(); });
+    const auto first = ms(timer);
+    waitFor([&] () { return !model.isLoading(); });
+    const auto all = ms(timer);
+    out() << rows << " rows: first page in " << first << "ms, "
+          << model.rowCount() << " rows counted in " << all << "ms" << endl;
+    if (!model.rowCount())
+        return;
+
+    // location is empty until the page of the row arrives
+    auto loaded = [&] (int row) {
+        return !model.data(model.index(row, 0), HistoryModel::LocationRole)
+                .toString().isEmpty();
+    };
+    QVector<double> jumps;
+    qsrand(0);
+    for (int i = 0; i < 200; ++i) {
+        const int row = qrand() % model.rowCount();
+        timer.restart();
+        waitFor([&] () { return loaded(row); });
+        jumps.push_back(ms(timer));
+    }
+    std::sort(jumps.begin(), jumps.end());
+    out() << "uncached page: p50 " << jumps[jumps.size() / 2]
+          << "ms, p99 " << jumps[jumps.size() * 99 / 100]
+          << "ms, max " << jumps.back() << "ms" << endl;
+
+    const int calls = 1000000;
+    const auto idx = model.index(0, 0);
+    waitFor([&] () { return loaded(0); });
+    int length = 0;
+    timer.restart();
+    for (int i = 0; i < calls; ++i)
+        length += model.data(idx, HistoryModel::LatestPlayRole).toString().size();
+    out() << "cached data(): " << ms(timer) * 1e6 / calls
+          << "ns per call (" << length / calls << " chars)" << endl;
+}
@@ -0,0 +1,69 @@
+#include "benchmark.hpp"
+#include <QLocalSocket>
+#include <QElapsedTimer>
+#include <numeric>
+
+// Sends requests one by one and in batches to a running bomi and reports
+// round-trip latency of each.
+auto Benchmark::jsonRpc(const QString &server, int requests) -> void
+{
+    requests = qMax(requests, 1);
+    QLocalSocket socket;
+    socket.connectToServer(server);
+    if (!socket.waitForConnected(3000)) {
+        out() << "Cannot connect to " << server << ": " << socket.errorString() << endl;
+        return;
+    }
+    auto call = [&] (int id) {
+        return "{\"jsonrpc\":\"2.0\",\"method\":\"engine.time\",\"id\":"_b
+                % QByteArray::number(id) % "}"_b;
+    };
+    auto roundTrip = [&] (const QByteArray &data) -> bool {
+        socket.write(data % '\n');
+        while (!socket.canReadLine()) {
+            if (!socket.waitForReadyRead(3000))
+                return false;
+        }
+        socket.readLine();
+        return true;
+    };
+    auto report = [&] (const char *name, QVector<qint64> &ns, int calls) {
+        std::sort(ns.begin(), ns.end());
+        const auto total = std::accumulate(ns.begin(), ns.end(), 0.0);
+        const auto at = [&] (double p) { return ns[qMin<int>(ns.size() - 1, ns.size() * p)] * 1e-3; };
+        out() << name << ": " << calls << " requests, "
+              << qRound(calls / qMax(total * 1e-9, 1e-9)) << " requests/s, p50 "
+              << at(0.5) << "us, p99 " << at(0.99) << "us" << endl;
+    };
+
+    QElapsedTimer timer;
+    QVector<qint64> ns;
+    ns.reserve(requests);
+    for (int i = 0; i < requests; ++i) {
+        timer.start();
+        if (!roundTrip(call(i)))
+            return void(out() << "No response from server." << endl);
+        ns.push_back(timer.nsecsElapsed());
+    }
+    report("single", ns, requests);
+
+    static constexpr int BatchSize = 64;
+    ns.clear();
+    int sent = 0;
+    while (sent < requests) {
+        QByteArray batch = "["_b;
+        const int size = qMin(BatchSize, requests - sent);
+        for (int i = 0; i < size; ++i) {
+            if (i)
+                batch += ',';
+            batch += call(sent + i);
+        }
+        batch += ']';
+        timer.start();
+        if (!roundTrip(batch))
+            return void(out() << "No response from server." << endl);
+        ns.push_back(timer.nsecsElapsed());
+        sent += size;
+    }
+    report("batch of 64", ns, requests);
+}
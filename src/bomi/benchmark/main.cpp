@@ -0,0 +1,62 @@
+#include "benchmark.hpp"
+#include "os/os.hpp"
+#include "misc/dirindex.hpp"
+#include <clocale>
+#include <QCommandLineParser>
+
+auto Benchmark::out() -> QTextStream&
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+int main(int argc, char **argv)
+{
+    QApplication::setAttribute(Qt::AA_X11InitThreads);
+    QApplication app(argc, argv);
+#ifdef Q_OS_LINUX
+    setlocale(LC_NUMERIC, "C");
+#endif
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u"Measure performance of bomi components."_q);
+    parser.addHelpOption();
+    const QCommandLineOption history(u"history"_q,
+        u"Measure history loading with <rows> synthetic entries."_q,
+        u"rows"_q, u"1000000"_q);
+    parser.addOption(history);
+    const QCommandLineOption jsonRpc(u"jsonrpc"_q,
+        u"Measure JSON-RPC latency against local server <server> of running bomi."_q,
+        u"server"_q);
+    parser.addOption(jsonRpc);
+    const QCommandLineOption requests(u"requests"_q,
+        u"Number of requests for --jsonrpc."_q, u"count"_q, u"10000"_q);
+    parser.addOption(requests);
+    const QCommandLineOption dirIndex(u"dir-index"_q,
+        u"Measure directory indexing with <files> synthetic files."_q,
+        u"files"_q, u"100000"_q);
+    parser.addOption(dirIndex);
+    const QCommandLineOption playback(u"playback"_q,
+        u"Play <file> without display and report pipeline timings. Repeatable."_q,
+        u"file"_q);
+    parser.addOption(playback);
+    const QCommandLineOption report(u"report"_q,
+        u"Write --playback report to <file> instead of stdout."_q, u"file"_q);
+    parser.addOption(report);
+    parser.process(app);
+    if (parser.optionNames().isEmpty())
+        parser.showHelp(1);
+
+    OS::initialize();
+    DirIndex::initialize();
+    if (parser.isSet(history))
+        Benchmark::history(parser.value(history).toInt());
+    if (parser.isSet(jsonRpc))
+        Benchmark::jsonRpc(parser.value(jsonRpc), parser.value(requests).toInt());
+    if (parser.isSet(dirIndex))
+        Benchmark::dirIndex(parser.value(dirIndex).toInt());
+    if (parser.isSet(playback))
+        Benchmark::playback(parser.values(playback), parser.value(report));
+    DirIndex::finalize();
+    OS::finalize();
+    return 0;
+}
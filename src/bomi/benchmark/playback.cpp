@@ -0,0 +1,178 @@
+#include "benchmark.hpp"
+#include "player/app.hpp"
+#include "player/playengine.hpp"
+#include "player/playengine_p.hpp"
+#include "misc/latencystats.hpp"
+#include "opengl/opengloffscreencontext.hpp"
+#include "os/os.hpp"
+#include <QTemporaryDir>
+#include <QAbstractEventDispatcher>
+#include <atomic>
+
+// Plays files one by one with null audio output and draws each new video frame
+// into an offscreen framebuffer right away, so nothing but bomi and mpv limits
+// the frame rate. Writes a JSON report to given file or stdout, so messages
+// go to stderr.
+auto Benchmark::playback(const QStringList &files, const QString &report) -> void
+{
+    OpenGLOffscreenContext gl;
+    gl.setContextName(u"Benchmark"_q);
+    if (!gl.createContext()) {
+        qWarning("Cannot create OpenGL context.");
+        return;
+    }
+    gl.createSurface();
+    if (!gl.makeCurrent()) {
+        qWarning("Cannot make OpenGL context current.");
+        return;
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qWarning("Cannot create temporary directory.");
+        return;
+    }
+    HistoryModel history(dir.path() % "/history.db"_a);
+    PlayEngine engine;
+    engine.setHistory(&history);
+    auto d = engine.d;
+    d->mpv.set("options/ao", "null"_b);
+    d->mpv.set("options/resume-playback", false);
+
+    LatencyStats videoFilter, audioFilter, render;
+    d->vp->setLatencyStats(&videoFilter);
+    d->ac->setLatencyStats(&audioFilter);
+
+    std::atomic<bool> updated{false};
+    auto dispatcher = QAbstractEventDispatcher::instance();
+    d->mpv.initializeGL(gl.context());
+    d->mpv.setUpdateCallback([&] () { updated = true; dispatcher->wakeUp(); });
+
+    auto pool = OpenGLResourcePool::current();
+    Fbo *fbo = nullptr;
+    int frames = 0;
+    auto draw = [&] () {
+        const auto size = d->info.video.output()->size();
+        if (size.isEmpty())
+            return;
+        if (!fbo || fbo->size() != size) {
+            pool->release(fbo);
+            fbo = pool->takeFramebufferObject(size);
+        }
+        render.start();
+        d->mpv.render(fbo, nullptr, QMargins());
+        gl.context()->functions()->glFinish();
+        render.stop();
+        render.commit();
+        d->mpv.frameSwapped();
+        pool->endFrame();
+        d->presentation.update(d->mpv.presentationStats());
+        ++frames;
+    };
+
+    // thread times are sampled periodically since some threads exit with file
+    QHash<quint64, OS::ThreadTime> threads;
+    auto cpu = [&] () {
+        QMap<QString, quint64> times;
+        for (auto &t : threads)
+            times[t.name] += t.usec;
+        return times;
+    };
+    QJsonObject decode, dropped;
+    auto sample = [&] () {
+        const auto times = OS::threadTimes();
+        for (auto it = times.begin(); it != times.end(); ++it)
+            threads[it.key()] = *it;
+        const auto timing = d->mpv.get<QVariant>("decoder-timing").toMap();
+        if (!timing.isEmpty()) {
+            decode = QJsonObject::fromVariantMap(timing);
+            for (auto key : { u"p50"_q, u"p90"_q, u"p99"_q, u"max"_q })
+                decode[key] = timing[key].toDouble() * 1e3;
+        }
+        dropped[u"decoder"_q] = d->mpv.get<int>("drop-frame-count");
+        dropped[u"output"_q] = d->mpv.get<int>("vo-drop-frame-count");
+    };
+    QTimer sampler;
+    sampler.setInterval(200);
+    QObject::connect(&sampler, &QTimer::timeout, &engine, sample);
+    sampler.start();
+
+    QJsonArray results;
+    const auto processStart = OS::processTime();
+    QElapsedTimer timer;
+    for (auto &file : files) {
+        const Mrl mrl(file);
+        if (mrl.isImage()) {
+            qDebug().nospace() << "Skip image file " << file;
+            continue;
+        }
+        sample();
+        const auto cpuStart = cpu();
+        frames = 0;
+        decode = dropped = QJsonObject();
+        videoFilter.clear();
+        audioFilter.clear();
+        render.clear();
+
+        bool done = false, eof = false;
+        auto conn = QObject::connect(&engine, &PlayEngine::finished, &engine,
+                                     [&] (const Mrl &, bool end) { done = true; eof = end; });
+        timer.start();
+        engine.load(mrl, false);
+        while (!done) {
+            qApp->processEvents(QEventLoop::WaitForMoreEvents);
+            if (updated.exchange(false))
+                draw();
+        }
+        const auto elapsed = timer.nsecsElapsed() * 1e-6;
+        QObject::disconnect(conn);
+        sample();
+
+        QJsonObject stages;
+        const auto cpuEnd = cpu();
+        for (auto it = cpuEnd.begin(); it != cpuEnd.end(); ++it)
+            stages[it.key()] = (*it - cpuStart.value(it.key())) * 1e-3;
+        QJsonObject result;
+        result[u"file"_q] = file;
+        result[u"eof"_q] = eof;
+        result[u"elapsed"_q] = elapsed;
+        result[u"open"_q] = QJsonObject::fromVariantMap(engine.openTiming());
+        result[u"frames"_q] = frames;
+        result[u"dropped"_q] = dropped;
+        result[u"presentation"_q] = QJsonObject::fromVariantMap(engine.presentation());
+        result[u"observations"_q] = QJsonObject::fromVariantMap(engine.observations());
+        result[u"decode"_q] = decode;
+        result[u"filter"_q] = QJsonObject{{u"video"_q, videoFilter.toJson()},
+                                          {u"audio"_q, audioFilter.toJson()}};
+        result[u"render"_q] = render.toJson();
+        result[u"cpu"_q] = stages;
+        result[u"glPool"_q] = QJsonObject::fromVariantMap(pool->toMap());
+        results.push_back(result);
+        qDebug().nospace() << file << ": " << frames << " frames in " << elapsed << "ms";
+    }
+    sampler.stop();
+    d->vp->setLatencyStats(nullptr);
+    d->ac->setLatencyStats(nullptr);
+    pool->release(fbo);
+    d->mpv.finalizeGL();
+
+    QJsonObject stages;
+    const auto total = cpu();
+    for (auto it = total.begin(); it != total.end(); ++it)
+        stages[it.key()] = *it * 1e-3;
+    QJsonObject json;
+    json[u"version"_q] = QString::fromLatin1(App::version());
+    json[u"files"_q] = results;
+    json[u"cpu"_q] = stages;
+    json[u"process-cpu"_q] = (OS::processTime() - processStart) * 1e-3;
+    json[u"peak-rss"_q] = OS::peakMemory();
+
+    QFile out(report);
+    const bool open = report.isEmpty() ? out.open(stdout, QFile::WriteOnly)
+                                       : out.open(QFile::WriteOnly | QFile::Truncate);
+    if (!open) {
+        qWarning().nospace() << "Cannot write report to " << report;
+        return;
+    }
+    out.write(QJsonDocument(json).toJson());
+}
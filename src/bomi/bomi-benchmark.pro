@@ -0,0 +1,18 @@
+# Measures parts of bomi with synthetic input. Built from the sources of bomi
+# except for its main(), so objects in the same build directory are shared.
+include(bomi.pro)
+
+TARGET = bomi-benchmark
+macx:CONFIG -= app_bundle
+
+SOURCES -= player/main.cpp
+
+HEADERS += \
+	benchmark/benchmark.hpp
+
+SOURCES += \
+	benchmark/main.cpp \
+	benchmark/history.cpp \
+	benchmark/jsonrpc.cpp \
+	benchmark/dirindex.cpp \
+	benchmark/playback.cpp
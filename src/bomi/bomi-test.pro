@@ -0,0 +1,20 @@
+# Unit tests of bomi components. Built from the sources of bomi except for its
+# main(), so objects in the same build directory are shared.
+include(bomi.pro)
+
+TARGET = bomi-test
+macx:CONFIG -= app_bundle
+QT += testlib
+
+SOURCES -= player/main.cpp
+
+HEADERS += \
+	tests/jrservertest.hpp \
+	tests/framepacertest.hpp \
+	tests/openglresourcepooltest.hpp
+
+SOURCES += \
+	tests/main.cpp \
+	tests/jrservertest.cpp \
+	tests/framepacertest.cpp \
+	tests/openglresourcepooltest.cpp
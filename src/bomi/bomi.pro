@@ -113,6 +113,7 @@ HEADERS += \
 	opengl/openglvertex.hpp \
 	opengl/opengltexturebase.hpp \
 	opengl/openglframebufferobject.hpp \
+	opengl/openglresourcepool.hpp \
 	opengl/opengltexture2d.hpp \
 	opengl/opengltexture1d.hpp \
 	opengl/opengltexturebinder.hpp \
@@ -192,6 +193,7 @@ HEADERS += \
 	player/recentinfo.hpp \
 	player/mpv_helper.hpp \
 	player/playengine_p.hpp \
+	player/preloader.hpp \
 	player/historymodel.hpp \
 	player/playlistmodel.hpp \
     audio/channellayoutmap.hpp \
@@ -247,6 +249,8 @@ HEADERS += \
     quick/maskareaitem.hpp \
 	quick/windowobject.hpp \
     misc/autoloader.hpp \
+    misc/dirindex.hpp \
+    misc/latencystats.hpp \
     player/mpv_property.hpp \
     enum/autoselectmode.hpp \
     player/mrlstate_p.hpp \
@@ -301,7 +305,9 @@ HEADERS += \
     dialog/encoderdialog.hpp \
     misc/filenamegenerator.hpp \
     enum/rotation.hpp \
-    player/videosettings.hpp
+    player/videosettings.hpp \
+    player/presentationstats.hpp \
+    video/framepacer.hpp
 
 SOURCES += \
 	stdafx.cpp \
@@ -344,6 +350,7 @@ SOURCES += \
 	opengl/openglvertex.cpp \
 	opengl/opengltexturebase.cpp \
 	opengl/openglframebufferobject.cpp \
+	opengl/openglresourcepool.cpp \
 	opengl/opengltexture2d.cpp \
 	opengl/opengltexture1d.cpp \
 	opengl/opengltexturebinder.cpp \
@@ -418,6 +425,7 @@ SOURCES += \
 	player/rootmenu.cpp \
 	player/app.cpp \
 	player/playengine.cpp \
+	player/preloader.cpp \
 	player/skin.cpp \
 	player/mediamisc.cpp \
 	player/mrlstate.cpp \
@@ -470,10 +478,14 @@ SOURCES += \
     quick/maskareaitem.cpp \
 	quick/windowobject.cpp \
     misc/autoloader.cpp \
+    misc/dirindex.cpp \
+    misc/latencystats.cpp \
     enum/autoselectmode.cpp \
     subtitle/subtitlerenderer.cpp \
     video/videoprocessor.cpp \
     player/mpv.cpp \
+    player/presentationstats.cpp \
+    video/framepacer.cpp \
     video/interpolatorparams.cpp \
     video/videofilter.cpp \
     video/motioninterpolator.cpp \
@@ -3,13 +3,43 @@
 #include "http-parser/http_parser.h"
 #include "misc/log.hpp"
 #include <QNetworkRequest>
+#include <QElapsedTimer>
 
 DECLARE_LOG_CONTEXT(JSON-RPC)
 
+// stop pushing while this amount of data is not written yet
+static constexpr qint64 MaxBacklog = 64 * 1024;
+
+struct JrSubscription {
+    int interval = 0;
+    double threshold = 0;
+    qint64 sentAt = -1;
+    QJsonValue sent{QJsonValue::Undefined};
+    QJsonValue pending{QJsonValue::Undefined};
+    auto isPending() const -> bool { return !pending.isUndefined(); }
+    auto due() const -> qint64 { return sentAt < 0 ? 0 : sentAt + interval; }
+};
+
 struct JrClient::Data {
     QIODevice *device;
     JrServer *server;
     QString peer;
+    QHash<QString, JrSubscription> subscriptions;
+    QElapsedTimer clock;
+    QTimer flush;
+    auto schedule() -> void
+    {
+        qint64 due = -1;
+        for (auto &s : subscriptions) {
+            if (s.isPending() && (due < 0 || s.due() < due))
+                due = s.due();
+        }
+        if (due < 0)
+            return;
+        const int wait = qMax<qint64>(0, due - clock.elapsed());
+        if (!flush.isActive() || flush.remainingTime() > wait)
+            flush.start(wait);
+    }
 };
 
 JrClient::JrClient(QIODevice *device, const QString &peer, JrServer *server)
@@ -18,6 +48,13 @@ JrClient::JrClient(QIODevice *device, const QString &peer, JrServer *server)
     d->device = device;
     d->server = server;
     d->peer = peer;
+    d->clock.start();
+    d->flush.setSingleShot(true);
+    connect(&d->flush, &QTimer::timeout, this, &JrClient::flush);
+    connect(device, &QIODevice::bytesWritten, this, [=] () {
+        if (!d->flush.isActive() && d->device->bytesToWrite() < MaxBacklog)
+            d->schedule();
+    });
 }
 
 JrClient::~JrClient()
@@ -54,6 +91,71 @@ auto JrClient::write(const QList<JrResponse> &responses,
         d->device->close();
 }
 
+auto JrClient::subscribe(const QString &name, int interval, double threshold) -> void
+{
+    auto &s = d->subscriptions[name];
+    s.interval = qMax(0, interval);
+    s.threshold = qMax(0.0, threshold);
+}
+
+auto JrClient::unsubscribe(const QString &name) -> bool
+{
+    return d->subscriptions.remove(name);
+}
+
+auto JrClient::subscriptions() const -> QStringList
+{
+    return d->subscriptions.keys();
+}
+
+auto JrClient::push(const QString &name, const QJsonValue &value) -> void
+{
+    auto it = d->subscriptions.find(name);
+    if (it == d->subscriptions.end())
+        return;
+    auto &s = *it;
+    if (s.threshold > 0 && value.isDouble() && s.sent.isDouble()
+            && qAbs(value.toDouble() - s.sent.toDouble()) < s.threshold) {
+        s.pending = QJsonValue::Undefined;
+        return;
+    }
+    if (value == s.sent) {
+        s.pending = QJsonValue::Undefined;
+        return;
+    }
+    s.pending = value;
+    if (d->device->bytesToWrite() < MaxBacklog)
+        d->schedule();
+}
+
+// all due values of a client go out in one notification
+auto JrClient::flush() -> void
+{
+    if (!d->device->isOpen())
+        return;
+    if (d->device->bytesToWrite() >= MaxBacklog)
+        return; // resumed by bytesWritten()
+    const auto now = d->clock.elapsed();
+    QJsonObject params;
+    for (auto it = d->subscriptions.begin(); it != d->subscriptions.end(); ++it) {
+        auto &s = *it;
+        if (!s.isPending() || s.due() > now)
+            continue;
+        params.insert(it.key(), s.pending);
+        s.sent = s.pending;
+        s.sentAt = now;
+        s.pending = QJsonValue::Undefined;
+    }
+    if (!params.isEmpty()) {
+        QJsonObject json;
+        json.insert(u"jsonrpc"_q, u"2.0"_q);
+        json.insert(u"method"_q, u"rpc.notify"_q);
+        json.insert(u"params"_q, params);
+        *d->device << QJsonDocument(json).toJson(QJsonDocument::Compact) << '\n';
+    }
+    d->schedule();
+}
+
 auto JrClient::parse(const QByteArray &data) -> void
 {
     d->server->parse(this, data);
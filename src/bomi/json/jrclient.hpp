@@ -16,12 +16,19 @@ public:
     virtual auto autoClose() const -> bool { return false; }
     auto reply(const JrResponse &response) -> void;
     auto reply(const QList<JrResponse> &response) -> void;
+    // pushes are possible only for persistent connection
+    auto canPush() const -> bool { return !autoClose(); }
+    auto subscribe(const QString &name, int interval, double threshold) -> void;
+    auto unsubscribe(const QString &name) -> bool;
+    auto subscriptions() const -> QStringList;
+    auto push(const QString &name, const QJsonValue &value) -> void;
 protected:
     virtual auto beginReply(const QList<JrResponse> &/*responses*/, int /*length*/) -> void { }
     virtual auto endReply() -> void { }
 private:
     auto write(const QList<JrResponse> &responses,
                const QJsonDocument &doc) -> void;
+    auto flush() -> void;
     struct Data;
     Data *d;
 };
@@ -1 +1,11 @@
 #include "jriface.hpp"
+#include "jrcommon.hpp"
+
+auto JrIface::request(const QList<JrRequest> &requests) -> QList<JrResponse>
+{
+    QList<JrResponse> responses;
+    responses.reserve(requests.size());
+    for (auto &req : requests)
+        responses.push_back(request(req));
+    return responses;
+}
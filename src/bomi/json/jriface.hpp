@@ -5,9 +5,23 @@ class JrRequest;                        class JrResponse;
 
 class JrIface : public QObject {
 public:
+    using Notify = std::function<void(const QString &name, const QJsonValue &value)>;
     JrIface(QObject *parent = nullptr): QObject(parent) { }
     ~JrIface() = default;
     virtual auto request(const JrRequest &request) -> JrResponse = 0;
+    // requests of a batch in order, responses are made for all of them
+    virtual auto request(const QList<JrRequest> &requests) -> QList<JrResponse>;
+    // current value of property or undefined
+    virtual auto read(const QString &/*name*/) -> QJsonValue { return QJsonValue::Undefined; }
+    // notify() will be called on change after watch() succeeded
+    virtual auto watch(const QString &/*name*/) -> bool { return false; }
+    virtual auto unwatch(const QString &/*name*/) -> void { }
+    auto setNotify(Notify &&notify) -> void { m_notify = std::move(notify); }
+protected:
+    auto notify(const QString &name, const QJsonValue &value) -> void
+        { if (m_notify) m_notify(name, value); }
+private:
+    Notify m_notify;
 };
 
 #endif // JRIFACE_HPP
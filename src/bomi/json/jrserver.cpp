@@ -105,6 +105,7 @@ struct JrServer::Data {
     JrIface *iface = nullptr;
     ServerError error = QAbstractSocket::UnknownSocketError;
     QMap<QIODevice*, JrClient*> clients;
+    QHash<QString, int> watching; // number of subscribers for each name
     Error handleError;
     QString errorString = u"No Error"_q;
 };
@@ -177,21 +178,45 @@ auto JrServer::parse(JrClient *client, const QByteArray &data) -> void
     else if (doc.isArray())
         array = doc.array();
 
+    // invalid ones are answered in place, valid ones are run as one batch
     QList<JrResponse> replies;
+    QList<JrRequest> requests;
+    QVector<int> positions;
     replies.reserve(array.size());
+    requests.reserve(array.size());
     for (int i = 0; i < array.size(); ++i) {
         const auto request = JrRequest::fromJson(array.at(i).toObject());
         if (!request.isValid()) {
             _Error("Invalid request object exits.");
             replies.push_back(_JrErrorResponse(QJsonValue::Null, JrError::InvalidRequest));
-        } else {
+        } else if (request.method().startsWith("rpc."_a)) {
             JrResponse res;
-            if (d->iface)
-                res = d->iface->request(request);
+            if (request.method() == "rpc.subscribe"_a)
+                res = subscribe(client, request);
+            else if (request.method() == "rpc.unsubscribe"_a)
+                res = unsubscribe(client, request);
             else
                 res = _JrErrorResponse(request.id(), JrError::MethodNotFound);
             if (!request.isNotification())
                 replies.push_back(res);
+        } else {
+            positions.push_back(request.isNotification() ? -1 : replies.size());
+            if (!request.isNotification())
+                replies.push_back(JrResponse());
+            requests.push_back(request);
+        }
+    }
+    if (!requests.isEmpty()) {
+        QList<JrResponse> results;
+        if (d->iface)
+            results = d->iface->request(requests);
+        for (int i = 0; i < requests.size(); ++i) {
+            if (positions[i] < 0)
+                continue;
+            if (i < results.size())
+                replies[positions[i]] = results[i];
+            else
+                replies[positions[i]] = _JrErrorResponse(requests[i].id(), JrError::MethodNotFound);
         }
     }
     if (replies.size() == 1)
@@ -200,6 +225,66 @@ auto JrServer::parse(JrClient *client, const QByteArray &data) -> void
         client->reply(replies);
 }
 
+// params: { "properties": [names], "interval": msec, "threshold": number }
+auto JrServer::subscribe(JrClient *client, const JrRequest &request) -> JrResponse
+{
+    if (!client->canPush())
+        return _JrErrorResponse(request.id(), JrError::InvalidRequest,
+                                u"Subscription needs persistent connection."_q);
+    const auto params = request.params().toObject();
+    const auto names = params[u"properties"_q].toArray();
+    const int interval = params[u"interval"_q].toInt(0);
+    const double threshold = params[u"threshold"_q].toDouble(0);
+    if (names.isEmpty() || !d->iface)
+        return _JrErrorResponse(request.id(), JrError::InvalidParams);
+    QJsonArray accepted;
+    for (auto v : names) {
+        const auto name = v.toString();
+        if (name.isEmpty())
+            continue;
+        if (!client->subscriptions().contains(name)) {
+            auto &count = d->watching[name];
+            if (!count && !d->iface->watch(name)) {
+                d->watching.remove(name);
+                continue;
+            }
+            ++count;
+        }
+        client->subscribe(name, interval, threshold);
+        client->push(name, d->iface->read(name));
+        accepted.push_back(name);
+    }
+    return { request, accepted };
+}
+
+auto JrServer::unsubscribe(JrClient *client, const JrRequest &request) -> JrResponse
+{
+    auto names = request.params().toObject()[u"properties"_q].toArray();
+    if (names.isEmpty()) {
+        for (auto &name : client->subscriptions())
+            names.push_back(name);
+    }
+    QJsonArray removed;
+    for (auto v : names) {
+        const auto name = v.toString();
+        if (!client->unsubscribe(name))
+            continue;
+        unwatch(name);
+        removed.push_back(name);
+    }
+    return { request, removed };
+}
+
+auto JrServer::unwatch(const QString &name) -> void
+{
+    auto it = d->watching.find(name);
+    if (it == d->watching.end() || --*it > 0)
+        return;
+    d->watching.erase(it);
+    if (d->iface)
+        d->iface->unwatch(name);
+}
+
 auto JrServer::addClient(QIODevice *dev, const QString &peer) -> bool
 {
     JrClient *client = nullptr;
@@ -224,18 +309,31 @@ auto JrServer::removeClient(QIODevice *dev) -> void
     auto client = d->clients.take(dev);
     if (client) {
         _Info("Client disconnected: %%", client->peer());
+        for (auto &name : client->subscriptions())
+            unwatch(name);
         delete client;
     }
 }
 
 auto JrServer::setInterface(JrIface *iface) -> void
 {
-    if (d->iface)
+    if (d->iface) {
         disconnect(d->iface, nullptr, this, nullptr);
+        for (auto it = d->watching.begin(); it != d->watching.end(); ++it)
+            d->iface->unwatch(it.key());
+        d->iface->setNotify(nullptr);
+    }
     d->iface = iface;
-    if (d->iface)
+    if (d->iface) {
         connect(d->iface, &JrIface::destroyed, this,
                 [=] () { if (d->iface == iface) d->iface = nullptr; });
+        d->iface->setNotify([=] (const QString &name, const QJsonValue &value) {
+            for (auto client : d->clients)
+                client->push(name, value);
+        });
+        for (auto it = d->watching.begin(); it != d->watching.end(); ++it)
+            d->iface->watch(it.key());
+    }
 }
 
 auto JrServer::setErrorHandler(Error &&func) -> void
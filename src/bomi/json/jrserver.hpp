@@ -26,6 +26,9 @@ private:
     auto sendError(QAbstractSocket::SocketError error,
                    const QString &errorString) -> void;
     auto parse(JrClient *client, const QByteArray &data) -> void;
+    auto subscribe(JrClient *client, const JrRequest &request) -> JrResponse;
+    auto unsubscribe(JrClient *client, const JrRequest &request) -> JrResponse;
+    auto unwatch(const QString &name) -> void;
     auto addClient(QIODevice *dev, const QString &peer = QString()) -> bool;
     auto removeClient(QIODevice *dev) -> void;
     friend class JrTransport;
@@ -0,0 +1,292 @@
+#include "dirindex.hpp"
+#include "dataevent.hpp"
+#include "log.hpp"
+#include <QDirIterator>
+#include <QFileSystemWatcher>
+#include <QCollator>
+#include <QPointer>
+#include <QElapsedTimer>
+
+DECLARE_LOG_CONTEXT(DirIndex)
+
+static constexpr int MaxDirs = 16;
+
+enum EventType { Scanned = QEvent::User + 1, Watch, Unwatch };
+
+static auto suffixTypes() -> const QHash<QString, ExtTypes>&
+{
+    static const auto types = [] () {
+        QHash<QString, ExtTypes> types;
+        for (auto type : { AudioExt, VideoExt, SubtitleExt, ImageExt, DiscExt,
+                           PlaylistExt, WritableImageExt, WritablePlaylistExt }) {
+            for (auto &suffix : _ExtList(type))
+                types[suffix.toLower()] |= type;
+        }
+        return types;
+    }();
+    return types;
+}
+
+static auto makeEntry(const QString &name) -> DirEntry
+{
+    DirEntry e;
+    e.name = name;
+    const int dot = name.lastIndexOf('.'_q);
+    e.base = dot < 0 ? name : name.left(dot);
+    if (dot >= 0)
+        e.type = suffixTypes().value(name.mid(dot + 1).toLower());
+    const int len = name.size();
+    int i = 0;
+    while (i < len && !name[i].isDigit())
+        ++i;
+    if (i < len) {
+        int j = i;
+        while (j < len && name[j].isDigit())
+            ++j;
+        e.head = name.left(i);
+        e.tail = name.mid(j);
+        e.numbered = true;
+    }
+    return e;
+}
+
+static auto scan(const QString &path, QDateTime *modified) -> DirListingPtr
+{
+    // taken first so that changes while enumerating invalidate the result
+    *modified = QFileInfo(path).lastModified();
+    auto listing = QSharedPointer<DirListing>::create();
+    listing->path = path;
+    QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        if (it.fileInfo().isDir())
+            listing->dirs.push_back(it.fileName());
+        else
+            listing->files.push_back(makeEntry(it.fileName()));
+    }
+    QCollator c;
+    c.setNumericMode(true);
+    std::sort(listing->files.begin(), listing->files.end(),
+              [&] (const DirEntry &a, const DirEntry &b) { return c.compare(a.name, b.name) < 0; });
+    std::sort(listing->dirs.begin(), listing->dirs.end());
+    return listing;
+}
+
+/******************************************************************************/
+
+class DirScanner : public QThread {
+    using Scan = std::function<void(const QString &path)>;
+public:
+    DirScanner(Scan &&scan): m_scan(std::move(scan)) { }
+    ~DirScanner() { finish(); }
+    auto request(const QString &path) -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_queue.contains(path))
+            m_queue.push_back(path);
+        m_wait.wakeAll();
+    }
+    auto finish() -> void
+    {
+        m_mutex.lock();
+        m_quit = true;
+        m_wait.wakeAll();
+        m_mutex.unlock();
+        wait();
+    }
+private:
+    auto run() -> void final;
+    Scan m_scan;
+    QMutex m_mutex;
+    QWaitCondition m_wait;
+    QStringList m_queue;
+    bool m_quit = false;
+};
+
+struct DirCache {
+    DirListingPtr listing;
+    QDateTime modified;
+    bool watched = false;
+};
+
+struct DirRequest {
+    QPointer<QObject> context;
+    std::function<void(const DirListingPtr&)> func;
+};
+
+struct DirIndex::Data {
+    DirIndex *p = nullptr;
+    mutable QMutex mutex;
+    QHash<QString, DirCache> cache;
+    QStringList recent; // most recently used first
+    QFileSystemWatcher watcher;
+    DirScanner *scanner = nullptr;
+    QHash<QString, QList<DirRequest>> requests;
+
+    // watcher is not available for all file systems, so mtime is a fallback
+    auto find(const QString &path) -> DirListingPtr
+    {
+        QMutexLocker locker(&mutex);
+        auto it = cache.find(path);
+        if (it == cache.end())
+            return DirListingPtr();
+        if (!it->watched && QFileInfo(path).lastModified() != it->modified)
+            return DirListingPtr();
+        touch(path);
+        return it->listing;
+    }
+    auto touch(const QString &path) -> void
+    {
+        if (recent.isEmpty() || recent.front() != path) {
+            recent.removeOne(path);
+            recent.prepend(path);
+        }
+    }
+    auto insert(const QString &path, const DirListingPtr &listing,
+                const QDateTime &modified) -> void
+    {
+        QMutexLocker locker(&mutex);
+        auto &c = cache[path];
+        const bool watched = c.watched;
+        c.listing = listing;
+        c.modified = modified;
+        touch(path);
+        if (!watched)
+            _PostEvent(p, Watch, path);
+        while (recent.size() > MaxDirs) {
+            const auto old = recent.takeLast();
+            if (cache.take(old).watched)
+                _PostEvent(p, Unwatch, old);
+        }
+    }
+    auto scan(const QString &path) -> DirListingPtr
+    {
+        if (auto listing = find(path))
+            return listing;
+        QDateTime modified;
+        QElapsedTimer timer;
+        timer.start();
+        auto listing = ::scan(path, &modified);
+        _Info("Indexed %% files in %%: %%ms", listing->files.size(), path,
+              timer.nsecsElapsed() * 1e-6);
+        insert(path, listing, modified);
+        return listing;
+    }
+};
+
+auto DirScanner::run() -> void
+{
+    forever {
+        m_mutex.lock();
+        while (!m_quit && m_queue.isEmpty())
+            m_wait.wait(&m_mutex);
+        if (m_quit) {
+            m_mutex.unlock();
+            break;
+        }
+        const auto path = m_queue.takeFirst();
+        m_mutex.unlock();
+        m_scan(path);
+    }
+}
+
+/******************************************************************************/
+
+static DirIndex *obj = nullptr;
+
+auto DirIndex::initialize() -> void
+{
+    Q_ASSERT(!obj);
+    obj = new DirIndex;
+}
+
+auto DirIndex::instance() -> DirIndex&
+{
+    Q_ASSERT(obj);
+    return *obj;
+}
+
+auto DirIndex::finalize() -> void
+{
+    _Delete(obj);
+}
+
+DirIndex::DirIndex()
+    : d(new Data)
+{
+    d->p = this;
+    if (qApp && thread() != qApp->thread())
+        moveToThread(qApp->thread());
+    d->watcher.moveToThread(thread());
+    connect(&d->watcher, &QFileSystemWatcher::directoryChanged,
+            this, [=] (const QString &path) {
+        QMutexLocker locker(&d->mutex);
+        d->cache.remove(path);
+        d->recent.removeOne(path);
+        d->watcher.removePath(path);
+    });
+    d->scanner = new DirScanner([=] (const QString &path)
+        { _PostEvent(this, Scanned, path, d->scan(path)); });
+    d->scanner->start(QThread::LowPriority);
+}
+
+DirIndex::~DirIndex()
+{
+    delete d->scanner;
+    delete d;
+}
+
+auto DirIndex::cached(const QString &path) const -> DirListingPtr
+{
+    return d->find(path);
+}
+
+auto DirIndex::listing(const QString &path) -> DirListingPtr
+{
+    return d->scan(path);
+}
+
+auto DirIndex::request(const QString &path, QObject *context, Callback &&func) -> void
+{
+    d->requests[path].push_back({ context, std::move(func) });
+    if (auto listing = d->find(path))
+        _PostEvent(this, Scanned, path, listing);
+    else
+        d->scanner->request(path);
+}
+
+auto DirIndex::customEvent(QEvent *event) -> void
+{
+    switch (static_cast<int>(event->type())) {
+    case Scanned: {
+        QString path; DirListingPtr listing;
+        _TakeData(event, path, listing);
+        for (auto &req : d->requests.take(path)) {
+            if (req.context)
+                req.func(listing);
+        }
+        break;
+    } case Watch: {
+        const auto path = _GetData<QString>(event);
+        QMutexLocker locker(&d->mutex);
+        auto it = d->cache.find(path);
+        if (it == d->cache.end() || it->watched)
+            break;
+        it->watched = d->watcher.addPath(path);
+        // changes between scan and now are not notified
+        if (it->watched && QFileInfo(path).lastModified() != it->modified) {
+            d->watcher.removePath(path);
+            d->cache.erase(it);
+            d->recent.removeOne(path);
+        }
+        break;
+    } case Unwatch: {
+        const auto path = _GetData<QString>(event);
+        QMutexLocker locker(&d->mutex);
+        if (!d->cache.contains(path))
+            d->watcher.removePath(path);
+        break;
+    } default:
+        break;
+    }
+}
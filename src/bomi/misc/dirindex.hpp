@@ -0,0 +1,44 @@
+#ifndef DIRINDEX_HPP
+#define DIRINDEX_HPP
+
+struct DirEntry {
+    QString name, base;
+    // text before and after the first number in name
+    QString head, tail;
+    ExtTypes type = AllExt;
+    bool numbered = false;
+};
+
+struct DirListing {
+    QString path;
+    QVector<DirEntry> files; // natural order, same as Playlist::sort()
+    QStringList dirs;
+    auto filePath(const DirEntry &entry) const -> QString
+        { return path % '/'_q % entry.name; }
+};
+
+using DirListingPtr = QSharedPointer<const DirListing>;
+
+class DirIndex : public QObject {
+public:
+    using Callback = std::function<void(const DirListingPtr&)>;
+    // created in GUI thread before any use from other threads
+    static auto initialize() -> void;
+    static auto instance() -> DirIndex&;
+    static auto finalize() -> void;
+    // valid listing in cache or null
+    auto cached(const QString &path) const -> DirListingPtr;
+    // enumerates in calling thread if not cached
+    auto listing(const QString &path) -> DirListingPtr;
+    // enumerates in background if needed, func is called later in GUI thread
+    // unless context is gone
+    auto request(const QString &path, QObject *context, Callback &&func) -> void;
+private:
+    DirIndex();
+    ~DirIndex();
+    auto customEvent(QEvent *event) -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // DIRINDEX_HPP
@@ -221,6 +221,28 @@ auto _JsonToQVariant(const QJsonValue &json, int metaType) -> QVariant
     return _JsonToQVariant(json, metaType, QVariant());
 }
 
+JsonQVariantConverter::JsonQVariantConverter(int metaType)
+{
+    const auto it = convs().find(metaType);
+    if (it != convs().end())
+        m_conv = &it.value();
+}
+
+auto JsonQVariantConverter::toQVariant(const QJsonValue &json) const -> QVariant
+{
+    QVariant var;
+    if (m_conv && m_conv->j2v(m_conv, json, var))
+        return var;
+    return QVariant();
+}
+
+auto JsonQVariantConverter::toJson(const QVariant &var) const -> QJsonValue
+{
+    if (m_conv)
+        return m_conv->v2j(m_conv, var);
+    return QJsonValue(QJsonValue::Undefined);
+}
+
 auto _JsonSetToQVariant(const QJsonValue &json, QVariant &var) -> bool
 {
     auto v = _JsonToQVariant(json, var.userType());
@@ -31,6 +31,19 @@ auto _JsonToQVariant(const QJsonValue &json, const QVariant &def) -> QVariant;
 auto _JsonToQVariant(const QJsonValue &json, int metaType) -> QVariant;
 auto _JsonToQVariant(const QJsonValue &json, int metaType, const QVariant &def) -> QVariant;
 
+struct JVConvert;
+
+// conversion for a type resolved once, to be kept and reused
+class JsonQVariantConverter {
+public:
+    JsonQVariantConverter(int metaType = QMetaType::UnknownType);
+    auto isValid() const -> bool { return m_conv; }
+    auto toQVariant(const QJsonValue &json) const -> QVariant;
+    auto toJson(const QVariant &var) const -> QJsonValue;
+private:
+    const JVConvert *m_conv = nullptr;
+};
+
 auto _JsonType(int metaType) -> QJsonValue::Type;
 auto _QVariantFromType(int metaType) -> QVariant;
 
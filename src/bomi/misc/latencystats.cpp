@@ -0,0 +1,40 @@
+#include "latencystats.hpp"
+#include <numeric>
+
+auto LatencyStats::commit() -> void
+{
+    QMutexLocker locker(&m_mutex);
+    m_samples.push_back(m_pending);
+    m_pending = 0;
+}
+
+auto LatencyStats::clear() -> void
+{
+    QMutexLocker locker(&m_mutex);
+    m_samples.clear();
+}
+
+auto LatencyStats::count() const -> int
+{
+    QMutexLocker locker(&m_mutex);
+    return m_samples.size();
+}
+
+auto LatencyStats::toJson() const -> QJsonObject
+{
+    m_mutex.lock();
+    auto samples = m_samples;
+    m_mutex.unlock();
+    QJsonObject json;
+    json[u"count"_q] = samples.size();
+    if (samples.isEmpty())
+        return json;
+    std::sort(samples.begin(), samples.end());
+    auto ms = [&] (int p) { return samples[(samples.size() - 1) * p / 100] * 1e-6; };
+    json[u"total"_q] = std::accumulate(samples.begin(), samples.end(), 0.0) * 1e-6;
+    json[u"p50"_q] = ms(50);
+    json[u"p90"_q] = ms(90);
+    json[u"p99"_q] = ms(99);
+    json[u"max"_q] = ms(100);
+    return json;
+}
@@ -0,0 +1,27 @@
+#ifndef LATENCYSTATS_HPP
+#define LATENCYSTATS_HPP
+
+#include <QElapsedTimer>
+
+// durations of a pipeline stage for benchmark reports
+// a sample may consist of several measured parts, e.g. filter input and output
+class LatencyStats {
+public:
+    // measures a part of current sample
+    auto start() -> void { m_timer.start(); }
+    auto stop() -> void { m_pending += m_timer.nsecsElapsed(); }
+    // ends current sample
+    auto commit() -> void;
+    // can be called from other thread than the measuring one
+    auto clear() -> void;
+    auto count() const -> int;
+    // count, total, p50, p90, p99 and max, in ms
+    auto toJson() const -> QJsonObject;
+private:
+    mutable QMutex m_mutex;
+    QVector<qint64> m_samples;
+    qint64 m_pending = 0;
+    QElapsedTimer m_timer;
+};
+
+#endif // LATENCYSTATS_HPP
@@ -5,6 +5,9 @@
 #include "tmp/algorithm.hpp"
 #include <QTextCodec>
 #include <QBuffer>
+#include <QThreadStorage>
+#include <QtEndian>
+#include <atomic>
 #include <cstdlib>
 
 #if HAVE_SYSTEMD
@@ -33,7 +36,10 @@ static QReadWriteLock s_rwLock;
 static QHash<QObject*, int> s_subscribers;
 
 static QSharedPointer<FILE> s_file;
-static bool s_local8BitIsUtf8 = false;
+static bool s_local8BitIsUtf8 = false, s_binary = false;
+
+static constexpr char BinaryMagic[8] = { 'B', 'O', 'M', 'I', 'L', 'O', 'G', 1 };
+static constexpr int BinaryHeader = 8 + 1 + 2 + 4, FlushInterval = 50;
 
 SIA encodeForTerminal(const QByteArray &log) -> QByteArray
 {
@@ -48,36 +54,315 @@ const QStringList Log::m_options = QStringList()
         << u"off"_q   << u"fatal"_q << u"error"_q << u"warn"_q
         << u"info"_q  << u"debug"_q << u"trace"_q;
 
+struct LogLine {
+    qint64 time = 0;
+    Log::Level level = Log::Off;
+    QByteArray context, text;
+    auto format() const -> QByteArray
+    {
+        QByteArray log;
+        log.reserve(context.size() + text.size() + 8);
+        ((((((log += '(') += " FEWIDT"[level]) += ")[") += context) += "] ") += text) += '\n';
+        return log;
+    }
+};
+
+// A line is copied into fixed-size records of the ring owned by the calling
+// thread. Records after the first one only carry the rest of context/text.
+struct LogRecord {
+    static constexpr int Size = 256, Capacity = Size - 16;
+    qint64 time;
+    quint32 length;
+    quint16 context;
+    quint8 level, reserved;
+    char data[Capacity];
+};
+
+static_assert(sizeof(LogRecord) == LogRecord::Size, "LogRecord is not packed");
+
+// single producer (owner thread), single consumer (writer thread)
+struct LogRing {
+    static constexpr quint32 Records = 512;
+    static auto count(quint32 length) -> quint32
+        { return qMax<quint32>(1, (length + LogRecord::Capacity - 1) / LogRecord::Capacity); }
+    auto push(Log::Level lv, qint64 time, const char *ctx, int ctxLen,
+              const char *text, int len) -> bool
+    {
+        const quint32 length = ctxLen + len, n = count(length);
+        const auto h = head.load(std::memory_order_relaxed);
+        if (n > Records - (h - tail.load(std::memory_order_acquire))) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        auto &first = records[h % Records];
+        first.time = time;
+        first.length = length;
+        first.context = ctxLen;
+        first.level = lv;
+        quint32 pos = 0;
+        auto copy = [&] (const char *src, int size) {
+            while (size > 0) {
+                auto &r = records[(h + pos / LogRecord::Capacity) % Records];
+                const int offset = pos % LogRecord::Capacity;
+                const int len = qMin(size, LogRecord::Capacity - offset);
+                memcpy(r.data + offset, src, len);
+                src += len; size -= len; pos += len;
+            }
+        };
+        copy(ctx, ctxLen);
+        copy(text, len);
+        head.store(h + n, std::memory_order_release);
+        return true;
+    }
+    auto pop(LogLine &line) -> bool
+    {
+        const auto t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        const auto &first = records[t % Records];
+        QByteArray data(first.length, Qt::Uninitialized);
+        for (quint32 pos = 0; pos < first.length; pos += LogRecord::Capacity) {
+            const auto &r = records[(t + pos / LogRecord::Capacity) % Records];
+            memcpy(data.data() + pos, r.data,
+                   qMin<quint32>(LogRecord::Capacity, first.length - pos));
+        }
+        line.time = first.time;
+        line.level = (Log::Level)first.level;
+        line.context = data.left(first.context);
+        line.text = data.mid(first.context);
+        tail.store(t + count(first.length), std::memory_order_release);
+        return true;
+    }
+    std::array<LogRecord, Records> records;
+    std::atomic<quint32> head{0}, tail{0};
+    std::atomic<quint64> dropped{0};
+    std::atomic<bool> closed{false};
+};
+
+struct LogRingHandle {
+    LogRing *ring = new LogRing;
+    ~LogRingHandle() { ring->closed.store(true, std::memory_order_release); }
+};
+
+static QMutex s_ringsMutex, s_drainMutex;
+static QList<LogRing*> s_rings;
+static QThreadStorage<LogRingHandle*> s_localRing;
+static std::atomic<bool> s_async{false};
+static std::atomic<quint64> s_dropped{0};
+
+static auto localRing() -> LogRing*
+{
+    if (!s_localRing.hasLocalData()) {
+        auto handle = new LogRingHandle;
+        s_ringsMutex.lock();
+        s_rings.push_back(handle->ring);
+        s_ringsMutex.unlock();
+        s_localRing.setLocalData(handle);
+    }
+    return s_localRing.localData()->ring;
+}
+
 SIA print(FILE *file, const QByteArray &log) -> void
 {
     fwrite(log.constData(), 1, log.size(), file);
-    fflush(file);
 }
 
-auto Log::print(Level lv, const QByteArray &log) -> void
+SIA encodeBinary(QByteArray &out, const LogLine &line) -> void
 {
+    uchar header[BinaryHeader];
+    qToLittleEndian<qint64>(line.time, header);
+    header[8] = line.level;
+    qToLittleEndian<quint16>(line.context.size(), header + 9);
+    qToLittleEndian<quint32>(line.text.size(), header + 11);
+    out.append((const char*)header, BinaryHeader);
+    out += line.context;
+    out += line.text;
+}
+
+// caller should hold s_drainMutex
+static auto output(const QVector<LogLine> &lines) -> void
+{
+    QByteArray out, err, file;
+    QVector<QPair<Log::Level, QString>> viewer;
+    for (auto &line : lines) {
+        const auto lv = line.level;
+        const auto log = line.format();
 #if HAVE_SYSTEMD
-    if (lv <= lvJournal)
-        sd_journal_print(jp[lv], log.constData());
+        if (lv <= lvJournal)
+            sd_journal_print(jp[lv], "%s", log.constData());
 #endif
-    if (lv <= lvStdOut)
-        ::print(stdout, encodeForTerminal(log));
-    if (lv <= lvStdErr)
-        ::print(stderr, encodeForTerminal(log));
-    if (lv <= lvFile && s_file)
-        ::print(s_file.data(), log);
-    if (lv <= lvViewer && !s_subscribers.isEmpty()) {
+        if (lv <= lvStdOut)
+            out += log;
+        if (lv <= lvStdErr)
+            err += log;
+        if (lv <= lvFile && s_file) {
+            if (s_binary)
+                encodeBinary(file, line);
+            else
+                file += log;
+        }
+        if (lv <= lvViewer)
+            viewer.push_back(qMakePair(lv, QString::fromUtf8(log.constData(), log.size() - 1)));
+    }
+    // one write and flush for each sink per batch
+    if (!out.isEmpty()) {
+        print(stdout, encodeForTerminal(out));
+        fflush(stdout);
+    }
+    if (!err.isEmpty()) {
+        print(stderr, encodeForTerminal(err));
+        fflush(stderr);
+    }
+    if (!file.isEmpty()) {
+        print(s_file.data(), file);
+        fflush(s_file.data());
+    }
+    if (!viewer.isEmpty() && !s_subscribers.isEmpty()) {
         s_rwLock.lockForRead();
         auto &s = _C(s_subscribers);
-        auto str = QString::fromUtf8(log); str.chop(1);
         for (auto it = s.begin(); it != s.end(); ++it)
-            _PostEvent(it.key(), it.value(), lv, str);
+            _PostEvent(it.key(), it.value(), viewer);
         s_rwLock.unlock();
     }
+}
+
+static auto drain() -> void
+{
+    QMutexLocker locker(&s_drainMutex);
+    QVector<LogLine> lines;
+    s_ringsMutex.lock();
+    for (auto it = s_rings.begin(); it != s_rings.end(); ) {
+        auto ring = *it;
+        // everything pushed before closing is visible after this
+        const bool closed = ring->closed.load(std::memory_order_acquire);
+        LogLine line;
+        while (ring->pop(line))
+            lines.push_back(line);
+        if (const auto dropped = ring->dropped.exchange(0)) {
+            s_dropped += dropped;
+            LogLine line;
+            line.time = QDateTime::currentMSecsSinceEpoch();
+            line.level = Log::Warn;
+            line.context = "Log"_b;
+            line.text = QByteArray::number(dropped) + " lines dropped by full ring"_b;
+            lines.push_back(line);
+        }
+        if (closed) {
+            delete ring;
+            it = s_rings.erase(it);
+        } else
+            ++it;
+    }
+    s_ringsMutex.unlock();
+    // rings are drained one after another
+    std::stable_sort(lines.begin(), lines.end(), [] (auto &lhs, auto &rhs)
+        { return lhs.time < rhs.time; });
+    if (!lines.isEmpty())
+        output(lines);
+}
+
+class LogWriter : public QThread {
+public:
+    auto stop() -> void
+    {
+        m_mutex.lock();
+        m_quit = true;
+        m_wait.wakeAll();
+        m_mutex.unlock();
+        wait();
+    }
+private:
+    auto run() -> void final
+    {
+        m_mutex.lock();
+        while (!m_quit) {
+            m_mutex.unlock();
+            drain();
+            m_mutex.lock();
+            if (!m_quit)
+                m_wait.wait(&m_mutex, FlushInterval);
+        }
+        m_mutex.unlock();
+        drain();
+    }
+    QMutex m_mutex;
+    QWaitCondition m_wait;
+    bool m_quit = false;
+};
+
+static LogWriter *s_writer = nullptr;
+
+auto Log::print(Level lv, const char *ctx, int ctxLen,
+                const char *text, int len) -> void
+{
+    const auto time = QDateTime::currentMSecsSinceEpoch();
+    if (s_async.load(std::memory_order_acquire)) {
+        localRing()->push(lv, time, ctx, ctxLen, text, len);
+        if (lv == Fatal) {
+            drain();
+            abort();
+        }
+        return;
+    }
+    LogLine line;
+    line.time = time;
+    line.level = lv;
+    line.context = QByteArray(ctx, ctxLen);
+    line.text = QByteArray(text, len);
+    s_drainMutex.lock();
+    output({ line });
+    s_drainMutex.unlock();
     if (lv == Fatal)
         abort();
 }
 
+auto Log::finalize() -> void
+{
+    if (!s_writer)
+        return;
+    s_async.store(false, std::memory_order_release);
+    s_writer->stop();
+    _Delete(s_writer);
+    drain();
+}
+
+auto Log::dropped() -> quint64
+{
+    return s_dropped;
+}
+
+auto Log::decode(const QString &path) -> bool
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        qDebug("Cannot open file: %s", qPrintable(path));
+        return false;
+    }
+    if (file.read(sizeof(BinaryMagic)) != QByteArray(BinaryMagic, sizeof(BinaryMagic))) {
+        qDebug("Not a binary log: %s", qPrintable(path));
+        return false;
+    }
+    QByteArray out;
+    uchar header[BinaryHeader];
+    while (file.read((char*)header, BinaryHeader) == BinaryHeader) {
+        LogLine line;
+        line.time = qFromLittleEndian<qint64>(header);
+        line.level = (Level)header[8];
+        line.context = file.read(qFromLittleEndian<quint16>(header + 9));
+        line.text = file.read(qFromLittleEndian<quint32>(header + 11));
+        const auto dt = QDateTime::fromMSecsSinceEpoch(line.time);
+        out += dt.toString(u"yyyy-MM-ddThh:mm:ss.zzz "_q).toLatin1();
+        out += line.format();
+        if (out.size() > (1 << 16)) {
+            print(stdout, encodeForTerminal(out));
+            out.clear();
+        }
+    }
+    print(stdout, encodeForTerminal(out));
+    fflush(stdout);
+    return true;
+}
+
 static const std::array<Log::Level, 4> lvQt = []() {
     std::array<Log::Level, 4> ret;
     ret[QtDebugMsg] = Log::Debug;
@@ -110,15 +395,26 @@ auto Log::setOption(const LogOption &option) -> void
 
     s_local8BitIsUtf8 = QTextCodec::codecForLocale()->mibEnum() == 106;
 
-    if (!lvFile)
-        return;
-    auto path = option.file().toLocal8Bit();
-    auto pf = fopen(path.constData(), "a");
-    if (!pf) {
-        qDebug("Cannot open file: %s\n", path.constData());
-        return;
+    if (lvFile) {
+        // records are kept in binary and decoded by --decode-log
+        s_binary = option.file().endsWith(".binlog"_a, Qt::CaseInsensitive);
+        auto path = option.file().toLocal8Bit();
+        auto pf = fopen(path.constData(), s_binary ? "ab" : "a");
+        if (!pf)
+            qDebug("Cannot open file: %s\n", path.constData());
+        else {
+            s_file = QSharedPointer<FILE>(pf, fclose);
+            fseek(pf, 0, SEEK_END);
+            if (s_binary && !ftell(pf))
+                fwrite(BinaryMagic, 1, sizeof(BinaryMagic), pf);
+        }
+    }
+
+    if (!s_writer) {
+        s_writer = new LogWriter;
+        s_writer->start(QThread::LowPriority);
+        s_async.store(true, std::memory_order_release);
     }
-    s_file = QSharedPointer<FILE>(pf, fclose);
 }
 
 auto Log::option() -> const LogOption&
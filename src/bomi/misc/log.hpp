@@ -59,17 +59,17 @@ class Log {
 public:
     enum Level { Off, Fatal, Error, Warn, Info, Debug, Trace };
     template<class F>
-    static auto write(Level level, F &&getLogText) -> void
+    static auto write(Level level, const char *ctx, F &&getLogText) -> void
     {
         if (level <= maximumLevel())
-            print(level, std::move(getLogText() += '\n'));
+            print(level, ctx, getLogText());
     }
     template<class... Args>
     static auto write(const char *ctx, Level level, const QByteArray &format,
                       const Args &... args) -> void
     {
         if (level <= maximumLevel())
-            print(level, std::move(Helper(level, ctx, format, args...).log() += '\n'));
+            print(level, ctx, Helper(format, args...).log());
     }
     template<class... Args>
     static auto parse(Level lv, const char *ctx, const QByteArray &fmt, const Args &... args) -> QByteArray
@@ -84,7 +84,20 @@ public:
         const int index = m_options.indexOf(name);
         return index < 0 ? Off : (Level)index;
     }
-    static auto print(Level lv, const QByteArray &log) -> void;
+    static auto print(Level lv, const char *ctx, int ctxLen,
+                      const char *text, int len) -> void;
+    static auto print(Level lv, const char *ctx, const QByteArray &text) -> void
+        { print(lv, ctx, qstrlen(ctx), text.constData(), text.size()); }
+    static auto print(Level lv, const QByteArray &ctx, const char *text) -> void
+    {
+        int len = qstrlen(text);
+        if (len > 0 && text[len - 1] == '\n')
+            --len;
+        print(lv, ctx.constData(), ctx.size(), text, len);
+    }
+    static auto finalize() -> void;
+    static auto dropped() -> quint64;
+    static auto decode(const QString &path) -> bool;
     static auto maximumLevel() -> Level;
     static auto setOption(const LogOption &option) -> void;
     static auto option() -> const LogOption&;
@@ -151,8 +164,8 @@ private:
 #define DECLARE_LOG_CONTEXT(ctx) \
     static inline const char *getLogContext() { return (#ctx); }
 
-#define _WriteLog(lv, fmt, ...) Log::write(lv, [&] () \
-    { return std::move(Log::parse(lv, getLogContext(), fmt, ##__VA_ARGS__)); })
+#define _WriteLog(lv, fmt, ...) Log::write(lv, getLogContext(), [&] () \
+    { return std::move(Log::parse(fmt, ##__VA_ARGS__)); })
 #define _Fatal(fmt, ...) _WriteLog(Log::Fatal, fmt, ##__VA_ARGS__)
 #define _Error(fmt, ...) _WriteLog(Log::Error, fmt, ##__VA_ARGS__)
 #define _Warn(fmt, ...)  _WriteLog(Log::Warn,  fmt, ##__VA_ARGS__)
@@ -215,23 +215,27 @@ auto LogViewer::customEvent(QEvent *ev) -> void
         return;
     if (d->stop)
         return;
-    LogEntry entry;
-    _TakeData(ev, entry.level, entry.message);
-    Q_ASSERT(entry.message.at(3) == '['_q);
-    const int idx = entry.message.indexOf(']'_q, 4);
-    if (idx < 0) {
-        qDebug("Unknown logging context. Skip it.");
-        return;
+    bool sort = false;
+    for (auto &line : _MoveData<QVector<QPair<Log::Level, QString>>>(ev)) {
+        LogEntry entry;
+        entry.level = line.first;
+        entry.message = std::move(line.second);
+        Q_ASSERT(entry.message.at(3) == '['_q);
+        const int idx = entry.message.indexOf(']'_q, 4);
+        if (idx < 0) {
+            qDebug("Unknown logging context. Skip it.");
+            continue;
+        }
+        entry.context = entry.message.mid(4, idx -4 );
+        d->model.append(entry);
+        sort |= d->newContext(entry.context, true);
     }
-    entry.context = entry.message.mid(4, idx -4 );
-    d->model.append(entry);
-
-    if (d->newContext(entry.context, true)) {
+    if (sort) {
         d->ui.context->sortItems();
         d->syncContext();
     }
 
-    if (d->model.rows() > d->lines)
+    while (d->model.rows() > d->lines)
         d->model.remove(0);
     if (d->ui.autoscroll->isChecked())
         d->ui.view->scrollToBottom();
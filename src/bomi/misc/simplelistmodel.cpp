@@ -118,16 +118,20 @@ auto SimpleListModelBase::clear() -> void
 auto SimpleListModelBase::insertRows(int row, int count, const QModelIndex &parent) -> bool
 {
     beginInsertRows(parent, row, row + count - 1);
-    for (int i = 0; i < count; ++i) {
+    for (int i = 0; i < count; ++i)
         insertAt(row + i);
-        for (auto &v : d->checked)
-            v.insert(row + i, false);
-    }
+    inserted(row, count);
+    endInsertRows();
+    return true;
+}
+
+auto SimpleListModelBase::inserted(int row, int count) -> void
+{
+    for (auto &v : d->checked)
+        v.insert(row, count, false);
     emit rowsChanged(d->rows += count);
     if (d->special >= row)
         setSpecialRow(d->special + count);
-    endInsertRows();
-    return true;
 }
 
 auto SimpleListModelBase::removeRows(int row, int count, const QModelIndex &parent) -> bool
@@ -36,6 +36,7 @@ signals:
 protected:
     auto resize(int rows) -> void;
     auto reset(int rows) -> void;
+    auto inserted(int row, int count) -> void;
     auto setSpecialFont(const QFont &font) -> void;
     auto setSpecialRow(int row) -> void;
     virtual auto flags(int row, int column) const -> Qt::ItemFlags;
@@ -79,6 +80,7 @@ public:
     auto setList(const Container &list) -> void;
     auto append(const T &t) -> void { append(Container() << t); }
     auto append(const Container &list) -> void;
+    auto insert(int row, const Container &list) -> void;
     auto rowOf(const T &t) const -> int {return m_list.indexOf(t);}
 protected:
     auto getList() -> Container& { return m_list; }
@@ -118,6 +120,19 @@ auto SimpleListModel<T, List>::append(const List &list) -> void{
     endInsertRows();
 }
 
+template<class T, class List>
+auto SimpleListModel<T, List>::insert(int row, const List &list) -> void
+{
+    if (list.isEmpty())
+        return;
+    row = qBound(0, row, m_list.size());
+    beginInsertRows(QModelIndex(), row, row + list.size() - 1);
+    for (int i = 0; i < list.size(); ++i)
+        m_list.insert(row + i, list[i]);
+    inserted(row, list.size());
+    endInsertRows();
+}
+
 class StringListModel : public SimpleListModel<QString, QStringList> {
     Q_OBJECT
 public:
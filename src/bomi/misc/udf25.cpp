@@ -474,14 +474,14 @@ auto udf25::SetUDFCache(UDFCacheType type, quint32 nr, void *data) -> int
     c->lbs[n].lb = nr;
     break;
   case MapCache:
-    for(n = 0; n < c->map_num; n++) {
-      if(c->maps[n].lbn == nr) {
-        /* replace with new data */
-        c->maps[n] = *(struct icbmap *)data;
-        c->maps[n].lbn = nr;
-        return 1;
-      }
+    n = m_mapIndex.value(nr, -1);
+    if(n >= 0) {
+      /* replace with new data */
+      c->maps[n] = *(struct icbmap *)data;
+      c->maps[n].lbn = nr;
+      return 1;
     }
+    n = c->map_num;
     c->map_num++;
     tmp = realloc(c->maps, c->map_num * sizeof(struct icbmap));
     /*
@@ -491,12 +491,15 @@ auto udf25::SetUDFCache(UDFCacheType type, quint32 nr, void *data) -> int
     */
     if(tmp == NULL) {
       if(c->maps) free(c->maps);
+      c->maps = NULL;
       c->map_num = 0;
+      m_mapIndex.clear();
       return 0;
     }
     c->maps = (struct icbmap *)tmp;
     c->maps[n] = *(struct icbmap *)data;
     c->maps[n].lbn = nr;
+    m_mapIndex.insert(nr, n);
     break;
   default:
     return 0;
@@ -575,11 +578,10 @@ auto udf25::GetUDFCache(UDFCacheType type, quint32 nr, void *data) -> int
     }
     break;
   case MapCache:
-    for(n = 0; n < c->map_num; n++) {
-      if(c->maps[n].lbn == nr) {
-        *(struct icbmap *)data = c->maps[n];
-        return 1;
-      }
+    n = m_mapIndex.value(nr, -1);
+    if(n >= 0) {
+      *(struct icbmap *)data = c->maps[n];
+      return 1;
     }
     break;
   default:
@@ -589,15 +591,55 @@ auto udf25::GetUDFCache(UDFCacheType type, quint32 nr, void *data) -> int
   return 0;
 }
 
-auto udf25::ReadAt( int64_t pos, size_t len, unsigned char *data ) -> int
+auto udf25::ReadDirect( int64_t pos, size_t len, unsigned char *data ) -> int
 {
+  m_fp->clear(); /* a short read before leaves failbit set */
   if (!m_fp->seekg(pos))
     return -1;
-  if (!m_fp->read((char*)data, len))
-    _Error("ReadFile - less data than requested available!");
+  m_fp->read((char*)data, len);
   return m_fp->gcount();
 }
 
+/* UDF metadata and the few blocks read for disc identification are scattered
+ * small reads. Serving them from larger aligned chunks turns them into a
+ * handful of sequential reads, which matters for images on network storage. */
+auto udf25::ReadAt( int64_t pos, size_t len, unsigned char *data ) -> int
+{
+  static constexpr int chunkSize = UDF_CACHE_CHUNK_BLOCKS * DVD_VIDEO_LB_LEN;
+  if (len > (size_t)chunkSize) {
+    const int ret = ReadDirect(pos, len, data);
+    if (ret >= 0 && (size_t)ret < len)
+      _Error("ReadFile - less data than requested available!");
+    return ret;
+  }
+  size_t done = 0;
+  while (done < len) {
+    const qint64 idx = (pos + done) / chunkSize;
+    const int offset = (pos + done) % chunkSize;
+    auto chunk = m_chunks.object(idx);
+    if (!chunk) {
+      chunk = new QByteArray(chunkSize, Qt::Uninitialized);
+      const int ret = ReadDirect(idx * chunkSize, chunkSize, (uchar*)chunk->data());
+      if (ret < 0) {
+        delete chunk;
+        return done ? (int)done : -1;
+      }
+      chunk->resize(ret);
+      m_chunks.insert(idx, chunk);
+    }
+    if (chunk->size() <= offset)
+      break;
+    const int n = qMin<size_t>(chunk->size() - offset, len - done);
+    memcpy(data + done, chunk->constData() + offset, n);
+    done += n;
+    if (chunk->size() < chunkSize)
+      break;
+  }
+  if (done < len)
+    _Error("ReadFile - less data than requested available!");
+  return done;
+}
+
 auto udf25::DVDReadLBUDF( quint32 lb_number, size_t block_count, unsigned char *data, int /*encrypted*/ ) -> int
 {
   int ret;
@@ -854,77 +896,28 @@ auto udf25::UDFScanDir( struct FileAD Dir, char *FileName, struct Partition *par
   quint16 TagID;
   quint8 filechar;
   unsigned int p;
-  quint8 *cached_dir_base = NULL, *cached_dir;
   quint32 dir_lba;
-  struct AD tmpICB;
-  int found = 0;
-  int in_cache = 0;
 
   /* Scan dir for ICB of file */
   lbnum = partition->Start + Dir.AD_chain[0].Location;
 
   if(DVDUDFCacheLevel(-1) > 0) {
-    /* caching */
-
-    if(!GetUDFCache(LBUDFCache, lbnum, &cached_dir)) {
+    /* caching: each directory is parsed once, when it is first visited */
+    auto it = m_dirs.find(lbnum);
+    if(it == m_dirs.end()) {
       dir_lba = (Dir.AD_chain[0].Length + DVD_VIDEO_LB_LEN) / DVD_VIDEO_LB_LEN;
-      if((cached_dir_base = (quint8 *)malloc(dir_lba * DVD_VIDEO_LB_LEN + 2048)) == NULL)
-        return 0;
-      cached_dir = (quint8 *)(((uintptr_t)cached_dir_base & ~((uintptr_t)2047)) + 2048);
-      if( DVDReadLBUDF( lbnum, dir_lba, cached_dir, 0) <= 0 ) {
-        free(cached_dir_base);
-        cached_dir_base = NULL;
-        cached_dir = NULL;
-      }
-      /*
-      if(cached_dir) {
-        fprintf(stderr, "malloc dir: %d\n",  dir_lba * DVD_VIDEO_LB_LEN);
-      }
-      */
-      {
-        quint8 *data[2];
-        data[0] = cached_dir_base;
-        data[1] = cached_dir;
-        SetUDFCache(LBUDFCache, lbnum, data);
-      }
-    } else
-      in_cache = 1;
-
-    if(cached_dir == NULL)
-      return 0;
-
-    p = 0;
-
-    while( p < Dir.AD_chain[0].Length ) {  /* Assuming dirs don't use chains? */
-      UDFDescriptor( &cached_dir[ p ], &TagID );
-      if( TagID == 257 ) {
-        p += UDFFileIdentifier( &cached_dir[ p ], &filechar,
-                                filename, &tmpICB );
-        if(cache_file_info && !in_cache) {
-          struct FileAD tmpFile;
-
-          memset(&tmpFile, 0, sizeof(tmpFile));
-
-          if( !strcasecmp( FileName, filename ) ) {
-            memcpy(FileICB, &tmpICB, sizeof(tmpICB));
-            found = 1;
-          }
-          UDFMapICB(tmpICB, partition, &tmpFile);
-        } else {
-          if( !strcasecmp( FileName, filename ) ) {
-            memcpy(FileICB, &tmpICB, sizeof(tmpICB));
-            return 1;
-          }
-        }
-      } else {
-        if(cache_file_info && (!in_cache) && found)
-          return 1;
+      QByteArray buffer(dir_lba * DVD_VIDEO_LB_LEN, Qt::Uninitialized);
+      if( DVDReadLBUDF( lbnum, dir_lba, (quint8*)buffer.data(), 0) <= 0 )
         return 0;
-      }
+      it = m_dirs.insert(lbnum, IndexDir((quint8*)buffer.data(),
+                                         Dir.AD_chain[0].Length,
+                                         cache_file_info ? partition : NULL));
     }
-    if(cache_file_info && (!in_cache) && found)
-      return 1;
-    return 0;
+    const auto entry = it->constFind(QByteArray(FileName).toLower());
+    if(entry == it->constEnd())
+      return 0;
+    *FileICB = *entry;
+    return 1;
   }
 
   if( DVDReadLBUDF( lbnum, 2, directory, 0 ) <= 0 )
@@ -954,6 +947,33 @@ auto udf25::UDFScanDir( struct FileAD Dir, char *FileName, struct Partition *par
   return 0;
 }
 
+auto udf25::IndexDir( quint8 *data, quint32 length, struct Partition *partition ) -> QHash<QByteArray, AD>
+{
+  char filename[ MAX_UDF_FILE_NAME_LEN ];
+  QHash<QByteArray, AD> index;
+  quint16 TagID;
+  quint8 filechar;
+  struct AD ICB;
+  unsigned int p = 0;
+
+  while( p < length ) {  /* Assuming dirs don't use chains? */
+    UDFDescriptor( &data[ p ], &TagID );
+    if( TagID != 257 )
+      break;
+    p += UDFFileIdentifier( &data[ p ], &filechar,
+                            filename, &ICB );
+    const auto key = QByteArray(filename).toLower();
+    if(!index.contains(key))
+      index.insert(key, ICB);
+    if(partition) {
+      /* prefetch file entries of the whole directory */
+      struct FileAD tmpFile;
+      UDFMapICB(ICB, partition, &tmpFile);
+    }
+  }
+  return index;
+}
+
 udf25::udf25( )
 {
   m_fp = NULL;
@@ -964,6 +984,12 @@ udf25::udf25( )
 udf25::~udf25( )
 {
   delete m_fp;
+  if (auto c = (struct udf_cache *)m_udfcache) {
+    for (int n = 0; n < c->lb_num; n++)
+      free(c->lbs[n].data_base);
+    free(c->lbs);
+    free(c->maps);
+  }
   free(m_udfcache);
 }
 
@@ -27,6 +27,7 @@
  */
 
 #include <fstream>
+#include <QCache>
 
 namespace udf {
 
@@ -40,6 +41,13 @@ static constexpr int DVD_VIDEO_LB_LEN = 2048;
  */
 static constexpr int MAX_UDF_FILE_NAME_LEN = 2048;
 
+/**
+ * Small reads from the image are served from chunks of this many logical
+ * blocks, and at most UDF_CACHE_CHUNKS chunks are kept in memory.
+ */
+static constexpr int UDF_CACHE_CHUNK_BLOCKS = 32;
+static constexpr int UDF_CACHE_CHUNKS = 64;
+
 struct Partition {
   int valid;
   char VolumeDesc[128];
@@ -191,6 +199,8 @@ private:
   auto UDFGetAVDP( struct avdp_t *avdp) -> int;
   auto DVDReadLBUDF(quint32 lb_number, size_t block_count, unsigned char *data, int) -> int;
   auto ReadAt( int64_t pos, size_t len, unsigned char *data ) -> int;
+  auto ReadDirect( int64_t pos, size_t len, unsigned char *data ) -> int;
+  auto IndexDir( quint8 *data, quint32 length, struct Partition *partition ) -> QHash<QByteArray, AD>;
   auto UDFMapICB( struct AD ICB, struct Partition *partition, struct FileAD *File ) -> int;
   auto UDFScanDir( struct FileAD Dir, char *FileName, struct Partition *partition, struct AD *FileICB, int cache_file_info) -> int;
   auto SetUDFCache(UDFCacheType type, quint32 nr, void *data) -> int;
@@ -200,6 +210,9 @@ protected:
     /* Filesystem cache */
   int m_udfcache_level; /* 0 - turned off, 1 - on */
   void *m_udfcache;
+  QHash<quint32, int> m_mapIndex; /* lbn -> index in udf_cache::maps */
+  QHash<quint32, QHash<QByteArray, AD>> m_dirs; /* lowercased name -> ICB */
+  QCache<qint64, QByteArray> m_chunks{UDF_CACHE_CHUNKS};
   std::fstream *m_fp;
 };
 
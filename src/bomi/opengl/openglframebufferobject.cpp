@@ -4,6 +4,8 @@
 
 DECLARE_LOG_CONTEXT(OpenGL)
 
+static QAtomicInt serials;
+
 auto makeTexture(const QSize &size, OGL::TextureFormat internal) -> OpenGLTexture2D
 {
     OpenGLTextureTransferInfo info;
@@ -24,6 +26,7 @@ OpenGLFramebufferObject::OpenGLFramebufferObject(const QSize &size,
     , m_target(target)
 {
     func()->glGenFramebuffers(1, &m_id);
+    renewSerial();
 }
 
 OpenGLFramebufferObject::OpenGLFramebufferObject(const QSize &size,
@@ -45,14 +48,34 @@ OpenGLFramebufferObject::OpenGLFramebufferObject(const OpenGLTexture2D &texture,
 
 OpenGLFramebufferObject::~OpenGLFramebufferObject()
 {
-    auto f = func();
     if (m_id != GL_NONE)
-        f->glDeleteFramebuffers(1, &m_id);
+        func()->glDeleteFramebuffers(1, &m_id);
     if (m_autodelete) {
         m_texture.destroy();
     }
 }
 
+auto OpenGLFramebufferObject::renewSerial() -> void
+{
+    m_serial = serials.fetchAndAddRelaxed(1) + 1;
+}
+
+auto OpenGLFramebufferObject::resize(const QSize &size) -> bool
+{
+    Q_ASSERT(m_autodelete && m_texture.isValid());
+    Q_ASSERT(m_texture.target() == OGL::Target2D);
+    {
+        OpenGLTextureBinder<OGL::Target2D> binder(&m_texture);
+        m_texture.initialize(size, m_texture.info());
+    }
+    m_size = size;
+    renewSerial();
+    bind();
+    attach(m_texture);
+    release();
+    return m_complete;
+}
+
 auto OpenGLFramebufferObject::attach(const OpenGLTexture2D &texture) -> bool
 {
     Q_ASSERT(texture.isValid() && !texture.isEmpty());
@@ -4,6 +4,7 @@
 #include "opengltexture2d.hpp"
 
 class OpenGLFramebufferObject {
+    friend class OpenGLResourcePool;
 public:
     OpenGLFramebufferObject(const QSize &size, OGL::Target target);
     OpenGLFramebufferObject(const OpenGLTexture2D &texture, bool autodelete = false);
@@ -27,10 +28,16 @@ public:
     auto attach(const OpenGLTexture2D &texture) -> bool;
     auto target() const -> OGL::Target { return m_target; }
     auto checkStatus() const -> bool;
+    // reallocates own texture in new size and keeps fbo
+    auto resize(const QSize &size) -> bool;
+    // changes whenever contents may have been replaced by other user
+    auto serial() const -> int { return m_serial; }
 private:
+    auto renewSerial() -> void;
     static auto func() -> QOpenGLFunctions*
         { return QOpenGLContext::currentContext()->functions(); }
     GLuint m_id = GL_NONE;
+    int m_serial = 0;
     bool m_complete = false, m_autodelete = false;
     OpenGLTexture2D m_texture;
     QSize m_size;
@@ -0,0 +1,358 @@
+#include "openglresourcepool.hpp"
+#include "openglframebufferobject.hpp"
+#include "opengltexturebinder.hpp"
+#include "misc/log.hpp"
+#include <QtMath>
+
+DECLARE_LOG_CONTEXT(OpenGL)
+
+static constexpr qint64 DefaultBudget = 128 * 1024 * 1024;
+
+// sizes rounded up to a multiple of 1/16 of the smallest power of two greater
+// than size (1/8 of the largest one not greater unless size is a power of
+// two), at least 64 pixels
+SIA sizeClass(int n) -> int
+{
+    const int step = qMax<int>(64, qNextPowerOfTwo(quint32(n)) >> 4);
+    return (n + step - 1) / step * step;
+}
+
+SIA bucketKey(const QSize &size, OGL::TextureFormat format, bool fbo) -> quint64
+{
+    return (quint64(fbo) << 63) | (quint64(format) << 32)
+            | (quint64(sizeClass(size.width()) / 64) << 16)
+            | quint64(sizeClass(size.height()) / 64);
+}
+
+SIA bytes(const OpenGLTexture2D &texture) -> qint64
+{
+    return qint64(texture.width()) * texture.height()
+            * OpenGLResourcePool::bytesPerPixel(texture.format());
+}
+
+namespace {
+struct Entry {
+    OpenGLFramebufferObject *fbo = nullptr; // null for texture
+    OpenGLTexture2D texture;
+    quint64 frame = 0; // released at
+};
+}
+
+struct OpenGLResourcePool::Data {
+    QOpenGLContext *gl = nullptr;
+    QHash<quint64, QVector<Entry>> free;
+    QHash<GLuint, qint64> used;
+    quint64 frame = 0;
+    qint64 budget = DefaultBudget;
+    Stats stats;
+
+    // same size first, else the most recent one of same class
+    auto find(const QVector<Entry> &bucket, const QSize &size) const -> int
+    {
+        int found = -1;
+        for (int i = bucket.size() - 1; i >= 0; --i) {
+            if (bucket[i].frame >= frame)
+                continue;
+            if (bucket[i].texture.size() == size)
+                return i;
+            if (found < 0)
+                found = i;
+        }
+        return found;
+    }
+    auto take(quint64 key, const QSize &size, Entry *entry) -> bool
+    {
+        auto it = free.find(key);
+        if (it == free.end())
+            return false;
+        const int idx = find(*it, size);
+        if (idx < 0)
+            return false;
+        *entry = it->takeAt(idx);
+        if (it->isEmpty())
+            free.erase(it);
+        stats.freeBytes -= bytes(entry->texture);
+        --stats.free;
+        return true;
+    }
+    auto use(const OpenGLTexture2D &texture) -> void
+    {
+        const auto size = bytes(texture);
+        used[texture.id()] = size;
+        stats.usedBytes += size;
+        stats.used = used.size();
+        stats.peakBytes = qMax(stats.peakBytes, stats.usedBytes + stats.freeBytes);
+    }
+    auto unuse(const OpenGLTexture2D &texture) -> void
+    {
+        auto it = used.find(texture.id());
+        if (it == used.end())
+            return;
+        stats.usedBytes -= *it;
+        used.erase(it);
+        stats.used = used.size();
+    }
+    auto put(const Entry &entry) -> void
+    {
+        const auto &t = entry.texture;
+        free[bucketKey(t.size(), t.format(), entry.fbo)].push_back(entry);
+        stats.freeBytes += bytes(t);
+        ++stats.free;
+        stats.peakBytes = qMax(stats.peakBytes, stats.usedBytes + stats.freeBytes);
+    }
+    auto destroy(Entry &entry) -> void
+    {
+        // without context, objects are gone with it
+        if (QOpenGLContext::currentContext() != gl && entry.fbo) {
+            entry.fbo->m_id = GL_NONE;
+            entry.fbo->m_autodelete = false;
+        }
+        if (entry.fbo)
+            delete entry.fbo;
+        else if (QOpenGLContext::currentContext() == gl)
+            entry.texture.destroy();
+        ++stats.deleted;
+    }
+    auto expire(std::function<bool(const Entry&)> &&pred) -> void
+    {
+        for (auto it = free.begin(); it != free.end(); ) {
+            for (int i = 0; i < it->size(); ) {
+                auto &entry = (*it)[i];
+                if (!pred(entry)) {
+                    ++i;
+                    continue;
+                }
+                stats.freeBytes -= bytes(entry.texture);
+                --stats.free;
+                destroy(entry);
+                it->removeAt(i);
+            }
+            if (it->isEmpty())
+                it = free.erase(it);
+            else
+                ++it;
+        }
+    }
+    auto trim() -> void
+    {
+        while (stats.freeBytes > budget && !free.isEmpty()) {
+            auto oldest = frame;
+            for (auto &bucket : free) {
+                for (auto &entry : bucket)
+                    oldest = qMin(oldest, entry.frame);
+            }
+            expire([&] (const Entry &e) { return e.frame <= oldest; });
+        }
+    }
+};
+
+OpenGLResourcePool::OpenGLResourcePool()
+    : d(new Data)
+{
+    d->gl = QOpenGLContext::currentContext();
+}
+
+OpenGLResourcePool::~OpenGLResourcePool()
+{
+    clear();
+    if (!d->used.isEmpty())
+        _Debug("%% objects are still in use at deleting pool.", d->used.size());
+    delete d;
+}
+
+auto OpenGLResourcePool::current() -> OpenGLResourcePool*
+{
+    static QMutex mutex;
+    static QHash<QOpenGLContext*, OpenGLResourcePool*> pools;
+    auto gl = QOpenGLContext::currentContext();
+    if (!gl)
+        return nullptr;
+    QMutexLocker locker(&mutex);
+    auto &pool = pools[gl];
+    if (!pool) {
+        pool = new OpenGLResourcePool;
+        QObject::connect(gl, &QOpenGLContext::aboutToBeDestroyed, [gl] () {
+            mutex.lock();
+            auto pool = pools.take(gl);
+            mutex.unlock();
+            delete pool;
+        });
+    }
+    return pool;
+}
+
+auto OpenGLResourcePool::takeFramebufferObject(const QSize &size,
+                                               OGL::TextureFormat format)
+    -> OpenGLFramebufferObject*
+{
+    if (size.isEmpty())
+        return new OpenGLFramebufferObject(size, format);
+    Entry entry;
+    OpenGLFramebufferObject *fbo = nullptr;
+    if (d->take(bucketKey(size, format, true), size, &entry)) {
+        fbo = entry.fbo;
+        if (fbo->size() == size) {
+            fbo->renewSerial();
+            ++d->stats.hits;
+        } else if (fbo->resize(size)) {
+            ++d->stats.resized;
+        } else {
+            d->destroy(entry);
+            fbo = nullptr;
+        }
+    }
+    if (!fbo) {
+        fbo = new OpenGLFramebufferObject(size, format);
+        ++d->stats.misses;
+    }
+    d->use(fbo->texture());
+    return fbo;
+}
+
+auto OpenGLResourcePool::release(OpenGLFramebufferObject *fbo) -> void
+{
+    if (!fbo)
+        return;
+    d->unuse(fbo->texture());
+    if (!fbo->m_autodelete || !fbo->isValid() || fbo->texture().isEmpty()) {
+        delete fbo;
+        return;
+    }
+    Entry entry;
+    entry.fbo = fbo;
+    entry.texture = fbo->texture();
+    entry.frame = d->frame;
+    d->put(entry);
+    d->trim();
+}
+
+auto OpenGLResourcePool::takeTexture(const QSize &size,
+                                     const OpenGLTextureTransferInfo &info)
+    -> OpenGLTexture2D
+{
+    if (size.isEmpty())
+        return OpenGLTexture2D();
+    Entry entry;
+    auto &texture = entry.texture;
+    OpenGLTextureBinder<OGL::Target2D> binder;
+    if (d->take(bucketKey(size, info.texture, false), size, &entry)) {
+        binder.bind(&texture);
+        texture.setFilter(OGL::Linear);
+        texture.setWrapMode(OGL::ClampToEdge);
+        if (texture.size() == size) {
+            texture.setAttributes(size.width(), size.height(), info);
+            ++d->stats.hits;
+        } else {
+            texture.initialize(size, info);
+            ++d->stats.resized;
+        }
+    } else {
+        texture.create(OGL::Linear, OGL::ClampToEdge);
+        binder.bind(&texture);
+        texture.initialize(size, info);
+        ++d->stats.misses;
+    }
+    d->use(texture);
+    return texture;
+}
+
+auto OpenGLResourcePool::release(const OpenGLTexture2D &texture) -> void
+{
+    if (!texture.isValid())
+        return;
+    d->unuse(texture);
+    Entry entry;
+    entry.texture = texture;
+    entry.frame = d->frame;
+    if (texture.isEmpty() || texture.target() != OGL::Target2D) {
+        entry.texture.destroy();
+        return;
+    }
+    d->put(entry);
+    d->trim();
+}
+
+auto OpenGLResourcePool::endFrame() -> void
+{
+    ++d->frame;
+    if (d->frame > MaxIdleFrames) {
+        const auto old = d->frame - MaxIdleFrames;
+        d->expire([&] (const Entry &e) { return e.frame < old; });
+    }
+    d->trim();
+}
+
+auto OpenGLResourcePool::setBudget(qint64 bytes) -> void
+{
+    d->budget = bytes;
+    d->trim();
+}
+
+auto OpenGLResourcePool::budget() const -> qint64
+{
+    return d->budget;
+}
+
+auto OpenGLResourcePool::clear() -> void
+{
+    d->expire([] (const Entry&) { return true; });
+}
+
+auto OpenGLResourcePool::stats() const -> Stats
+{
+    return d->stats;
+}
+
+auto OpenGLResourcePool::toMap() const -> QVariantMap
+{
+    const auto &s = d->stats;
+    QVariantMap map;
+    map[u"usedBytes"_q] = s.usedBytes;
+    map[u"freeBytes"_q] = s.freeBytes;
+    map[u"peakBytes"_q] = s.peakBytes;
+    map[u"used"_q] = s.used;
+    map[u"free"_q] = s.free;
+    map[u"hits"_q] = qint64(s.hits);
+    map[u"resized"_q] = qint64(s.resized);
+    map[u"misses"_q] = qint64(s.misses);
+    map[u"deleted"_q] = qint64(s.deleted);
+    return map;
+}
+
+auto OpenGLResourcePool::bytesPerPixel(OGL::TextureFormat format) -> int
+{
+    switch (format) {
+    case OGL::R8_UNorm:
+    case OGL::Luminance8_UNorm:
+        return 1;
+    case OGL::RG8_UNorm:
+    case OGL::R16_UNorm:
+    case OGL::Luminance16_UNorm:
+    case OGL::LuminanceAlpha8_UNorm:
+    case OGL::YCbCr_UNorm_Mesa:
+    case OGL::R16F:
+        return 2;
+    case OGL::RGB8_UNorm:
+        return 3;
+    case OGL::RGBA8_UNorm:
+    case OGL::RG16_UNorm:
+    case OGL::LuminanceAlpha16_UNorm:
+    case OGL::RG16F:
+    case OGL::R32F:
+        return 4;
+    case OGL::RGB16_UNorm:
+    case OGL::RGB16F:
+        return 6;
+    case OGL::RGBA16_UNorm:
+    case OGL::RGBA16F:
+    case OGL::RG32F:
+        return 8;
+    case OGL::RGB32F:
+        return 12;
+    case OGL::RGBA32F:
+        return 16;
+    case OGL::NoTextureFormat:
+        return 0;
+    }
+    return 4;
+}
@@ -0,0 +1,56 @@
+#ifndef OPENGLRESOURCEPOOL_HPP
+#define OPENGLRESOURCEPOOL_HPP
+
+#include "openglmisc.hpp"
+
+class OpenGLFramebufferObject;          class OpenGLTexture2D;
+class OpenGLTextureTransferInfo;
+
+// FBOs and textures of a context which are kept after release for reuse
+// released ones are bucketed by (size class, format); a request takes one of
+// the same size, or resizes one of the same class in place, before creating
+// a new one. an object released in a frame is reused from next frame only, so
+// that drawing into it never waits for the pending draws of its last user.
+// unused objects are deleted after a while, or when over budget.
+// all functions must be called with the context current
+class OpenGLResourcePool {
+public:
+    struct Stats {
+        qint64 usedBytes = 0, freeBytes = 0, peakBytes = 0;
+        int used = 0, free = 0;
+        quint64 hits = 0, resized = 0, misses = 0, deleted = 0;
+    };
+    // unused objects are deleted after this many frames, about 10s in 60Hz
+    static constexpr int MaxIdleFrames = 600;
+    ~OpenGLResourcePool();
+    // pool for current context, created at first use and deleted with context
+    static auto current() -> OpenGLResourcePool*;
+    // object with texture of given size and format; empty size is allowed, but
+    // then not pooled
+    auto takeFramebufferObject(const QSize &size,
+                               OGL::TextureFormat format = OGL::RGBA8_UNorm)
+        -> OpenGLFramebufferObject*;
+    // fbo can be null or created outside of pool
+    auto release(OpenGLFramebufferObject *fbo) -> void;
+    // texture created with linear filter and edge clamping
+    auto takeTexture(const QSize &size, const OpenGLTextureTransferInfo &info)
+        -> OpenGLTexture2D;
+    // texture can be invalid or created outside of pool
+    auto release(const OpenGLTexture2D &texture) -> void;
+    // call after each frame to expire unused objects
+    auto endFrame() -> void;
+    // maximum bytes of unused objects
+    auto setBudget(qint64 bytes) -> void;
+    auto budget() const -> qint64;
+    // delete all unused objects
+    auto clear() -> void;
+    auto stats() const -> Stats;
+    auto toMap() const -> QVariantMap;
+    static auto bytesPerPixel(OGL::TextureFormat format) -> int;
+private:
+    OpenGLResourcePool();
+    struct Data;
+    Data *d;
+};
+
+#endif // OPENGLRESOURCEPOOL_HPP
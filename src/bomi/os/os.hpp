@@ -27,6 +27,10 @@ auto processTime() -> quint64; // us
 auto systemTime()  -> quint64; // us
 auto totalMemory() -> double;
 auto usingMemory() -> double;
+auto peakMemory() -> double;
+
+struct ThreadTime { QString name; quint64 usec = 0; };
+auto threadTimes() -> QHash<quint64, ThreadTime>; // by thread id, empty if not supported
 
 auto defaultFont() -> QFont;
 auto defaultFixedFont() -> QFont;
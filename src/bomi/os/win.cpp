@@ -522,6 +522,19 @@ auto usingMemory() -> double
     return counters.WorkingSetSize/double(1024*1024);
 }
 
+auto peakMemory() -> double
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(d->proc, &counters, sizeof(counters)))
+        return 0.0;
+    return counters.PeakWorkingSetSize/double(1024*1024);
+}
+
+auto threadTimes() -> QHash<quint64, ThreadTime>
+{
+    return QHash<quint64, ThreadTime>();
+}
+
 auto canShutdown() -> bool
 {
     if (d->shutdownToken)
@@ -15,6 +15,7 @@
 #include <fcntl.h>
 #include <time.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <sys/sysctl.h>
 #include <sys/types.h>
 #include <xcb/xcb.h>
@@ -575,6 +576,39 @@ auto usingMemory() -> double
     return resident * sysconf(_SC_PAGESIZE) / double(1024*1024);
 }
 
+auto peakMemory() -> double
+{
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) < 0)
+        return 0;
+    return usage.ru_maxrss / 1024.0;
+}
+
+auto threadTimes() -> QHash<quint64, ThreadTime>
+{
+    QHash<quint64, ThreadTime> times;
+    const auto tick = sysconf(_SC_CLK_TCK);
+    QDir dir(u"/proc/self/task"_q);
+    for (auto &tid : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile file(dir.filePath(tid) % "/stat"_a);
+        if (!file.open(QFile::ReadOnly))
+            continue;
+        const auto stat = file.readAll();
+        // name is in parentheses and may contain spaces or parentheses
+        const int open = stat.indexOf('('), close = stat.lastIndexOf(')');
+        if (open < 0 || close < open)
+            continue;
+        const auto fields = stat.mid(close + 2).split(' ');
+        if (fields.size() < 13)
+            continue;
+        auto &t = times[tid.toULongLong()];
+        t.name = QString::fromLocal8Bit(stat.mid(open + 1, close - open - 1));
+        // utime and stime
+        t.usec = (fields[11].toULongLong() + fields[12].toULongLong()) * 1000000llu / tick;
+    }
+    return times;
+}
+
 /******************************************************************************/
 
 struct HwAccCodec {
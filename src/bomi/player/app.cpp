@@ -8,6 +8,7 @@
 #include "misc/objectstorage.hpp"
 #include "quick/appobject.hpp"
 #include "rootmenu.hpp"
+#include "misc/dirindex.hpp"
 #include "os/os.hpp"
 #include <clocale>
 #include <QStyleFactory>
@@ -42,7 +43,7 @@ auto translator_load(const Locale &locale) -> bool;
 enum class LineCmd {
     Wake, Open, Action, LogLevel, Debug,
     DumpApiTree, DumpActionList, WinAssoc, WinUnassoc, WinAssocDefault,
-    SetSubtitle, AddSubtitle,
+    SetSubtitle, AddSubtitle, DecodeLog
 };
 
 static const QCommandLineOption s_dummy{u"__dummy__"_q};
@@ -235,6 +236,7 @@ App::App(int &argc, char **argv)
 #endif
 
     OS::initialize();
+    DirIndex::initialize();
 
     _New(d->parser);
     d->parser->addOption(LineCmd::Open, u"open"_q,
@@ -256,6 +258,8 @@ App::App(int &argc, char **argv)
                          u"Dump API structure tree to stdout."_q);
     d->parser->addOption(LineCmd::DumpActionList, u"dump-action-list"_q,
                          u"Dump executable action list to stdout."_q);
+    d->parser->addOption(LineCmd::DecodeLog, u"decode-log"_q,
+                         u"Print binary log %1 written to *.binlog to stdout."_q, u"file"_q);
 #ifdef Q_OS_WIN
     d->parser->addOption(LineCmd::WinAssoc, u"win-assoc"_q,
                          u"Associate given comma-separated extension list."_q, u"ext"_q);
@@ -325,6 +329,8 @@ App::~App() {
     delete d;
     OS::finalize();
     RootMenu::finalize();
+    DirIndex::finalize();
+    Log::finalize();
     delete d->parser;
 }
 
@@ -346,6 +352,8 @@ auto App::executeToQuit() -> bool
         AppObject::dumpInfo();
     if (isSet(LineCmd::DumpActionList))
         RootMenu::dumpInfo();
+    if (isSet(LineCmd::DecodeLog))
+        Log::decode(d->parser->value(LineCmd::DecodeLog));
     if (isSet(LineCmd::WinAssoc))
         OS::associateFileTypes(nullptr, true, d->parser->value(LineCmd::WinAssoc).split(','_q));
     if (isSet(LineCmd::WinAssocDefault))
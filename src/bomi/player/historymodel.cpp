@@ -1,11 +1,14 @@
 #include "historymodel.hpp"
 #include "mrlstatesqlfield.hpp"
 #include "misc/log.hpp"
+#include "misc/dataevent.hpp"
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QQuickItem>
 #include <QSqlQuery>
 #include <QSqlRecord>
+#include <QElapsedTimer>
+#include <QCache>
 
 DECLARE_LOG_CONTEXT(History)
 
@@ -39,23 +42,426 @@ private:
     bool m_commit = true, m_doing = false;
 };
 
-struct RowCache { Mrl mrl; int row = -1; };
-
 static constexpr auto currentVersion = MrlState::Version;
+static constexpr int PageSize = 128, PageCacheSize = 64, ScanBatch = 64;
+static constexpr int StateCacheSize = 64, CommitDelay = 200;
+
+enum EventType { Loaded = QEvent::User + 1, Committed };
+
+// starred ones come first and each segment is ordered by (last, mrl)
+enum Segment { Starred, Others, End };
+
+struct HistoryKey {
+    int segment = Starred;
+    qint64 last = 0;
+    QString mrl;
+    bool bounded = false; // unbounded key points the start of segment
+};
+
+struct HistoryRow {
+    Mrl mrl;
+    QString id, name, latest;
+    qint64 last = 0;
+    bool star = false;
+    auto key() const -> HistoryKey
+        { return { star ? Starred : Others, last, id, true }; }
+};
+
+using HistoryPage = QVector<HistoryRow>;
+
+// Walks the table in keyset pages on its own connection.
+// Only the first key of each page is kept here, rows are decoded on request.
+class HistoryLoader : public QThread {
+public:
+    HistoryLoader(const QSqlDatabase &db, const QString &table, QObject *receiver)
+        : m_source(db), m_table(table), m_receiver(receiver) { }
+    ~HistoryLoader() { finish(); }
+    auto reload(int generation) -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        m_reset = generation;
+        m_requests.clear();
+        m_wait.wakeAll();
+    }
+    auto request(int page) -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        m_requests.push_back(page);
+        m_wait.wakeAll();
+    }
+    auto finish() -> void
+    {
+        m_mutex.lock();
+        m_quit = true;
+        m_wait.wakeAll();
+        m_mutex.unlock();
+        wait();
+    }
+private:
+    auto run() -> void final;
+    auto exec(int segment, const HistoryKey &key,
+              const QString &columns, const QString &tail) -> bool;
+    auto fetch(const HistoryKey &from, int limit) -> HistoryPage;
+    auto skip(const HistoryKey &from, int count, int *skipped) -> HistoryKey;
+    auto post(int page, const HistoryPage &rows) -> void
+        { _PostEvent(m_receiver, Loaded, m_generation, page, rows, m_rows, m_done); }
+    QSqlDatabase m_source;
+    const QString m_table;
+    QObject *m_receiver = nullptr;
+    QSqlQuery m_query;
+    QMutex m_mutex;
+    QWaitCondition m_wait;
+    QList<int> m_requests;
+    QVector<HistoryKey> m_starts;
+    HistoryKey m_next;
+    int m_reset = -1, m_generation = -1, m_rows = 0;
+    bool m_quit = false, m_done = true;
+};
+
+auto HistoryLoader::run() -> void
+{
+    const auto name = u"history-loader-%1"_q.arg((quintptr)this);
+    {
+        auto db = QSqlDatabase::cloneDatabase(m_source, name);
+        if (!db.open()) {
+            _Error("Cannot open database for loader: %%", db.lastError().text());
+            return;
+        }
+        m_query = QSqlQuery(db);
+        forever {
+            int page = -1;
+            m_mutex.lock();
+            while (!m_quit && m_reset < 0 && m_requests.isEmpty() && m_done)
+                m_wait.wait(&m_mutex);
+            if (m_quit) {
+                m_mutex.unlock();
+                break;
+            }
+            if (m_reset >= 0) {
+                m_generation = m_reset;
+                m_reset = -1;
+                m_starts.clear();
+                m_rows = 0;
+                m_done = false;
+            }
+            // the latest request is likely what the view is showing now
+            if (!m_requests.isEmpty())
+                page = m_requests.takeLast();
+            m_mutex.unlock();
+
+            if (page >= 0) {
+                if (page < m_starts.size())
+                    post(page, fetch(m_starts[page], PageSize));
+            } else if (m_starts.isEmpty()) {
+                auto rows = fetch(HistoryKey(), PageSize + 1);
+                m_starts.push_back(HistoryKey());
+                if (rows.size() > PageSize)
+                    m_next = rows.takeLast().key();
+                else
+                    m_next.segment = End;
+                m_rows = rows.size();
+                m_done = m_next.segment == End;
+                post(0, rows);
+            } else {
+                for (int i = 0; i < ScanBatch && m_next.segment != End; ++i) {
+                    int skipped = 0;
+                    m_starts.push_back(m_next);
+                    m_next = skip(m_next, PageSize, &skipped);
+                    m_rows += skipped;
+                }
+                m_done = m_next.segment == End;
+                post(-1, HistoryPage());
+            }
+        }
+        m_query = QSqlQuery();
+    }
+    QSqlDatabase::removeDatabase(name);
+}
+
+auto HistoryLoader::exec(int segment, const HistoryKey &key,
+                         const QString &columns, const QString &tail) -> bool
+{
+    QString sql = "SELECT "_a % columns % " FROM "_a % m_table % " WHERE star = ?"_a;
+    const bool bounded = key.bounded && key.segment == segment;
+    if (bounded)
+        sql += " AND (last_played_date_time < ?"
+               " OR (last_played_date_time = ? AND mrl <= ?))"_a;
+    m_query.prepare(sql % tail);
+    m_query.addBindValue(int(segment == Starred));
+    if (bounded) {
+        m_query.addBindValue(key.last);
+        m_query.addBindValue(key.last);
+        m_query.addBindValue(key.mrl);
+    }
+    if (m_query.exec())
+        return true;
+    _Error("Error on query: %% for %%"
+           , m_query.lastError().text(), m_query.lastQuery());
+    return false;
+}
+
+auto HistoryLoader::fetch(const HistoryKey &from, int limit) -> HistoryPage
+{
+    HistoryPage rows;
+    rows.reserve(limit);
+    for (int seg = from.segment; seg < End && rows.size() < limit; ++seg) {
+        const auto tail = u" ORDER BY last_played_date_time DESC, mrl DESC"
+                          " LIMIT %1"_q.arg(limit - rows.size());
+        if (!exec(seg, from, u"mrl, name, last_played_date_time, device"_q, tail))
+            break;
+        while (m_query.next()) {
+            HistoryRow row;
+            row.id = m_query.value(0).toString();
+            row.name = m_query.value(1).toString();
+            row.last = m_query.value(2).toLongLong();
+            row.mrl = Mrl::fromUniqueId(row.id, m_query.value(3).toString(), row.name);
+            row.latest = QDateTime::fromMSecsSinceEpoch(row.last).toString(Qt::ISODate);
+            row.star = seg == Starred;
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+auto HistoryLoader::skip(const HistoryKey &from, int count, int *skipped) -> HistoryKey
+{
+    int remaining = count;
+    for (int seg = from.segment; seg < End; ++seg) {
+        const auto tail = u" ORDER BY last_played_date_time DESC, mrl DESC"
+                          " LIMIT 1 OFFSET %1"_q.arg(remaining);
+        if (!exec(seg, from, u"last_played_date_time, mrl"_q, tail))
+            break;
+        if (m_query.next()) {
+            *skipped = count;
+            return { seg, m_query.value(0).toLongLong(),
+                     m_query.value(1).toString(), true };
+        }
+        if (!exec(seg, from, u"COUNT(*)"_q, QString()) || !m_query.next())
+            break;
+        remaining -= m_query.value(0).toInt();
+    }
+    *skipped = count - remaining;
+    HistoryKey end;
+    end.segment = End;
+    return end;
+}
+
+struct HistoryWrite {
+    QVariant mrl;
+    QMap<QString, QVariant> set; // sorted to share statements between writes
+    QVector<QVariant> insert; // every column, used when no row is updated
+};
+
+// Commits queued writes in one transaction on its own connection.
+// Writes for the same mrl are merged while they wait in queue.
+class HistoryWriter : public QThread {
+public:
+    HistoryWriter(const QSqlDatabase &db, const QString &table,
+                  const QStringList &columns, QObject *receiver);
+    ~HistoryWriter() { finish(); }
+    auto write(HistoryWrite &&w) -> void;
+    auto isPending(const QVariant &mrl) const -> bool;
+    auto isIdle() const -> bool;
+    auto flush() -> void;
+    auto finish() -> void;
+private:
+    auto run() -> void final;
+    auto commit(const QList<HistoryWrite> &batch) -> void;
+    auto query(const QString &sql) -> QSqlQuery&;
+    QSqlDatabase m_source, m_db;
+    const QString m_table;
+    const QStringList m_columns;
+    QString m_insert;
+    QHash<QString, QSqlQuery> m_queries;
+    QObject *m_receiver = nullptr;
+    mutable QMutex m_mutex;
+    QWaitCondition m_wait, m_idle;
+    QList<HistoryWrite> m_queue;
+    QHash<QString, int> m_index;
+    bool m_quit = false, m_flush = false, m_busy = false;
+    quint64 m_commits = 0, m_writes = 0, m_coalesced = 0;
+    double m_lastCommit = 0, m_maxCommit = 0, m_totalCommit = 0;
+};
+
+HistoryWriter::HistoryWriter(const QSqlDatabase &db, const QString &table,
+                             const QStringList &columns, QObject *receiver)
+    : m_source(db), m_table(table), m_columns(columns), m_receiver(receiver)
+{
+    const auto phs = _ToStringList(columns, [] (const QString &) {
+        return QString('?'_q);
+    }).join(','_q);
+    m_insert = u"INSERT OR REPLACE INTO %1 (%2) VALUES (%3)"_q
+            .arg(table).arg(columns.join(','_q)).arg(phs);
+}
+
+auto HistoryWriter::write(HistoryWrite &&w) -> void
+{
+    QMutexLocker locker(&m_mutex);
+    const auto key = w.mrl.toString();
+    const auto it = m_index.constFind(key);
+    if (it == m_index.cend()) {
+        m_index.insert(key, m_queue.size());
+        m_queue.push_back(std::move(w));
+    } else {
+        auto &old = m_queue[*it];
+        if (!w.insert.isEmpty())
+            old.insert = std::move(w.insert);
+        for (auto s = w.set.cbegin(); s != w.set.cend(); ++s)
+            old.set[s.key()] = s.value();
+        ++m_coalesced;
+    }
+    m_wait.wakeAll();
+}
+
+auto HistoryWriter::isPending(const QVariant &mrl) const -> bool
+{
+    QMutexLocker locker(&m_mutex);
+    return m_busy || m_index.contains(mrl.toString());
+}
+
+auto HistoryWriter::isIdle() const -> bool
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_busy && m_queue.isEmpty();
+}
+
+auto HistoryWriter::flush() -> void
+{
+    QMutexLocker locker(&m_mutex);
+    if (!isRunning())
+        return;
+    m_flush = true;
+    m_wait.wakeAll();
+    while (m_busy || !m_queue.isEmpty())
+        m_idle.wait(&m_mutex);
+}
+
+auto HistoryWriter::finish() -> void
+{
+    m_mutex.lock();
+    m_quit = true;
+    m_wait.wakeAll();
+    m_mutex.unlock();
+    wait();
+}
+
+auto HistoryWriter::run() -> void
+{
+    const auto name = u"history-writer-%1"_q.arg((quintptr)this);
+    m_db = QSqlDatabase::cloneDatabase(m_source, name);
+    if (!m_db.open())
+        _Error("Cannot open database for writer: %%", m_db.lastError().text());
+    else {
+        forever {
+            m_mutex.lock();
+            while (!m_quit && m_queue.isEmpty())
+                m_wait.wait(&m_mutex);
+            if (m_queue.isEmpty()) {
+                m_mutex.unlock();
+                break;
+            }
+            // let following writes join this transaction
+            QElapsedTimer timer;
+            timer.start();
+            while (!m_quit && !m_flush && timer.elapsed() < CommitDelay)
+                m_wait.wait(&m_mutex, CommitDelay - timer.elapsed());
+            const auto batch = m_queue;
+            m_queue.clear();
+            m_index.clear();
+            m_busy = true;
+            m_flush = false;
+            m_mutex.unlock();
+
+            commit(batch);
+
+            m_mutex.lock();
+            m_busy = false;
+            m_idle.wakeAll();
+            m_mutex.unlock();
+        }
+    }
+    m_queries.clear();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(name);
+}
+
+auto HistoryWriter::query(const QString &sql) -> QSqlQuery&
+{
+    auto it = m_queries.find(sql);
+    if (it == m_queries.end()) {
+        it = m_queries.insert(sql, QSqlQuery(m_db));
+        it->prepare(sql);
+    }
+    return *it;
+}
+
+auto HistoryWriter::commit(const QList<HistoryWrite> &batch) -> void
+{
+    auto check = [] (QSqlQuery &query) {
+        if (query.exec())
+            return true;
+        _Error("Error on query: %% for %%"
+               , query.lastError().text(), query.lastQuery());
+        return false;
+    };
+    QElapsedTimer timer;
+    timer.start();
+    Transactor t(&m_db);
+    for (auto &w : batch) {
+        const auto sets = _ToStringList(w.set.keys(), [] (const QString &column) {
+            return QString(column % "=?"_a);
+        }).join(','_q);
+        auto &update = query(u"UPDATE %1 SET %2 WHERE mrl=?"_q.arg(m_table, sets));
+        int i = 0;
+        for (auto &value : w.set)
+            update.bindValue(i++, value);
+        update.bindValue(i, w.mrl);
+        if (!check(update) || update.numRowsAffected() > 0 || w.insert.isEmpty())
+            continue;
+        auto &insert = query(m_insert);
+        for (int i = 0; i < m_columns.size(); ++i)
+            insert.bindValue(i, w.set.value(m_columns[i], w.insert[i]));
+        check(insert);
+    }
+    t.done();
+
+    m_mutex.lock();
+    m_lastCommit = timer.nsecsElapsed() * 1e-6;
+    m_maxCommit = qMax(m_maxCommit, m_lastCommit);
+    m_totalCommit += m_lastCommit;
+    ++m_commits;
+    m_writes += batch.size();
+    QVariantMap stats;
+    stats[u"queue"_q] = m_queue.size();
+    stats[u"batch"_q] = batch.size();
+    stats[u"commits"_q] = m_commits;
+    stats[u"writes"_q] = m_writes;
+    stats[u"coalesced"_q] = m_coalesced;
+    stats[u"lastCommitMs"_q] = m_lastCommit;
+    stats[u"maxCommitMs"_q] = m_maxCommit;
+    stats[u"averageCommitMs"_q] = m_totalCommit / m_commits;
+    m_mutex.unlock();
+    _PostEvent(m_receiver, Committed, stats);
+}
 
 struct HistoryModel::Data {
     HistoryModel *p = nullptr;
     QSqlDatabase db;
-    RowCache rowCache;
-    QSqlQuery loader, finder;
+    HistoryLoader *loader = nullptr;
+    HistoryWriter *writer = nullptr;
+    QCache<int, HistoryPage> pages{PageCacheSize};
+    QSet<int> requested;
+    QSqlQuery finder;
     QSqlError error;
     MrlStateSqlFieldList fields, restores, writes;
-    MrlState cached;
+    QCache<QString, MrlState> states{StateCacheSize};
+    QVariantMap persistence;
     const MrlState default_{};
     const QString table = MrlState::table();
-    bool rememberImage = false, reload = true, visible = false;
+    bool rememberImage = false, visible = false, loading = false, reset = false;
+    bool reloadOnCommit = false;
     bool mediaTitleLocal = false, mediaTitleUrl = false;
-    int idx_mrl, idx_name, idx_last, idx_device, idx_star, rows = 0;
+    int rows = 0, generation = 0;
     QMutex mutex;
     auto check(const QSqlQuery &query) -> bool
     {
@@ -65,10 +471,64 @@ struct HistoryModel::Data {
                , query.lastError().text(), query.lastQuery());
         return false;
     }
+    auto key(const Mrl &mrl) const -> QVariant
+        { return fields.field(u"mrl"_q).sqlData(QVariant::fromValue(mrl)); }
+    // full state of mrl, read through the cache
+    auto state(const Mrl &mrl) -> MrlState*
+    {
+        const auto key = this->key(mrl);
+        if (auto state = states.object(key.toString()))
+            return state;
+        if (writer && writer->isPending(key))
+            writer->flush();
+        auto state = new MrlState;
+        if (!fields.select(finder, state, mrl)) {
+            delete state;
+            return nullptr;
+        }
+        state->set_mrl(mrl);
+        states.insert(key.toString(), state);
+        return state;
+    }
+    auto write(const MrlState *state) -> void
+    {
+        if (!writer)
+            return;
+        HistoryWrite w;
+        w.mrl = key(state->mrl());
+        w.insert.reserve(fields.size());
+        for (auto &f : fields)
+            w.insert.push_back(f.sqlData(f.property().read(state)));
+        for (auto &f : writes)
+            w.set.insert(_L(f.property().name()), f.sqlData(f.property().read(state)));
+        // star is kept for existing row
+        if (auto cached = states.object(w.mrl.toString())) {
+            const auto star = cached->star();
+            cached->copyFrom(state);
+            cached->set_star(star);
+        }
+        writer->write(std::move(w));
+    }
+    auto write(const Mrl &mrl, const MrlStateSqlField &f, const QVariant &value) -> void
+    {
+        if (!writer)
+            return;
+        HistoryWrite w;
+        w.mrl = key(mrl);
+        w.set.insert(_L(f.property().name()), f.sqlData(value));
+        if (auto cached = states.object(w.mrl.toString()))
+            f.property().write(cached, value);
+        writer->write(std::move(w));
+    }
+    auto reloadAfterCommit() -> void
+    {
+        if (writer && !writer->isIdle())
+            reloadOnCommit = true;
+        else
+            load();
+    }
     auto upsert(const MrlState *state) -> bool
     {
-        if (state->mrl() == cached.mrl())
-            cached.set_mrl(Mrl());
         if (!writes.update(finder, state))
             return check(finder);
         if (finder.numRowsAffected() > 0)
@@ -76,39 +536,32 @@ struct HistoryModel::Data {
         fields.insert(finder, state);
         return check(finder);
     }
+    auto setLoading(bool on) -> void
+    {
+        if (_Change(loading, on))
+            emit p->loadingChanged(loading);
+    }
+    // current rows stay visible until the first page of new generation comes
     auto load() -> bool
     {
-        const QString select = QString::fromLatin1(
-            "SELECT mrl, name, last_played_date_time, device, star"
-            ", (SELECT COUNT(*) FROM %1) as total FROM %2 ORDER BY "
-            "CASE WHEN star = 1 THEN 1 ELSE 0 END DESC"
-            ", last_played_date_time DESC"
-        );
-        if (!loader.exec(select.arg(table).arg(table))) {
-            _Error("%%", loader.lastError().text());
-            _Error("Query: %%", loader.lastQuery());
+        if (!loader)
             return false;
-        }
-        Q_ASSERT(!loader.isForwardOnly());
-        p->beginResetModel();
-        rows = 0;
-        if (loader.next()) {
-            int c = 0;
-            idx_mrl = c++;
-            idx_name = c++;
-            idx_last = c++;
-            idx_device = c++;
-            idx_star = c++;
-            if (_Change(rows,loader.value(c).toInt()))
-                emit p->lengthChanged(rows);
-            loader.seek(-1);
-        }
-        error = QSqlError();
-        p->endResetModel();
-        reload = false;
-        rowCache = RowCache();
+        reset = true;
+        setLoading(true);
+        loader->reload(++generation);
         return true;
     }
+    auto row(int row) -> const HistoryRow*
+    {
+        const int page = row / PageSize;
+        if (auto rows = pages.object(page))
+            return row % PageSize < rows->size() ? &rows->at(row % PageSize) : nullptr;
+        if (!requested.contains(page)) {
+            requested.insert(page);
+            loader->request(page);
+        }
+        return nullptr;
+    }
     auto import(const QVector<MrlState*> &states) -> void
     {
         Transactor t(&db);
@@ -123,16 +576,12 @@ struct HistoryModel::Data {
             delete state;
         }
     }
-    auto getMrl() const -> Mrl
-    {
-        const auto id = loader.value(idx_mrl).toString();
-        const auto dev = loader.value(idx_device).toString();
-        const auto name = loader.value(idx_name).toString();
-        return Mrl::fromUniqueId(id, dev, name);
-    }
 };
 
 HistoryModel::HistoryModel(QObject *parent)
+    : HistoryModel(_WritablePath(Location::Config) % "/history.db"_a, parent) { }
+
+HistoryModel::HistoryModel(const QString &path, QObject *parent)
 : QAbstractTableModel(parent), d(new Data) {
     d->p = this;
     auto &metaObject = MrlState::staticMetaObject;
@@ -153,15 +602,15 @@ HistoryModel::HistoryModel(QObject *parent)
     d->writes.prepareUpdate(d->table, d->fields.field(u"mrl"_q));
     setPropertiesToRestore(QStringList());
 
-    d->db = QSqlDatabase::addDatabase(u"QSQLITE"_q, u"history-model"_q);
-    d->db.setDatabaseName(_WritablePath(Location::Config) % "/history.db"_a);
+    d->db = QSqlDatabase::addDatabase(u"QSQLITE"_q, u"history-model-%1"_q
+                                      .arg((quintptr)this));
+    d->db.setDatabaseName(path);
     if (!d->db.open()) {
         _Error("Error: %%. Couldn't create database.",
                d->db.lastError().text());
         return;
     }
 
-    d->loader = QSqlQuery(d->db);
     d->finder = QSqlQuery(d->db);
 
     d->finder.exec(u"PRAGMA journal_mode = WAL"_q);
@@ -189,11 +638,96 @@ HistoryModel::HistoryModel(QObject *parent)
             }
         }
     }
+    // pages are selected by star = 0/1 and (last, mrl), which this index covers
+    d->finder.exec("UPDATE "_a % d->table % " SET star = 0 WHERE star IS NULL OR star != 1"_a);
+    d->check(d->finder);
+    d->finder.exec(u"CREATE INDEX IF NOT EXISTS %1_history ON %1"
+                   " (star, last_played_date_time, mrl)"_q.arg(d->table));
+    d->check(d->finder);
+
+    const auto columns = _ToStringList(d->fields, [] (const MrlStateSqlField &f) {
+        return QString::fromLatin1(f.property().name());
+    });
+    d->writer = new HistoryWriter(d->db, d->table, columns, this);
+    d->writer->start();
+    d->loader = new HistoryLoader(d->db, d->table, this);
+    d->loader->start();
     d->load();
 }
 
 HistoryModel::~HistoryModel() {
+    delete d->writer; // commits what is left in queue
+    delete d->loader;
+    const auto name = d->db.connectionName();
+    d->finder = QSqlQuery();
+    d->db.close();
     delete d;
+    QSqlDatabase::removeDatabase(name);
+}
+
+auto HistoryModel::customEvent(QEvent *event) -> void
+{
+    if (event->type() == Committed) {
+        d->persistence = _MoveData<QVariantMap>(event);
+        emit persistenceChanged();
+        if (d->reloadOnCommit && d->writer->isIdle()) {
+            d->reloadOnCommit = false;
+            d->load();
+        }
+        return;
+    }
+    if (event->type() != Loaded)
+        return;
+    int generation = 0, page = -1, rows = 0; bool done = false;
+    HistoryPage data;
+    _TakeData(event, generation, page, data, rows, done);
+    if (generation != d->generation)
+        return;
+    if (d->reset) {
+        beginResetModel();
+        d->reset = false;
+        d->pages.clear();
+        d->requested.clear();
+        d->rows = rows;
+        if (page >= 0)
+            d->pages.insert(page, new HistoryPage(std::move(data)));
+        d->error = QSqlError();
+        endResetModel();
+        emit lengthChanged(d->rows);
+    } else {
+        if (page >= 0) {
+            d->requested.remove(page);
+            const int first = page * PageSize;
+            const int last = qMin(d->rows, first + data.size()) - 1;
+            d->pages.insert(page, new HistoryPage(std::move(data)));
+            if (first <= last)
+                emit dataChanged(index(first, 0), index(last, columnCount() - 1));
+        }
+        if (rows > d->rows) {
+            beginInsertRows(QModelIndex(), d->rows, rows - 1);
+            d->rows = rows;
+            endInsertRows();
+            emit lengthChanged(d->rows);
+        }
+    }
+    if (done)
+        d->setLoading(false);
+}
+
+auto HistoryModel::isLoading() const -> bool
+{
+    return d->loading;
+}
+
+auto HistoryModel::persistence() const -> QVariantMap
+{
+    return d->persistence;
+}
+
+auto HistoryModel::flush() -> void
+{
+    if (d->writer)
+        d->writer->flush();
 }
 
 auto HistoryModel::rowCount(const QModelIndex &index) const -> int
@@ -213,11 +747,11 @@ auto HistoryModel::getState(MrlState *state) const -> bool
         return false;
     if (d->restores.isEmpty())
         return true;
-    Q_ASSERT(d->restores.isSelectPrepared());
-    if (d->cached.mrl() != state->mrl())
-        return d->restores.select(d->finder, state);
+    auto cached = d->state(state->mrl());
+    if (!cached)
+        return false;
     for (auto &f : d->restores)
-        f.property().write(state, f.property().read(&d->cached));
+        f.property().write(state, f.property().read(cached));
     return true;
 }
 
@@ -226,64 +760,45 @@ auto HistoryModel::find(const Mrl &mrl) const -> const MrlState*
     QMutexLocker locker(&d->mutex);
     if (!mrl.isUnique())
         return nullptr;
-    if (d->cached.mrl() == mrl)
-        return &d->cached;
     Q_ASSERT(d->fields.isSelectPrepared());
-    if (!d->fields.select(d->finder, &d->cached, mrl))
-        return nullptr;
-    d->cached.set_mrl(mrl);
-    return &d->cached;
+    return d->state(mrl);
 }
 
 auto HistoryModel::play(int row) -> void
 {
-    QMutexLocker locker(&d->mutex);
-    if (_InRange0(row, d->rows) && d->loader.seek(row))
-        emit playRequested(d->getMrl());
+    if (!_InRange0(row, d->rows))
+        return;
+    if (auto r = d->row(row))
+        emit playRequested(r->mrl);
 }
 
 auto HistoryModel::setShowMediaTitleInName(bool local, bool url) -> void
 {
-    if (_Change(d->mediaTitleLocal, local) | _Change(d->mediaTitleUrl, url))
-        d->load();
+    if ((_Change(d->mediaTitleLocal, local) | _Change(d->mediaTitleUrl, url))
+            && d->rows > 0)
+        emit dataChanged(index(0, 0), index(d->rows - 1, columnCount() - 1),
+                         { NameRole });
 }
 
 auto HistoryModel::getData(const int row, int role) const -> QVariant
 {
-    if (d->reload) {
-        d->load();
-        d->reload = false;
-    }
-    if (!(0 <= row && row < d->rows))
-        return QVariant();
-    if (!d->loader.seek(row))
+    if (!_InRange0(row, d->rows))
         return QVariant();
-    if (d->rowCache.row != row) {
-        d->rowCache.row = row;
-        d->rowCache.mrl = Mrl();
-    }
-    auto fillMrl = [this] () -> const Mrl& {
-        if (d->rowCache.mrl.isEmpty())
-            d->rowCache.mrl = d->getMrl();
-        return d->rowCache.mrl;
-    };
+    auto r = d->row(row);
+    if (!r) // avoid undefined in QML until the page arrives
+        return role == StarRole ? QVariant(false) : QVariant(QString());
     switch (role) {
-    case NameRole: {
-        fillMrl();
-        if ((d->rowCache.mrl.isLocalFile() && d->mediaTitleLocal)
-                || (d->rowCache.mrl.isRemoteUrl() && d->mediaTitleUrl)) {
-            const auto name = d->loader.value(d->idx_name).toString();
-            if (!name.isEmpty())
-                return name;
-        }
-        return d->rowCache.mrl.displayName();
-    } case LatestPlayRole: {
-        const auto msecs = d->loader.value(d->idx_last).toLongLong();
-        return QDateTime::fromMSecsSinceEpoch(msecs).toString(Qt::ISODate);
-    } case LocationRole:
-        return fillMrl().toString();
+    case NameRole:
+        if (!r->name.isEmpty() && ((r->mrl.isLocalFile() && d->mediaTitleLocal)
+                || (r->mrl.isRemoteUrl() && d->mediaTitleUrl)))
+            return r->name;
+        return r->mrl.displayName();
+    case LatestPlayRole:
+        return r->latest;
+    case LocationRole:
+        return r->mrl.toString();
     case StarRole:
-        return d->loader.value(d->idx_star);
+        return r->star;
     default:
         return QVariant();
     }
@@ -316,26 +831,19 @@ auto HistoryModel::isStarred(int row) const -> bool
 
 auto HistoryModel::setStarred(int row, bool star) -> void
 {
-    QMutexLocker locker(&d->mutex);
-    if (!d->loader.seek(row)) {
-        _Error("Cannot seek to %% row.", row);
+    auto r = _InRange0(row, d->rows) ? d->row(row) : nullptr;
+    if (!r) {
+        _Error("Row %% is not loaded yet.", row);
         return;
     }
-    const auto mrl = d->getMrl();
-    const auto f = d->fields.field(u"star"_q), m = d->fields.field(u"mrl"_q);
-    Transactor t(&d->db);
-    d->finder.prepare("UPDATE "_a % d->table % " SET star=? WHERE mrl=?"_a);
-    d->finder.bindValue(0, f.sqlData(QVariant::fromValue(star)));
-    d->finder.bindValue(1, m.sqlData(QVariant::fromValue(mrl)));
-    if (!d->finder.exec())
-        qDebug() << d->finder.executedQuery();
-    t.done();
+    QMutexLocker locker(&d->mutex);
+    d->write(r->mrl, d->fields.field(u"star"_q), QVariant::fromValue(star));
     update();
 }
 
 auto HistoryModel::update() -> void
 {
-    d->load();
+    d->reloadAfterCommit();
 }
 
 auto HistoryModel::update(const MrlState *state, const QString &column, bool reload) -> void
@@ -346,15 +854,10 @@ auto HistoryModel::update(const MrlState *state, const QString &column, bool rel
         return;
     if (!state->mrl().isUnique())
         return;
-    const auto f = d->fields.field(column), m = d->fields.field(u"mrl"_q);
-    if (!f.isValid() || !m.isValid())
+    const auto f = d->fields.field(column);
+    if (!f.isValid())
         return;
-    Transactor t(&d->db);
-    d->finder.prepare("UPDATE "_a % d->table % " SET "_a % column % "=? WHERE mrl=?"_a);
-    d->finder.bindValue(0, f.sqlData(f.property().read(state)));
-    d->finder.bindValue(1, m.sqlData(m.property().read(state)));
-    d->finder.exec();
-    t.done();
+    d->write(state->mrl(), f, f.property().read(state));
     if (reload)
         update();
 }
@@ -367,9 +870,7 @@ auto HistoryModel::update(const MrlState *state, bool reload) -> void
         return;
     if (!state->mrl().isUnique())
         return;
-    Transactor t(&d->db);
-    d->upsert(state);
-    t.done();
+    d->write(state);
     if (reload)
         update();
 }
@@ -409,8 +910,10 @@ auto HistoryModel::setPropertiesToRestore(const QStringList &list) -> void
 auto HistoryModel::clear() -> void
 {
     QMutexLocker locker(&d->mutex);
+    flush();
+    d->states.clear();
     Transactor t(&d->db);
-    d->loader.exec("DELETE FROM "_a % d->table % " WHERE star != 1 OR star IS NULL"_a);
+    d->finder.exec("DELETE FROM "_a % d->table % " WHERE star != 1 OR star IS NULL"_a);
     t.done();
     d->load();
 }
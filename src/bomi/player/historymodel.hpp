@@ -9,9 +9,12 @@ class HistoryModel: public QAbstractTableModel {
     Q_OBJECT
     Q_PROPERTY(bool visible READ isVisible WRITE setVisible NOTIFY visibleChanged)
     Q_PROPERTY(int length READ rowCount NOTIFY lengthChanged)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
+    Q_PROPERTY(QVariantMap persistence READ persistence NOTIFY persistenceChanged)
 public:
     enum Role {NameRole = Qt::UserRole + 1, LatestPlayRole, LocationRole, StarRole};
     HistoryModel(QObject *parent = nullptr);
+    HistoryModel(const QString &path, QObject *parent = nullptr);
     ~HistoryModel();
     auto rowCount(const QModelIndex &parent = QModelIndex()) const -> int;
     auto columnCount(const QModelIndex &parent = QModelIndex()) const -> int;
@@ -29,6 +32,9 @@ public:
     auto clear() -> void;
     auto isVisible() const -> bool;
     auto setVisible(bool visible) -> void;
+    auto isLoading() const -> bool;
+    auto persistence() const -> QVariantMap;
+    auto flush() -> void;
     auto update() -> void;
     auto toggle() -> void { setVisible(!isVisible()); }
     Q_INVOKABLE bool isStarred(int row) const;
@@ -39,7 +45,10 @@ signals:
     void changeVisibilityRequested(bool visible);
     void visibleChanged(bool visible);
     void lengthChanged(int length);
+    void loadingChanged(bool loading);
+    void persistenceChanged();
 private:
+    auto customEvent(QEvent *event) -> void final;
     auto getData(int row, int role) const -> QVariant;
     struct Data;
     Data *d;
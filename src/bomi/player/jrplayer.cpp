@@ -2,6 +2,27 @@
 #include "quick/appobject.hpp"
 #include "json/jrcommon.hpp"
 #include "misc/jsonstorage.hpp"
+#include <QQuickItem>
+
+struct JrMethod {
+    QMetaMethod method;
+    QVector<JsonQVariantConverter> params;
+    QList<QByteArray> names;
+};
+
+// method name resolved to property indices from App and the final target
+struct JrTarget {
+    QVector<int> path;
+    int property = -1;
+    JsonQVariantConverter converter;
+    QVector<JrMethod> methods;
+};
+
+// notify signals restart timer, so value is read once per event loop pass
+struct JrWatch {
+    QTimer timer;
+    QMetaObject::Connection connection;
+};
 
 struct JrPlayer::Data {
     AppObject app;
@@ -11,8 +32,135 @@ struct JrPlayer::Data {
     HistoryModel *history;
     WindowObject *window;
 
+    QHash<QString, JrTarget> targets;
+    QHash<QString, JrWatch*> watches;
+
     using ParamArray = std::array<QVariant, 10>;
 
+    auto build(const QMetaObject *mo, const QString &prefix, const QVector<int> &path,
+               QVector<const QMetaObject*> &visiting) -> void
+    {
+        visiting.push_back(mo);
+        for (int i = 0; i < mo->propertyCount(); ++i) {
+            const auto p = mo->property(i);
+            const auto name = QString(prefix % _L(p.name()));
+            if (QByteArray(p.typeName()).startsWith("QQmlListProperty<"))
+                continue; // indexed access is resolved on each request
+            if (auto child = QMetaType::metaObjectForType(p.userType())) {
+                if (!child->inherits(&QQuickItem::staticMetaObject)
+                        && !visiting.contains(child))
+                    build(child, name % '.'_q, QVector<int>(path) << i, visiting);
+                continue;
+            }
+            auto &t = targets[name];
+            t.path = path;
+            t.property = i;
+            t.converter = JsonQVariantConverter(p.userType());
+        }
+        for (int i = 0; i < mo->methodCount(); ++i) {
+            const auto m = mo->method(i);
+            if (m.parameterCount() > 10)
+                continue;
+            JrMethod method;
+            method.method = m;
+            method.names = m.parameterNames();
+            for (int j = 0; j < m.parameterCount(); ++j)
+                method.params.push_back(JsonQVariantConverter(m.parameterType(j)));
+            auto &t = targets[prefix % _L(m.name())];
+            t.path = path;
+            t.methods.push_back(method);
+        }
+        visiting.pop_back();
+    }
+
+    auto find(const QString &name) const -> const JrTarget*
+    {
+        const auto it = name.startsWith("App."_a) ? targets.constFind(name.mid(4))
+                                                  : targets.constFind(name);
+        return it != targets.cend() ? &*it : nullptr;
+    }
+
+    auto read(const JrTarget &t, QObject *object) -> QJsonValue
+    {
+        return t.converter.toJson(object->metaObject()->property(t.property).read(object));
+    }
+
+    auto object(const JrTarget &t) -> QObject*
+    {
+        QObject *object = &app;
+        for (int idx : t.path) {
+            object = object->metaObject()->property(idx).read(object).value<QObject*>();
+            if (!object)
+                return nullptr;
+        }
+        return object;
+    }
+
+    auto invoke(QObject *object, const JrMethod &m, const QJsonValue &json) -> QJsonValue
+    {
+        QList<QVariant> params;
+        params.reserve(m.params.size());
+        if (json.isArray()) {
+            const auto array = json.toArray();
+            if (array.size() != m.params.size())
+                return QJsonValue::Undefined;
+            for (int i = 0; i < m.params.size(); ++i)
+                params.push_back(m.params[i].toQVariant(array.at(i)));
+        } else if (json.isObject()) {
+            const auto object = json.toObject();
+            if (object.size() != m.params.size())
+                return QJsonValue::Undefined;
+            for (int i = 0; i < m.params.size(); ++i)
+                params.push_back(m.params[i].toQVariant(object[_L(m.names[i])]));
+        } else if (!json.isUndefined() || !m.params.isEmpty())
+            return QJsonValue::Undefined;
+        for (auto &param : params) {
+            if (!param.isValid())
+                return QJsonValue::Undefined;
+        }
+        return invoke(object, m.method, params);
+    }
+
+    auto request(const JrRequest &request, const JrTarget &t) -> JrResponse
+    {
+        auto object = this->object(t);
+        if (!object)
+            return _JrErrorResponse(request.id(), JrError::MethodNotFound);
+        const auto params = request.params();
+        if (t.property < 0) {
+            for (auto &m : t.methods) {
+                const auto res = invoke(object, m, params);
+                if (!res.isUndefined())
+                    return { request, res };
+            }
+            return _JrErrorResponse(request.id(), JrError::InvalidParams);
+        }
+        const auto p = object->metaObject()->property(t.property);
+        if (!params.isUndefined()) {
+            QJsonValue value(QJsonValue::Undefined);
+            if (params.isArray()) {
+                const auto array = params.toArray();
+                if (array.size() == 1)
+                    value = array.at(0);
+            } else if (params.isObject()) {
+                const auto object = params.toObject();
+                if (object.size() == 1)
+                    value = object.begin().value();
+            }
+            const auto var = t.converter.toQVariant(value);
+            if (value.isUndefined() || !var.isValid())
+                return _JrErrorResponse(request.id(), JrError::InvalidParams);
+            if (!p.write(object, var))
+                return _JrErrorResponse(request.id(), JrError::MethodNotFound);
+        }
+        const auto res = read(t, object);
+        if (!res.isUndefined())
+            return { request, res };
+        return _JrErrorResponse(request.id(), JrError::InternalError);
+    }
+
+    auto resolve(const JrRequest &request) -> JrResponse;
+
     auto invoke(QObject *object, const QMetaMethod &method, const QList<QVariant> &params) -> QJsonValue
     {
         if (method.parameterCount() > 10)
@@ -64,7 +212,7 @@ struct JrPlayer::Data {
             auto param = _JsonToQVariant(json[_L(names[i])], method.parameterType(i));
             if (!param.isValid())
                 return QJsonValue::Undefined;
-            params.push_back(params);
+            params.push_back(param);
         }
         return invoke(object, method, params);
     }
@@ -73,17 +221,74 @@ struct JrPlayer::Data {
 JrPlayer::JrPlayer(QObject *parent)
     : JrIface(parent), d(new Data)
 {
+    QVector<const QMetaObject*> visiting;
+    d->build(&AppObject::staticMetaObject, QString(), QVector<int>(), visiting);
 }
 
 JrPlayer::~JrPlayer()
 {
+    qDeleteAll(d->watches);
     delete d;
 }
 
 auto JrPlayer::request(const JrRequest &request) -> JrResponse
 {
     Q_ASSERT(request.isValid());
-    QObject *object = &d->app;
+    if (auto t = d->find(request.method()))
+        return d->request(request, *t);
+    return d->resolve(request);
+}
+
+auto JrPlayer::read(const QString &name) -> QJsonValue
+{
+    const auto t = d->find(name);
+    if (!t || t->property < 0)
+        return QJsonValue::Undefined;
+    const auto object = d->object(*t);
+    return object ? d->read(*t, object) : QJsonValue::Undefined;
+}
+
+auto JrPlayer::watch(const QString &name) -> bool
+{
+    if (d->watches.contains(name))
+        return true;
+    const auto t = d->find(name);
+    if (!t || t->property < 0)
+        return false;
+    const auto object = d->object(*t);
+    if (!object)
+        return false;
+    const auto p = object->metaObject()->property(t->property);
+    if (!p.hasNotifySignal())
+        return false;
+    auto w = new JrWatch;
+    w->timer.setSingleShot(true);
+    w->timer.setInterval(0);
+    const auto &tmo = QTimer::staticMetaObject;
+    w->connection = connect(object, p.notifySignal(), &w->timer,
+                            tmo.method(tmo.indexOfSlot("start()")));
+    if (!w->connection) {
+        delete w;
+        return false;
+    }
+    const auto target = *t;
+    connect(&w->timer, &QTimer::timeout, this, [=] () {
+        if (auto object = d->object(target))
+            notify(name, d->read(target, object));
+    });
+    d->watches.insert(name, w);
+    return true;
+}
+
+auto JrPlayer::unwatch(const QString &name) -> void
+{
+    delete d->watches.take(name);
+}
+
+// for names not in table, e.g. indexed list access
+auto JrPlayer::Data::resolve(const JrRequest &request) -> JrResponse
+{
+    QObject *object = &app;
     int pos = 0;
     const auto jrMethod = request.method();
     const auto jrParams = request.params();
@@ -160,11 +365,11 @@ auto JrPlayer::request(const JrRequest &request) -> JrResponse
                 continue;
             QJsonValue res(QJsonValue::Undefined);
             if (jrParams.isArray())
-                res = d->invoke(object, mo->method(i), jrParams.toArray());
+                res = invoke(object, mo->method(i), jrParams.toArray());
             else if (jrParams.isObject())
-                res = d->invoke(object, mo->method(i), jrParams.toObject());
+                res = invoke(object, mo->method(i), jrParams.toObject());
             else if (jrParams.isUndefined())
-                res = d->invoke(object, mo->method(i), QJsonArray());
+                res = invoke(object, mo->method(i), QJsonArray());
             if (!res.isUndefined())
                 return { request, res };
         }
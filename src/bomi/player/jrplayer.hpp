@@ -7,8 +7,12 @@ class JrPlayer : public JrIface {
 public:
     JrPlayer(QObject *parent = nullptr);
     ~JrPlayer();
+    using JrIface::request;
 private:
     auto request(const JrRequest &request) -> JrResponse final;
+    auto read(const QString &name) -> QJsonValue final;
+    auto watch(const QString &name) -> bool final;
+    auto unwatch(const QString &name) -> void final;
     struct Data;
     Data *d;
 };
@@ -4,6 +4,7 @@
 #include "dialog/mbox.hpp"
 #include "dialog/encoderdialog.hpp"
 #include "quick/appobject.hpp"
+#include "opengl/openglresourcepool.hpp"
 #include <QSessionManager>
 
 //DECLARE_LOG_CONTEXT(Main)
@@ -75,6 +76,10 @@ MainWindow::MainWindow()
         m_engine->deleteLater();
         _Debug("Scene graph invalidated.");
     }, Qt::DirectConnection);
+    connect(this, &QQuickView::frameSwapped, this, [] () {
+        if (auto pool = OpenGLResourcePool::current())
+            pool->endFrame();
+    }, Qt::DirectConnection);
     connect(this, &MainWindow::fullscreenChanged, this,
             [=] (bool fs) { d->setCursorVisible(!fs); });
     connect(&cApp, &App::commitDataRequest, this, [=] () { d->commitData(); });
@@ -27,7 +27,11 @@ auto MainWindow::Data::restoreState() -> void
     playlist.setVisible(as.playlist_visible);
     playlist.setRepeat(as.playlist_repeat);
     playlist.setShuffled(as.playlist_shuffled);
-    playlist.setList(recent.lastPlaylist());
+    const auto list = recent.lastPlaylist();
+    if (list.isEmpty())
+        playlist.load(recent.lastPlaylistFile(), Playlist::Binary);
+    else
+        playlist.setList(list);
     if (pref.load_last() && !recent.lastMrl().isEmpty()) {
         load(recent.lastMrl(), false);
         setOpen(recent.lastMrl());
@@ -195,6 +199,8 @@ auto MainWindow::Data::plugEngine() -> void
         const auto next = playlist.checkNextMrl();
         if (!next.isEmpty()) load(next, true, !pref.resume_ignore_in_playlist());
     });
+    connect(&playlist, &PlaylistModel::nextChanged, p, [=] () { preloadNext(); });
+    connect(&playlist, &PlaylistModel::countChanged, p, [=] () { preloadNext(); });
 
     connect(e.media(), &MediaObject::nameChanged, p, [=] () { updateTitle(); });
 
@@ -227,6 +233,10 @@ auto MainWindow::Data::initItems() -> void
     waiter.setSingleShot(true);
     connect(&waiter, &QTimer::timeout, p, [=] () { updateWaitingMessage(); });
 
+    generated.timer.setInterval(0);
+    generated.timer.setSingleShot(true);
+    connect(&generated.timer, &QTimer::timeout, p, [=] () { insertGeneratedPlaylist(); });
+
     singleClick.timer.setSingleShot(true);
     connect(&singleClick.timer, &QTimer::timeout, p,
             [=] () { if (singleClick.action) trigger(singleClick.action); });
@@ -391,7 +401,9 @@ auto MainWindow::Data::commitData() -> void
 {
     static bool first = true;
     if (first) {
-        recent.setLastPlaylist(playlist.list());
+        // partial list would replace complete one saved before
+        if (!playlist.isLoading())
+            recent.setLastPlaylist(playlist.list());
         recent.setLastMrl(e.mrl());
         e.shutdown();
         as.updateWindowGeometry(p);
@@ -515,60 +527,104 @@ auto MainWindow::Data::openMimeData(const QMimeData *md) -> void
         e.addSubtitleFiles(subList, pref.sub_enc());
 }
 
-auto MainWindow::Data::generatePlaylist(const Mrl &mrl) const -> Playlist
+// returns mrl alone and inserts the others later if directory is not indexed yet
+auto MainWindow::Data::generatePlaylist(const Mrl &mrl) -> Playlist
 {
+    const int generation = ++generated.generation;
+    generated.timer.stop();
+    generated.list.clear();
     if (mrl.isCueTrack())
         { Playlist list;  list.load(mrl.cueSheet()); return list; }
     if (!mrl.isLocalFile() || !pref.enable_generate_playlist())
         return Playlist(mrl);
 
+    const auto path = QFileInfo(mrl.toLocalFile()).absolutePath();
+    auto &index = DirIndex::instance();
+    if (const auto dir = index.cached(path)) {
+        const auto list = generatePlaylist(mrl, *dir);
+        return list.isEmpty() ? Playlist(mrl) : list;
+    }
+    index.request(path, p, [=] (const DirListingPtr &dir) {
+        if (generation != generated.generation)
+            return;
+        generated.mrl = mrl;
+        generated.list = generatePlaylist(mrl, *dir);
+        generated.at = generated.list.indexOf(mrl);
+        generated.row = playlist.rowOf(mrl);
+        generated.before = 0;
+        generated.after = generated.at + 1;
+        insertGeneratedPlaylist();
+    });
+    return Playlist(mrl);
+}
+
+auto MainWindow::Data::generatePlaylist(const Mrl &mrl,
+                                        const DirListing &dir) const -> Playlist
+{
     Playlist list;
     const auto mode = pref.generate_playlist();
-    const QFileInfo file(mrl.toLocalFile());
-    const QDir dir = file.dir();
-    const auto filter = _ToNameFilter(pref.exclude_images() ? VideoExt | AudioExt : MediaExt);
-    if (mode == GeneratePlaylist::Folder) {
-        const auto files = dir.entryList(filter, QDir::Files, QDir::Name);
-        for (int i=0; i<files.size(); ++i)
-            list.push_back(dir.absoluteFilePath(files[i]));
-    } else {
-        const auto files = dir.entryInfoList(filter, QDir::Files, QDir::Name);
-        const auto fileName = file.fileName();
-        bool prefix = false, suffix = false;
-        auto it = files.cbegin();
-        for(; it != files.cend(); ++it) {
-            static QRegEx rxs(uR"((\D*)\d+(.*))"_q);
-            const auto ms = rxs.match(fileName);
-            if (!ms.hasMatch())
-                continue;
-            static QRegEx rxt(uR"((\D*)\d+(.*))"_q);
-            const auto mt = rxt.match(it->fileName());
-            if (!mt.hasMatch())
+    const ExtTypes types = pref.exclude_images() ? VideoExt | AudioExt : MediaExt;
+    const auto fileName = QFileInfo(mrl.toLocalFile()).fileName();
+    const DirEntry *file = nullptr;
+    for (auto &entry : dir.files) {
+        if (entry.name == fileName) {
+            file = &entry;
+            break;
+        }
+    }
+    bool prefix = false, suffix = false;
+    for (auto &entry : dir.files) {
+        if (!(entry.type & types))
+            continue;
+        if (mode != GeneratePlaylist::Folder) {
+            if (!file || !file->numbered || !entry.numbered)
                 continue;
             if (!prefix && !suffix) {
-                if (ms.capturedRef(1) == mt.capturedRef(1))
+                if (file->head == entry.head)
                     prefix = true;
-                else if (ms.capturedRef(2) == mt.capturedRef(2))
+                else if (file->tail == entry.tail)
                     suffix = true;
                 else
                     continue;
             } else if (prefix) {
-                if (ms.capturedRef(1) != mt.capturedRef(1))
+                if (file->head != entry.head)
                     continue;
             } else if (suffix) {
-                if (ms.capturedRef(2) != mt.capturedRef(2))
+                if (file->tail != entry.tail)
                     continue;
             }
-            list.append(it->absoluteFilePath());
         }
+        list.push_back(dir.filePath(entry));
     }
+    return list; // already in order of Playlist::sort()
+}
 
-    if (list.size()) {
-        list.sort();
-        return list;
-    } else {
-        return Playlist(mrl);
+// entries after current one go first so that next one is available soon
+auto MainWindow::Data::insertGeneratedPlaylist() -> void
+{
+    static constexpr int Chunk = 500;
+    auto &g = generated;
+    if (g.list.isEmpty())
+        return;
+    if (playlist.value(g.row) != g.mrl) { // edited in the meantime
+        g.list.clear();
+        return;
+    }
+    const int end = g.list.size();
+    if (g.after < end) {
+        const int n = qMin(Chunk, end - g.after);
+        playlist.insert(g.row + g.after - g.at, g.list.mid(g.after, n));
+        g.after += n;
+    } else if (g.before < g.at) {
+        const int n = qMin(Chunk, g.at - g.before);
+        playlist.insert(g.row, g.list.mid(g.before, n));
+        g.before += n;
+        g.row += n;
     }
+    if (g.after < end || g.before < g.at)
+        g.timer.start();
+    else
+        g.list.clear();
 }
 
 auto MainWindow::Data::showMessage(const QString &msg, const bool *force) -> void
@@ -732,6 +788,7 @@ auto MainWindow::Data::applyPref() -> void
     e.setHwAcc_locked(p.enable_hwaccel(), p.hwaccel_codecs());
     e.setDeintOptions_locked(p.deinterlacing());
     e.setMotionIntrplOption_locked(p.motion_interpolation());
+    e.setFramePacing_locked(p.video_frame_pacing(), p.video_frame_pacing_audio());
 
     e.setAudioDevice_locked(p.audio_device());
     e.setVolumeNormalizerOption_locked(p.audio_normalizer());
@@ -744,6 +801,7 @@ auto MainWindow::Data::applyPref() -> void
                                p.sub_ext(), p.sub_prefer_external());
     e.unlock();
     e.reload();
+    preloadNext();
 }
 
 auto MainWindow::Data::updateStaysOnTop() -> void
@@ -841,6 +899,12 @@ auto MainWindow::Data::updateRecentActions(const QList<Mrl> &list) -> void
     }
 }
 
+auto MainWindow::Data::preloadNext() -> void
+{
+    e.setNextMrl(pref.preload_next() ? playlist.nextMrl() : Mrl(),
+                 !pref.resume_ignore_in_playlist());
+}
+
 auto MainWindow::Data::updateMrl(const Mrl &mrl) -> void
 {
     const auto disc = mrl.isDisc();
@@ -25,6 +25,7 @@
 #include "os/os.hpp"
 #include "misc/smbauth.hpp"
 #include "misc/dataevent.hpp"
+#include "misc/dirindex.hpp"
 #include "json/jrserver.hpp"
 #include "player/jrplayer.hpp"
 #include <QUndoCommand>
@@ -117,6 +118,13 @@ struct MainWindow::Data {
     QSharedPointer<IntrplDialog> intrpl, chroma, intrplDown;
     QSharedPointer<EncoderDialog> encoder;
     PlaylistModel playlist;
+    // rest of generated playlist inserted around mrl chunk by chunk
+    struct {
+        Mrl mrl;
+        Playlist list;
+        int at = -1, row = -1, before = 0, after = 0, generation = 0;
+        QTimer timer;
+    } generated;
     QUndoStack undo;
     Downloader downloader;
     TrayIcon *tray = nullptr;
@@ -170,6 +178,7 @@ struct MainWindow::Data {
     auto setVideoSize(const QSize &video) -> void;
     auto updateRecentActions(const QList<Mrl> &list) -> void;
     auto updateMrl(const Mrl &mrl) -> void;
+    auto preloadNext() -> void;
     auto updateTitle() -> void;
     auto showMessage(const QString &msg, const bool *force = nullptr) -> void;
     auto showMessage(const QString &cmd, const QString &desc) -> void
@@ -181,7 +190,9 @@ struct MainWindow::Data {
     auto commitData() -> void;
     auto initWindow() -> void;
     auto initTray() -> void;
-    auto generatePlaylist(const Mrl &mrl) const -> Playlist;
+    auto generatePlaylist(const Mrl &mrl) -> Playlist;
+    auto generatePlaylist(const Mrl &mrl, const DirListing &dir) const -> Playlist;
+    auto insertGeneratedPlaylist() -> void;
     auto openMrl(const Mrl &mrl) -> void;
     auto openMimeData(const QMimeData *md) -> void;
     auto plugEngine() -> void;
@@ -5,6 +5,7 @@
 #include "mainwindow.hpp"
 #include "player/avinfoobject.hpp"
 #include "misc/dataevent.hpp"
+#include <QPointer>
 
 namespace mpris {
 
@@ -279,7 +280,17 @@ Player::Player(QObject *parent)
     });
     connect(&d->started.timer, &QTimer::timeout, this, [=] () {
         d->started.flag = true;
-        d->thread.saveAlbumArt(d->engine->snapshot());
+        // ask mpv for a thumbnail instead of converting the whole frame
+        auto size = d->engine->frameSize();
+        if (size.width() > 512 && size.height() > 512)
+            size = size.width() >= size.height() ? QSize(0, 512) : QSize(512, 0);
+        else
+            size = QSize();
+        QPointer<Player> self(this);
+        d->engine->snapshot(false, size, [=] (const QImage &image) {
+            if (self && d->started.flag)
+                d->thread.saveAlbumArt(image);
+        });
     });
     d->thread.moveToThread(&d->thread);
 }
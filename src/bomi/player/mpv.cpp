@@ -2,12 +2,17 @@
 #include "video/mpvosdrenderer.hpp"
 #include <QOpenGLContext>
 #include <QLibrary>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <atomic>
+#include <deque>
 
 struct PropertyObservation {
     int event;
     const char *name = nullptr;
-    std::function<void(int)> notify = nullptr;      // post from mpv to qt
+    std::function<void(int, mpv_event_property*)> notify = nullptr; // post from mpv to qt
     std::function<void(QEvent*)> process = nullptr; // handle posted event
+    mutable std::atomic<quint64> changes{0}, deliveries{0};
 };
 
 static constexpr const int UpdateEventBegin = QEvent::User + 10000;
@@ -32,7 +37,11 @@ struct Mpv::Data {
     mpv_opengl_cb_context *gl = nullptr;
     MpvOsdRenderer osd;
     bool quit = false;
-    QVector<PropertyObservation> observations;
+    std::deque<PropertyObservation> observations;
+    QElapsedTimer uptime;
+    QMutex mutex;
+    QWaitCondition wakeup;
+    bool wakeupPending = false;
     QVector<std::function<void(mpv_event*)>> events;
     QMap<QByteArray, std::function<void(void)>> hooks;
     int updateEventMax = ::UpdateEventBegin;
@@ -44,6 +53,20 @@ struct Mpv::Data {
         Q_ASSERT(event == observations[event - UpdateEventBegin].event);
         return observations[event - UpdateEventBegin];
     }
+    static auto onWakeup(void *p) -> void
+    {
+        auto d = static_cast<Data*>(p);
+        QMutexLocker locker(&d->mutex);
+        d->wakeupPending = true;
+        d->wakeup.wakeAll();
+    }
+    auto waitWakeup() -> void
+    {
+        QMutexLocker locker(&mutex);
+        while (!wakeupPending)
+            wakeup.wait(&mutex);
+        wakeupPending = false;
+    }
     auto reset()
     {
         quit = false;
@@ -52,6 +75,7 @@ struct Mpv::Data {
         hooks.clear();
         updateEventMax = ::UpdateEventBegin;
         hookId = 0;
+        wakeupPending = false;
     }
 };
 
@@ -70,6 +94,8 @@ auto Mpv::create() -> void
 {
     if (!m_handle) {
         m_handle = mpv_create();
+        mpv_set_wakeup_callback(m_handle, Data::onWakeup, d);
+        d->uptime.start();
         setOption("config", "no");
         setOption("fs", "no");
         setOption("quiet", "yes");
@@ -103,6 +129,9 @@ auto Mpv::initialize(Log::Level lv, bool ogl) -> void
 auto Mpv::destroy() -> void
 {
     if (m_handle) {
+        for (auto &s : observationStats())
+            _Debug("%%: %% changes (%%/s), %% deliveries", s.name, s.changes,
+                   s.changesPerSec, s.deliveries);
         mpv_terminate_destroy(m_handle);
         m_handle = nullptr;
         d->gl = nullptr;
@@ -140,9 +169,27 @@ auto Mpv::render(OpenGLFramebufferObject *frame, OpenGLFramebufferObject *osd, c
     return ret;
 }
 
-auto Mpv::frameSwapped() -> void
+auto Mpv::frameSwapped() -> qint64
+{
+    const auto time = this->time();
+    mpv_opengl_cb_report_flip(d->gl, time);
+    return time;
+}
+
+auto Mpv::peekFrame(qint64 *pts) const -> int
+{
+    int64_t next = 0;
+    const int count = d->gl ? mpv_opengl_cb_peek_frame(d->gl, &next) : 0;
+    *pts = next;
+    return count;
+}
+
+auto Mpv::presentationStats() const -> mpv_opengl_cb_stats
 {
-    mpv_opengl_cb_report_flip(d->gl, 0);
+    mpv_opengl_cb_stats stats{};
+    if (d->gl)
+        mpv_opengl_cb_get_stats(d->gl, &stats);
+    return stats;
 }
 
 auto Mpv::initializeGL(QOpenGLContext *ctx) -> void
@@ -169,6 +216,18 @@ auto Mpv::finalizeGL() -> void
     mpv_opengl_cb_uninit_gl(d->gl);
 }
 
+auto Mpv::snapshot(const char *mode, const QSize &size, Snapshot &&done) -> bool
+{
+    Q_ASSERT(m_handle);
+    auto user = new Snapshot(std::move(done));
+    const int error = mpv_screenshot_raw_async(m_handle, (quint64)user, mode,
+                                               qMax(size.width(), 0),
+                                               qMax(size.height(), 0));
+    if (!isSuccess(error))
+        delete user;
+    return MPV_CHECK(error, "take snapshot %%", mode);
+}
+
 auto Mpv::hook(const QByteArray &when, std::function<void ()> &&run) -> void
 {
     Q_ASSERT(!d->hooks.contains(when));
@@ -184,21 +243,38 @@ auto Mpv::request(mpv_event_id id, std::function<void(mpv_event*)> &&proc) -> vo
     d->events[id] = std::move(proc);
 }
 
-auto Mpv::newObservation(const char *name, std::function<void(int)> &&notify,
-                  std::function<void(QEvent*)> &&process) -> int
+auto Mpv::newObservation(const char *name, mpv_format format,
+                         std::function<void(int, mpv_event_property*)> &&notify,
+                         std::function<void(QEvent*)> &&process) -> int
 {
     const int event = d->updateEventMax++;
-    PropertyObservation ob;
+    d->observations.emplace_back();
+    auto &ob = d->observations.back();
     ob.event = event;
     ob.name = name;
     ob.notify = std::move(notify);
     ob.process = std::move(process);
-    d->observations.append(ob);
-    Q_ASSERT(d->observations.size() == d->updateEventMax - UpdateEventBegin);
-    mpv_observe_property(m_handle, ob.event, ob.name, MPV_FORMAT_NONE);
+    Q_ASSERT((int)d->observations.size() == d->updateEventMax - UpdateEventBegin);
+    mpv_observe_property(m_handle, ob.event, ob.name, format);
     return event;
 }
 
+auto Mpv::observationStats() const -> QVector<MpvObservationStats>
+{
+    const double secs = qMax<qint64>(d->uptime.elapsed(), 1) * 1e-3;
+    QVector<MpvObservationStats> stats;
+    stats.reserve(d->observations.size());
+    for (auto &ob : d->observations) {
+        MpvObservationStats s;
+        s.name = ob.name;
+        s.changes = ob.changes;
+        s.deliveries = ob.deliveries;
+        s.changesPerSec = s.changes / secs;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
 auto Mpv::setOption(const char *name, const char *data) -> void
 {
     const auto err = mpv_set_option_string(m_handle, name, data);
@@ -216,13 +292,15 @@ auto Mpv::run() -> void
     _Debug("Start playloop thread");
     d->quit = false;
     while (!d->quit) {
-        auto ev = mpv_wait_event(m_handle, 0.005);
+        auto ev = mpv_wait_event(m_handle, 0);
         switch (ev->event_id) {
         case MPV_EVENT_NONE:
+            d->waitWakeup();
             break;
         case MPV_EVENT_PROPERTY_CHANGE: {
             auto &o = d->observation(ev->reply_userdata);
-            o.notify(o.event);
+            ++o.changes;
+            o.notify(o.event, static_cast<mpv_event_property*>(ev->data));
             break;
         } case MPV_EVENT_LOG_MESSAGE: {
             auto msg = static_cast<mpv_event_log_message*>(ev->data);
@@ -239,7 +317,7 @@ auto Mpv::run() -> void
                 }
             };
             const auto lv = getLevel();
-            Log::print(lv, Log::parse(lv, m_logContext + '/' + msg->prefix, msg->text));
+            Log::print(lv, m_logContext + '/' + msg->prefix, msg->text);
             break;
         } case MPV_EVENT_CLIENT_MESSAGE: {
             auto message = static_cast<mpv_event_client_message*>(ev->data);
@@ -266,6 +344,19 @@ auto Mpv::run() -> void
                        mpv_error_string(ev->error), *name);
             }
             break;
+        } case MPV_EVENT_SCREENSHOT_RAW_REPLY: {
+            QScopedPointer<Snapshot> done(reinterpret_cast<Snapshot*>(ev->reply_userdata));
+            QImage image;
+            auto shot = static_cast<mpv_event_screenshot_raw*>(ev->data);
+            // keep the buffer of mpv instead of copying it
+            if (!isSuccess(ev->error))
+                _Debug("Error %%: Couldn't take snapshot.", mpv_error_string(ev->error));
+            else if (auto frame = mpv_raw_frame_ref(shot->frame))
+                image = QImage(static_cast<uchar*>(shot->data), shot->w, shot->h,
+                               shot->stride, QImage::Format_RGB32, [] (void *p)
+                               { mpv_raw_frame_unref(static_cast<mpv_raw_frame*>(p)); }, frame);
+            (*done)(std::move(image));
+            break;
         } case MPV_EVENT_GET_PROPERTY_REPLY: {
             auto event = static_cast<mpv_event_property*>(ev->data);
             _Error("Never requested reply: %%", event->name);
@@ -287,7 +378,9 @@ auto Mpv::process(QEvent *event) -> bool
 {
     const int type = event->type();
     if (UpdateEventBegin <= type && type < d->updateEventMax) {
-        d->observation(type).process(event);
+        auto &o = d->observation(type);
+        ++o.deliveries;
+        o.process(event);
         return true;
     }
     return false;
@@ -17,6 +17,13 @@ SCIA s2ms(double s) -> int { return s*1000 + 0.5; }
 #define MPV_CHECK(err, fmt, ...) \
     (isSuccess(err) ? true : (_WriteLog(e2l(err), "Failed to " fmt ": %%", __VA_ARGS__, e2s(err)), false))
 
+struct MpvObservationStats {
+    QByteArray name;
+    quint64 changes = 0;    // change notifications from mpv
+    quint64 deliveries = 0; // values handed to the GUI thread after coalescing
+    double changesPerSec = 0;
+};
+
 class Mpv : public QThread {
     template<class R, class...Args> using func = std::function<R(Args...)>;
     template<class T> using trait = mpv_trait<T>;
@@ -70,6 +77,10 @@ public:
     template<class... Args>
     auto tellAsync(QByteArray &&name, const Args&... args) -> bool;
     auto flush() { mpv_wait_async_requests(m_handle); }
+    using Snapshot = std::function<void(QImage&&)>;
+    // done is called in the mpv event thread; size with 0 for either
+    // dimension keeps aspect ratio, QSize() takes video in display size
+    auto snapshot(const char *mode, const QSize &size, Snapshot &&done) -> bool;
 
     auto setObserver(QObject *observer) -> void { m_observer = observer; }
     template<class Get, class Set>
@@ -93,8 +104,27 @@ public:
                 const QMargins &m) -> int;
     auto initializeGL(QOpenGLContext *ctx) -> void;
     auto finalizeGL() -> void;
-    auto frameSwapped() -> void;
+    // returns flip time in us of time()
+    auto frameSwapped() -> qint64;
+    auto presentationStats() const -> mpv_opengl_cb_stats;
+    // number of queued frames and display time of next one in us of time()
+    auto peekFrame(qint64 *pts) const -> int;
+    auto time() const -> qint64 { return mpv_get_time_us(m_handle); }
+    auto observationStats() const -> QVector<MpvObservationStats>;
 private:
+    // Latest value of an observed property not yet taken by the GUI thread.
+    template<class T>
+    struct Latest { QMutex mutex; T value = T(); bool pending = false; };
+    template<class T>
+    static auto native(mpv_event_property *prop) -> T
+    {
+        T t = T();
+        if (prop && prop->format == trait<T>::format && prop->data)
+            trait<T>::get(t, *static_cast<type<T>*>(prop->data));
+        return t;
+    }
+    template<class Get, class Set>
+    auto coalesce(const char *name, mpv_format format, Get get, Set set) -> int;
     static auto e2s(int error) -> const char* { return mpv_error_string(error); }
     static auto e2l(int error) -> Log::Level;
     template <class T>
@@ -123,7 +153,8 @@ private:
         int error = f(&node);
         return MPV_CHECK(error, "execute %%", name);
     }
-    auto newObservation(const char *name, std::function<void(int)> &&notify,
+    auto newObservation(const char *name, mpv_format format,
+                        std::function<void(int, mpv_event_property*)> &&notify,
                         std::function<void(QEvent*)> &&process) -> int;
     struct Data; Data *d;
     mpv_handle *m_handle = nullptr;
@@ -198,39 +229,64 @@ template<int N, class... Args>
 auto Mpv::tellAsync(const char (&name)[N], const Args&... args) -> bool
     { return tellAsync(QByteArray::fromRawData(name, N), args...); }
 
+// Changes are coalesced: while an update is waiting for the GUI thread, newer
+// values replace the pending one instead of posting another event.
+template<class Get, class Set>
+auto Mpv::coalesce(const char *name, mpv_format format, Get get, Set set) -> int
+{
+    using T = tmp::remove_cref_t<decltype(get(nullptr))>;
+    auto latest = std::make_shared<Latest<T>>();
+    return newObservation(name, format, [=] (int e, mpv_event_property *prop) {
+        auto value = get(prop);
+        QMutexLocker locker(&latest->mutex);
+        latest->value = std::move(value);
+        if (_Change(latest->pending, true))
+            _PostEvent(m_observer, e);
+    }, [=] (QEvent*) {
+        QMutexLocker locker(&latest->mutex);
+        auto value = std::move(latest->value);
+        latest->pending = false;
+        locker.unlock();
+        set(std::move(value));
+    });
+}
+
+// A custom getter can't use the value sent with the change event, so it is
+// called on each change instead.
 template<class Get, class Set>
 auto Mpv::observe(const char *name, Get get, Set set) -> tmp::enable_if_callable_t<Get, int>
 {
-    using T = tmp::remove_cref_t<decltype(get())>;
-    return newObservation(name, [=] (int e) { _PostEvent(m_observer, e, get()); },
-                          [=] (QEvent *event) { set(_MoveData<T>(event)); });
+    return coalesce(name, MPV_FORMAT_NONE,
+                    [=] (mpv_event_property*) { return get(); }, set);
 }
 
 template<class T, class Update>
 auto Mpv::observe(const char *name, T &t, Update update) -> tmp::enable_unless_callable_t<T, int>
 {
-    return observe(name, [=] () { return get<T>(name); },
-                   [=, &t] (T &&v) { if (_Change(t, v)) update(); });
+    return coalesce(name, trait<T>::format, &Mpv::native<T>,
+                    [=, &t] (T &&v) { if (_Change(t, v)) update(); });
 }
 
 template<class Update>
 auto Mpv::observeTime(const char *name, int &t, Update update) -> int
 {
-    return observe(name, [=] () { return s2ms(get<double>(name)); },
-                   [=, &t] (int &&v) { if (_Change(t, v)) update(); });
+    return coalesce(name, MPV_FORMAT_DOUBLE,
+                    [] (mpv_event_property *p) { return s2ms(native<double>(p)); },
+                    [=, &t] (int &&v) { if (_Change(t, v)) update(); });
 }
 
 template<class Set>
 auto Mpv::observe(const char *name, Set set) -> int {
     using T = tmp::remove_ref_t<tmp::func_arg_t<Set, 0>>;
-    return observe(name, [=] () { return get<T>(name); }, set);
+    return coalesce(name, trait<T>::format, &Mpv::native<T>, set);
 }
 
 template<class Check>
 auto Mpv::observeState(const char *name, Check ck) -> int
 {
     using T = tmp::remove_ref_t<tmp::func_arg_t<Check, 0>>;
-    return newObservation(name, [=] (int) { ck(get<T>(name)); }, [](QEvent*){});
+    return newObservation(name, trait<T>::format, [=] (int, mpv_event_property *p)
+                          { ck(native<T>(p)); }, [](QEvent*){});
 }
 
 #endif // MPV_HPP
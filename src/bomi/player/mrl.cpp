@@ -1,6 +1,7 @@
 #include "mrl.hpp"
 #include "tmp/algorithm.hpp"
 #include "misc/udf25.hpp"
+#include "misc/jsonstorage.hpp"
 #include <QCryptographicHash>
 
 Mrl::Mrl(const QUrl &url) {
@@ -242,6 +243,69 @@ static QByteArray blurayHash(const QString &device) {
     return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
 }
 
+// An image file keeps its identity as long as its size and modification time
+// don't change, so the hash is remembered across runs and costs a stat later.
+// Only the most recently used entries are kept. The last use of a hit is
+// written back at most once a day to avoid rewriting the file on every play.
+static constexpr int MaxImageHashes = 200;
+static constexpr qint64 ImageHashTouchInterval = 24 * 60 * 60 * 1000;
+
+static auto pruneImageHashes(QJsonObject &cache) -> void
+{
+    if (cache.size() <= MaxImageHashes)
+        return;
+    QVector<QPair<qint64, QString>> used;
+    used.reserve(cache.size());
+    for (auto it = cache.begin(); it != cache.end(); ++it) {
+        const auto time = it.value().toObject()[u"used"_q].toString().toLongLong();
+        used.push_back(qMakePair(time, it.key()));
+    }
+    tmp::sort(used);
+    for (int i = 0; i < used.size() - MaxImageHashes; ++i)
+        cache.remove(used[i].second);
+}
+
+static QByteArray imageHash(const QString &device, QByteArray(*calc)(const QString&))
+{
+    const QFileInfo info(device);
+    if (!info.isFile())
+        return calc(device);
+    static QMutex mutex;
+    static QJsonObject cache;
+    static bool loaded = false;
+    JsonStorage storage(_WritablePath(Location::Cache) % "/disc-hash.json"_a);
+    const auto key = info.canonicalFilePath();
+    const auto size = QString::number(info.size());
+    const auto mtime = QString::number(info.lastModified().toMSecsSinceEpoch());
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+    QMutexLocker locker(&mutex);
+    if (!loaded) {
+        cache = storage.read();
+        loaded = true;
+    }
+    auto entry = cache.value(key).toObject();
+    if (entry[u"size"_q].toString() == size && entry[u"mtime"_q].toString() == mtime) {
+        const auto used = entry[u"used"_q].toString().toLongLong();
+        if (now - used > ImageHashTouchInterval) {
+            entry[u"used"_q] = QString::number(now);
+            cache.insert(key, entry);
+            storage.write(cache);
+        }
+        return entry[u"hash"_q].toString().toLatin1();
+    }
+    locker.unlock();
+    const auto hash = calc(device);
+    if (hash.isEmpty())
+        return hash;
+    locker.relock();
+    cache.insert(key, QJsonObject{ { u"size"_q, size }, { u"mtime"_q, mtime },
+                                   { u"used"_q, QString::number(now) },
+                                   { u"hash"_q, QString::fromLatin1(hash) } });
+    pruneImageHashes(cache);
+    storage.write(cache);
+    return hash;
+}
+
 auto Mrl::calculateHash(const Mrl &mrl) -> QByteArray
 {
     if (!mrl.isDisc())
@@ -249,7 +313,7 @@ auto Mrl::calculateHash(const Mrl &mrl) -> QByteArray
     const auto device = mrl.device();
     if (device.isEmpty())
         return QByteArray();
-    return mrl.isDvd() ? dvdHash(device) : blurayHash(device);
+    return imageHash(device, mrl.isDvd() ? dvdHash : blurayHash);
 }
 
 auto Mrl::updateHash() -> void
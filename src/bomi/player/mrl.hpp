@@ -49,8 +49,9 @@ public:
     auto end() const -> int;
     auto toCueTrack() const -> CueTrack;
     auto cueSheet() const -> QString;
-    static auto fromString(const QString str) -> Mrl
-        { Mrl mrl; mrl.m_loc = str; return mrl; }
+    // str must be normalized already, i.e. toString() of other Mrl
+    static auto fromString(const QString str, const QString &name = QString()) -> Mrl
+        { Mrl mrl; mrl.m_loc = str; mrl.m_name = name; return mrl; }
     static auto fromDisc(const QString &scheme, const QString &device,
                          int title, bool hash) -> Mrl;
     static auto fromCueTrack(const QString &cue, const CueTrack &track,
@@ -126,7 +126,8 @@ auto MrlState::metaProperty(const char *property) const -> QMetaProperty
 auto MrlState::defaultProperties() -> QStringList
 {
     return { u"name"_q, u"device"_q, u"last_played_date_time"_q,
-             u"resume_position"_q, u"edition"_q, u"star"_q };
+             u"resume_position"_q, u"edition"_q, u"star"_q,
+             u"probe_hint"_q };
 }
 
 auto MrlState::restorableProperties() -> QVector<PropertyInfo>
@@ -15,9 +15,18 @@ PlayEngine::PlayEngine()
     d->sr = new SubtitleRenderer;
     d->vr = new VideoRenderer;
     d->preview = new VideoPreview;
+    d->preloader = new Preloader([=] (const PreloadedMrlPtr &pre)
+        { _PostEvent(this, Preloaded, pre); });
+    d->preloader->start(QThread::LowPriority);
     d->vr->setOverlay(d->sr);
     d->vr->setRenderFrameFunction([this] (Fbo *frame, Fbo* osd, const QMargins &m)
         { d->renderVideoFrame(frame, osd, m); });
+    d->vr->setPeekFrameFunction([this] () {
+        QueuedFrame frame;
+        frame.count = d->mpv.peekFrame(&frame.pts);
+        frame.now = d->mpv.time();
+        return frame;
+    });
     d->updateVideoRendererFboFormat();
     d->info.video.setScreen(d->vr);
 
@@ -195,6 +204,14 @@ PlayEngine::PlayEngine()
         d->info.video.decoder()->setBitrate(d->mpv.get<int>("video-bitrate"));
         d->info.video.setDelayedFrames(d->info.delayed);
         d->info.video.setDroppedFrames(d->mpv.get<int64_t>("vo-drop-frame-count"));
+        if (d->presentation.takeChanged())
+            emit presentationChanged();
+        quint64 observed = 0;
+        for (auto &s : d->mpv.observationStats())
+            observed += s.deliveries;
+        if (_Change(d->observed, observed))
+            emit observationsChanged();
+        d->updateSyncSpeed();
     });
     connect(d->info.video.output(), &VideoFormatObject::sizeChanged,
             d->preview, &VideoPreview::setSizeHint);
@@ -262,6 +279,7 @@ PlayEngine::~PlayEngine()
     qDeleteAll(d->info.chapters);
     qDeleteAll(d->info.editions);
     d->params.m_mutex = nullptr;
+    delete d->preloader;
     d->mpv.destroy();
     d->vr->setOverlay(nullptr);
     delete d->ac;
@@ -276,8 +294,10 @@ PlayEngine::~PlayEngine()
 auto PlayEngine::initializeGL(const QQuickWindow *w, QOpenGLContext *ctx) -> void
 {
     d->mpv.initializeGL(ctx);
-    connect(w, &QQuickWindow::frameSwapped,
-            &d->mpv, &Mpv::frameSwapped, Qt::DirectConnection);
+    connect(w, &QQuickWindow::frameSwapped, &d->mpv, [=] () {
+        d->vr->flipped(d->mpv.frameSwapped());
+        d->presentation.update(d->mpv.presentationStats());
+    }, Qt::DirectConnection);
 }
 
 auto PlayEngine::finalizeGL(QOpenGLContext */*ctx*/) -> void
@@ -407,7 +427,7 @@ auto PlayEngine::autoloadSubtitleFiles() -> void
 
 auto PlayEngine::autoloadAudioFiles() -> void
 {
-    setAudioFiles(d->autoloadFiles(StreamAudio).names);
+    setAudioFiles(d->autoloadFiles(StreamAudio, d->mrl).names);
 }
 
 auto PlayEngine::reloadSubtitleFiles(const EncodingInfo &enc, bool detect) -> void
@@ -538,6 +558,7 @@ auto PlayEngine::preview() const -> VideoPreview*
 auto PlayEngine::setHistory(HistoryModel *history) -> void
 {
     d->history = history;
+    d->preloader->setHistory(history);
 }
 
 auto PlayEngine::lock() -> void
@@ -597,6 +618,38 @@ auto PlayEngine::avSync() const -> int
     return d->avSync;
 }
 
+auto PlayEngine::openTiming() const -> QVariantMap
+{
+    return d->openTiming;
+}
+
+auto PlayEngine::presentation() const -> QVariantMap
+{
+    auto map = d->presentation.toMap();
+    map[u"cadenceError"_q] = d->vr->cadenceError();
+    map[u"syncSpeed"_q] = d->pacing.speed;
+    return map;
+}
+
+auto PlayEngine::observations() const -> QVariantMap
+{
+    QVariantMap map;
+    for (auto &s : d->mpv.observationStats()) {
+        QVariantMap ob;
+        ob[u"changes"_q] = qint64(s.changes);
+        ob[u"deliveries"_q] = qint64(s.deliveries);
+        ob[u"changesPerSec"_q] = s.changesPerSec;
+        map[QString::fromLatin1(s.name)] = ob;
+    }
+    return map;
+}
+
+auto PlayEngine::setFramePacing_locked(bool on, bool audio) -> void
+{
+    d->pacing.on = on;
+    d->pacing.audio = audio;
+}
+
 auto PlayEngine::stepFrame(int direction) -> void
 {
     if ((d->state & (Playing | Paused)) && d->seekable)
@@ -722,15 +775,27 @@ auto PlayEngine::setMrl(const Mrl &mrl) -> void
 
 auto PlayEngine::load(const Mrl &mrl, bool tryResume, const QString &sub) -> void
 {
+    // already being opened by mpv after previous one
+    const bool queued = d->next.continuing && mrl == d->next.mrl;
     if (_Change(d->mrl, mrl)) {
         d->hasImage = mrl.isImage();
         d->updateMediaName();
         emit mrlChanged(d->mrl);
     }
-    if (!d->mrl.isEmpty())
+    if (!queued && !d->mrl.isEmpty())
         d->loadfile(d->mrl, tryResume, sub);
 }
 
+auto PlayEngine::setNextMrl(const Mrl &mrl, bool tryResume) -> void
+{
+    if (d->next.mrl == mrl && d->next.resume == tryResume)
+        return;
+    d->dequeueNext();
+    d->next.mrl = mrl;
+    d->next.resume = tryResume;
+    d->preload();
+}
+
 auto PlayEngine::time() const -> int
 {
     return d->time;
@@ -1442,49 +1507,14 @@ auto PlayEngine::currentSubtitleStreamTrack() const -> StreamTrack
     return track ? *track : StreamTrack();
 }
 
-auto PlayEngine::snapshot(bool osd) const -> QImage
+auto PlayEngine::snapshot(bool osd, const QSize &size,
+                          std::function<void(const QImage&)> &&done) const -> void
 {
-    mpv_node values[2];
-    values[0].format = MPV_FORMAT_STRING;
-    values[0].u.string = const_cast<char*>("screenshot_raw");
-    values[1].format = MPV_FORMAT_STRING;
-    values[1].u.string = const_cast<char*>(osd ? "subtitle" : "video");
-
-    mpv_node_list list;
-    list.num = 2;
-    list.keys = nullptr;
-    list.values = values;
-
-    mpv_node args;
-    args.format = MPV_FORMAT_NODE_ARRAY;
-    args.u.list = &list;
-
-    mpv_node *res = new mpv_node;
-    int error = mpv_command_node(d->mpv.handle(), &args, res);
-    if (error != MPV_ERROR_SUCCESS) {
-        delete res;
-        return QImage();
-    }
-
-    Q_ASSERT(res->format == MPV_FORMAT_NODE_MAP);
-    QSize s; int stride = 0;
-    mpv_byte_array bytes { nullptr, 0 };
-    for (int i = 0; i < res->u.list->num; ++i) {
-        const char *key = res->u.list->keys[i];
-        const auto &node = res->u.list->values[i];
-        if (!qstrcmp(key, "w"))
-            s.rwidth() = node.u.int64;
-        else if (!qstrcmp(key, "h"))
-            s.rheight() = node.u.int64;
-        else if (!qstrcmp(key, "stride"))
-            stride = node.u.int64;
-        else if (!qstrcmp(key, "format"))
-            {}
-        else if (!qstrcmp(key, "data"))
-            bytes = *node.u.ba;
-    }
-    return QImage((uchar*)bytes.data, s.width(), s.height(), stride, QImage::Format_RGB32,
-                  [] (void *p) { auto res = (mpv_node*)p; mpv_free_node_contents(res); delete res;}, res);
+    using Done = std::function<void(const QImage&)>;
+    auto p = const_cast<PlayEngine*>(this);
+    auto post = [p, done] (QImage &&image) { _PostEvent(p, SnapshotReady, image, done); };
+    if (!d->mpv.snapshot(osd ? "subtitles" : "video", size, std::move(post)))
+        _PostEvent(p, SnapshotReady, QImage(), Done(std::move(done)));
 }
 
 auto PlayEngine::setVideoSettings(const VideoSettings &s) -> void
@@ -69,6 +69,9 @@ class PlayEngine : public QObject {
     Q_PROPERTY(bool muted READ isMuted WRITE setAudioMuted NOTIFY mutedChanged)
 
     Q_PROPERTY(int avSync READ avSync NOTIFY avSyncChanged)
+    Q_PROPERTY(QVariantMap openTiming READ openTiming NOTIFY openTimingChanged)
+    Q_PROPERTY(QVariantMap presentation READ presentation NOTIFY presentationChanged)
+    Q_PROPERTY(QVariantMap observations READ observations NOTIFY observationsChanged)
 
     Q_PROPERTY(State state READ state NOTIFY stateChanged)
     Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
@@ -115,6 +118,8 @@ public:
     auto state() const -> State;
     auto load(const Mrl &mrl, bool tryResume = true, const QString &sub = QString()) -> void;
     auto setMrl(const Mrl &mrl) -> void;
+    // prepares mrl in background and lets it follow current one without gap
+    auto setNextMrl(const Mrl &mrl, bool tryResume = true) -> void;
     auto edition() const -> EditionObject*;
     auto chapter() const -> ChapterObject*;
     auto editions() const -> const QVector<EditionObject*>&;
@@ -126,7 +131,10 @@ public:
     auto currentAudioStreamTrack() const -> StreamTrack;
     auto currentSubtitleStreamTrack() const -> StreamTrack;
     auto frameSize() const -> QSize;
-    auto snapshot(bool osd = false) const -> QImage;
+    // asynchronous, done is called in GUI thread with null image on failure;
+    // 0 for either dimension of size keeps aspect ratio
+    auto snapshot(bool osd, const QSize &size,
+                  std::function<void(const QImage&)> &&done) const -> void;
 
     auto setAudioFiles(const QStringList &files) -> void;
     auto addAudioFiles(const QStringList &files) -> void;
@@ -167,6 +175,7 @@ public:
     auto setPreciseSeeking_locked(bool on) -> void;
     auto setResyncAvWhenFilterToggled_locked(bool on) -> void;
     auto setMotionIntrplOption_locked(const MotionIntrplOption &option) -> void;
+    auto setFramePacing_locked(bool on, bool audio) -> void;
     auto unlock() -> void;
 
     auto params() const -> const MrlState*;
@@ -218,6 +227,10 @@ public:
     auto audio() const -> AudioObject*;
     auto video() const -> VideoObject*;
     auto avSync() const -> int;
+    auto openTiming() const -> QVariantMap;
+    auto presentation() const -> QVariantMap;
+    // mpv property observation counts since start, keyed by property name
+    auto observations() const -> QVariantMap;
     auto rate(int time) const -> double { return (double)(time-begin())/duration(); }
     Q_INVOKABLE double rate_ms(int ms) const { return rate(ms); }
     auto rate() const -> double { return rate(time()); }
@@ -237,7 +250,6 @@ public:
     auto isMouseInButton() const -> bool;
     auto subtitle() const -> SubtitleObject*;
     auto setSubtitleDelay(int ms) -> void;
-    auto setNextMrl(const Mrl &Mrl) -> void;
     auto shutdown() -> void;
     auto stepFrame(int direction) -> void;
     auto setAudioVolume(double volume) -> void;
@@ -318,6 +330,9 @@ signals:
     void mutedChanged();
     void zoomChanged(double zoom);
     void avSyncChanged(int avSync);
+    void openTimingChanged();
+    void presentationChanged();
+    void observationsChanged();
     void chaptersChanged();
     void editionsChanged();
     void editionChanged();
@@ -348,6 +363,7 @@ private:
     auto setSubtitleTrackSelected(int id, bool s) -> void;
     auto setSubtitleInclusiveTrackSelected(int id, bool s) -> void;
     auto customEvent(QEvent *event) -> void;
+    friend class Benchmark;
     struct Data; Data *d;
 };
 
@@ -130,8 +130,13 @@ auto PlayEngine::Data::videoSubOptions(const MrlState *s) const -> QByteArray
         opts.add("dscale", s->d->intrplDown[s->video_interpolator_down()].toMpvOption("dscale"));
     opts.add("dither-depth", "auto"_b);
     opts.add("dither", _EnumData(s->video_dithering()));
+    const bool pacing = isFramePacing(s);
     opts.add("frame-queue-size", s->video_motion_interpolation() || vp->isSkipping() ? 1 : 3);
-    opts.add("frame-drop-mode", s->video_motion_interpolation() ? "block"_b : "clear"_b);
+    // paced frames wait in queue until due, so only the oldest one is late
+    opts.add("frame-drop-mode", s->video_motion_interpolation() ? "block"_b
+                                : pacing ? "pop"_b : "clear"_b);
+    if (pacing)
+        opts.add("frame-queue-ahead", 40);
     opts.add("fancy-downscaling", s->video_hq_downscaling());
     opts.add("sigmoid-upscaling", s->video_hq_upscaling() && OGL::is16bitFramebufferFormatSupported());
     opts.add("interpolation", s->video_motion_interpolation());
@@ -140,6 +145,9 @@ auto PlayEngine::Data::videoSubOptions(const MrlState *s) const -> QByteArray
     const auto cmat = c_matrix();
     if (!cmat.isIdentity())
         opts.add("custom-shader", customShader(cmat));
+    static const auto shaderCache
+            = QFile::encodeName(_WritablePath(Location::Cache) % "/shader"_a);
+    opts.addRaw("shader-cache-dir", shaderCache);
     return opts.get();
 }
 
@@ -162,23 +170,47 @@ auto PlayEngine::Data::updateVideoSubOptions() -> void
 {
     mutex.lock();
     auto opts = videoSubOptions(&params);
+    vr->setFramePacing(isFramePacing(&params));
     mutex.unlock();
     mpv.tellAsync("vo_cmdline", videoSubOptions(&params));
 }
 
-auto PlayEngine::Data::loadfile(const Mrl &mrl, bool resume, const QString &sub) -> void
+auto PlayEngine::Data::isFramePacing(const MrlState *s) const -> bool
+{
+    // mpv picks frames by itself for interpolation
+    return pacing.on && !s->video_motion_interpolation() && !vp->isSkipping();
+}
+
+auto PlayEngine::Data::updateSyncSpeed() -> void
+{
+    double speed = 1.0;
+    if (pacing.audio && ac->isTempoScalerActivated() && isFramePacing(&params)) {
+        const auto fps = info.video.decoder()->fps() * params.play_speed();
+        speed = vr->syncSpeed(fps, 0.01);
+    }
+    // the scaler restarts on every change
+    if (qAbs(speed - pacing.speed) > 1e-4 || (speed == 1.0) != (pacing.speed == 1.0)) {
+        pacing.speed = speed;
+        ac->setSyncSpeed(speed);
+    }
+}
+
+auto PlayEngine::Data::loadfile(const Mrl &mrl, bool resume, const QString &sub,
+                                bool append) -> void
 {
     QString file = mrl.isLocalFile() ? mrl.toLocalFile() : mrl.toString();
     if (file.isEmpty())
         return;
+    if (!append) // replacing clears whole playlist
+        next.queued = next.continuing = false;
     OptionList opts;
-    opts.add("pause"_b, p->isPaused() || hasImage);
+    opts.add("pause"_b, append ? mrl.isImage() : p->isPaused() || hasImage);
     opts.add("resume-playback", resume);
     if (!sub.isEmpty())
         opts.add("sub-file", sub.toUtf8(), true);
     if (!mrl.name().isEmpty() && mrl.isCueTrack())
         opts.addRaw("media-title", mrl.name().toUtf8());
-    mpv.tell("loadfile"_b, file.toUtf8(), "replace"_b, opts.get());
+    mpv.tell("loadfile"_b, file.toUtf8(), append ? "append"_b : "replace"_b, opts.get());
 }
 
 auto PlayEngine::Data::updateMediaName(const QString &name) -> void
@@ -215,6 +247,9 @@ auto PlayEngine::Data::onLoad() -> void
     mutex.lock();
     auto reload = this->reload;
     this->reload = -1;
+    PreloadedMrlPtr pre;
+    if (preloaded && preloaded->mrl == mrl)
+        pre = preloaded;
     mutex.unlock();
 
     bool found = false, resume = false;
@@ -224,6 +259,7 @@ auto PlayEngine::Data::onLoad() -> void
         local->set_edition(-1);
         local->set_device(QString());
         local->set_star(false);
+        local->set_probe_hint(QString());
         local->set_video_tracks(StreamList());
         local->set_audio_tracks(StreamList());
         local->set_sub_tracks(StreamList());
@@ -232,6 +268,11 @@ auto PlayEngine::Data::onLoad() -> void
         resume = mpv.get<bool>("options/resume-playback") && this->resume;
         if (resume)
             start = local->resume_position();
+        if (found && mrl.isLocalFile() && !local->probe_hint().isEmpty())
+            mpv.setAsync("file-local-options/demuxer-lavf-hint",
+                         local->probe_hint().toLatin1());
+        else if (pre && !pre->probeHint.isEmpty())
+            mpv.setAsync("file-local-options/demuxer-lavf-hint", pre->probeHint);
     } else {
         start = reload;
         local->set_device(mrl.device());
@@ -293,9 +334,11 @@ auto PlayEngine::Data::onLoad() -> void
 
     if (found && local->audio_tracks().isValid())
         setFiles("file-local-options/audio-file"_b, "file-local-options/aid"_b, local->audio_tracks());
+    else if (pre)
+        mpv.setAsync("file-local-options/audio-file", MpvFileList(pre->audios));
     else {
         QMutexLocker locker(&mutex);
-        mpv.setAsync("file-local-options/audio-file", autoloadFiles(StreamAudio));
+        mpv.setAsync("file-local-options/audio-file", autoloadFiles(StreamAudio, mrl));
     }
     QVector<SubComp> loads;
     auto loadSub = [&] (auto &&res) {
@@ -322,7 +365,7 @@ auto PlayEngine::Data::onLoad() -> void
             loads = restoreInclusiveSubtitles(local->sub_tracks_inclusive(), EncodingInfo(), -1);
         } else {
             QMutexLocker locker(&mutex);
-            loadSub(autoloadSubtitle(local));
+            loadSub(pre ? autoloadSubtitle(local, pre->subtitles) : autoloadSubtitle(local));
         }
     } else {
         QMutexLocker locker(&mutex);
@@ -346,6 +389,7 @@ auto PlayEngine::Data::onLoad() -> void
     mpv.setAsync("video-rotate", _EnumData(local->video_rotation()));
 
     mpv.setAsync("options/vo", vo(local));
+    vr->setFramePacing(isFramePacing(local));
     mpv.setAsync("options/vf", vf(local));
     mpv.setAsync("options/deinterlace", deint ? "yes"_b : "no"_b);
 
@@ -665,6 +709,15 @@ auto PlayEngine::Data::observe() -> void
         auto info = video.filter();
         setParams(info, params, u"w"_q, u"h"_q);
     });
+    mpv.observe("open-timing", [=] (QVariant &&var) {
+        auto timing = var.toMap();
+        const auto total = timing[u"total"_q].toDouble();
+        if (total >= 0 && total != openTiming[u"total"_q].toDouble())
+            _Info("Time to first frame: %%ms, gap from previous file: %%ms",
+                  total * 1e3, timing[u"gap"_q].toDouble() * 1e3);
+        openTiming = std::move(timing);
+        emit p->openTimingChanged();
+    });
     mpv.observe("video-out-params", [=] (QVariant &&var) {
         const auto params = var.toMap();
         auto info = this->info.video.output();
@@ -803,14 +856,17 @@ auto PlayEngine::Data::process(QEvent *event) -> void
         emit p->started(params.mrl());
         if (params.set_name(mpv.get<MpvUtf8>("media-title").data))
             history->update(&params, u"name"_q, false);
+        if (params.set_probe_hint(mpv.get<MpvLatin1>("demuxer-probe-hint").data))
+            history->update(&params, u"probe_hint"_q, false);
         history->update();
+        queueNext();
         break;
     } case EndPlayback: {
         QSharedPointer<MrlState> last; int reason, error;
         _TakeData(event, last, reason, error);
         Q_ASSERT(last.data());
         auto state = Stopped;
-        bool eof = false;
+        bool eof = false, stopped = false;
         switch ((mpv_end_file_reason)reason) {
         case MPV_END_FILE_REASON_EOF:
         case MPV_END_FILE_REASON_REDIRECT:
@@ -821,15 +877,28 @@ auto PlayEngine::Data::process(QEvent *event) -> void
         case MPV_END_FILE_REASON_QUIT:
         case MPV_END_FILE_REASON_STOP:
             _Info("Playback has been terminated by request");
+            stopped = true;
             break;
         case MPV_END_FILE_REASON_ERROR:
             _Error("Playback has been terminated by error: %%", mpv_error_string(error));
             state = Error;
             break;
         }
-        updateState(state);
         history->update(last.data(), false);
+        if (stopped || !next.queued) {
+            next.queued = false;
+            updateState(state);
+            emit p->finished(last->mrl(), eof);
+            break;
+        }
+        // mpv goes on to queued item without stopping, so only switch mrl
+        // when finished() is handled by loading it as usual
+        next.queued = false;
+        next.continuing = true;
         emit p->finished(last->mrl(), eof);
+        if (next.continuing)
+            p->load(next.mrl);
+        next.continuing = false;
         break;
     } case NotifySeek:
         emit p->sought();
@@ -860,6 +929,20 @@ auto PlayEngine::Data::process(QEvent *event) -> void
         emit p->streamingFormatsChanged();
         emit p->streamingFormatChanged();
         break;
+    } case SnapshotReady: {
+        QImage image; std::function<void(const QImage&)> done;
+        _TakeData(event, image, done);
+        done(image);
+        break;
+    } case Preloaded: {
+        const auto pre = _GetData<PreloadedMrlPtr>(event);
+        if (pre->mrl != next.mrl)
+            break;
+        mutex.lock();
+        preloaded = pre;
+        mutex.unlock();
+        queueNext();
+        break;
     } default:
         break;
     }
@@ -873,10 +956,14 @@ auto PlayEngine::Data::takeSnapshot() -> void
         emit p->snapshotTaken();
         return;
     }
-    Fbo frame(size), osd(size);
-    mpv.render(&frame, &osd, QMargins());
-    ss.frame = frame.texture().toImage(QImage::Format_ARGB32);
-    ss.osd = osd.texture().toImage(QImage::Format_ARGB32_Premultiplied);
+    auto pool = OpenGLResourcePool::current();
+    auto frame = pool->takeFramebufferObject(size);
+    auto osd = pool->takeFramebufferObject(size);
+    mpv.render(frame, osd, QMargins());
+    ss.frame = frame->texture().toImage(QImage::Format_ARGB32);
+    ss.osd = osd->texture().toImage(QImage::Format_ARGB32_Premultiplied);
+    pool->release(frame);
+    pool->release(osd);
     ss.time = mpv.get<double>("time-pos") * 1e3;
     emit p->snapshotTaken();
 }
@@ -942,7 +1029,7 @@ auto PlayEngine::Data::restoreInclusiveSubtitles(const StreamList &tracks, const
     return ret;
 }
 
-auto PlayEngine::Data::autoloadFiles(StreamType type) -> MpvFileList
+auto PlayEngine::Data::autoloadFiles(StreamType type, const Mrl &mrl) -> MpvFileList
 {
     auto &a = streams[type].autoloader;
     if (!a.enabled)
@@ -954,7 +1041,7 @@ auto PlayEngine::Data::autoselect(const MrlState *s, QVector<SubComp> &loads) ->
 {
     QVector<int> selected;
     QSet<QString> langSet;
-    const QFileInfo file(mrl.toLocalFile());
+    const QFileInfo file(s->mrl().toLocalFile());
     const QString base = file.completeBaseName();
 
     for (int i = 0; i<loads.size(); ++i) {
@@ -998,19 +1085,27 @@ auto PlayEngine::Data::autoselect(const MrlState *s, QVector<SubComp> &loads) ->
 
 auto PlayEngine::Data::autoloadSubtitle(const MrlState *s, const MpvFileList &subs)
 -> T<MpvFileList, QVector<SubComp>>
+{
+    QVector<PreloadedSubtitle> parsed;
+    parsed.reserve(subs.names.size());
+    for (auto &file : subs.names)
+        parsed.push_back(Preloader::parseSubtitle(file));
+    return autoloadSubtitle(s, parsed);
+}
+
+auto PlayEngine::Data::autoloadSubtitle(const MrlState *s,
+                                        const QVector<PreloadedSubtitle> &subs)
+-> T<MpvFileList, QVector<SubComp>>
 {
     MpvFileList files;
     QVector<SubComp> loads;
-    for (auto &file : subs.names) {
-       Subtitle sub;
-       const auto enc = EncodingInfo::detect(EncodingInfo::Subtitle, file);
-       if (sub.load(file, enc)) {
-           for (int i = 0; i < sub.size(); ++i)
-               loads.push_back(sub[i]);
-       } else {
-           files.names.push_back(file);
-           assEncodings[file] = enc;
-       }
+    for (auto &sub : subs) {
+        if (sub.parsed)
+            loads += sub.components;
+        else {
+            files.names.push_back(sub.file);
+            assEncodings[sub.file] = sub.encoding;
+        }
     }
     autoselect(s, loads);
     return _T(files, loads);
@@ -1018,7 +1113,42 @@ auto PlayEngine::Data::autoloadSubtitle(const MrlState *s, const MpvFileList &su
 
 auto PlayEngine::Data::autoloadSubtitle(const MrlState *s) -> T<MpvFileList, QVector<SubComp>>
 {
-    return autoloadSubtitle(s, autoloadFiles(StreamSubtitle));
+    return autoloadSubtitle(s, autoloadFiles(StreamSubtitle, s->mrl()));
+}
+
+auto PlayEngine::Data::preload() -> void
+{
+    mutex.lock();
+    preloaded.reset();
+    const auto audio = streams[StreamAudio].autoloader;
+    const auto sub = streams[StreamSubtitle].autoloader;
+    mutex.unlock();
+    if (next.mrl.isEmpty() || next.mrl.isDisc())
+        preloader->cancel();
+    else
+        preloader->request(next.mrl, audio, sub);
+}
+
+auto PlayEngine::Data::queueNext() -> void
+{
+    if (next.queued || next.mrl.isEmpty() || !p->isRunning())
+        return;
+    mutex.lock();
+    const bool ready = preloaded && preloaded->mrl == next.mrl;
+    mutex.unlock();
+    if (!ready)
+        return;
+    // formats are checked by mpv: audio output is kept only if they match
+    loadfile(next.mrl, next.resume, QString(), true);
+    next.queued = true;
+}
+
+auto PlayEngine::Data::dequeueNext() -> void
+{
+    if (!next.queued)
+        return;
+    mpv.tellAsync("playlist-clear");
+    next.queued = false;
 }
 
 auto PlayEngine::Data::localCopy() -> QSharedPointer<MrlState>
@@ -1072,6 +1202,7 @@ auto PlayEngine::Data::clearTimings() -> void
     info.video.setDelayedFrames(0);
     info.video.output()->setFps(0);
     frames.drawn = 0;
+    presentation.clear();
 }
 
 auto PlayEngine::Data::sub_add(const QString &file, const EncodingInfo &enc, bool select) -> void
@@ -8,6 +8,8 @@
 #include "avinfoobject.hpp"
 #include "streamtrack.hpp"
 #include "historymodel.hpp"
+#include "preloader.hpp"
+#include "presentationstats.hpp"
 #include "misc/autoloader.hpp"
 #include "misc/youtubedl.hpp"
 #include "misc/osdstyle.hpp"
@@ -24,6 +26,7 @@
 #include "enum/codecid.hpp"
 #include "enum/framebufferobjectformat.hpp"
 #include "opengl/openglframebufferobject.hpp"
+#include "opengl/openglresourcepool.hpp"
 #include "os/os.hpp"
 
 #ifdef bool
@@ -37,7 +40,7 @@ auto _ChmapNameFromLayout(ChannelLayout layout) -> QByteArray;
 enum EventType {
     UserType = QEvent::User, StateChange, WaitingChange,
     PreparePlayback,EndPlayback, StartPlayback, NotifySeek,
-    SyncMrlState,
+    SyncMrlState, Preloaded, SnapshotReady,
     EventTypeMax
 };
 
@@ -99,6 +102,14 @@ struct PlayEngine::Data {
     HistoryModel *history = nullptr;
     YleDL *yle = nullptr;
     YouTubeDL *youtube = nullptr;
+    Preloader *preloader = nullptr;
+    PreloadedMrlPtr preloaded; // for onLoad(), guarded by mutex
+
+    // next item in playlist, queued in mpv's playlist after preloaded
+    struct {
+        Mrl mrl;
+        bool resume = false, queued = false, continuing = false;
+    } next;
 
     struct {
         bool caching = false;
@@ -118,6 +129,14 @@ struct PlayEngine::Data {
     int duration = 0, begin = 0, time = 0;
 
     QMap<QString, EncodingInfo> assEncodings;
+    QVariantMap openTiming;
+    PresentationStats presentation;
+    quint64 observed = 0; // deliveries at last observationsChanged()
+
+    struct {
+        bool on = false, audio = false;
+        double speed = 1.0; // applied to audio
+    } pacing;
 
     std::array<StreamData, StreamUnknown> streams = []() {
         std::array<StreamData, StreamUnknown> strs;
@@ -152,9 +171,14 @@ struct PlayEngine::Data {
         { mpv.tellAsync("audio_add", MpvFile(file), select ? "select"_b : "auto"_b); }
     auto sub_add(const QString &file, const EncodingInfo &enc, bool select) -> void;
     auto autoselect(const MrlState *s, QVector<SubComp> &loads) -> void;
-    auto autoloadFiles(StreamType type) -> MpvFileList;
+    auto autoloadFiles(StreamType type, const Mrl &mrl) -> MpvFileList;
     auto autoloadSubtitle(const MrlState *s) -> T<MpvFileList, QVector<SubComp>>;
     auto autoloadSubtitle(const MrlState *s, const MpvFileList &files) -> T<MpvFileList, QVector<SubComp>>;
+    auto autoloadSubtitle(const MrlState *s, const QVector<PreloadedSubtitle> &subs)
+        -> T<MpvFileList, QVector<SubComp>>;
+    auto preload() -> void;
+    auto queueNext() -> void;
+    auto dequeueNext() -> void;
 
     auto af(const MrlState *s) const -> QByteArray;
     auto vf(const MrlState *s) const -> QByteArray;
@@ -162,13 +186,16 @@ struct PlayEngine::Data {
     auto updateVideoScaler() -> void;
     auto videoSubOptions(const MrlState *s) const -> QByteArray;
     auto updateVideoSubOptions() -> void;
+    auto isFramePacing(const MrlState *s) const -> bool;
+    auto updateSyncSpeed() -> void;
     auto updateVideoRendererFboFormat() -> void;
     auto renderVideoFrame(Fbo *frame, Fbo *osd, const QMargins &m) -> void;
     auto displaySize() const { return info.video.output()->size(); }
     auto post(State state) -> void { _PostEvent(p, StateChange, state); }
     auto post(Waitings w, bool set) -> void { _PostEvent(p, WaitingChange, w, set); }
     auto volume(const MrlState *s) const -> double;
-    auto loadfile(const Mrl &mrl, bool resume, const QString &sub = QString()) -> void;
+    auto loadfile(const Mrl &mrl, bool resume, const QString &sub = QString(),
+                  bool append = false) -> void;
     auto updateMediaName(const QString &name = QString()) -> void;
 
     auto toTracks(const QVariant &var) -> QVector<StreamList>;
@@ -5,6 +5,8 @@
 #include <QCollator>
 #include <QTextStream>
 #include <QTextCodec>
+#include <QBuffer>
+#include <QSaveFile>
 
 Playlist::Playlist()
 : QList<Mrl>() {}
@@ -34,57 +36,40 @@ auto Playlist::sort() -> void
 
 auto Playlist::save(const QString &filePath, Type type) const -> bool
 {
-    QFile file(filePath);
-    if (!file.open(QFile::WriteOnly | QFile::Truncate))
+    // previous file is kept until new one is written completely
+    QSaveFile file(filePath);
+    if (!file.open(QFile::WriteOnly))
         return false;
     if (type == Unknown)
         type = guessType(file.fileName());
+    if (type == Binary)
+        return saveBinary(&file) && file.commit();
     QTextStream out(&file);
     out.setCodec(EncodingInfo::utf8().codec());
+    bool ok = false;
     switch (type) {
     case PLS:
-        return savePLS(out);
+        ok = savePLS(out);
+        break;
     case M3U:
     case M3U8:
-        return saveM3U(out);
+        ok = saveM3U(out);
+        break;
     default:
-        return false;
+        break;
     }
-}
-
-auto Playlist::load(QTextStream &in, const EncodingInfo &_enc,
-                    Type type, const QUrl &url) -> bool
-{
-    clear();
-    EncodingInfo enc = _enc;
-    if (type == M3U8)
-        enc = EncodingInfo::utf8();
-    if (enc.isValid())
-        in.setCodec(enc.codec());
-    const qint64 pos = in.pos();
-    in.seek(0);
-    auto ret = [&] () {
-        switch (type) {
-        case PLS:
-            return loadPLS(in, url);
-        case M3U:
-        case M3U8:
-            return loadM3U(in, url);
-        case Cue:
-            return loadCue(in, url);
-        default:
-            return false;
-        }
-    }();
-    in.seek(pos);
-    return ret;
+    out.flush();
+    return ok && out.status() == QTextStream::Ok && file.commit();
 }
 
 auto Playlist::load(const QUrl &url, QByteArray *data,
                     const EncodingInfo &enc, Type type) -> bool
 {
-    QTextStream in(data);
-    return load(in, enc, type, url);
+    QBuffer buffer(data);
+    if (!buffer.open(QBuffer::ReadOnly))
+        return false;
+    clear();
+    return read(&buffer, enc, type, url, [&] (Mrl &&mrl) { push_back(mrl); return true; });
 }
 
 auto Playlist::load(const QString &filePath, const EncodingInfo &enc, Type type) -> bool
@@ -94,8 +79,9 @@ auto Playlist::load(const QString &filePath, const EncodingInfo &enc, Type type)
         return false;
     if (type == Unknown)
         type = guessType(filePath);
-    QTextStream in(&file);
-    return load(in, enc, type, _UrlFromLocalFile(filePath));
+    clear();
+    return read(&file, enc, type, _UrlFromLocalFile(filePath),
+                [&] (Mrl &&mrl) { push_back(mrl); return true; });
 }
 
 auto Playlist::load(const Mrl &mrl, const EncodingInfo &enc, Type type) -> bool
@@ -116,6 +102,8 @@ auto Playlist::typeForSuffix(const QString &str) -> Type
         return M3U;
     if (suffix == "m3u8"_a)
         return M3U8;
+    if (suffix == "bpl"_a)
+        return Binary;
     return Unknown;
 }
 
@@ -146,21 +134,77 @@ auto Playlist::saveM3U(QTextStream &out) const -> bool
     return true;
 }
 
-auto Playlist::loadPLS(QTextStream &in, const QUrl &url) -> bool
+/******************************************************************************/
+
+// entries of a playlist mostly share a few directories, so normalization of a
+// directory is done once and each entry only appends its file name to it
+class PlaylistReader {
+public:
+    PlaylistReader(const QUrl &url, const Playlist::Sink &sink)
+        : m_url(url), m_sink(sink)
+    {
+        const auto str = url.toString();
+        const int idx = str.lastIndexOf('/'_q);
+        if (!url.isEmpty() && idx >= 0)
+            m_base = str.left(idx + 1);
+    }
+    auto push(const QString &location, const QString &name = QString()) -> bool
+        { return m_sink(make(resolve(location), name)); }
+    auto push(Mrl &&mrl) -> bool { return m_sink(std::move(mrl)); }
+    auto resolve(const QString &location) const -> QString
+    {
+        if (m_base.isEmpty() || location.indexOf("://"_a) > 0)
+            return location;
+        if (QFileInfo(location).isAbsolute())
+            return location;
+        return m_base % location;
+    }
+    auto url() const -> const QUrl& { return m_url; }
+private:
+    auto make(const QString &location, const QString &name) -> Mrl
+    {
+        const int slash = location.lastIndexOf('/'_q);
+        const bool file = location.startsWith("file://"_a, Qt::CaseInsensitive);
+        if (slash < 0 || (!file && location.indexOf("://"_a) >= 0))
+            return Mrl(location, name);
+        const auto fileName = location.midRef(slash + 1);
+        if (fileName.isEmpty() || fileName == "."_a || fileName == ".."_a
+                || (file && fileName.contains('%'_q)))
+            return Mrl(location, name);
+        const auto dir = location.left(slash + 1);
+        auto it = m_dirs.find(dir);
+        if (it == m_dirs.end()) {
+            QString prefix;
+            if (file)
+                prefix = Mrl(dir % "_"_a).toString();
+            else
+                prefix = "file://"_a % _ToAbsFilePath(dir % "_"_a);
+            prefix.chop(1);
+            it = m_dirs.insert(dir, prefix);
+        }
+        return Mrl::fromString(*it % fileName, name);
+    }
+    QUrl m_url;
+    QString m_base;
+    QHash<QString, QString> m_dirs;
+    const Playlist::Sink &m_sink;
+};
+
+static auto loadPLS(QTextStream &in, PlaylistReader &r) -> bool
 {
+    static QRegEx rxFile(uR"(^File\d+=(.+)$)"_q);
     while (!in.atEnd()) {
         const QString line = in.readLine();
         if (line.isEmpty())
             continue;
-        static QRegEx rxFile(uR"(^File\d+=(.+)$)"_q);
         const auto match = rxFile.match(line);
-        if (match.hasMatch())
-            push_back(Mrl(resolve(match.captured(1), url)));
+        if (match.hasMatch() && !r.push(match.captured(1)))
+            break;
     }
     return true;
 }
 
-auto Playlist::loadM3U(QTextStream &in, const QUrl &url) -> bool
+static auto loadM3U(QTextStream &in, PlaylistReader &r) -> bool
 {
     auto getNextLocation = [&in] () -> QString {
         while (!in.atEnd()) {
@@ -185,8 +229,8 @@ auto Playlist::loadM3U(QTextStream &in, const QUrl &url) -> bool
             }
         } else
             location = line;
-        if (!location.isEmpty())
-            push_back(Mrl(resolve(location, url), name));
+        if (!location.isEmpty() && !r.push(location, name))
+            break;
     }
     return true;
 }
@@ -213,15 +257,18 @@ struct CueTrack {
     }
 };
 
-auto Playlist::loadCue(QTextStream &in, const QUrl &url) -> bool
+// a track ends where next one starts and a malformed sheet is rejected as a
+// whole, so tracks are passed only after whole sheet is parsed
+static auto loadCue(QTextStream &in, PlaylistReader &r) -> bool
 {
-    CueTrack init;
-    CueTrack *current = &init;
+    const auto cue = r.url().toLocalFile();
+    CueTrack current;
+    bool hasCurrent = false;
+    QVector<CueTrack> tracks;
     QRegEx rxField(uR"#(^(\w+)\s+(.*)\s*$)#"_q);
     QRegEx rxText(uR"#(^\s*"(.*)"\s*$)#"_q);
     QRegEx rxFile(uR"#(^\s*"(.*)"\s+\w+\s*$)#"_q);
     QRegEx rxIndex(uR"(^\s*(\d\d)\s+(\d\d):(\d\d):(\d\d)\s*$)"_q);
-    QVector<CueTrack> tracks;
     while (!in.atEnd()) {
         const auto line = in.readLine().trimmed();
         auto m = rxField.match(line);
@@ -232,16 +279,17 @@ auto Playlist::loadCue(QTextStream &in, const QUrl &url) -> bool
             continue;
         const auto value = m.captured(2);
         if (key == "TRACK"_a) {
-            tracks.push_back(*current);
-            current = &tracks.last();
-            current->idx00 = current->idx01 = -1;
+            if (hasCurrent)
+                tracks.push_back(current);
+            current.idx00 = current.idx01 = -1;
+            hasCurrent = true;
             continue;
         }
         if (key == "FILE"_a) {
             m = rxFile.match(value);
             if (!m.hasMatch())
                 return false;
-            current->file = resolve(m.captured(1), url);
+            current.file = r.resolve(m.captured(1));
             continue;
         }
         if (key == "INDEX"_a) {
@@ -254,9 +302,9 @@ auto Playlist::loadCue(QTextStream &in, const QUrl &url) -> bool
                     + m.capturedRef(4).toInt() / 75.0;
             const auto msec = (min * 60 + sec) * 1000;
             if (idx == 1)
-                current->idx01 = msec;
+                current.idx01 = msec;
             else if (idx == 0)
-                current->idx00 = msec;
+                current.idx00 = msec;
             continue;
         }
 #define TEST_TEXT(name, var) \
@@ -267,33 +315,102 @@ auto Playlist::loadCue(QTextStream &in, const QUrl &url) -> bool
             var = m.captured(1); \
             continue; \
         }
-        TEST_TEXT("TITLE"_a, current->title);
-        TEST_TEXT("PERFORMER"_a, current->performer);
-        TEST_TEXT("SONGWRITER"_a, current->writer);
+        TEST_TEXT("TITLE"_a, current.title);
+        TEST_TEXT("PERFORMER"_a, current.performer);
+        TEST_TEXT("SONGWRITER"_a, current.writer);
 #undef TEST_TEXT
     }
-
-    const auto cue = url.toLocalFile();
-    reserve(tracks.size());
+    if (hasCurrent)
+        tracks.push_back(current);
     for (int i = 0; i < tracks.size(); ++i) {
-        const auto next = i + 1 < tracks.size() ? &tracks[i+1] : nullptr;
-        push_back(tracks[i].toMrl(cue, next));
+        const auto next = i + 1 < tracks.size() ? &tracks.at(i + 1) : nullptr;
+        if (!r.push(tracks.at(i).toMrl(cue, next)))
+            break;
+    }
+    return true;
+}
+
+/*
+ * Binary playlist: "BOMIPL" + version byte, then QDataStream of
+ * quint32 count and for each entry
+ *   quint32 directory index [+ QString directory if index is new]
+ *   QString rest of location, QString name
+ */
+
+static const QByteArray BinaryMagic = QByteArrayLiteral("BOMIPL\x01");
+
+static auto loadBinary(QIODevice *device, PlaylistReader &r) -> bool
+{
+    if (device->read(BinaryMagic.size()) != BinaryMagic)
+        return false;
+    QDataStream in(device);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 count = 0;
+    in >> count;
+    QStringList dirs;
+    QString rest, name;
+    for (quint32 i = 0; i < count; ++i) {
+        quint32 dir = 0;
+        in >> dir;
+        if (dir == (quint32)dirs.size()) {
+            dirs.push_back(QString());
+            in >> dirs.last();
+        }
+        in >> rest >> name;
+        if (in.status() != QDataStream::Ok || dir >= (quint32)dirs.size())
+            return false;
+        if (!r.push(Mrl::fromString(dirs[dir] % rest, name)))
+            break;
     }
     return true;
 }
 
-auto Playlist::resolve(const QString &location, const QUrl &url) -> QString
+auto Playlist::saveBinary(QIODevice *device) const -> bool
+{
+    device->write(BinaryMagic);
+    QDataStream out(device);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << (quint32)size();
+    QHash<QString, quint32> dirs;
+    for (auto &mrl : *this) {
+        const auto loc = mrl.toString();
+        const int slash = loc.lastIndexOf('/'_q) + 1;
+        const auto dir = loc.left(slash);
+        auto it = dirs.find(dir);
+        if (it == dirs.end()) {
+            const quint32 idx = dirs.size();
+            dirs.insert(dir, idx);
+            out << idx << dir;
+        } else
+            out << *it;
+        out << loc.mid(slash) << mrl.name();
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+auto Playlist::read(QIODevice *device, const EncodingInfo &_enc, Type type,
+                    const QUrl &url, const Sink &sink) -> bool
 {
-    if (url.isEmpty() || location.indexOf("://"_a) > 0)
-        return location;
-    const QFileInfo info(location);
-    if (info.isAbsolute())
-        return location;
-    const auto str = url.toString();
-    const auto idx = str.lastIndexOf('/'_q);
-    if (idx < 0)
-        return location;
-    return str.left(idx + 1) % location;
+    PlaylistReader reader(url, sink);
+    if (type == Binary)
+        return loadBinary(device, reader);
+    QTextStream in(device);
+    EncodingInfo enc = _enc;
+    if (type == M3U8)
+        enc = EncodingInfo::utf8();
+    if (enc.isValid())
+        in.setCodec(enc.codec());
+    switch (type) {
+    case PLS:
+        return loadPLS(in, reader);
+    case M3U:
+    case M3U8:
+        return loadM3U(in, reader);
+    case Cue:
+        return loadCue(in, reader);
+    default:
+        return false;
+    }
 }
 
 auto operator << (QDataStream &out, const Playlist &pl) -> QDataStream&
@@ -6,10 +6,13 @@
 
 class QFile;                            class QDir;
 class EncodingInfo;                     class ObjectStorage;
+class QIODevice;
 
 class Playlist : public QList<Mrl> {
 public:
-    enum Type {Unknown, PLS, M3U, M3U8, Cue};
+    enum Type {Unknown, PLS, M3U, M3U8, Cue, Binary};
+    // return false to stop reading
+    using Sink = std::function<bool(Mrl &&mrl)>;
     Playlist();
     Playlist(const Playlist &rhs);
     Playlist(const Mrl &mrl);
@@ -24,15 +27,13 @@ public:
     auto load(const QUrl &url, QByteArray *data, const EncodingInfo &enc, Type type) -> bool;
     static auto guessType(const QString &fileName) -> Type;
     static auto typeForSuffix(const QString &suffix) -> Type;
+    // parses incrementally, so that entries can be consumed while reading
+    static auto read(QIODevice *device, const EncodingInfo &enc, Type type,
+                     const QUrl &url, const Sink &sink) -> bool;
 private:
-    static auto resolve(const QString &location, const QUrl &url) -> QString;
     auto savePLS(QTextStream &out) const -> bool;
     auto saveM3U(QTextStream &out) const -> bool;
-    auto load(QTextStream &in, const EncodingInfo &enc, Type type,
-              const QUrl &url = QUrl()) -> bool;
-    auto loadPLS(QTextStream &in, const QUrl &url = QUrl()) -> bool;
-    auto loadM3U(QTextStream &in, const QUrl &url = QUrl()) -> bool;
-    auto loadCue(QTextStream &in, const QUrl &url = QUrl()) -> bool;
+    auto saveBinary(QIODevice *device) const -> bool;
 };
 
 Q_DECLARE_METATYPE(Playlist)
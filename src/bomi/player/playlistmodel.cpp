@@ -1,9 +1,87 @@
 #include "playlistmodel.hpp"
 #include "misc/downloader.hpp"
 #include "misc/encodinginfo.hpp"
+#include "misc/dataevent.hpp"
 #include <random>
 #include <chrono>
 #include <QQuickItem>
+#include <QBuffer>
+#include <QElapsedTimer>
+
+enum EventType { Loaded = QEvent::User + 1 };
+
+// parses a playlist in its own thread and posts entries in batches
+class PlaylistLoader : public QThread {
+public:
+    PlaylistLoader(const QString &file, const EncodingInfo &enc, Playlist::Type type)
+        : m_file(file), m_url(_UrlFromLocalFile(file)), m_enc(enc), m_type(type) { }
+    PlaylistLoader(const QUrl &url, const QByteArray &data,
+                   const EncodingInfo &enc, Playlist::Type type)
+        : m_url(url), m_data(data), m_enc(enc), m_type(type) { }
+    ~PlaylistLoader() { cancel(); wait(); }
+    auto start(QObject *receiver, int generation) -> void
+    {
+        m_receiver = receiver;
+        m_generation = generation;
+        QThread::start(QThread::LowPriority);
+    }
+    // nothing is posted after this returns
+    auto cancel() -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        m_canceled = true;
+        m_receiver = nullptr;
+    }
+private:
+    auto run() -> void final;
+    auto post(bool done) -> void
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_receiver)
+            _PostEvent(m_receiver, Loaded, m_generation, m_batch, done);
+        m_batch.clear();
+    }
+    QString m_file;
+    QUrl m_url;
+    QByteArray m_data;
+    EncodingInfo m_enc;
+    Playlist::Type m_type;
+    QObject *m_receiver = nullptr;
+    int m_generation = 0;
+    Playlist m_batch;
+    QMutex m_mutex;
+    std::atomic<bool> m_canceled{false};
+};
+
+auto PlaylistLoader::run() -> void
+{
+    QFile file(m_file);
+    QBuffer buffer(&m_data);
+    QIODevice *device = &buffer;
+    if (!m_file.isEmpty())
+        device = &file;
+    if (!device->open(QIODevice::ReadOnly)) {
+        post(true);
+        return;
+    }
+    // first batch is small to show something as soon as possible
+    static constexpr int FirstBatch = 256, Batch = 4096, Interval = 100;
+    int limit = FirstBatch;
+    QElapsedTimer timer;
+    timer.start();
+    Playlist::read(device, m_enc, m_type, m_url, [&] (Mrl &&mrl) {
+        if (m_canceled)
+            return false;
+        m_batch.push_back(mrl);
+        if (m_batch.size() >= limit || timer.elapsed() > Interval) {
+            post(false);
+            limit = Batch;
+            timer.restart();
+        }
+        return true;
+    });
+    post(true);
+}
 
 PlaylistModel::PlaylistModel(QObject *parent)
 : Super(parent) {
@@ -11,9 +89,78 @@ PlaylistModel::PlaylistModel(QObject *parent)
     connect(this, &PlaylistModel::rowsChanged, this, &PlaylistModel::countChanged);
     connect(this, &PlaylistModel::specialRowChanged, this, &PlaylistModel::loadedChanged);
     connect(this, &PlaylistModel::loadedChanged, this, &PlaylistModel::nextChanged);
+    // list is replaced by others, so stop appending
+    connect(this, &PlaylistModel::modelAboutToBeReset, this, &PlaylistModel::cancelLoading);
+}
+
+PlaylistModel::~PlaylistModel()
+{
+    delete m_loader;
+    // waits for canceled ones still running
+    qDeleteAll(m_canceled);
+}
+
+auto PlaylistModel::load(const QString &file, Playlist::Type type,
+                         const EncodingInfo &enc) -> void
+{
+    if (type == Playlist::Unknown)
+        type = Playlist::guessType(file);
+    startLoading(new PlaylistLoader(file, enc, type));
 }
 
-PlaylistModel::~PlaylistModel() {}
+auto PlaylistModel::startLoading(PlaylistLoader *loader) -> void
+{
+    clear();
+    cancelLoading();
+    m_loader = loader;
+    m_loader->start(this, ++m_generation);
+    emit loadingChanged();
+}
+
+auto PlaylistModel::cancelLoading() -> void
+{
+    // canceled ones are kept until finished to avoid waiting here
+    for (auto it = m_canceled.begin(); it != m_canceled.end(); ) {
+        if ((*it)->isFinished()) {
+            delete *it;
+            it = m_canceled.erase(it);
+        } else
+            ++it;
+    }
+    if (!m_loader)
+        return;
+    m_loader->cancel();
+    m_canceled.push_back(m_loader);
+    m_loader = nullptr;
+    ++m_generation; // drop batches already posted
+    m_pendingLoaded = Mrl();
+    emit loadingChanged();
+}
+
+auto PlaylistModel::customEvent(QEvent *event) -> void
+{
+    if (event->type() != static_cast<QEvent::Type>(Loaded))
+        return;
+    int generation = 0; Playlist batch; bool done = false;
+    _TakeData(event, generation, batch, done);
+    if (!m_loader || generation != m_generation)
+        return;
+    const int offset = rows();
+    append(batch);
+    if (!m_pendingLoaded.isEmpty()) {
+        const int idx = batch.indexOf(m_pendingLoaded);
+        if (idx >= 0) {
+            m_pendingLoaded = Mrl();
+            setLoaded(offset + idx);
+        }
+    }
+    if (done) {
+        m_loader->wait();
+        _Delete(m_loader);
+        m_pendingLoaded = Mrl();
+        emit loadingChanged();
+    }
+}
 
 auto PlaylistModel::next() const -> int
 {
@@ -145,7 +292,10 @@ auto PlaylistModel::setLoaded(int row) -> void
 
 auto PlaylistModel::setLoaded(const Mrl &mrl) -> void
 {
-    setLoaded(rowOf(mrl));
+    const int row = rowOf(mrl);
+    // may be in batches not arrived yet
+    m_pendingLoaded = row < 0 && m_loader ? mrl : Mrl();
+    setLoaded(row);
 }
 
 auto PlaylistModel::setDownloader(Downloader *downloader) -> void
@@ -154,14 +304,13 @@ auto PlaylistModel::setDownloader(Downloader *downloader) -> void
     connect(m_downloader, &Downloader::finished, this, [this] () {
         if (m_downloader->isCanceled())
             return;
-        auto data = m_downloader->takeData();
+        const auto data = m_downloader->takeData();
         const auto suffix = m_downloader->suffixes().value(0);
         const auto type = Playlist::typeForSuffix(suffix);
-        Playlist list;
-        if (list.load(m_downloader->url(), &data, m_enc, type)) {
-            setList(list);
-            setVisible(true);
-        }
+        if (type == Playlist::Unknown)
+            return;
+        startLoading(new PlaylistLoader(m_downloader->url(), data, m_enc, type));
+        setVisible(true);
     });
 }
 
@@ -183,7 +332,7 @@ auto PlaylistModel::add(const QString &mrl) -> void
 auto PlaylistModel::open(const Mrl &mrl, const EncodingInfo &enc) -> void
 {
     if (mrl.isLocalFile()) {
-        setList({mrl, enc});
+        load(mrl.toLocalFile(), Playlist::Unknown, enc);
         setVisible(true);
     } else {
         if (m_downloader->isRunning())
@@ -5,6 +5,7 @@
 #include "misc/simplelistmodel.hpp"
 
 class Downloader;                       class EncodingInfo;
+class PlaylistLoader;
 
 class PlaylistModel : public SimpleListModel<Mrl, Playlist> {
     Q_OBJECT
@@ -18,6 +19,7 @@ class PlaylistModel : public SimpleListModel<Mrl, Playlist> {
     Q_PROPERTY(int selected READ selected WRITE select NOTIFY selectedChanged)
     Q_PROPERTY(bool shuffled READ isShuffled NOTIFY shuffledChanged)
     Q_PROPERTY(bool repetitive READ repeat NOTIFY repeatChanged)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
     Q_ENUMS(Role)
 public:
     enum Role {NameRole = Qt::UserRole + 1, LocationRole, LoadedRole};
@@ -41,12 +43,16 @@ public:
     auto isShuffled() const -> bool { return m_shuffled; }
     auto selected() const -> int { return m_selected; }
     auto repeat() const -> bool { return m_repeat; }
+    auto isLoading() const -> bool { return m_loader; }
     Q_INVOKABLE QString name(int row) const {return value(row).displayName();}
     Q_INVOKABLE QString location(int row) const;
     Q_INVOKABLE QString number(int row) const;
     Q_INVOKABLE bool isLoaded(int row) const {return loaded() == row;}
 
     auto open(const Mrl &mrl, const EncodingInfo &enc) -> void;
+    // replaces list with entries of file which are appended while parsing
+    auto load(const QString &file, Playlist::Type type = Playlist::Unknown,
+              const EncodingInfo &enc = EncodingInfo()) -> void;
     Q_INVOKABLE void open(const QString &mrl);
     Q_INVOKABLE void open(const QString &mrl, const QString &enc);
     Q_INVOKABLE void add(const QString &mrl);
@@ -75,10 +81,14 @@ signals:
     void shuffledChanged();
     void repeatChanged();
     void nextChanged();
+    void loadingChanged();
 private:
     friend class PlayEngine;
     auto setLoaded(int row) -> void;
     auto shuffle() const -> void;
+    auto startLoading(PlaylistLoader *loader) -> void;
+    auto cancelLoading() -> void;
+    auto customEvent(QEvent *event) -> void final;
     QChar m_fill = QChar::Null;
     bool m_visible = false;
     int m_selected = -1;
@@ -86,6 +96,10 @@ private:
     EncodingInfo m_enc;
     bool m_shuffled = false, m_repeat = false;
     mutable QVector<int> m_shuffledIdx;
+    PlaylistLoader *m_loader = nullptr;
+    QList<PlaylistLoader*> m_canceled;
+    int m_generation = 0;
+    Mrl m_pendingLoaded;
 };
 
 inline auto PlaylistModel::setFillChar(QChar c) -> void
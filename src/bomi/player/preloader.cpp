@@ -0,0 +1,171 @@
+#include "preloader.hpp"
+#include "historymodel.hpp"
+#include "misc/log.hpp"
+#include <QElapsedTimer>
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+DECLARE_LOG_CONTEXT(Preloader)
+
+// enough for container headers and first packets of common files
+static constexpr int ReadAhead = 8 * 1024 * 1024;
+static constexpr int ReadChunk = 1024 * 1024;
+static constexpr int ProbeSize = 1024 * 1024;
+
+struct PreloadRequest {
+    Mrl mrl;
+    Autoloader audio, subtitle;
+    HistoryModel *history = nullptr;
+};
+
+struct Preloader::Data {
+    Done done;
+    HistoryModel *history = nullptr;
+    QMutex mutex;
+    QWaitCondition wait;
+    PreloadRequest request;
+    bool pending = false, quit = false;
+    std::atomic<bool> canceled{false};
+    QByteArray buffer;
+
+    // reads head of file to page cache and returns probed format
+    auto readAhead(const QString &path, qint64 *read) -> QByteArray
+    {
+        QFile file(path);
+        if (!file.open(QFile::ReadOnly))
+            return QByteArray();
+        buffer.resize(ReadAhead + AVPROBE_PADDING_SIZE);
+        auto data = buffer.data();
+        qint64 size = 0;
+        while (size < ReadAhead && !canceled) {
+            const auto len = file.read(data + size, qMin<qint64>(ReadChunk, ReadAhead - size));
+            if (len <= 0)
+                break;
+            size += len;
+        }
+        *read = size;
+        if (canceled || size <= 0)
+            return QByteArray();
+        const int probe = qMin<qint64>(size, ProbeSize);
+        memset(data + probe, 0, AVPROBE_PADDING_SIZE);
+        const auto name = path.toUtf8();
+        AVProbeData pd;
+        memset(&pd, 0, sizeof(pd));
+        pd.filename = name.constData();
+        pd.buf = reinterpret_cast<uchar*>(data);
+        pd.buf_size = probe;
+        int score = 0;
+        auto fmt = av_probe_input_format2(&pd, true, &score);
+        if (!fmt || score < AVPROBE_SCORE_MAX / 4)
+            return QByteArray();
+        return QByteArray(fmt->name) + ';';
+    }
+    auto preload(const PreloadRequest &req) -> PreloadedMrlPtr
+    {
+        QElapsedTimer timer;
+        timer.start();
+        auto pre = QSharedPointer<PreloadedMrl>::create();
+        pre->mrl = req.mrl;
+        // result is kept in history's cache until the file is opened
+        if (req.history)
+            req.history->find(req.mrl.toUnique());
+        if (req.mrl.isLocalFile()) {
+            const auto path = req.mrl.toLocalFile();
+            pre->probeHint = readAhead(path, &pre->cached);
+            if (req.audio.enabled)
+                pre->audios = req.audio.autoload(req.mrl, AudioExt);
+            if (req.subtitle.enabled) {
+                for (auto &file : req.subtitle.autoload(req.mrl, SubtitleExt)) {
+                    if (canceled)
+                        break;
+                    pre->subtitles.push_back(parseSubtitle(file));
+                }
+            }
+        }
+        pre->elapsed = timer.nsecsElapsed() * 1e-6;
+        return pre;
+    }
+};
+
+Preloader::Preloader(Done &&done)
+    : d(new Data)
+{
+    d->done = std::move(done);
+}
+
+Preloader::~Preloader()
+{
+    finish();
+    delete d;
+}
+
+auto Preloader::setHistory(HistoryModel *history) -> void
+{
+    QMutexLocker locker(&d->mutex);
+    d->history = history;
+}
+
+auto Preloader::request(const Mrl &mrl, const Autoloader &audio,
+                        const Autoloader &subtitle) -> void
+{
+    QMutexLocker locker(&d->mutex);
+    d->request = { mrl, audio, subtitle, d->history };
+    d->pending = true;
+    d->canceled = true;
+    d->wait.wakeAll();
+}
+
+auto Preloader::cancel() -> void
+{
+    QMutexLocker locker(&d->mutex);
+    d->pending = false;
+    d->canceled = true;
+}
+
+auto Preloader::finish() -> void
+{
+    d->mutex.lock();
+    d->quit = d->canceled = true;
+    d->wait.wakeAll();
+    d->mutex.unlock();
+    wait();
+}
+
+auto Preloader::parseSubtitle(const QString &file) -> PreloadedSubtitle
+{
+    PreloadedSubtitle ret;
+    ret.file = file;
+    ret.encoding = EncodingInfo::detect(EncodingInfo::Subtitle, file);
+    Subtitle sub;
+    ret.parsed = sub.load(file, ret.encoding);
+    if (ret.parsed) {
+        for (int i = 0; i < sub.size(); ++i)
+            ret.components.push_back(sub[i]);
+    }
+    return ret;
+}
+
+auto Preloader::run() -> void
+{
+    forever {
+        d->mutex.lock();
+        while (!d->quit && !d->pending)
+            d->wait.wait(&d->mutex);
+        if (d->quit) {
+            d->mutex.unlock();
+            break;
+        }
+        const auto req = d->request;
+        d->pending = d->canceled = false;
+        d->mutex.unlock();
+
+        auto pre = d->preload(req);
+        if (d->canceled)
+            continue;
+        _Debug("Preloaded %%: %%KiB in %%ms", req.mrl.toString(),
+               pre->cached / 1024, pre->elapsed);
+        d->done(pre);
+    }
+    d->buffer = QByteArray();
+}
@@ -0,0 +1,48 @@
+#ifndef PRELOADER_HPP
+#define PRELOADER_HPP
+
+#include "mrl.hpp"
+#include "misc/autoloader.hpp"
+#include "subtitle/subtitle.hpp"
+
+class HistoryModel;
+
+struct PreloadedSubtitle {
+    QString file;
+    EncodingInfo encoding;
+    QVector<SubComp> components;
+    bool parsed = false; // otherwise left for mpv
+};
+
+struct PreloadedMrl {
+    Mrl mrl;
+    QStringList audios;
+    QVector<PreloadedSubtitle> subtitles;
+    QByteArray probeHint; // only format part, empty if not probed
+    qint64 cached = 0; // bytes read ahead
+    double elapsed = 0.0; // ms
+};
+
+using PreloadedMrlPtr = QSharedPointer<const PreloadedMrl>;
+
+// prepares the next item in playlist so that opening it later spends little
+// time in the work bomi does for each file
+class Preloader : public QThread {
+public:
+    using Done = std::function<void(const PreloadedMrlPtr&)>;
+    Preloader(Done &&done);
+    ~Preloader();
+    auto setHistory(HistoryModel *history) -> void;
+    // replaces previous request if it is not started yet
+    auto request(const Mrl &mrl, const Autoloader &audio,
+                 const Autoloader &subtitle) -> void;
+    auto cancel() -> void;
+    auto finish() -> void;
+    static auto parseSubtitle(const QString &file) -> PreloadedSubtitle;
+private:
+    auto run() -> void final;
+    struct Data;
+    Data *d;
+};
+
+#endif // PRELOADER_HPP
@@ -0,0 +1,81 @@
+#include "presentationstats.hpp"
+
+auto PresentationStats::Times::push(double t) -> void
+{
+    max = count ? qMax(max, t) : t;
+    last = t;
+    total += t;
+    ++count;
+}
+
+auto PresentationStats::Times::toMap() const -> QVariantMap
+{
+    QVariantMap map;
+    map[u"last"_q] = last;
+    map[u"mean"_q] = count ? total / count : 0.0;
+    map[u"max"_q] = max;
+    return map;
+}
+
+auto PresentationStats::update(const mpv_opengl_cb_stats &stats) -> void
+{
+    QMutexLocker locker(&m_mutex);
+    if (stats.frames != m_last.frames)
+        m_latency.push(stats.queue_latency * 1e-3);
+    if (stats.presented != m_last.presented) {
+        m_error.push(stats.display_error * 1e-3);
+        if (stats.vsync_interval > 0) {
+            const double vsyncs = stats.display_error / (double)stats.vsync_interval;
+            const int bin = qFloor((vsyncs - HistogramMin) / HistogramStep);
+            ++m_histogram[qBound(0, bin, Bins - 1)];
+        }
+    }
+    m_changed |= stats.frames != m_last.frames
+            || stats.dropped_late != m_last.dropped_late
+            || stats.dropped_queue_full != m_last.dropped_queue_full
+            || stats.dropped_flush != m_last.dropped_flush;
+    m_last = stats;
+}
+
+auto PresentationStats::clear() -> void
+{
+    QMutexLocker locker(&m_mutex);
+    m_base = m_last;
+    m_latency = m_error = Times();
+    m_histogram.fill(0);
+    m_changed = true;
+}
+
+auto PresentationStats::takeChanged() -> bool
+{
+    QMutexLocker locker(&m_mutex);
+    return _Change(m_changed, false);
+}
+
+auto PresentationStats::toMap() const -> QVariantMap
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantMap dropped;
+    dropped[u"late"_q] = qint64(m_last.dropped_late - m_base.dropped_late);
+    dropped[u"queueFull"_q] = qint64(m_last.dropped_queue_full - m_base.dropped_queue_full);
+    dropped[u"flush"_q] = qint64(m_last.dropped_flush - m_base.dropped_flush);
+    QVariantList counts;
+    for (auto count : m_histogram)
+        counts.push_back(count);
+    QVariantMap histogram;
+    histogram[u"min"_q] = HistogramMin;
+    histogram[u"step"_q] = HistogramStep;
+    histogram[u"counts"_q] = counts;
+
+    QVariantMap map;
+    map[u"frames"_q] = qint64(m_last.frames - m_base.frames);
+    map[u"presented"_q] = qint64(m_last.presented - m_base.presented);
+    map[u"queued"_q] = m_last.queued;
+    map[u"queueSize"_q] = m_last.queue_size;
+    map[u"vsync"_q] = m_last.vsync_interval * 1e-3;
+    map[u"dropped"_q] = dropped;
+    map[u"queueLatency"_q] = m_latency.toMap();
+    map[u"displayError"_q] = m_error.toMap();
+    map[u"histogram"_q] = histogram;
+    return map;
+}
@@ -0,0 +1,33 @@
+#ifndef PRESENTATIONSTATS_HPP
+#define PRESENTATIONSTATS_HPP
+
+#include <libmpv/opengl_cb.h>
+
+// queue latency, display error and drops of opengl-cb frames
+// fed in render thread after each flip, read in any thread
+class PresentationStats {
+public:
+    // histogram of display error in vsync intervals, folded at both ends
+    static constexpr int Bins = 24;
+    static constexpr double HistogramMin = -2.0, HistogramStep = 0.25;
+    auto update(const mpv_opengl_cb_stats &stats) -> void;
+    // counters start from current values
+    auto clear() -> void;
+    // true if frames were rendered or dropped since last call
+    auto takeChanged() -> bool;
+    // times in ms
+    auto toMap() const -> QVariantMap;
+private:
+    struct Times {
+        double last = 0, total = 0, max = 0; int count = 0;
+        auto push(double t) -> void;
+        auto toMap() const -> QVariantMap;
+    };
+    mutable QMutex m_mutex;
+    mpv_opengl_cb_stats m_last{}, m_base{};
+    Times m_latency, m_error;
+    std::array<int, Bins> m_histogram{};
+    bool m_changed = false;
+};
+
+#endif // PRESENTATIONSTATS_HPP
@@ -6,6 +6,7 @@ struct RecentInfo::Data {
     int max = 10;
     Playlist openList, lastList;
     Mrl lastMrl;
+    bool lastListChanged = false;
     ObjectStorage storage;
     Update update;
 };
@@ -17,12 +18,14 @@ RecentInfo::RecentInfo()
                    [=] () { return QVariant::fromValue(d->lastMrl.location()); },
                    [=] (auto &var) { return d->lastMrl = var.toString(); });
     d->storage.add("recent-open-list", &d->openList);
-    d->storage.add("last-playlist", &d->lastList);
+    // saved in binary file instead, legacy list is read for migration
+    d->storage.add("last-playlist", [] () { return QVariant::fromValue(Playlist()); },
+                   [=] (auto &var) { d->lastList = var.template value<Playlist>(); });
     d->storage.restore();
 }
 
 RecentInfo::~RecentInfo() {
-    d->storage.save();
+    save();
     delete d;
 }
 
@@ -53,6 +56,10 @@ auto RecentInfo::clear() -> void
 auto RecentInfo::save() const -> void
 {
     d->storage.save();
+    if (d->lastListChanged) {
+        d->lastList.save(lastPlaylistFile(), Playlist::Binary);
+        d->lastListChanged = false;
+    }
 }
 
 auto RecentInfo::load() -> void
@@ -63,6 +70,7 @@ auto RecentInfo::load() -> void
 auto RecentInfo::setLastPlaylist(const Playlist &list) -> void
 {
     d->lastList = list;
+    d->lastListChanged = true;
 }
 
 auto RecentInfo::lastPlaylist() const -> Playlist
@@ -70,6 +78,11 @@ auto RecentInfo::lastPlaylist() const -> Playlist
     return d->lastList;
 }
 
+auto RecentInfo::lastPlaylistFile() -> QString
+{
+    return _WritablePath(Location::Config) % "/last-playlist.bpl"_a;
+}
+
 auto RecentInfo::setLastMrl(const Mrl &mrl) -> void
 {
     d->lastMrl = mrl;
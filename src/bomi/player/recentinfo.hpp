@@ -13,7 +13,9 @@ public:
     auto setLastPlaylist(const Playlist &list) -> void;
     auto setLastMrl(const Mrl &mrl) -> void;
     auto lastMrl() const -> Mrl;
+    // empty if saved in lastPlaylistFile()
     auto lastPlaylist() const -> Playlist;
+    static auto lastPlaylistFile() -> QString;
     auto clear() -> void;
     auto setUpdateFunc(Update &&func) -> void;
 private:
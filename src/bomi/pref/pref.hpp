@@ -91,6 +91,7 @@ private:
     P0(bool, show_logo, true)
     P0(QColor, bg_color, Qt::black)
     P0(bool, exclude_images, true)
+    P0(bool, preload_next, true)
     P0(QStringList, sub_priority, {})
     P0(QStringList, audio_priority, {})
     P0(int, volume_scale, 60)
@@ -99,6 +100,8 @@ private:
     P0(ControlsTheme, controls_theme, {})
 
     P0(MotionIntrplOption, motion_interpolation, {})
+    P0(bool, video_frame_pacing, false)
+    P0(bool, video_frame_pacing_audio, false)
 
     P0(ChannelLayoutMap, channel_manipulation, ChannelLayoutMap::default_())
 
@@ -1,5 +1,6 @@
 #include "simplefboitem.hpp"
 #include "opengl/openglframebufferobject.hpp"
+#include "opengl/openglresourcepool.hpp"
 
 SimpleFboItem::SimpleFboItem(QQuickItem *parent)
 : SimpleTextureItem(parent) {
@@ -15,7 +16,9 @@ SimpleFboItem::SimpleFboItem(QQuickItem *parent)
 
 auto SimpleFboItem::finalizeGL() -> void
 {
-    SimpleTextureItem::finalizeGL(); _Delete(m_fbo);
+    SimpleTextureItem::finalizeGL();
+    OpenGLResourcePool::current()->release(m_fbo);
+    m_fbo = nullptr;
 }
 
 auto SimpleFboItem::updateVertex(Vertex *vertex) -> void
@@ -41,12 +44,15 @@ auto SimpleFboItem::geometryChanged(const QRectF &new_, const QRectF &old) -> vo
 auto SimpleFboItem::updateTexture(OpenGLTexture2D *texture) -> void
 {
     const auto size = imageSize();
+    auto pool = OpenGLResourcePool::current();
     if (size.isEmpty()) {
-        _Delete(m_fbo);
+        pool->release(m_fbo);
+        m_fbo = nullptr;
         *texture = OpenGLTexture2D();
     } else {
         if (!m_fbo || m_fbo->size() != size) {
-            _Renew(m_fbo, size);
+            pool->release(m_fbo);
+            m_fbo = pool->takeFramebufferObject(size);
             *texture = m_fbo->texture();
         }
         paint(m_fbo);
@@ -4,6 +4,7 @@
 #include "enum/autoselectmode.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/opengltexturebinder.hpp"
+#include "opengl/openglresourcepool.hpp"
 
 struct SubtitleShaderData : public SubtitleRenderer::ShaderData {
     const OpenGLTexture2D *texture, *bbox;
@@ -154,15 +155,15 @@ auto SubtitleRenderer::createShader() const -> ShaderIface*
 auto SubtitleRenderer::initializeGL() -> void
 {
     SimpleTextureItem::initializeGL();
-    texture().create();
-    d->bbox.create();
 }
 
 auto SubtitleRenderer::finalizeGL() -> void
 {
     SimpleTextureItem::finalizeGL();
-    d->bbox.destroy();
-    texture().destroy();
+    auto pool = OpenGLResourcePool::current();
+    pool->release(d->bbox);
+    pool->release(texture());
+    d->bbox = texture() = OpenGLTexture2D();
 }
 
 auto SubtitleRenderer::text() const -> const RichTextDocument&
@@ -311,11 +312,18 @@ auto SubtitleRenderer::updateTexture(OpenGLTexture2D *texture) -> void
     if (!d->imageSize.isEmpty()) {
         const auto len = d->imageSize.width()*d->imageSize.height();
         _Expand(d->zeros, len);
+        if (texture->size() != d->imageSize) {
+            auto pool = OpenGLResourcePool::current();
+            pool->release(*texture);
+            pool->release(d->bbox);
+            *texture = pool->takeTexture(d->imageSize, texture->info());
+            d->bbox = pool->takeTexture(d->imageSize, d->bbox.info());
+        }
         OpenGLTextureBinder<OGL::Target2D> binder;
         binder.bind(texture);
-        texture->initialize(d->imageSize, d->zeros.data());
+        texture->upload(d->zeros.data());
         binder.bind(&d->bbox);
-        d->bbox.initialize(d->imageSize, d->zeros.data());
+        d->bbox.upload(d->zeros.data());
         int y = 0;
         d->selection.forImages([&] (const SubCompImage &image) {
             const int x = (texture->width() - image.width())*0.5;
@@ -0,0 +1,68 @@
+#include "framepacertest.hpp"
+#include "video/framepacer.hpp"
+#include <random>
+#include <QtTest>
+
+static constexpr double Hz = 60.0, Window = 0.01;
+
+// shows frames of fps on a display of hz for secs like VideoRenderer does;
+// flip timestamps and wake-ups of the render loop are jittered, and the loop
+// stalls for a vsync once in a while, returns the number of stalls
+static auto simulate(FramePacer &pacer, double fps, double hz, int secs) -> int
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> jitter(-1500.0, 1500.0);
+    std::uniform_real_distribution<double> wake(2000.0, 14000.0);
+    const double vsync = 1e6 / hz, frame = 1e6 / fps;
+    const qint64 start = 1000000, offset = 5000;
+    const int vsyncs = secs * hz;
+    int next = 0, stalls = 0;
+    for (int n = 1; n <= vsyncs; ++n) {
+        const double time = start + n * vsync;
+        if (!(n % 600)) {
+            ++stalls;
+            continue;
+        }
+        const qint64 pts = start + offset + next * frame;
+        if (pacer.isDue(pts, time - wake(rng))) {
+            pacer.render(pts);
+            ++next;
+        }
+        pacer.flip(time + jitter(rng));
+    }
+    return stalls;
+}
+
+void FramePacerTest::pacing_data()
+{
+    QTest::addColumn<double>("fps");
+    QTest::newRow("24") << 24.0;
+    QTest::newRow("23.976") << 24000.0 / 1001.0;
+}
+
+void FramePacerTest::pacing()
+{
+    QFETCH(double, fps);
+    FramePacer pacer;
+    const int stalls = simulate(pacer, fps, Hz, 60);
+    const auto speed = pacer.syncSpeed(fps, Window);
+    qDebug().nospace() << fps << "fps on " << Hz << "Hz: vsync "
+                       << pacer.vsyncInterval() << "us, "
+                       << pacer.presentedFrames() << " frames, "
+                       << pacer.missedFrames() << " missed with "
+                       << stalls << " stalls, cadence error "
+                       << pacer.cadenceError() << ", sync speed " << speed;
+    QVERIFY(qAbs(pacer.vsyncInterval() * Hz / 1e6 - 1.0) < 1e-3);
+    QVERIFY(pacer.presentedFrames() > fps * 59);
+    QVERIFY(pacer.missedFrames() <= stalls + pacer.presentedFrames() / 100);
+    QVERIFY(pacer.cadenceError() < 0.05);
+    // 3:2 pulldown
+    QVERIFY(qAbs(speed - Hz / fps / 2.5) < 2e-4);
+}
+
+void FramePacerTest::syncSpeedWindow()
+{
+    FramePacer pacer;
+    simulate(pacer, 24.0, Hz, 60);
+    QCOMPARE(pacer.syncSpeed(25.0, Window), 1.0);
+}
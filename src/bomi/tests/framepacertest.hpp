@@ -0,0 +1,13 @@
+#ifndef FRAMEPACERTEST_HPP
+#define FRAMEPACERTEST_HPP
+
+// film content on a simulated jittery 60Hz display
+class FramePacerTest : public QObject {
+    Q_OBJECT
+private slots:
+    void pacing_data();
+    void pacing();
+    void syncSpeedWindow();
+};
+
+#endif // FRAMEPACERTEST_HPP
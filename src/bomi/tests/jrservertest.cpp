@@ -0,0 +1,190 @@
+#include "jrservertest.hpp"
+#include "json/jrserver.hpp"
+#include "json/jriface.hpp"
+#include "json/jrcommon.hpp"
+#include <QLocalSocket>
+#include <QLocalServer>
+#include <QElapsedTimer>
+#include <QtTest>
+
+namespace {
+struct TestIface : public JrIface {
+    using JrIface::request;
+    QHash<QString, QJsonValue> values;
+    QSet<QString> watched;
+    auto request(const JrRequest &request) -> JrResponse final
+        { return _JrErrorResponse(request.id(), JrError::MethodNotFound); }
+    auto read(const QString &name) -> QJsonValue final
+        { return values.value(name, QJsonValue::Undefined); }
+    auto watch(const QString &name) -> bool final
+    {
+        if (!values.contains(name))
+            return false;
+        watched.insert(name);
+        return true;
+    }
+    auto unwatch(const QString &name) -> void final { watched.remove(name); }
+    auto set(const QString &name, const QJsonValue &value) -> void
+    {
+        values[name] = value;
+        if (watched.contains(name))
+            notify(name, value);
+    }
+};
+}
+
+struct JrServerTest::Data {
+    TestIface iface;
+    JrServer *server = nullptr;
+    QLocalSocket *socket = nullptr;
+    QTimer tick;
+
+    // server runs in this thread, so wait by event loop
+    auto wait(std::function<bool()> &&cond, int msec) -> bool
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (!cond()) {
+            if (timer.elapsed() > msec)
+                return false;
+            qApp->processEvents(QEventLoop::WaitForMoreEvents);
+        }
+        return true;
+    }
+    auto readLine(int msec = 3000) -> QJsonObject
+    {
+        if (!wait([&] () { return socket->canReadLine(); }, msec))
+            return QJsonObject();
+        return QJsonDocument::fromJson(socket->readLine()).object();
+    }
+    auto call(int id, const char *method, const QJsonObject &params) -> void
+    {
+        const QJsonObject json{{u"jsonrpc"_q, u"2.0"_q}, {u"id"_q, id},
+                               {u"method"_q, _L(method)}, {u"params"_q, params}};
+        socket->write(QJsonDocument(json).toJson(QJsonDocument::Compact) % '\n');
+    }
+    // params of next notification or empty
+    auto pushed() -> QJsonObject
+    {
+        const auto json = readLine();
+        return json[u"method"_q].toString() == "rpc.notify"_a
+                ? json[u"params"_q].toObject() : QJsonObject();
+    }
+    auto subscribe(int id, const QJsonArray &properties) -> QJsonArray
+    {
+        call(id, "rpc.subscribe", {{u"properties"_q, properties}});
+        const auto res = readLine();
+        return res[u"id"_q].toInt() == id ? res[u"result"_q].toArray() : QJsonArray();
+    }
+    // initial values are pushed after the reply, possibly merged
+    auto initial(int count) -> QJsonObject
+    {
+        QJsonObject values;
+        while (values.size() < count) {
+            const auto params = pushed();
+            if (params.isEmpty())
+                break;
+            for (auto it = params.begin(); it != params.end(); ++it)
+                values.insert(it.key(), it.value());
+        }
+        return values;
+    }
+};
+
+JrServerTest::JrServerTest()
+    : d(new Data)
+{
+    d->tick.setInterval(10);
+}
+
+JrServerTest::~JrServerTest()
+{
+    delete d;
+}
+
+void JrServerTest::init()
+{
+    d->iface.values.clear();
+    d->iface.watched.clear();
+    d->iface.values[u"a"_q] = 1;
+    d->iface.values[u"b"_q] = u"x"_q;
+    d->iface.values[u"big"_q] = QString();
+    d->server = new JrServer(JrConnection::Local, JrProtocol::Raw);
+    d->server->setInterface(&d->iface);
+    const auto name = u"bomi-test-jsonrpc-"_q
+            % _N((quint64)QCoreApplication::applicationPid());
+    QLocalServer::removeServer(name);
+    QVERIFY(d->server->listen(name));
+    d->tick.start();
+    d->socket = new QLocalSocket;
+    d->socket->connectToServer(name);
+    QVERIFY(d->wait([&] () { return d->socket->state() == QLocalSocket::ConnectedState; }, 3000));
+}
+
+void JrServerTest::cleanup()
+{
+    _Delete(d->socket);
+    _Delete(d->server);
+    d->tick.stop();
+}
+
+void JrServerTest::subscribe()
+{
+    QCOMPARE(d->subscribe(1, {u"a"_q, u"b"_q, u"none"_q}), QJsonArray({u"a"_q, u"b"_q}));
+    const auto values = d->initial(2);
+    QCOMPARE(values[u"a"_q].toInt(), 1);
+    QCOMPARE(values[u"b"_q].toString(), u"x"_q);
+
+    d->iface.set(u"a"_q, 2);
+    QCOMPARE(d->pushed(), QJsonObject({{u"a"_q, 2}}));
+}
+
+void JrServerTest::unsubscribe()
+{
+    QCOMPARE(d->subscribe(1, {u"a"_q, u"b"_q}).size(), 2);
+    QCOMPARE(d->initial(2).size(), 2);
+
+    d->call(2, "rpc.unsubscribe", {{u"properties"_q, QJsonArray{u"a"_q}}});
+    auto res = d->readLine();
+    QCOMPARE(res[u"id"_q].toInt(), 2);
+    QCOMPARE(res[u"result"_q].toArray(), QJsonArray({u"a"_q}));
+    QVERIFY(!d->iface.watched.contains(u"a"_q));
+    QVERIFY(d->iface.watched.contains(u"b"_q));
+    d->iface.set(u"a"_q, 3);
+    d->iface.set(u"b"_q, u"y"_q);
+    QCOMPARE(d->pushed(), QJsonObject({{u"b"_q, u"y"_q}}));
+
+    d->call(3, "rpc.unsubscribe", {});
+    res = d->readLine();
+    QCOMPARE(res[u"result"_q].toArray(), QJsonArray({u"b"_q}));
+    QVERIFY(d->iface.watched.isEmpty());
+}
+
+// a reader which does not read makes server hold back pushes, and the latest
+// value arrives once it reads again
+void JrServerTest::slowReader()
+{
+    QCOMPARE(d->subscribe(1, {u"big"_q}), QJsonArray({u"big"_q}));
+    QCOMPARE(d->initial(1).size(), 1);
+    static constexpr int Changes = 100;
+    QString big(256 * 1024, 'x'_q);
+    d->socket->setReadBufferSize(4096);
+    for (int i = 0; i < Changes; ++i) {
+        big.replace(0, 3, _N(i, 10, 3, '0'_q));
+        d->iface.set(u"big"_q, big);
+        d->wait([] () { return false; }, 10);
+    }
+    d->socket->setReadBufferSize(0);
+    int received = 0;
+    QString last;
+    while (last != big) {
+        const auto params = d->pushed();
+        if (params.isEmpty())
+            break;
+        last = params[u"big"_q].toString();
+        ++received;
+    }
+    QVERIFY(last == big);
+    QVERIFY2(received < Changes, qPrintable(u"%1 notifications for %2 changes"_q
+                                            .arg(received).arg(Changes)));
+}
@@ -0,0 +1,21 @@
+#ifndef JRSERVERTEST_HPP
+#define JRSERVERTEST_HPP
+
+// property subscriptions of raw clients over a local socket
+class JrServerTest : public QObject {
+    Q_OBJECT
+public:
+    JrServerTest();
+    ~JrServerTest();
+private slots:
+    void init();
+    void cleanup();
+    void subscribe();
+    void unsubscribe();
+    void slowReader();
+private:
+    struct Data;
+    Data *d;
+};
+
+#endif // JRSERVERTEST_HPP
@@ -0,0 +1,26 @@
+#include "jrservertest.hpp"
+#include "framepacertest.hpp"
+#include "openglresourcepooltest.hpp"
+#include <clocale>
+#include <QtTest>
+
+template<class T>
+static auto run(int argc, char **argv) -> int
+{
+    T test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+int main(int argc, char **argv)
+{
+    QApplication::setAttribute(Qt::AA_X11InitThreads);
+    QApplication app(argc, argv);
+#ifdef Q_OS_LINUX
+    setlocale(LC_NUMERIC, "C");
+#endif
+    int failed = 0;
+    failed += !!run<JrServerTest>(argc, argv);
+    failed += !!run<FramePacerTest>(argc, argv);
+    failed += !!run<OpenGLResourcePoolTest>(argc, argv);
+    return failed;
+}
@@ -0,0 +1,135 @@
+#include "openglresourcepooltest.hpp"
+#include "opengl/openglresourcepool.hpp"
+#include "opengl/openglframebufferobject.hpp"
+#include "opengl/opengloffscreencontext.hpp"
+#include <QtTest>
+
+static const QSize Size(640, 360), Smaller(600, 330), Small(256, 256);
+static constexpr qint64 SizeBytes = 640 * 360 * 4, SmallerBytes = 600 * 330 * 4;
+static constexpr qint64 SmallBytes = 256 * 256 * 4;
+
+// each test gets a new context, so pool and its stats start from scratch
+void OpenGLResourcePoolTest::init()
+{
+    m_gl = new OpenGLOffscreenContext;
+    m_gl->setContextName(u"ResourcePoolTest"_q);
+    if (!m_gl->createContext())
+        QSKIP("Cannot create OpenGL context.");
+    m_gl->createSurface();
+    if (!m_gl->makeCurrent())
+        QSKIP("Cannot make OpenGL context current.");
+    m_pool = OpenGLResourcePool::current();
+    QVERIFY(m_pool);
+}
+
+void OpenGLResourcePoolTest::cleanup()
+{
+    if (m_pool)
+        m_pool->clear();
+    m_pool = nullptr;
+    _Delete(m_gl);
+}
+
+void OpenGLResourcePoolTest::reuse()
+{
+    auto s = [&] () { return m_pool->stats(); };
+    auto a = m_pool->takeFramebufferObject(Size);
+    QCOMPARE(s().usedBytes, SizeBytes);
+    QCOMPARE(s().used, 1);
+    const auto aId = a->id();
+    const auto aSerial = a->serial();
+    m_pool->release(a);
+    QCOMPARE(s().usedBytes, 0ll);
+    QCOMPARE(s().freeBytes, SizeBytes);
+    QCOMPARE(s().free, 1);
+
+    // drawing into a released one may wait for its last user
+    auto b = m_pool->takeFramebufferObject(Size);
+    QVERIFY(b != a && b->id() != aId);
+    QCOMPARE(s().misses, 2ull);
+    QCOMPARE(s().hits, 0ull);
+    const auto bSerial = b->serial();
+    m_pool->release(b);
+    m_pool->endFrame();
+
+    auto c = m_pool->takeFramebufferObject(Size);
+    QCOMPARE(c, b);
+    QCOMPARE(s().hits, 1ull);
+    QVERIFY(c->serial() != bSerial);
+
+    // same size class is resized in place
+    auto r = m_pool->takeFramebufferObject(Smaller);
+    QCOMPARE(r, a);
+    QCOMPARE(r->id(), aId);
+    QCOMPARE(r->size(), Smaller);
+    QVERIFY(r->serial() != aSerial);
+    QCOMPARE(s().resized, 1ull);
+    QCOMPARE(s().misses, 2ull);
+    QCOMPARE(s().usedBytes, SizeBytes + SmallerBytes);
+    QCOMPARE(s().used, 2);
+    QCOMPARE(s().free, 0);
+    m_pool->release(c);
+    m_pool->release(r);
+    QCOMPARE(s().usedBytes, 0ll);
+    QCOMPARE(s().freeBytes, SizeBytes + SmallerBytes);
+}
+
+void OpenGLResourcePoolTest::expiry()
+{
+    auto s = [&] () { return m_pool->stats(); };
+    auto a = m_pool->takeFramebufferObject(Size);
+    auto b = m_pool->takeFramebufferObject(Smaller);
+    m_pool->release(a);
+    m_pool->release(b);
+    for (int i = 0; i < OpenGLResourcePool::MaxIdleFrames; ++i)
+        m_pool->endFrame();
+    QCOMPARE(s().free, 2);
+    QCOMPARE(s().deleted, 0ull);
+    m_pool->endFrame();
+    QCOMPARE(s().free, 0);
+    QCOMPARE(s().freeBytes, 0ll);
+    QCOMPARE(s().deleted, 2ull);
+}
+
+void OpenGLResourcePoolTest::budget()
+{
+    auto s = [&] () { return m_pool->stats(); };
+    // released in four frames, oldest first
+    OpenGLFramebufferObject *fbos[4];
+    GLuint ids[4];
+    for (int i = 0; i < 4; ++i) {
+        fbos[i] = m_pool->takeFramebufferObject(Small);
+        ids[i] = fbos[i]->id();
+    }
+    for (auto fbo : fbos) {
+        m_pool->release(fbo);
+        m_pool->endFrame();
+    }
+    QCOMPARE(s().freeBytes, 4 * SmallBytes);
+    m_pool->setBudget(2 * SmallBytes + 1);
+    QVERIFY(s().freeBytes <= m_pool->budget());
+    QCOMPARE(s().free, 2);
+    QCOMPARE(s().deleted, 2ull);
+
+    const auto hits = s().hits;
+    auto x = m_pool->takeFramebufferObject(Small);
+    auto y = m_pool->takeFramebufferObject(Small);
+    const QSet<GLuint> kept{ ids[2], ids[3] };
+    QCOMPARE(s().hits, hits + 2);
+    QVERIFY(kept.contains(x->id()) && kept.contains(y->id()) && x->id() != y->id());
+    m_pool->release(x);
+    m_pool->release(y);
+}
+
+void OpenGLResourcePoolTest::clear()
+{
+    auto s = [&] () { return m_pool->stats(); };
+    auto a = m_pool->takeFramebufferObject(Size);
+    auto b = m_pool->takeFramebufferObject(Small);
+    m_pool->release(a);
+    m_pool->release(b);
+    m_pool->clear();
+    QCOMPARE(s().free, 0);
+    QCOMPARE(s().freeBytes, 0ll);
+    QCOMPARE(s().used, 0);
+}
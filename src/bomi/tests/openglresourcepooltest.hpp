@@ -0,0 +1,21 @@
+#ifndef OPENGLRESOURCEPOOLTEST_HPP
+#define OPENGLRESOURCEPOOLTEST_HPP
+
+class OpenGLOffscreenContext;           class OpenGLResourcePool;
+
+// reuse, expiry and budget of the pool of an offscreen context
+class OpenGLResourcePoolTest : public QObject {
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+    void reuse();
+    void expiry();
+    void budget();
+    void clear();
+private:
+    OpenGLOffscreenContext *m_gl = nullptr;
+    OpenGLResourcePool *m_pool = nullptr;
+};
+
+#endif // OPENGLRESOURCEPOOLTEST_HPP
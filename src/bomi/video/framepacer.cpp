@@ -0,0 +1,103 @@
+#include "framepacer.hpp"
+
+// how fast the loop follows measured flips
+static constexpr double PhaseGain = 0.1, IntervalGain = 0.02;
+// after this many vsyncs since lock, interval is measured over a long span
+// instead, which cancels out jitter of single flips; the span is kept
+// between Span and 2 * Span vsyncs
+static constexpr int MinSpan = 120, Span = 1800;
+
+auto FramePacer::reset() -> void
+{
+    *this = FramePacer();
+}
+
+auto FramePacer::flip(qint64 time) -> void
+{
+    const auto pending = m_pending;
+    m_pending = 0;
+    if (!m_count || time <= m_last) {
+        m_last = time;
+        m_phase = time;
+        m_interval = 0.0;
+        m_count = 1;
+        return;
+    }
+    const double elapsed = time - m_last;
+    m_last = time;
+    if (!hasVsync()) {
+        // average of first intervals, skipping ones with missed vsyncs
+        if (m_interval > 0.0 && elapsed > m_interval * 1.5)
+            return;
+        m_interval += (elapsed - m_interval) / m_count++;
+        m_phase = m_base = time;
+        m_vsyncs = 0;
+        return;
+    }
+    const int vsyncs = qRound(elapsed / m_interval);
+    if (vsyncs < 1 || qAbs(elapsed / vsyncs - m_interval) > m_interval * 0.25) {
+        // refresh rate changed or timestamps are broken
+        m_count = 0;
+        flip(time);
+        return;
+    }
+    const int k = qMax(1, qRound((time - m_phase) / m_interval));
+    const double predicted = m_phase + k * m_interval;
+    const double error = time - predicted;
+    m_phase = predicted + PhaseGain * error;
+    m_vsyncs += k;
+    if (m_vsyncs < MinSpan)
+        m_interval += IntervalGain * error / k;
+    else
+        m_interval = (m_phase - m_base) / m_vsyncs;
+    if (m_vsyncs >= 2 * Span) {
+        m_base = m_phase - Span * m_interval;
+        m_vsyncs = Span;
+    }
+
+    if (pending) {
+        const int missed = qAbs(qRound((m_phase - pending) / m_interval));
+        m_error += missed;
+        m_missed += missed > 0;
+        ++m_presented;
+    }
+}
+
+auto FramePacer::nextVsync(qint64 now) const -> qint64
+{
+    if (!hasVsync())
+        return now;
+    const auto k = qFloor((now - m_phase) / m_interval) + 1;
+    return m_phase + k * m_interval;
+}
+
+auto FramePacer::isDue(qint64 pts, qint64 now) const -> bool
+{
+    if (!hasVsync())
+        return true;
+    return pts < nextVsync(now) + m_interval * 0.5;
+}
+
+auto FramePacer::syncSpeed(double fps, double window) const -> double
+{
+    if (!hasVsync() || fps <= 0.0)
+        return 1.0;
+    // vsyncs per frame at normal speed
+    const double ratio = 1e6 / (fps * m_interval);
+    double speed = 1.0, best = window;
+    for (double cadence : { (double)qRound(ratio), qRound(ratio * 2) * 0.5 }) {
+        if (cadence < 1.0)
+            continue;
+        const double s = ratio / cadence;
+        if (qAbs(s - 1.0) <= best) {
+            best = qAbs(s - 1.0);
+            speed = s;
+        }
+    }
+    return speed;
+}
+
+auto FramePacer::cadenceError() const -> double
+{
+    return m_presented ? m_error / m_presented : 0.0;
+}
@@ -0,0 +1,39 @@
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+
+// decides at which vsync each video frame is shown
+// vsync is predicted from flip timestamps with a phase-locked loop, so that
+// render-loop jitter doesn't move frames to other vsyncs
+// all times are in us on mpv's clock; not thread-safe
+class FramePacer {
+public:
+    auto reset() -> void;
+    // a frame was flipped at time; call after each swap
+    auto flip(qint64 time) -> void;
+    auto hasVsync() const -> bool { return m_count >= MinFlips; }
+    // estimated refresh interval
+    auto vsyncInterval() const -> double { return m_interval; }
+    // predicted time of the first vsync after now
+    auto nextVsync(qint64 now) const -> qint64;
+    // true if a frame supposed to be displayed at pts should be rendered for
+    // the vsync after now, i.e. the vsync is the closest one to pts
+    auto isDue(qint64 pts, qint64 now) const -> bool;
+    // a frame for pts was rendered and will be shown at next flip
+    auto render(qint64 pts) -> void { m_pending = pts; }
+    // speed which makes a frame last a whole number of vsyncs (or 2.5 for 3:2
+    // cadence), or 1.0 if it differs by more than window from normal speed
+    auto syncSpeed(double fps, double window) const -> double;
+    // frames shown at other vsync than the closest one to their time, and
+    // average distance from it in vsyncs
+    auto missedFrames() const -> int { return m_missed; }
+    auto cadenceError() const -> double;
+    auto presentedFrames() const -> int { return m_presented; }
+private:
+    static constexpr int MinFlips = 8;
+    qint64 m_last = 0, m_pending = 0;
+    double m_phase = 0.0, m_interval = 0.0, m_error = 0.0;
+    double m_base = 0.0; // phase at m_vsyncs vsyncs ago
+    int m_count = 0, m_presented = 0, m_missed = 0, m_vsyncs = 0;
+};
+
+#endif // FRAMEPACER_HPP
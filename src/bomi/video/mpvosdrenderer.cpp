@@ -2,11 +2,15 @@
 #include "opengl/openglvertex.hpp"
 #include "opengl/opengltexturebinder.hpp"
 #include "tmp/static_op.hpp"
+#include "misc/log.hpp"
 #include <QOpenGLBuffer>
 extern "C" {
 #include <sub/osd.h>
+#include <video/out/bitmap_packer.h>
 }
 
+DECLARE_LOG_CONTEXT(Video)
+
 enum Attr {AttrPosition, AttrTexCoord, AttrColor};
 using Vertex = OGL::TextureColorVertex;
 
@@ -19,8 +23,7 @@ struct PartInfo {
 struct MpvOsdRenderer::Data {
     MpvOsdRenderer *p = nullptr;
     struct {
-        int id = -1;
-        OpenGLFramebufferObject *fbo = nullptr;
+        int id = -1, serial = 0;
         QSize size;
     } last;
 
@@ -37,6 +40,8 @@ struct MpvOsdRenderer::Data {
     int prevVboSize = 0;
     QOpenGLFunctions *func = nullptr;
     QVector<PartInfo> parts;
+    // keeps unchanged bitmaps in place so that only new ones are uploaded
+    bitmap_packer *packer = nullptr;
 
     auto build(int inFormat) -> void
     {
@@ -94,17 +99,22 @@ struct MpvOsdRenderer::Data {
         shader->setUniformValue(loc_atlas, 0);
         shader->release();
     }
-    auto initializeAtlas(const sub_bitmaps *imgs) -> void
+    auto initializeAtlas(const sub_bitmaps *imgs) -> bool
     {
-        using tmp::aligned;
-        static const int max = OGL::maximumTextureSize();
+        if (!packer) {
+            packer = static_cast<bitmap_packer*>(talloc_zero(nullptr, bitmap_packer));
+            packer->w_max = packer->h_max = OGL::maximumTextureSize();
+            packer->incremental = true;
+        }
+        if (packer_pack_from_subbitmaps(packer, const_cast<sub_bitmaps*>(imgs)) < 0) {
+            _Error("OSD bitmaps do not fit on %%x%% texture.",
+                   packer->w_max, packer->h_max);
+            return false;
+        }
         if (parts.size() < imgs->num_parts)
             _Expand(parts, imgs->num_parts);
         static constexpr int shifts[] = { 0, 0, 2, 2 };
         const int shift = shifts[imgs->format];
-        QSize sheet{0, 0}; QPoint map{0, 0};
-        int lineHeight = 0;
-
         for (int i=0; i<imgs->num_parts; ++i) {
             auto &img = imgs->parts[i];
             auto &part = parts[i];
@@ -113,26 +123,15 @@ struct MpvOsdRenderer::Data {
                 part.color = (color & 0xffffff00) | (0xff - (color & 0xff));
             }
             part.strideAsPixel = (img.stride >> shift);
-            if (map.x() + part.strideAsPixel >= max) {
-                map.rx() = 0; map.ry() += lineHeight;
-                lineHeight = 0;
-            }
-            part.map = map;
-            if (img.h > lineHeight)
-                lineHeight = img.h;
-            if (map.x() + part.strideAsPixel > sheet.width())
-                sheet.rwidth() = map.x() + part.strideAsPixel;
-            map.rx() += img.w;
+            part.map = { packer->result[i].x, packer->result[i].y };
         }
-        sheet.rheight() = map.y() + lineHeight;
-
-        if (sheet.width() > atlasSize.width() || sheet.height() > atlasSize.height()) {
-            if (sheet.width() > atlasSize.width())
-                atlasSize.rwidth() = qMin(aligned<4>(sheet.width()*1.5), max);
-            if (sheet.height() > atlasSize.height())
-                atlasSize.rheight() = qMin(aligned<4>(sheet.height()*1.5), max);
+        // packer repacks everything when it grows, so old contents can go
+        if (packer->w > atlasSize.width() || packer->h > atlasSize.height()) {
+            Q_ASSERT(packer->repacked);
+            atlasSize = { packer->w, packer->h };
             atlas.initialize(atlasSize, transfer);
         }
+        return true;
     }
 };
 
@@ -142,6 +141,7 @@ MpvOsdRenderer::MpvOsdRenderer()
     d->p = this;
 }
 MpvOsdRenderer::~MpvOsdRenderer() {
+    talloc_free(d->packer);
     delete d;
 }
 auto MpvOsdRenderer::initialize() -> void
@@ -154,6 +154,8 @@ auto MpvOsdRenderer::initialize() -> void
 auto MpvOsdRenderer::finalize() -> void
 {
     d->atlas.destroy();
+    talloc_free(d->packer);
+    d->packer = nullptr;
     _Delete(d->shader);
     d->vbo.destroy();
 }
@@ -184,7 +186,8 @@ auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
         return;
     d->clear = false;
     if (d->last.id == imgs->change_id
-            && d->last.fbo == d->fbo && d->last.size == d->fbo->size())
+            && d->last.serial == d->fbo->serial()
+            && d->last.size == d->fbo->size())
         return;
 
     d->vbo.bind();
@@ -194,21 +197,30 @@ auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
 
     if (_Change(d->last.id, imgs->change_id)) {
         d->build(imgs->format);
-        d->initializeAtlas(imgs);
+        if (!d->initializeAtlas(imgs)) {
+            d->vbo.release();
+            return;
+        }
+        for (int i = 0; i < d->packer->num_dirty; ++i) {
+            const int n = d->packer->dirty[i];
+            const auto &part = d->parts[n];
+            const auto &img = imgs->parts[n];
+            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment(img.stride));
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, part.strideAsPixel);
+            d->atlas.upload(part.map.x(), part.map.y(), img.w, img.h, img.bitmap);
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
         if (d->prevVboSize < static_cast<int>(num*6))
             d->vbo.allocate((d->prevVboSize = num*6*1.2)*sizeof(Vertex));
         auto vertex = static_cast<Vertex*>(d->vbo.map(QOpenGLBuffer::WriteOnly));
         for (int i = 0; i < num; ++i) {
             const auto &part = d->parts[i];
             const auto &img = imgs->parts[i];
-            Q_ASSERT(part.map.x() + part.strideAsPixel <= d->atlas.width());
+            Q_ASSERT(part.map.x() + img.w <= d->atlas.width());
             Q_ASSERT(part.map.y() + img.h <= d->atlas.height());
 
-            glPixelStorei(GL_UNPACK_ALIGNMENT, alignment(img.stride));
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, part.strideAsPixel);
-
-            d->atlas.upload(part.map.x(), part.map.y(), img.w, img.h, img.bitmap);
-
             QPointF tp = part.map; QSizeF ts(img.w, img.h);
             tp.rx() /= d->atlas.width();
             tp.ry() /= d->atlas.height();
@@ -219,9 +231,6 @@ auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
                 &Vertex::position, pos.topLeft(), pos.bottomRight(),
                 &Vertex::texCoord, tex.topLeft(), tex.bottomRight(),
                 [&](Vertex *const it) { it->color.set(part.color); });
-
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         }
         d->vbo.unmap();
     }
@@ -230,7 +239,7 @@ auto MpvOsdRenderer::draw(const sub_bitmaps *imgs) -> void
     d->vMatrix.ortho(0, d->fbo->width(), 0, d->fbo->height(), -1, 1);
 
     d->fbo->bind();
-    d->last.fbo = d->fbo;
+    d->last.serial = d->fbo->serial();
     d->last.size = d->fbo->size();
     glViewport(0, 0, d->fbo->width(), d->fbo->height());
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
@@ -8,6 +8,7 @@
 #include "player/mpv_helper.hpp"
 #include "opengl/opengloffscreencontext.hpp"
 #include "os/os.hpp"
+#include "misc/latencystats.hpp"
 #include "enum/colorrange.hpp"
 #include "enum/colorspace.hpp"
 extern "C" {
@@ -95,6 +96,9 @@ struct VideoProcessor::Data {
     double ptsSkipStart = MP_NOPTS_VALUE, ptsLastSkip = MP_NOPTS_VALUE;
     bool skip = false;
 
+    LatencyStats *stats = nullptr;
+    bool output = false;
+
     auto reset() -> void
     {
         deinterlacer.clear();
@@ -128,6 +132,11 @@ VideoProcessor::~VideoProcessor()
     delete d;
 }
 
+auto VideoProcessor::setLatencyStats(LatencyStats *stats) -> void
+{
+    d->stats = stats;
+}
+
 auto VideoProcessor::setMotionIntrplOption(const MotionIntrplOption &option) -> void
 {
     d->intrplOption = option;
@@ -150,10 +159,27 @@ auto VideoProcessor::open(vf_instance *vf) -> int
     vf->reconfig = [] (vf_instance *vf, mp_image_params *in,
                        mp_image_params *out) -> int
         { return priv(vf)->reconfig(in, out); };
-    vf->filter_ext = [] (vf_instance *vf, mp_image *in) -> int
-        { return priv(vf)->filterIn(in); };
-    vf->filter_out = [] (vf_instance *vf) -> int
-        { return priv(vf)->filterOut(); };
+    vf->filter_ext = [] (vf_instance *vf, mp_image *in) -> int {
+        auto stats = priv(vf)->d->stats;
+        if (!stats)
+            return priv(vf)->filterIn(in);
+        stats->start();
+        const int ret = priv(vf)->filterIn(in);
+        stats->stop();
+        return ret;
+    };
+    vf->filter_out = [] (vf_instance *vf) -> int {
+        auto d = priv(vf)->d;
+        if (!d->stats)
+            return priv(vf)->filterOut();
+        d->stats->start();
+        const int ret = priv(vf)->filterOut();
+        d->stats->stop();
+        if (d->output)
+            d->stats->commit();
+        d->output = false;
+        return ret;
+    };
     vf->needs_input = [] (vf_instance *vf) -> bool
         { return priv(vf)->needsInput(); };
     vf->query_format = queryFormat;
@@ -435,6 +461,7 @@ auto VideoProcessor::filterOut() -> int
     if (d->mp_lv_out != MP_CSP_LEVELS_AUTO)
         img->params.colorlevels = d->mp_lv_out;
     vf_add_output_frame(d->vf, img);
+    d->output = true;
     return 0;
 }
 
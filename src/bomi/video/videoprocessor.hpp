@@ -3,7 +3,7 @@
 
 struct vf_instance;                     struct mp_image_params;
 struct vf_info;                         struct mp_image;
-struct MotionIntrplOption;
+struct MotionIntrplOption;              class LatencyStats;
 enum class DeintMethod;                 enum class ColorSpace;
 enum class ColorRange;
 
@@ -27,6 +27,8 @@ public:
     auto outputColorRange() const -> ColorRange;
     auto setOutputColorSpace(ColorSpace space) -> void;
     auto setOutputColorRange(ColorRange range) -> void;
+    // measures filtering time per output frame if not null
+    auto setLatencyStats(LatencyStats *stats) -> void;
 signals:
     void hwdecChanged(const QString &api);
     void inputInterlacedChanged();
@@ -1,18 +1,21 @@
 #include "videorenderer.hpp"
 #include "letterboxitem.hpp"
+#include "framepacer.hpp"
 #include "mpvosdrenderer.hpp"
 #include "opengl/opengltexture2d.hpp"
 #include "opengl/openglframebufferobject.hpp"
+#include "opengl/openglresourcepool.hpp"
 #include "opengl/opengltexturebinder.hpp"
 #include "misc/dataevent.hpp"
 #include "misc/log.hpp"
 #include "enum/rotation.hpp"
 #include <QQmlProperty>
 #include <QQuickWindow>
+#include <atomic>
 
 DECLARE_LOG_CONTEXT(Video)
 
-enum EventType {NewFrame = QEvent::User + 1 };
+enum EventType {NewFrame = QEvent::User + 1, HoldFrame };
 
 enum DirtyFlag {
     DirtyRot = 1
@@ -36,13 +39,20 @@ struct FboSet {
     {
         if (!visible || (fbo && fbo->size() == size && fbo->format() == format))
             return false;
-        _Renew(fbo, size, format);
+        auto pool = OpenGLResourcePool::current();
+        pool->release(fbo);
+        fbo = pool->takeFramebufferObject(size, format);
         return true;
     }
+    auto release() -> void
+    {
+        OpenGLResourcePool::current()->release(fbo);
+        fbo = nullptr;
+    }
 };
 
 struct VideoRenderer::VideoShaderData : public VideoRenderer::ShaderData {
-    bool redraw = false, osdVisible = false;
+    bool redraw = false, osdVisible = false, renewed = false;
     const FboSet *frame = nullptr, *osd = nullptr;
     QMargins osdMargins;
 };
@@ -151,6 +161,25 @@ struct VideoRenderer::Data {
     QSize sourceSize{0, 1};
     QTimer sizeChecker;
     RenderFrameFunc render = nullptr;
+    PeekFrameFunc peek = nullptr;
+    std::atomic<bool> pacing{false}; // set by mpv's hook thread
+    FramePacer pacer;
+    mutable QMutex pacerMutex;
+
+    // renders the queued frame now, or holds the shown one for next vsync
+    auto isFrameDue() -> bool
+    {
+        if (!pacing || !peek)
+            return true;
+        const auto frame = peek();
+        if (frame.count <= 0 || !frame.pts)
+            return true;
+        QMutexLocker locker(&pacerMutex);
+        if (!pacer.isDue(frame.pts, frame.now))
+            return false;
+        pacer.render(frame.pts);
+        return true;
+    }
 
     static auto isSameRatio(double r1, double r2) -> bool
         {return (r1 < 0.0 && r2 < 0.0) || qFuzzyCompare(r1, r2);}
@@ -277,6 +306,34 @@ auto VideoRenderer::setRenderFrameFunction(const RenderFrameFunc &func) -> void
     d->render = func;
 }
 
+auto VideoRenderer::setFramePacing(bool on) -> void
+{
+    d->pacing = on;
+}
+
+auto VideoRenderer::setPeekFrameFunction(const PeekFrameFunc &func) -> void
+{
+    d->peek = func;
+}
+
+auto VideoRenderer::flipped(qint64 time) -> void
+{
+    QMutexLocker locker(&d->pacerMutex);
+    d->pacer.flip(time);
+}
+
+auto VideoRenderer::syncSpeed(double fps, double window) const -> double
+{
+    QMutexLocker locker(&d->pacerMutex);
+    return d->pacer.syncSpeed(fps, window);
+}
+
+auto VideoRenderer::cadenceError() const -> double
+{
+    QMutexLocker locker(&d->pacerMutex);
+    return d->pacer.cadenceError();
+}
+
 auto VideoRenderer::updateForNewFrame(const QSize &displaySize) -> void
 {
     _PostEvent(Qt::HighEventPriority, this, NewFrame, displaySize);
@@ -311,7 +368,8 @@ auto VideoRenderer::finalizeGL() -> void
 {
     Super::finalizeGL();
     d->frame.fallback.destroy();
-    _Delete(d->frame.fbo);
+    d->frame.release();
+    d->osd.release();
 }
 
 auto VideoRenderer::customEvent(QEvent *event) -> void
@@ -328,7 +386,11 @@ auto VideoRenderer::customEvent(QEvent *event) -> void
         d->redraw = true;
         reserve(UpdateMaterial);
         break;
-    } default:
+    } case HoldFrame:
+        d->redraw = true;
+        reserve(UpdateMaterial);
+        break;
+    default:
         break;
     }
 }
@@ -518,6 +580,10 @@ auto VideoRenderer::render(VideoShaderData *data) -> void
     if (!data->redraw)
         return;
     data->redraw = false;
+    if (!data->renewed && !d->isFrameDue()) {
+        _PostEvent(Qt::HighEventPriority, this, HoldFrame);
+        return;
+    }
     auto w = window();
     if (w && d->render) {
         w->resetOpenGLState();
@@ -533,8 +599,7 @@ auto VideoRenderer::updateData(ShaderData *_data) -> void
         _Trace("VideoRendererItem::updateTexture(): no queued frame");
     } else if (!d->frame.size.isEmpty()) {
         d->redraw = false;
-        d->frame.renew();
-        d->osd.renew();
+        data->renewed = d->frame.renew() | d->osd.renew();
         data->redraw = true;
         data->osdMargins = d->osd.margins;
         data->osdVisible = d->osd.visible;
@@ -10,6 +10,11 @@ class OpenGLFramebufferObject;          enum class Rotation;
 using Fbo = OpenGLFramebufferObject;
 using RenderFrameFunc = std::function<void(Fbo*,Fbo*,const QMargins&)>;
 
+// next frame to render: number of queued frames, its display time (0 if
+// unknown) and current time on the same clock, in us
+struct QueuedFrame { int count = 0; qint64 pts = 0, now = 0; };
+using PeekFrameFunc = std::function<QueuedFrame()>;
+
 struct VideoFrameOsdVertex {
     OGL::CoordAttr position, frameTexCoord, osdTexCoord;
     static const OGL::AttrInfo &info() {
@@ -53,6 +58,15 @@ public:
     auto setCropRatio(double ratio) -> void;
     auto setRotation(Rotation r) -> void;
     auto setRenderFrameFunction(const RenderFrameFunc &func) -> void;
+    // with frame pacing, a new frame is rendered only for the vsync closest
+    // to its display time, and the previous one is shown again otherwise
+    auto setFramePacing(bool on) -> void;
+    auto setPeekFrameFunction(const PeekFrameFunc &func) -> void;
+    // call in render thread after each swap, with time on the peek clock
+    auto flipped(qint64 time) -> void;
+    // playback speed to lock video to display refresh within window
+    auto syncSpeed(double fps, double window) const -> double;
+    auto cadenceError() const -> double;
     auto updateForNewFrame(const QSize &displaySize) -> void;
     auto setFramebufferObjectFormat(OGL::TextureFormat format) -> void;
     auto framebufferObjectFormat() const -> OGL::TextureFormat;
@@ -832,6 +832,8 @@ static void demux_copy(struct demuxer *dst, struct demuxer *src)
         dst->rel_seeks = src->rel_seeks;
         dst->allow_refresh_seeks = src->allow_refresh_seeks;
         dst->fully_read = src->fully_read;
+        dst->stream_info_secs = src->stream_info_secs;
+        dst->probe_hint = src->probe_hint;
         dst->start_time = src->start_time;
         dst->priv = src->priv;
     }
@@ -197,6 +197,10 @@ typedef struct demuxer {
     // packets is not slow either (unlike e.g. libavdevice pseudo-demuxers).
     // Typical examples: text subtitles, playlists
     bool fully_read;
+    // Time spent analyzing the streams when opening (in seconds).
+    double stream_info_secs;
+    // Format and stream layout description for --demuxer-lavf-hint (or NULL).
+    char *probe_hint;
 
     // Bitmask of DEMUX_EVENT_*
     int events;
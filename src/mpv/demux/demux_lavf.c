@@ -41,6 +41,7 @@
 #include "common/av_common.h"
 #include "misc/bstr.h"
 
+#include "osdep/timer.h"
 #include "stream/stream.h"
 #include "demux.h"
 #include "stheader.h"
@@ -51,6 +52,12 @@
 #define INITIAL_PROBE_SIZE STREAM_BUFFER_SIZE
 #define PROBE_BUF_SIZE FFMIN(STREAM_MAX_BUFFER_SIZE, 2 * 1024 * 1024)
 
+// Probe size for the first probe when a format hint is set. Large enough for
+// most demuxers to recognize the format without growing the probe buffer.
+#define HINT_PROBE_SIZE (64 * 1024)
+// Analysis time for avformat_find_stream_info() if the hint still matches.
+#define HINT_ANALYZE_DURATION 0.5
+
 
 // Should correspond to IO_BUFFER_SIZE in libavformat/aviobuf.c (not public)
 // libavformat (almost) always reads data in blocks of this size.
@@ -64,6 +71,7 @@ struct demux_lavf_opts {
     int buffersize;
     int allow_mimetype;
     char *format;
+    char *hint;
     char *cryptokey;
     char **avopts;
     int hacks;
@@ -74,6 +82,7 @@ const struct m_sub_options demux_lavf_conf = {
     .opts = (const m_option_t[]) {
         OPT_INTRANGE("probesize", probesize, 0, 32, INT_MAX),
         OPT_STRING("format", format, 0),
+        OPT_STRING("hint", hint, 0),
         OPT_FLOATRANGE("analyzeduration", analyzeduration, 0, 0, 3600),
         OPT_INTRANGE("buffersize", buffersize, 0, 1, 10 * 1024 * 1024,
                      OPTDEF_INT(BIO_BUFFER_SIZE)),
@@ -165,6 +174,7 @@ typedef struct lavf_priv {
     int cur_program;
     char *mime_type;
     bool merge_track_metadata;
+    bool hint_matched;
 } lavf_priv_t;
 
 // At least mp4 has name="mov,mp4,m4a,3gp,3g2,mj2", so we split the name
@@ -323,6 +333,12 @@ static int lavf_check_file(demuxer_t *demuxer, enum demux_check check)
     if (!avpd.buf)
         return -1;
 
+    // The hint is "<format>;<codec>,<codec>,...", see make_probe_hint().
+    bstr hint_format = {0};
+    if (lavfdopts->hint)
+        bstr_split_tok(bstr0(lavfdopts->hint), ";", &hint_format, &(bstr){0});
+    bool try_hint = !forced_format && hint_format.len;
+
     bool final_probe = false;
     do {
         int score = 0;
@@ -331,7 +347,8 @@ static int lavf_check_file(demuxer_t *demuxer, enum demux_check check)
             priv->avif = forced_format;
             score = AVPROBE_SCORE_MAX;
         } else {
-            int nsize = av_clip(avpd.buf_size * 2, INITIAL_PROBE_SIZE,
+            int nsize = try_hint ? HINT_PROBE_SIZE :
+                        av_clip(avpd.buf_size * 2, INITIAL_PROBE_SIZE,
                                 PROBE_BUF_SIZE);
             bstr buf = stream_peek(s, nsize);
             if (buf.len <= avpd.buf_size)
@@ -359,6 +376,18 @@ static int lavf_check_file(demuxer_t *demuxer, enum demux_check check)
                 break;
             }
 
+            // A hint never accepts a format the normal probe wouldn't, it
+            // only saves growing the probe buffer.
+            if (try_hint && bstr_equals0(hint_format, priv->avif->name)) {
+                if (score >= lavfdopts->probescore) {
+                    MP_VERBOSE(demuxer, "Format matches the hint.\n");
+                    priv->hint_matched = true;
+                    break;
+                }
+                MP_VERBOSE(demuxer, "Format matches the hint, but score is "
+                           "too low.\n");
+            }
+
             if (score >= lavfdopts->probescore)
                 break;
 
@@ -368,6 +397,7 @@ static int lavf_check_file(demuxer_t *demuxer, enum demux_check check)
                 break;
         }
 
+        try_hint = false;
         priv->avif = NULL;
         priv->format_hack = (struct format_hack){0};
     } while (!final_probe);
@@ -396,6 +426,36 @@ static int lavf_check_file(demuxer_t *demuxer, enum demux_check check)
     return 0;
 }
 
+// Describes the container format and stream layout of an opened file, so that
+// an API user can pass it back with --demuxer-lavf-hint when opening the same
+// file again.
+static char *make_probe_hint(void *ta_ctx, AVInputFormat *avif,
+                             AVFormatContext *avfc)
+{
+    char *hint = talloc_asprintf(ta_ctx, "%s;", avif->name);
+    for (int n = 0; n < avfc->nb_streams; n++) {
+        const char *codec =
+            mp_codec_from_av_codec_id(avfc->streams[n]->codec->codec_id);
+        hint = talloc_asprintf_append_buffer(hint, "%s%s", n ? "," : "",
+                                             codec ? codec : "unknown");
+    }
+    return hint;
+}
+
+// Whether the streams known right after avformat_open_input() are the same as
+// the ones listed in the hint.
+static bool hint_matches_streams(struct demuxer *demuxer, AVFormatContext *avfc)
+{
+    struct demux_lavf_opts *lavfdopts = demuxer->opts->demux_lavf;
+    lavf_priv_t *priv = demuxer->priv;
+    if (!priv->hint_matched || !avfc->nb_streams)
+        return false;
+    char *current = make_probe_hint(NULL, priv->avif, avfc);
+    bool match = strcmp(current, lavfdopts->hint) == 0;
+    talloc_free(current);
+    return match;
+}
+
 static uint8_t char2int(char c)
 {
     if (c >= '0' && c <= '9') return c - '0';
@@ -798,15 +858,28 @@ static int demux_open_lavf(demuxer_t *demuxer, enum demux_check check)
     mp_avdict_print_unset(demuxer->log, MSGL_V, dopts);
     av_dict_free(&dopts);
 
+    if ((analyze_duration <= 0 || analyze_duration > HINT_ANALYZE_DURATION) &&
+        hint_matches_streams(demuxer, avfc))
+    {
+        MP_VERBOSE(demuxer, "Stream layout matches the hint, shortening "
+                   "stream analysis.\n");
+        av_opt_set_int(avfc, "analyzeduration",
+                       HINT_ANALYZE_DURATION * AV_TIME_BASE, 0);
+    }
+
     priv->avfc = avfc;
+    int64_t stream_info_start = mp_time_us();
     if (avformat_find_stream_info(avfc, NULL) < 0) {
         MP_ERR(demuxer, "av_find_stream_info() failed\n");
         return -1;
     }
+    demuxer->stream_info_secs = (mp_time_us() - stream_info_start) / 1e6;
 
     MP_VERBOSE(demuxer, "avformat_find_stream_info() finished after %"PRId64
                " bytes.\n", stream_tell(demuxer->stream));
 
+    demuxer->probe_hint = make_probe_hint(demuxer, priv->avif, avfc);
+
     for (i = 0; i < avfc->nb_chapters; i++) {
         AVChapter *c = avfc->chapters[i];
         t = av_dict_get(c->metadata, "title", NULL, 0);
@@ -198,7 +198,7 @@ extern "C" {
  * relational operators (<, >, <=, >=).
  */
 #define MPV_MAKE_VERSION(major, minor) (((major) << 16) | (minor) | 0UL)
-#define MPV_CLIENT_API_VERSION MPV_MAKE_VERSION(1, 18)
+#define MPV_CLIENT_API_VERSION MPV_MAKE_VERSION(1, 21)
 
 /**
  * Return the MPV_CLIENT_API_VERSION the mpv source has been compiled with.
@@ -1191,7 +1191,13 @@ typedef enum mpv_event_id {
      * Event delivery will continue normally once this event was returned
      * (this forces the client to empty the queue completely).
      */
-    MPV_EVENT_QUEUE_OVERFLOW    = 24
+    MPV_EVENT_QUEUE_OVERFLOW    = 24,
+    /**
+     * Reply to a mpv_screenshot_raw_async() request.
+     * See also mpv_event and mpv_event_screenshot_raw.
+     * Since API version 1.19.
+     */
+    MPV_EVENT_SCREENSHOT_RAW_REPLY = 25
     // Internal note: adjust INTERNAL_EVENT_BASE when adding new events.
 } mpv_event_id;
 
@@ -1353,6 +1359,40 @@ typedef struct mpv_event_client_message {
     const char **args;
 } mpv_event_client_message;
 
+/**
+ * Opaque reference to the image of a mpv_event_screenshot_raw. See
+ * mpv_raw_frame_ref().
+ */
+typedef struct mpv_raw_frame mpv_raw_frame;
+
+typedef struct mpv_event_screenshot_raw {
+    /**
+     * Size of the image in pixels. This is the size requested with
+     * mpv_screenshot_raw_async(), or derived from it.
+     */
+    int w, h;
+    /**
+     * Bytes between the start of two lines.
+     */
+    int stride;
+    /**
+     * Always "bgr0". This is organized as B8G8R8X8 (where B is the LSB). The
+     * contents of the padding X is undefined.
+     */
+    const char *format;
+    /**
+     * Image data. This stays valid while the event is, or as long as a
+     * reference to frame is held.
+     */
+    void *data;
+    /**
+     * Use mpv_raw_frame_ref() to keep the image data beyond the next
+     * mpv_wait_event() call. The event itself holds a reference which is
+     * released with the event.
+     */
+    mpv_raw_frame *frame;
+} mpv_event_screenshot_raw;
+
 typedef struct mpv_event {
     /**
      * One of mpv_event. Keep in mind that later ABI compatible releases might
@@ -1368,6 +1408,7 @@ typedef struct mpv_event {
      *  MPV_EVENT_GET_PROPERTY_REPLY
      *  MPV_EVENT_SET_PROPERTY_REPLY
      *  MPV_EVENT_COMMAND_REPLY
+     *  MPV_EVENT_SCREENSHOT_RAW_REPLY
      */
     int error;
     /**
@@ -1378,6 +1419,7 @@ typedef struct mpv_event {
      *  MPV_EVENT_GET_PROPERTY_REPLY
      *  MPV_EVENT_SET_PROPERTY_REPLY
      *  MPV_EVENT_COMMAND_REPLY
+     *  MPV_EVENT_SCREENSHOT_RAW_REPLY
      *  MPV_EVENT_PROPERTY_CHANGE
      */
     uint64_t reply_userdata;
@@ -1388,6 +1430,8 @@ typedef struct mpv_event {
      *  MPV_EVENT_LOG_MESSAGE:            mpv_event_log_message*
      *  MPV_EVENT_CLIENT_MESSAGE:         mpv_event_client_message*
      *  MPV_EVENT_END_FILE:               mpv_event_end_file*
+     *  MPV_EVENT_SCREENSHOT_RAW_REPLY:   mpv_event_screenshot_raw* (NULL on
+     *                                    error)
      *  other: NULL
      *
      * Note: future enhancements might add new event structs for existing or new
@@ -1396,6 +1440,41 @@ typedef struct mpv_event {
     void *data;
 } mpv_event;
 
+/**
+ * Take a screenshot of the currently displayed frame asynchronously. This is
+ * like the screenshot_raw command, but the conversion to the output format is
+ * done on a separate thread, and it doesn't block the playback core. You will
+ * receive the image with the MPV_EVENT_SCREENSHOT_RAW_REPLY event; its
+ * mpv_event.error field is set to MPV_ERROR_COMMAND if there was no video, or
+ * the conversion failed.
+ *
+ * @param reply_userdata see section about asynchronous calls
+ * @param mode "video", "window", or "subtitles" (see screenshot_raw command),
+ *             NULL is the same as "subtitles"
+ * @param w Width of the returned image. If <= 0, it's chosen according to the
+ *          display aspect ratio of the video. If both w and h are <= 0, the
+ *          image has the display size of the video.
+ * @param h Height of the returned image, see w.
+ * @return error code if sending the request failed
+ */
+int mpv_screenshot_raw_async(mpv_handle *ctx, uint64_t reply_userdata,
+                             const char *mode, int w, int h);
+
+/**
+ * Return a new reference to the image. The image data (as returned in
+ * mpv_event_screenshot_raw.data) stays valid until all references are
+ * released with mpv_raw_frame_unref(). This can be called from any thread.
+ *
+ * @return new reference, or NULL on OOM
+ */
+mpv_raw_frame *mpv_raw_frame_ref(mpv_raw_frame *frame);
+
+/**
+ * Release a reference returned by mpv_raw_frame_ref(). NULL is ignored. This
+ * can be called from any thread, also after the mpv_handle was destroyed.
+ */
+void mpv_raw_frame_unref(mpv_raw_frame *frame);
+
 /**
  * Enable or disable the given event.
  *
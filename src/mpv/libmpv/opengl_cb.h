@@ -228,6 +228,86 @@ int mpv_opengl_cb_render_osd(struct mpv_opengl_cb_context *ctx,
  */
 int mpv_opengl_cb_report_flip(mpv_opengl_cb_context *ctx, int64_t time);
 
+/**
+ * Look at the frame which the next mpv_opengl_cb_draw() call would render,
+ * without removing it from the queue. A client doing its own frame pacing can
+ * use this to render a new frame only for the vsync closest to its intended
+ * display time, and redraw the previous one otherwise. To have frames queued
+ * before they are due, set the frame-queue-ahead sub-option.
+ *
+ * @param pts set to the time (using mpv_get_time_us()) at which the frame is
+ *            supposed to be displayed, or 0 if unknown or no frame is queued
+ * @return the number of queued frames
+ */
+int mpv_opengl_cb_peek_frame(mpv_opengl_cb_context *ctx, int64_t *pts);
+
+/**
+ * Presentation statistics, see mpv_opengl_cb_get_stats(). Counters start at 0
+ * when the context is created and are never reset. Times are in microseconds,
+ * on the clock of mpv_get_time_us().
+ */
+typedef struct mpv_opengl_cb_stats {
+    /**
+     * Number of frames taken from the queue and rendered by
+     * mpv_opengl_cb_draw().
+     */
+    int64_t frames;
+    /**
+     * Number of rendered frames for which a flip was reported with
+     * mpv_opengl_cb_report_flip().
+     */
+    int64_t presented;
+    /**
+     * Frames dropped in mpv_opengl_cb_draw(), because the frame after them
+     * was already due at the next vsync. This requires flips to be reported,
+     * and is not done with interpolation or disabled framedrop.
+     */
+    int64_t dropped_late;
+    /**
+     * Frames dropped because the queue was full when a new frame was
+     * queued (see the frame-queue-size and frame-drop-mode sub-options).
+     */
+    int64_t dropped_queue_full;
+    /**
+     * Frames discarded without being shown on seeks, video reconfiguration
+     * and uninitialization. Unlike the other drops, these are not included
+     * in the "vo-drop-frame-count" property.
+     */
+    int64_t dropped_flush;
+    /**
+     * Number of frames waiting in the queue, and the size of the queue. The
+     * size is 0 if no video is active.
+     */
+    int queued;
+    int queue_size;
+    /**
+     * Time between the last two reported flips, or 0 if unknown.
+     */
+    int64_t vsync_interval;
+    /**
+     * Time the last rendered frame spent in the queue.
+     */
+    int64_t queue_latency;
+    /**
+     * Time of the last reported flip minus the time at which the frame shown
+     * by it was supposed to be displayed. Positive values mean the frame was
+     * shown late. This is updated when "presented" is incremented.
+     */
+    int64_t display_error;
+} mpv_opengl_cb_stats;
+
+/**
+ * Return the current presentation statistics. This can be called from any
+ * thread. To get per-frame values, call it after each mpv_opengl_cb_draw()
+ * and mpv_opengl_cb_report_flip() call, and check which of the "frames" and
+ * "presented" counters changed.
+ *
+ * @param stats filled with the current values
+ * @return error code
+ */
+int mpv_opengl_cb_get_stats(mpv_opengl_cb_context *ctx,
+                            mpv_opengl_cb_stats *stats);
+
 /**
  * Destroy the mpv OpenGL state.
  *
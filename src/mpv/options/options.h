@@ -135,6 +135,7 @@ typedef struct MPOpts {
     int network_rtsp_transport;
     int hls_bitrate;
     struct mp_cache_opts stream_cache;
+    int stream_file_mmap;
     int chapterrange[2];
     int edition_id;
     int correct_pts;
@@ -36,10 +36,12 @@
 #include "osdep/timer.h"
 #include "osdep/io.h"
 #include "stream/stream.h"
+#include "video/mp_image.h"
 
 #include "command.h"
 #include "core.h"
 #include "client.h"
+#include "screenshot.h"
 
 #include "config.h"
 
@@ -1302,6 +1304,101 @@ int mpv_get_property_async(mpv_handle *ctx, uint64_t ud, const char *name,
     return run_async(ctx, getproperty_fn, req);
 }
 
+struct screenshot_request {
+    struct MPContext *mpctx;
+    int mode;
+    int w, h;
+    struct mpv_handle *reply_ctx;
+    uint64_t userdata;
+};
+
+static void screenshot_free_event(void *ptr)
+{
+    struct mpv_event_screenshot_raw *ev = ptr;
+    mpv_raw_frame_unref(ev->frame);
+}
+
+// Called on the screenshot worker thread.
+static void screenshot_reply(void *arg, struct mp_image *img)
+{
+    struct screenshot_request *req = arg;
+    struct mpv_event reply = {
+        .event_id = MPV_EVENT_SCREENSHOT_RAW_REPLY,
+        .error = MPV_ERROR_COMMAND,
+    };
+    if (img) {
+        struct mpv_event_screenshot_raw *ev = talloc_ptrtype(NULL, ev);
+        *ev = (struct mpv_event_screenshot_raw){
+            .w = img->w,
+            .h = img->h,
+            .stride = img->stride[0],
+            .format = "bgr0",
+            .data = img->planes[0],
+            .frame = (mpv_raw_frame *)img,
+        };
+        talloc_set_destructor(ev, screenshot_free_event);
+        reply.data = ev;
+        reply.error = 0;
+    }
+    send_reply(req->reply_ctx, req->userdata, &reply);
+    talloc_free(req);
+}
+
+static void screenshot_fn(void *arg)
+{
+    struct screenshot_request *req = arg;
+    // req is freed when this returns; the copy is freed by screenshot_reply()
+    struct screenshot_request *job = talloc_memdup(NULL, req, sizeof(*req));
+    if (!screenshot_get_rgb_async(req->mpctx, req->mode, req->w, req->h,
+                                  screenshot_reply, job))
+    {
+        status_reply(req->reply_ctx, MPV_EVENT_SCREENSHOT_RAW_REPLY,
+                     req->userdata, MPV_ERROR_COMMAND);
+        talloc_free(job);
+    }
+}
+
+int mpv_screenshot_raw_async(mpv_handle *ctx, uint64_t ud, const char *mode,
+                             int w, int h)
+{
+    if (!ctx->mpctx->initialized)
+        return MPV_ERROR_UNINITIALIZED;
+
+    // same values as the screenshot_raw command
+    static const char *const modes[] = {"video", "window", "subtitles"};
+    int imode = 2;
+    if (mode) {
+        imode = -1;
+        for (int n = 0; n < MP_ARRAY_SIZE(modes); n++) {
+            if (strcmp(mode, modes[n]) == 0)
+                imode = n;
+        }
+        if (imode < 0)
+            return MPV_ERROR_INVALID_PARAMETER;
+    }
+
+    struct screenshot_request *req = talloc_ptrtype(NULL, req);
+    *req = (struct screenshot_request){
+        .mpctx = ctx->mpctx,
+        .mode = imode,
+        .w = w,
+        .h = h,
+        .reply_ctx = ctx,
+        .userdata = ud,
+    };
+    return run_async(ctx, screenshot_fn, req);
+}
+
+mpv_raw_frame *mpv_raw_frame_ref(mpv_raw_frame *frame)
+{
+    return (mpv_raw_frame *)mp_image_new_ref((struct mp_image *)frame);
+}
+
+void mpv_raw_frame_unref(mpv_raw_frame *frame)
+{
+    talloc_free(frame);
+}
+
 static void property_free(void *p)
 {
     struct observe_property *prop = p;
@@ -1640,6 +1737,7 @@ static const char *const event_table[] = {
     [MPV_EVENT_PROPERTY_CHANGE] = "property-change",
     [MPV_EVENT_CHAPTER_CHANGE] = "chapter-change",
     [MPV_EVENT_QUEUE_OVERFLOW] = "event-queue-overflow",
+    [MPV_EVENT_SCREENSHOT_RAW_REPLY] = "screenshot-raw-reply",
 };
 
 const char *mpv_event_name(mpv_event_id event)
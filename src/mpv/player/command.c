@@ -426,6 +426,45 @@ static int mp_property_file_format(void *ctx, struct m_property *prop,
     return m_property_strdup_ro(action, arg, name);
 }
 
+static int mp_property_demuxer_probe_hint(void *ctx, struct m_property *prop,
+                                          int action, void *arg)
+{
+    MPContext *mpctx = ctx;
+    struct demuxer *demuxer = mpctx->master_demuxer;
+    if (!demuxer || !demuxer->probe_hint)
+        return M_PROPERTY_UNAVAILABLE;
+    return m_property_strdup_ro(action, arg, demuxer->probe_hint);
+}
+
+// Duration in seconds between two open_timing stages, -1 if not reached.
+static double open_timing_secs(int64_t from, int64_t to)
+{
+    return from && to ? (to - from) / 1e6 : -1;
+}
+
+static int mp_property_open_timing(void *ctx, struct m_property *prop,
+                                   int action, void *arg)
+{
+    MPContext *mpctx = ctx;
+    struct open_timing *t = &mpctx->open_timing;
+    struct demuxer *demuxer = mpctx->master_demuxer;
+    if (!t->start || !mpctx->playing)
+        return M_PROPERTY_UNAVAILABLE;
+    double stream_info = demuxer && t->demux ? demuxer->stream_info_secs : -1;
+    double demux = open_timing_secs(t->stream, t->demux);
+    struct m_sub_property props[] = {
+        {"stream-open",     SUB_PROP_DOUBLE(open_timing_secs(t->start, t->stream))},
+        {"probe",           SUB_PROP_DOUBLE(demux >= 0 ? demux - stream_info : -1)},
+        {"stream-info",     SUB_PROP_DOUBLE(stream_info)},
+        {"first-packet",    SUB_PROP_DOUBLE(open_timing_secs(t->demux, t->first_packet))},
+        {"first-frame",     SUB_PROP_DOUBLE(open_timing_secs(t->first_packet, t->first_frame))},
+        {"total",           SUB_PROP_DOUBLE(open_timing_secs(t->start, t->first_frame))},
+        {"gap",             SUB_PROP_DOUBLE(open_timing_secs(t->previous_frame, t->first_frame))},
+        {0}
+    };
+    return m_property_read_sub(props, action, arg);
+}
+
 /// Position in the stream (RW)
 static int mp_property_stream_pos(void *ctx, struct m_property *prop,
                                   int action, void *arg)
@@ -2354,6 +2393,28 @@ static int mp_property_video_codec(void *ctx, struct m_property *prop,
     return m_property_strdup_ro(action, arg, c);
 }
 
+/// Recent video decode call times and decoder threading (RO)
+static int mp_property_decoder_timing(void *ctx, struct m_property *prop,
+                                      int action, void *arg)
+{
+    MPContext *mpctx = ctx;
+    struct dec_video *d_video = mpctx->d_video;
+    if (!d_video)
+        return M_PROPERTY_UNAVAILABLE;
+    struct vd_threads threads = {1, "none"};
+    video_vd_control(d_video, VDCTRL_GET_THREADS, &threads);
+    struct m_sub_property props[] = {
+        {"p50",         SUB_PROP_DOUBLE(video_decode_time_percentile(d_video, 50))},
+        {"p90",         SUB_PROP_DOUBLE(video_decode_time_percentile(d_video, 90))},
+        {"p99",         SUB_PROP_DOUBLE(video_decode_time_percentile(d_video, 99))},
+        {"max",         SUB_PROP_DOUBLE(video_decode_time_percentile(d_video, 100))},
+        {"threads",     SUB_PROP_INT(threads.count)},
+        {"thread-type", SUB_PROP_STR(threads.type)},
+        {0}
+    };
+    return m_property_read_sub(props, action, arg);
+}
+
 static int property_imgparams(struct mp_image_params p, int action, void *arg)
 {
     if (!p.imgfmt)
@@ -3302,6 +3363,8 @@ static const struct m_property mp_properties[] = {
     {"stream-capture", mp_property_stream_capture},
     {"demuxer", mp_property_demuxer},
     {"file-format", mp_property_file_format},
+    {"demuxer-probe-hint", mp_property_demuxer_probe_hint},
+    {"open-timing", mp_property_open_timing},
     {"stream-pos", mp_property_stream_pos},
     {"stream-end", mp_property_stream_end},
     {"duration", mp_property_duration},
@@ -3402,6 +3465,7 @@ static const struct m_property mp_properties[] = {
     {"video-params", mp_property_vd_imgparams},
     {"video-format", mp_property_video_format},
     {"video-codec", mp_property_video_codec},
+    {"decoder-timing", mp_property_decoder_timing},
     M_PROPERTY_ALIAS("dwidth", "video-out-params/dw"),
     M_PROPERTY_ALIAS("dheight", "video-out-params/dh"),
     M_PROPERTY_ALIAS("width", "video-params/w"),
@@ -3526,7 +3590,7 @@ static const char *const *const mp_event_property_change[] = {
     E(MPV_EVENT_TICK, "time-pos", "stream-pos", "stream-time-pos", "avsync",
       "percent-pos", "time-remaining", "playtime-remaining", "playback-time",
       "estimated-vf-fps", "drop-frame-count", "vo-drop-frame-count",
-      "total-avsync-change"),
+      "total-avsync-change", "decoder-timing"),
     E(MPV_EVENT_VIDEO_RECONFIG, "video-out-params", "video-params",
       "video-format", "video-codec", "video-bitrate", "dwidth", "dheight",
       "width", "height", "fps", "aspect", "vo-configured", "current-vo",
@@ -3537,7 +3601,7 @@ static const char *const *const mp_event_property_change[] = {
       "volume-restore-data", "current-ao", "audio-codec-name", "audio-params",
       "audio-out-params"),
     E(MPV_EVENT_SEEK, "seeking", "core-idle"),
-    E(MPV_EVENT_PLAYBACK_RESTART, "seeking", "core-idle"),
+    E(MPV_EVENT_PLAYBACK_RESTART, "seeking", "core-idle", "open-timing"),
     E(MPV_EVENT_METADATA_UPDATE, "metadata", "filtered-metadata", "media-title"),
     E(MPV_EVENT_CHAPTER_CHANGE, "chapter", "chapter-metadata"),
     E(MP_EVENT_CACHE_UPDATE, "cache", "cache-free", "cache-used", "cache-idle",
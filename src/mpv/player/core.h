@@ -186,6 +186,16 @@ typedef struct MPContext {
     // Current file statistics
     int64_t shown_vframes, shown_aframes;
 
+    // mp_time_us() at the end of each stage of opening the current file, for
+    // the open-timing property. 0 if the stage wasn't reached (yet).
+    struct open_timing {
+        int64_t start, stream, demux, first_packet, first_frame;
+        // last frame of the previous file if it played to the end
+        int64_t previous_frame;
+    } open_timing;
+    // mp_time_us() of the last displayed frame, 0 after stopping by request
+    int64_t last_frame_time;
+
     struct stream *stream; // stream that was initially opened
     struct demuxer **sources; // all open demuxers
     int num_sources;
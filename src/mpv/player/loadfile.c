@@ -1021,6 +1021,11 @@ static void play_current_file(struct MPContext *mpctx)
     mpctx->filename = NULL;
     mpctx->shown_aframes = 0;
     mpctx->shown_vframes = 0;
+    mpctx->open_timing = (struct open_timing){
+        .start = mp_time_us(),
+        .previous_frame = mpctx->last_frame_time,
+    };
+    mpctx->last_frame_time = 0;
     mpctx->last_vo_pts = MP_NOPTS_VALUE;
     mpctx->last_chapter_seek = -2;
     mpctx->last_chapter_pts = MP_NOPTS_VALUE;
@@ -1085,6 +1090,7 @@ static void play_current_file(struct MPContext *mpctx)
                                           stream_flags);
     if (!mpctx->stream)
         goto terminate_playback;
+    mpctx->open_timing.stream = mp_time_us();
 
     if (opts->stream_dump && opts->stream_dump[0]) {
         stream_dump(mpctx);
@@ -1115,6 +1121,7 @@ goto_reopen_demuxer: ;
         goto terminate_playback;
     }
     mpctx->demuxer = mpctx->master_demuxer;
+    mpctx->open_timing.demux = mp_time_us();
 
     load_timeline(mpctx);
 
@@ -1324,6 +1331,9 @@ terminate_playback:
     case PT_STOP:           end_event.reason = MPV_END_FILE_REASON_STOP; break;
     case PT_QUIT:           end_event.reason = MPV_END_FILE_REASON_QUIT; break;
     };
+    // Only a file following at end of file has a gap worth measuring.
+    if (end_event.reason != MPV_END_FILE_REASON_EOF)
+        mpctx->last_frame_time = 0;
     mp_notify(mpctx, MPV_EVENT_END_FILE, &end_event);
 
     if (mpctx->playing)
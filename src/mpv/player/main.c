@@ -58,6 +58,7 @@
 #include "sub/osd.h"
 #include "video/decode/dec_video.h"
 #include "video/out/vo.h"
+#include "video/sws_utils.h"
 
 #include "core.h"
 #include "client.h"
@@ -184,6 +185,7 @@ void mp_destroy(struct MPContext *mpctx)
 #endif
 
     shutdown_clients(mpctx);
+    screenshot_uninit(mpctx);
 
     uninit_audio_out(mpctx);
     uninit_video_out(mpctx);
@@ -217,6 +219,8 @@ void mp_destroy(struct MPContext *mpctx)
     mp_input_uninit(mpctx->input);
 
     uninit_libav(mpctx->global);
+    // idle contexts only; other instances just repopulate the cache
+    mp_sws_cache_clear();
 
     if (mpctx->autodetach)
         pthread_detach(pthread_self());
@@ -15,13 +15,16 @@
  * with mpv.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
 
 #include "config.h"
 
 #include "osdep/io.h"
+#include "osdep/threads.h"
 
 #include "talloc.h"
 #include "screenshot.h"
@@ -34,6 +37,7 @@
 #include "video/decode/dec_video.h"
 #include "video/out/vo.h"
 #include "video/image_writer.h"
+#include "video/sws_utils.h"
 #include "sub/osd.h"
 
 #include "video/csputils.h"
@@ -41,6 +45,15 @@
 #define MODE_FULL_WINDOW 1
 #define MODE_SUBTITLES 2
 
+struct screenshot_job {
+    struct mp_image *image;
+    int mode;
+    int w, h;
+    double pts;
+    void (*cb)(void *cb_ctx, struct mp_image *res);
+    void *cb_ctx;
+};
+
 typedef struct screenshot_ctx {
     struct MPContext *mpctx;
 
@@ -49,6 +62,16 @@ typedef struct screenshot_ctx {
     bool osd;
 
     int frameno;
+
+    // Asynchronous captures (screenshot_get_rgb_async()). The worker is
+    // started with the first request.
+    pthread_t thread;
+    bool thread_valid;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    struct screenshot_job **jobs;
+    int num_jobs;
+    bool terminate;
 } screenshot_ctx;
 
 void screenshot_init(struct MPContext *mpctx)
@@ -58,6 +81,29 @@ void screenshot_init(struct MPContext *mpctx)
         .mpctx = mpctx,
         .frameno = 1,
     };
+    pthread_mutex_init(&mpctx->screenshot_ctx->lock, NULL);
+    pthread_cond_init(&mpctx->screenshot_ctx->wakeup, NULL);
+}
+
+void screenshot_uninit(struct MPContext *mpctx)
+{
+    screenshot_ctx *ctx = mpctx->screenshot_ctx;
+    if (!ctx)
+        return;
+
+    if (ctx->thread_valid) {
+        pthread_mutex_lock(&ctx->lock);
+        ctx->terminate = true;
+        pthread_cond_signal(&ctx->wakeup);
+        pthread_mutex_unlock(&ctx->lock);
+        pthread_join(ctx->thread, NULL);
+    }
+    assert(!ctx->num_jobs);
+
+    pthread_cond_destroy(&ctx->wakeup);
+    pthread_mutex_destroy(&ctx->lock);
+    talloc_free(ctx);
+    mpctx->screenshot_ctx = NULL;
 }
 
 #define SMSG_OK 0
@@ -304,18 +350,23 @@ static char *gen_fname(screenshot_ctx *ctx, const char *file_ext)
     }
 }
 
-static void add_subs(struct MPContext *mpctx, struct mp_image *image)
+// dar: display aspect ratio of the video the image was made from
+static void add_subs(struct osd_state *osd, double video_pts, double dar,
+                     struct mp_image *image)
 {
     double sar = (double)image->w / image->h;
-    double dar = (double)image->params.d_w / image->params.d_h;
     struct mp_osd_res res = {
         .w = image->w,
         .h = image->h,
         .display_par = sar / dar,
     };
 
-    osd_draw_on_image(mpctx->osd, res, mpctx->video_pts,
-                      OSD_DRAW_SUB_ONLY, image);
+    osd_draw_on_image(osd, res, video_pts, OSD_DRAW_SUB_ONLY, image);
+}
+
+static double image_dar(struct mp_image *image)
+{
+    return (double)image->params.d_w / image->params.d_h;
 }
 
 static void screenshot_save(struct MPContext *mpctx, struct mp_image *image)
@@ -333,20 +384,24 @@ static void screenshot_save(struct MPContext *mpctx, struct mp_image *image)
     }
 }
 
-static struct mp_image *screenshot_get(struct MPContext *mpctx, int mode)
+// Return a reference to the frame (or window contents) to capture. *mode is
+// set to the mode that was actually used.
+// wait: wait until the VO has displayed the last queued frame
+static struct mp_image *grab_image(struct MPContext *mpctx, int *mode, bool wait)
 {
     struct mp_image *image = NULL;
-    if (mode == MODE_SUBTITLES && osd_get_render_subs_in_filter(mpctx->osd))
-        mode = 0;
+    if (*mode == MODE_SUBTITLES && osd_get_render_subs_in_filter(mpctx->osd))
+        *mode = 0;
 
     if (mpctx->video_out && mpctx->video_out->config_ok) {
-        vo_wait_frame(mpctx->video_out); // important for each-frame mode
+        if (wait)
+            vo_wait_frame(mpctx->video_out); // important for each-frame mode
 
-        if (mode != MODE_FULL_WINDOW)
+        if (*mode != MODE_FULL_WINDOW)
             image = vo_get_current_frame(mpctx->video_out);
         if (!image) {
             vo_control(mpctx->video_out, VOCTRL_SCREENSHOT_WIN, &image);
-            mode = MODE_FULL_WINDOW;
+            *mode = MODE_FULL_WINDOW;
         }
     }
 
@@ -361,8 +416,15 @@ static struct mp_image *screenshot_get(struct MPContext *mpctx, int mode)
         }
     }
 
+    return image;
+}
+
+static struct mp_image *screenshot_get(struct MPContext *mpctx, int mode)
+{
+    struct mp_image *image = grab_image(mpctx, &mode, true);
+
     if (image && mode == MODE_SUBTITLES)
-        add_subs(mpctx, image);
+        add_subs(mpctx->osd, mpctx->video_pts, image_dar(image), image);
 
     return image;
 }
@@ -377,6 +439,117 @@ struct mp_image *screenshot_get_rgb(struct MPContext *mpctx, int mode)
     return res;
 }
 
+// w/h <= 0 are derived from the display aspect ratio of the source; if both
+// are <= 0, the image is converted to its display size.
+static void output_size(struct mp_image *src, int *w, int *h)
+{
+    int d_w = src->params.d_w, d_h = src->params.d_h;
+    if (*w <= 0 && *h <= 0) {
+        *w = d_w;
+        *h = d_h;
+    } else if (*w <= 0) {
+        *w = MPMAX(1, (int)(*h * (double)d_w / d_h + 0.5));
+    } else if (*h <= 0) {
+        *h = MPMAX(1, (int)(*w * (double)d_h / d_w + 0.5));
+    }
+}
+
+// Runs on the worker thread.
+static struct mp_image *convert_job(screenshot_ctx *ctx,
+                                    struct screenshot_job *job)
+{
+    struct mp_image *src = job->image;
+    int w = job->w, h = job->h;
+    output_size(src, &w, &h);
+
+    struct mp_image *dst = mp_image_alloc(IMGFMT_BGR0, w, h);
+    if (!dst) {
+        MP_ERR(ctx->mpctx, "Out of memory.\n");
+        return NULL;
+    }
+    mp_image_copy_attributes(dst, src);
+
+    // uses the shared context cache, so repeated captures of the same video
+    // don't reinitialize swscale
+    if (mp_image_swscale(dst, src, mp_sws_hq_flags) < 0) {
+        MP_ERR(ctx->mpctx, "Error when converting image.\n");
+        talloc_free(dst);
+        return NULL;
+    }
+
+    // Drawn after scaling, so that thumbnails don't pay for full size
+    // subtitle rendering.
+    if (job->mode == MODE_SUBTITLES)
+        add_subs(ctx->mpctx->osd, job->pts, image_dar(src), dst);
+
+    return dst;
+}
+
+static void *screenshot_thread(void *p)
+{
+    screenshot_ctx *ctx = p;
+    mpthread_set_name("screenshot");
+
+    pthread_mutex_lock(&ctx->lock);
+    while (1) {
+        if (ctx->num_jobs) {
+            struct screenshot_job *job = ctx->jobs[0];
+            MP_TARRAY_REMOVE_AT(ctx->jobs, ctx->num_jobs, 0);
+            pthread_mutex_unlock(&ctx->lock);
+
+            struct mp_image *res = convert_job(ctx, job);
+            job->cb(job->cb_ctx, res);
+            talloc_free(job);
+
+            pthread_mutex_lock(&ctx->lock);
+            continue;
+        }
+        if (ctx->terminate)
+            break;
+        pthread_cond_wait(&ctx->wakeup, &ctx->lock);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+    return NULL;
+}
+
+bool screenshot_get_rgb_async(struct MPContext *mpctx, int mode, int w, int h,
+                              void (*cb)(void *cb_ctx, struct mp_image *res),
+                              void *cb_ctx)
+{
+    screenshot_ctx *ctx = mpctx->screenshot_ctx;
+
+    // Not waiting for the VO: the request would block the playloop until the
+    // frame is displayed, and the frame queued last is what the user sees
+    // anyway in all practical cases.
+    struct mp_image *image = grab_image(mpctx, &mode, false);
+    if (!image)
+        return false;
+
+    pthread_mutex_lock(&ctx->lock);
+    if (!ctx->thread_valid) {
+        if (pthread_create(&ctx->thread, NULL, screenshot_thread, ctx)) {
+            pthread_mutex_unlock(&ctx->lock);
+            talloc_free(image);
+            return false;
+        }
+        ctx->thread_valid = true;
+    }
+    struct screenshot_job *job = talloc_ptrtype(NULL, job);
+    *job = (struct screenshot_job){
+        .image = talloc_steal(job, image),
+        .mode = mode,
+        .w = w,
+        .h = h,
+        .pts = mpctx->video_pts,
+        .cb = cb,
+        .cb_ctx = cb_ctx,
+    };
+    MP_TARRAY_APPEND(ctx, ctx->jobs, ctx->num_jobs, job);
+    pthread_cond_signal(&ctx->wakeup);
+    pthread_mutex_unlock(&ctx->lock);
+    return true;
+}
+
 void screenshot_to_file(struct MPContext *mpctx, const char *filename, int mode,
                         bool osd)
 {
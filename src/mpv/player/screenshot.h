@@ -21,10 +21,14 @@
 #include <stdbool.h>
 
 struct MPContext;
+struct mp_image;
 
 // One time initialization at program start.
 void screenshot_init(struct MPContext *mpctx);
 
+// Waits for pending asynchronous captures; called on player destruction.
+void screenshot_uninit(struct MPContext *mpctx);
+
 // Request a taking & saving a screenshot of the currently displayed frame.
 // mode: 0: -, 1: save the actual output window contents, 2: with subtitles.
 // each_frame: If set, this toggles per-frame screenshots, exactly like the
@@ -42,6 +46,17 @@ void screenshot_to_file(struct MPContext *mpctx, const char *filename, int mode,
 // mode is the same as in screenshot_request()
 struct mp_image *screenshot_get_rgb(struct MPContext *mpctx, int mode);
 
+// Like screenshot_get_rgb(), but only grabs a reference to the current frame
+// here, and does the conversion on a worker thread. The result is scaled to
+// w x h; if w or h is <= 0, it's derived from the video's aspect ratio, and if
+// both are, the display size of the video is used.
+// cb is called on the worker thread with the image (ownership is transferred),
+// or NULL if the conversion failed. If false is returned, there was nothing to
+// capture, and cb is never called.
+bool screenshot_get_rgb_async(struct MPContext *mpctx, int mode, int w, int h,
+                              void (*cb)(void *cb_ctx, struct mp_image *res),
+                              void *cb_ctx);
+
 // Called by the playback core code when a new frame is displayed.
 void screenshot_flip(struct MPContext *mpctx);
 
@@ -377,6 +377,8 @@ static int decode_image(struct MPContext *mpctx)
     struct demux_packet *pkt;
     if (demux_read_packet_async(d_video->header, &pkt) == 0)
         return VD_WAIT;
+    if (pkt && !mpctx->open_timing.first_packet)
+        mpctx->open_timing.first_packet = mp_time_us();
     if (pkt && pkt->pts != MP_NOPTS_VALUE)
         pkt->pts += mpctx->video_offset;
     if (pkt && pkt->dts != MP_NOPTS_VALUE)
@@ -868,6 +870,9 @@ void write_video(struct MPContext *mpctx, double endpts)
     shift_new_frame(mpctx);
 
     mpctx->shown_vframes++;
+    mpctx->last_frame_time = mp_time_us();
+    if (!mpctx->open_timing.first_frame)
+        mpctx->open_timing.first_frame = mpctx->last_frame_time;
     if (mpctx->video_status < STATUS_PLAYING) {
         mpctx->video_status = STATUS_READY;
         // After a seek, make sure to wait until the first frame is visible.
@@ -546,6 +546,12 @@ struct bstr stream_peek(stream_t *s, int len)
 {
     assert(len >= 0);
     assert(len <= STREAM_MAX_BUFFER_SIZE);
+    if (s->buf_len - s->buf_pos < len && s->peek_direct) {
+        // Zero-copy path: hand out the backing memory if it has enough data.
+        bstr data = s->peek_direct(s, stream_tell(s), len);
+        if (data.len >= len)
+            return (bstr){.start = data.start, .len = len};
+    }
     if (s->buf_len - s->buf_pos < len) {
         // Move to front to guarantee we really can read up to max size.
         int buf_valid = s->buf_len - s->buf_pos;
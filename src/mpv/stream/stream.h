@@ -170,6 +170,10 @@ typedef struct stream {
     int (*write_buffer)(struct stream *s, char *buffer, int len);
     // Seek
     int (*seek)(struct stream *s, int64_t pos);
+    // Optional: return up to len bytes of stream data starting at pos without
+    // copying them. The memory must stay valid until the stream is closed.
+    // A short or empty result makes the caller fall back to fill_buffer.
+    struct bstr (*peek_direct)(struct stream *s, int64_t pos, int len);
     // Control
     // Will be later used to let streams like dvd and cdda report
     // their structure (ie tracks, chapters, etc)
@@ -25,17 +25,23 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <time.h>
 
 #ifndef __MINGW32__
 #include <poll.h>
 #endif
 
+#if HAVE_POSIX
+#include <sys/mman.h>
+#endif
+
 #include "osdep/io.h"
 
 #include "common/common.h"
 #include "common/msg.h"
 #include "stream.h"
 #include "options/m_option.h"
+#include "options/options.h"
 #include "options/path.h"
 
 #if HAVE_BSD_FSTATFS
@@ -57,12 +63,144 @@
 #endif
 #endif
 
+// How far ahead of the read position the kernel is asked to prefetch mapped
+// pages after a seek.
+#define MMAP_WILLNEED_SIZE (8 * 1024 * 1024)
+
+// Files modified less than this many seconds before opening are probably
+// still being written (recordings, downloads) and are not mapped.
+#define MMAP_STABLE_SECS 10
+
+// While mapped, the file is re-checked after reading this many bytes and on
+// every seek. Touching mapped pages past the end of a truncated file raises
+// SIGBUS, so the mapping is abandoned as soon as the file looks modified.
+#define MMAP_CHECK_SIZE (4 * 1024 * 1024)
+
 struct priv {
     int fd;
     bool close;
     bool regular;
+    // Size and modification time at opening.
+    int64_t file_size;
+    int64_t file_mtime;
+    // Read-only mapping of the first map_size bytes of a local regular file.
+    // Data beyond it (the file grew after opening) is read with pread().
+    // map_size is set to 0 if the file changed, so that everything is read
+    // with pread() from then on; map_len is the length to unmap.
+    unsigned char *map;
+    int64_t map_len;
+    int64_t map_size;
+    int64_t map_pos;
+    int64_t map_check_pos;
 };
 
+#if HAVE_POSIX
+static void map_advise(struct priv *p, int64_t pos, int64_t len, int advice)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    int64_t start = pos - pos % (page > 0 ? page : 4096);
+    int64_t end = MPMIN(pos + len, p->map_size);
+    if (end > start)
+        madvise(p->map + start, end - start, advice);
+}
+
+// Whether the file still has the size and modification time it had when it
+// was mapped. Appending changes neither the mapped part nor the size checked
+// here, but the modification time, so growing files fall back to pread() too.
+static bool map_check(stream_t *s)
+{
+    struct priv *p = s->priv;
+    if (!p->map_size)
+        return false;
+    p->map_check_pos = p->map_pos + MMAP_CHECK_SIZE;
+    struct stat st;
+    if (fstat(p->fd, &st) == 0 && st.st_size >= p->map_size &&
+        st.st_mtime == p->file_mtime)
+        return true;
+    MP_VERBOSE(s, "File was modified, no longer reading through mmap.\n");
+    p->map_size = 0;
+    return false;
+}
+
+static int fill_buffer_mmap(stream_t *s, char *buffer, int max_len)
+{
+    struct priv *p = s->priv;
+    if (p->map_pos >= p->map_check_pos)
+        map_check(s);
+    if (p->map_pos >= p->map_size) {
+        int r = pread(p->fd, buffer, max_len, p->map_pos);
+        if (r <= 0)
+            return -1;
+        p->map_pos += r;
+        return r;
+    }
+    int len = MPMIN(max_len, p->map_size - p->map_pos);
+    memcpy(buffer, p->map + p->map_pos, len);
+    p->map_pos += len;
+    return len;
+}
+
+static int seek_mmap(stream_t *s, int64_t newpos)
+{
+    struct priv *p = s->priv;
+    p->map_pos = newpos;
+    if (map_check(s) && newpos < p->map_size)
+        map_advise(p, newpos, MMAP_WILLNEED_SIZE, MADV_WILLNEED);
+    return 1;
+}
+
+static struct bstr peek_direct_mmap(stream_t *s, int64_t pos, int len)
+{
+    struct priv *p = s->priv;
+    if (pos < 0 || pos >= p->map_size)
+        return (struct bstr){0};
+    return (struct bstr){p->map + pos, MPMIN(len, p->map_size - pos)};
+}
+
+// Map the file if it's a local regular file which is not being modified. On
+// failure the stream simply keeps using read(), so this never makes opening
+// fail.
+static bool try_mmap(stream_t *s, int64_t size)
+{
+    struct priv *p = s->priv;
+    if (!p->regular || s->streaming || s->mode != STREAM_READ)
+        return false;
+    if (!s->opts || !s->opts->stream_file_mmap)
+        return false;
+    if (size <= 0 || (uint64_t)size > SIZE_MAX)
+        return false;
+    struct stat st;
+    if (fstat(p->fd, &st) != 0 || st.st_size != size ||
+        st.st_size != p->file_size || st.st_mtime != p->file_mtime)
+    {
+        MP_VERBOSE(s, "File changed since opening, using read().\n");
+        return false;
+    }
+    if (time(NULL) - st.st_mtime < MMAP_STABLE_SECS) {
+        MP_VERBOSE(s, "File was modified recently, using read().\n");
+        return false;
+    }
+    void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, p->fd, 0);
+    if (map == MAP_FAILED) {
+        MP_VERBOSE(s, "mmap failed (%s), using read().\n", mp_strerror(errno));
+        return false;
+    }
+    p->map = map;
+    p->map_len = p->map_size = size;
+    p->map_pos = 0;
+    p->map_check_pos = MMAP_CHECK_SIZE;
+    map_advise(p, 0, size, MADV_SEQUENTIAL);
+    map_advise(p, 0, MMAP_WILLNEED_SIZE, MADV_WILLNEED);
+    MP_VERBOSE(s, "Reading through a %"PRId64" byte memory mapping.\n", size);
+    return true;
+}
+#else
+static bool try_mmap(stream_t *s, int64_t size)
+{
+    return false;
+}
+#endif
+
 static int fill_buffer(stream_t *s, char *buffer, int max_len)
 {
     struct priv *p = s->priv;
@@ -123,6 +261,10 @@ static int control(stream_t *s, int cmd, void *arg)
 static void s_close(stream_t *s)
 {
     struct priv *p = s->priv;
+#if HAVE_POSIX
+    if (p->map)
+        munmap(p->map, p->map_len);
+#endif
     if (p->close && p->fd >= 0)
         close(p->fd);
 }
@@ -275,6 +417,8 @@ static int open_f(stream_t *stream)
         }
         struct stat st;
         if (fstat(fd, &st) == 0) {
+            priv->file_size = st.st_size;
+            priv->file_mtime = st.st_mtime;
             if (S_ISDIR(st.st_mode)) {
                 stream->type = STREAMTYPE_DIR;
                 stream->allow_caching = false;
@@ -310,6 +454,17 @@ static int open_f(stream_t *stream)
     if (check_stream_network(fd))
         stream->streaming = true;
 
+    if (len != (off_t)-1 && try_mmap(stream, len)) {
+        stream->fill_buffer = fill_buffer_mmap;
+        stream->seek = seek_mmap;
+        stream->peek_direct = peek_direct_mmap;
+    }
+#if HAVE_POSIX_FADVISE
+    else if (priv->regular && !write) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+
     return STREAM_OK;
 }
 
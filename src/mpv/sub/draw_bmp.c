@@ -20,9 +20,18 @@
 #include <assert.h>
 #include <math.h>
 #include <inttypes.h>
+#include <string.h>
 
 #include <libswscale/swscale.h>
 #include <libavutil/common.h>
+#include <libavutil/cpu.h>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define HAVE_X86_BLEND 1
+#include <immintrin.h>
+#else
+#define HAVE_X86_BLEND 0
+#endif
 
 #include "common/common.h"
 #include "draw_bmp.h"
@@ -55,6 +64,7 @@ struct mp_draw_sub_cache
     struct part *parts[MAX_OSD_PARTS];
     struct mp_image *upsample_img;
     struct mp_image upsample_temp;
+    uint8_t *chroma_alpha; // see draw_ass_direct()
 };
 
 
@@ -64,107 +74,412 @@ static bool get_sub_area(struct mp_rect bb, struct mp_image *temp,
                          struct sub_bitmap *sb, struct mp_image *out_area,
                          int *out_src_x, int *out_src_y);
 
-#define ACCURATE
-#define CONDITIONAL
+// All blend functions compute exactly the same results as the scalar versions
+// (the dst value is unchanged where alpha is 0), so the implementation can be
+// picked according to the CPU.
+struct blend_funcs {
+    void (*const8)(uint8_t *dst, uint16_t srcp, const uint8_t *srca,
+                   uint8_t srcamul, int w);
+    void (*const16)(uint16_t *dst, uint16_t srcp, const uint8_t *srca,
+                    uint8_t srcamul, int w);
+    void (*src8)(uint8_t *dst, const uint8_t *src, const uint8_t *srca, int w);
+    void (*src16)(uint16_t *dst, const uint16_t *src, const uint8_t *srca,
+                  int w);
+};
 
-static void blend_const16_alpha(void *dst, int dst_stride, uint16_t srcp,
-                                uint8_t *srca, int srca_stride, uint8_t srcamul,
-                                int w, int h)
+static void blend_const16_row(uint16_t *dst, uint16_t srcp,
+                              const uint8_t *srca, uint8_t srcamul, int w)
 {
-    if (!srcamul)
-        return;
-    for (int y = 0; y < h; y++) {
-        uint16_t *dst_r = (uint16_t *)((uint8_t *)dst + dst_stride * y);
-        uint8_t *srca_r = srca + srca_stride * y;
-        for (int x = 0; x < w; x++) {
-            uint32_t srcap = srca_r[x];
-#ifdef CONDITIONAL
-            if (!srcap)
-                continue;
-#endif
-            srcap *= srcamul; // now 0..65025
-            dst_r[x] = (srcp * srcap + dst_r[x] * (65025 - srcap) + 32512) / 65025;
-        }
+    for (int x = 0; x < w; x++) {
+        uint32_t srcap = srca[x];
+        if (!srcap)
+            continue;
+        srcap *= srcamul; // now 0..65025
+        dst[x] = (srcp * srcap + dst[x] * (65025 - srcap) + 32512) / 65025;
     }
 }
 
-static void blend_const8_alpha(void *dst, int dst_stride, uint16_t srcp,
-                               uint8_t *srca, int srca_stride, uint8_t srcamul,
-                               int w, int h)
+static void blend_const8_row(uint8_t *dst, uint16_t srcp, const uint8_t *srca,
+                             uint8_t srcamul, int w)
 {
-    if (!srcamul)
-        return;
-    for (int y = 0; y < h; y++) {
-        uint8_t *dst_r = (uint8_t *)dst + dst_stride * y;
-        uint8_t *srca_r = srca + srca_stride * y;
-        for (int x = 0; x < w; x++) {
-            uint32_t srcap = srca_r[x];
-#ifdef CONDITIONAL
-            if (!srcap)
-                continue;
-#endif
-#ifdef ACCURATE
-            srcap *= srcamul; // now 0..65025
-            dst_r[x] = (srcp * srcap + dst_r[x] * (65025 - srcap) + 32512) / 65025;
-#else
-            srcap = (srcap * srcamul + 255) >> 8;
-            dst_r[x] = (srcp * srcap + dst_r[x] * (255 - srcap) + 255) >> 8;
-#endif
-        }
+    for (int x = 0; x < w; x++) {
+        uint32_t srcap = srca[x];
+        if (!srcap)
+            continue;
+        srcap *= srcamul; // now 0..65025
+        dst[x] = (srcp * srcap + dst[x] * (65025 - srcap) + 32512) / 65025;
     }
 }
 
-static void blend_const_alpha(void *dst, int dst_stride, int srcp,
-                              uint8_t *srca, int srca_stride, uint8_t srcamul,
-                              int w, int h, int bytes)
+static void blend_src16_row(uint16_t *dst, const uint16_t *src,
+                            const uint8_t *srca, int w)
 {
-    if (bytes == 2) {
-        blend_const16_alpha(dst, dst_stride, srcp, srca, srca_stride, srcamul,
-                            w, h);
-    } else if (bytes == 1) {
-        blend_const8_alpha(dst, dst_stride, srcp, srca, srca_stride, srcamul,
-                           w, h);
+    for (int x = 0; x < w; x++) {
+        uint32_t srcap = srca[x];
+        if (!srcap)
+            continue;
+        dst[x] = (src[x] * srcap + dst[x] * (255 - srcap) + 127) / 255;
     }
 }
 
-static void blend_src16_alpha(void *dst, int dst_stride, void *src,
-                              int src_stride, uint8_t *srca, int srca_stride,
-                              int w, int h)
+static void blend_src8_row(uint8_t *dst, const uint8_t *src,
+                           const uint8_t *srca, int w)
 {
-    for (int y = 0; y < h; y++) {
-        uint16_t *dst_r = (uint16_t *)((uint8_t *)dst + dst_stride * y);
-        uint16_t *src_r = (uint16_t *)((uint8_t *)src + src_stride * y);
-        uint8_t *srca_r = srca + srca_stride * y;
-        for (int x = 0; x < w; x++) {
-            uint32_t srcap = srca_r[x];
-#ifdef CONDITIONAL
-            if (!srcap)
-                continue;
-#endif
-            dst_r[x] = (src_r[x] * srcap + dst_r[x] * (255 - srcap) + 127) / 255;
-        }
+    for (int x = 0; x < w; x++) {
+        uint16_t srcap = srca[x];
+        if (!srcap)
+            continue;
+        dst[x] = (src[x] * srcap + dst[x] * (255 - srcap) + 127) / 255;
+    }
+}
+
+static const struct blend_funcs blend_funcs_c = {
+    .const8 = blend_const8_row,
+    .const16 = blend_const16_row,
+    .src8 = blend_src8_row,
+    .src16 = blend_src16_row,
+};
+
+#if HAVE_X86_BLEND
+
+// The divisions are done in float (or double for 16 bit constant color). The
+// dividends are integers that are exactly representable, and the correctly
+// rounded quotient is never close enough to the next integer to be rounded up
+// to it, so truncating it gives the same result as integer division.
+
+#define SSE2 __attribute__((target("sse2")))
+#define AVX2 __attribute__((target("avx2")))
+
+static inline bool SSE2 all_zero_sse2(__m128i a)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(a, _mm_setzero_si128())) == 0xFFFF;
+}
+
+// (s * a + d * (255 - a) + 127) / 255 for 8 bit values in 16 bit lanes. The
+// sum is at most 65152, and for such x, x / 255 = (x + 1 + ((x + 1) >> 8)) >> 8.
+static inline __m128i SSE2 blend8_sse2(__m128i s, __m128i d, __m128i a)
+{
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(s, a),
+                              _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a)));
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+static void SSE2 blend_src8_sse2(uint8_t *dst, const uint8_t *src,
+                                 const uint8_t *srca, int w)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(srca + x));
+        if (all_zero_sse2(a))
+            continue;
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+        __m128i lo = blend8_sse2(_mm_unpacklo_epi8(s, zero),
+                                 _mm_unpacklo_epi8(d, zero),
+                                 _mm_unpacklo_epi8(a, zero));
+        __m128i hi = blend8_sse2(_mm_unpackhi_epi8(s, zero),
+                                 _mm_unpackhi_epi8(d, zero),
+                                 _mm_unpackhi_epi8(a, zero));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    blend_src8_row(dst + x, src + x, srca + x, w - x);
+}
+
+// (srcp * srcap + d * (65025 - srcap) + 32512) / 65025 for 4 pixels, where all
+// products and the sum are below 2^24.
+static inline __m128i SSE2 blend_const8x4_sse2(__m128 srcp, __m128i d,
+                                               __m128i srcap)
+{
+    __m128 af = _mm_cvtepi32_ps(srcap);
+    __m128 x = _mm_add_ps(_mm_mul_ps(srcp, af),
+                          _mm_mul_ps(_mm_cvtepi32_ps(d),
+                                     _mm_sub_ps(_mm_set1_ps(65025), af)));
+    x = _mm_add_ps(x, _mm_set1_ps(32512));
+    return _mm_cvttps_epi32(_mm_div_ps(x, _mm_set1_ps(65025)));
+}
+
+static inline __m128i SSE2 blend_const8x8_sse2(__m128 srcp, __m128i d,
+                                               __m128i srcap)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = blend_const8x4_sse2(srcp, _mm_unpacklo_epi16(d, zero),
+                                     _mm_unpacklo_epi16(srcap, zero));
+    __m128i hi = blend_const8x4_sse2(srcp, _mm_unpackhi_epi16(d, zero),
+                                     _mm_unpackhi_epi16(srcap, zero));
+    return _mm_packs_epi32(lo, hi);
+}
+
+static void SSE2 blend_const8_sse2(uint8_t *dst, uint16_t srcp,
+                                   const uint8_t *srca, uint8_t srcamul, int w)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mul = _mm_set1_epi16(srcamul);
+    const __m128 srcpf = _mm_set1_ps(srcp);
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(srca + x));
+        if (all_zero_sse2(a))
+            continue;
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+        __m128i lo = blend_const8x8_sse2(srcpf, _mm_unpacklo_epi8(d, zero),
+                        _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), mul));
+        __m128i hi = blend_const8x8_sse2(srcpf, _mm_unpackhi_epi8(d, zero),
+                        _mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), mul));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    blend_const8_row(dst + x, srcp, srca + x, srcamul, w - x);
+}
+
+// Pack 32 bit values in the range 0..65535 to 16 bit (no packus_epi32 in SSE2).
+static inline __m128i SSE2 pack_u32_sse2(__m128i lo, __m128i hi)
+{
+    const __m128i bias = _mm_set1_epi32(32768);
+    __m128i r = _mm_packs_epi32(_mm_sub_epi32(lo, bias), _mm_sub_epi32(hi, bias));
+    return _mm_xor_si128(r, _mm_set1_epi16(-32768));
+}
+
+// (s * a + d * (255 - a) + 127) / 255 for 4 pixels, all below 2^24.
+static inline __m128i SSE2 blend16x4_sse2(__m128i s, __m128i d, __m128i a)
+{
+    __m128 af = _mm_cvtepi32_ps(a);
+    __m128 x = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(s), af),
+                          _mm_mul_ps(_mm_cvtepi32_ps(d),
+                                     _mm_sub_ps(_mm_set1_ps(255), af)));
+    x = _mm_add_ps(x, _mm_set1_ps(127));
+    return _mm_cvttps_epi32(_mm_div_ps(x, _mm_set1_ps(255)));
+}
+
+static void SSE2 blend_src16_sse2(uint16_t *dst, const uint16_t *src,
+                                  const uint8_t *srca, int w)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 8 <= w; x += 8) {
+        __m128i a = _mm_loadl_epi64((const __m128i *)(srca + x));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, zero)) == 0xFFFF)
+            continue;
+        a = _mm_unpacklo_epi8(a, zero);
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+        __m128i lo = blend16x4_sse2(_mm_unpacklo_epi16(s, zero),
+                                    _mm_unpacklo_epi16(d, zero),
+                                    _mm_unpacklo_epi16(a, zero));
+        __m128i hi = blend16x4_sse2(_mm_unpackhi_epi16(s, zero),
+                                    _mm_unpackhi_epi16(d, zero),
+                                    _mm_unpackhi_epi16(a, zero));
+        _mm_storeu_si128((__m128i *)(dst + x), pack_u32_sse2(lo, hi));
     }
+    blend_src16_row(dst + x, src + x, srca + x, w - x);
 }
 
-static void blend_src8_alpha(void *dst, int dst_stride, void *src,
-                             int src_stride, uint8_t *srca, int srca_stride,
-                             int w, int h)
+// The 16 bit constant color sum needs up to 32 bits, so use double.
+static inline __m128i SSE2 blend_const16x2_sse2(__m128d srcp, __m128i d,
+                                                __m128i srcap)
+{
+    __m128d af = _mm_cvtepi32_pd(srcap);
+    __m128d x = _mm_add_pd(_mm_mul_pd(srcp, af),
+                           _mm_mul_pd(_mm_cvtepi32_pd(d),
+                                      _mm_sub_pd(_mm_set1_pd(65025), af)));
+    x = _mm_add_pd(x, _mm_set1_pd(32512));
+    return _mm_cvttpd_epi32(_mm_div_pd(x, _mm_set1_pd(65025)));
+}
+
+static inline __m128i SSE2 blend_const16x4_sse2(__m128d srcp, __m128i d,
+                                                __m128i srcap)
+{
+    __m128i lo = blend_const16x2_sse2(srcp, d, srcap);
+    __m128i hi = blend_const16x2_sse2(srcp, _mm_srli_si128(d, 8),
+                                      _mm_srli_si128(srcap, 8));
+    return _mm_unpacklo_epi64(lo, hi);
+}
+
+static void SSE2 blend_const16_sse2(uint16_t *dst, uint16_t srcp,
+                                    const uint8_t *srca, uint8_t srcamul, int w)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mul = _mm_set1_epi16(srcamul);
+    const __m128d srcpd = _mm_set1_pd(srcp);
+    int x = 0;
+    for (; x + 8 <= w; x += 8) {
+        __m128i a = _mm_loadl_epi64((const __m128i *)(srca + x));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, zero)) == 0xFFFF)
+            continue;
+        __m128i srcap = _mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), mul);
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+        __m128i lo = blend_const16x4_sse2(srcpd, _mm_unpacklo_epi16(d, zero),
+                                          _mm_unpacklo_epi16(srcap, zero));
+        __m128i hi = blend_const16x4_sse2(srcpd, _mm_unpackhi_epi16(d, zero),
+                                          _mm_unpackhi_epi16(srcap, zero));
+        _mm_storeu_si128((__m128i *)(dst + x), pack_u32_sse2(lo, hi));
+    }
+    blend_const16_row(dst + x, srcp, srca + x, srcamul, w - x);
+}
+
+static const struct blend_funcs blend_funcs_sse2 = {
+    .const8 = blend_const8_sse2,
+    .const16 = blend_const16_sse2,
+    .src8 = blend_src8_sse2,
+    .src16 = blend_src16_sse2,
+};
+
+// The AVX2 versions widen 16 (8 bit src) or 8 pixels into one register, and
+// narrow the two 128 bit halves of the result back.
+
+static inline __m256i AVX2 blend8_avx2(__m256i s, __m256i d, __m256i a)
 {
+    __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(s, a),
+                    _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a)));
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+static void AVX2 blend_src8_avx2(uint8_t *dst, const uint8_t *src,
+                                 const uint8_t *srca, int w)
+{
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(srca + x));
+        if (_mm_testz_si128(a, a))
+            continue;
+        __m256i r = blend8_avx2(
+            _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(src + x))),
+            _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(dst + x))),
+            _mm256_cvtepu8_epi16(a));
+        _mm_storeu_si128((__m128i *)(dst + x),
+                         _mm_packus_epi16(_mm256_castsi256_si128(r),
+                                          _mm256_extracti128_si256(r, 1)));
+    }
+    blend_src8_row(dst + x, src + x, srca + x, w - x);
+}
+
+static inline __m128i AVX2 blend_const8x8_avx2(__m256 srcp, __m256i d,
+                                               __m256i srcap)
+{
+    __m256 af = _mm256_cvtepi32_ps(srcap);
+    __m256 x = _mm256_add_ps(_mm256_mul_ps(srcp, af),
+                             _mm256_mul_ps(_mm256_cvtepi32_ps(d),
+                                 _mm256_sub_ps(_mm256_set1_ps(65025), af)));
+    x = _mm256_add_ps(x, _mm256_set1_ps(32512));
+    __m256i r = _mm256_cvttps_epi32(_mm256_div_ps(x, _mm256_set1_ps(65025)));
+    return _mm_packus_epi32(_mm256_castsi256_si128(r),
+                            _mm256_extracti128_si256(r, 1));
+}
+
+static void AVX2 blend_const8_avx2(uint8_t *dst, uint16_t srcp,
+                                   const uint8_t *srca, uint8_t srcamul, int w)
+{
+    const __m256i mul = _mm256_set1_epi32(srcamul);
+    const __m256 srcpf = _mm256_set1_ps(srcp);
+    int x = 0;
+    for (; x + 16 <= w; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(srca + x));
+        if (_mm_testz_si128(a, a))
+            continue;
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + x));
+        __m128i lo = blend_const8x8_avx2(srcpf, _mm256_cvtepu8_epi32(d),
+                        _mm256_mullo_epi32(_mm256_cvtepu8_epi32(a), mul));
+        __m128i hi = blend_const8x8_avx2(srcpf,
+                        _mm256_cvtepu8_epi32(_mm_srli_si128(d, 8)),
+                        _mm256_mullo_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(a, 8)), mul));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    blend_const8_row(dst + x, srcp, srca + x, srcamul, w - x);
+}
+
+static void AVX2 blend_src16_avx2(uint16_t *dst, const uint16_t *src,
+                                  const uint8_t *srca, int w)
+{
+    int x = 0;
+    for (; x + 8 <= w; x += 8) {
+        __m128i a8 = _mm_loadl_epi64((const __m128i *)(srca + x));
+        if (_mm_testz_si128(a8, a8))
+            continue;
+        __m256 af = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(a8));
+        __m256 s = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + x))));
+        __m256 d = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+                        _mm_loadu_si128((const __m128i *)(dst + x))));
+        __m256 v = _mm256_add_ps(_mm256_mul_ps(s, af),
+                        _mm256_mul_ps(d, _mm256_sub_ps(_mm256_set1_ps(255), af)));
+        v = _mm256_add_ps(v, _mm256_set1_ps(127));
+        __m256i r = _mm256_cvttps_epi32(_mm256_div_ps(v, _mm256_set1_ps(255)));
+        _mm_storeu_si128((__m128i *)(dst + x),
+                         _mm_packus_epi32(_mm256_castsi256_si128(r),
+                                          _mm256_extracti128_si256(r, 1)));
+    }
+    blend_src16_row(dst + x, src + x, srca + x, w - x);
+}
+
+static inline __m128i AVX2 blend_const16x4_avx2(__m256d srcp, __m128i d,
+                                                __m128i srcap)
+{
+    __m256d af = _mm256_cvtepi32_pd(srcap);
+    __m256d v = _mm256_add_pd(_mm256_mul_pd(srcp, af),
+                    _mm256_mul_pd(_mm256_cvtepi32_pd(d),
+                                  _mm256_sub_pd(_mm256_set1_pd(65025), af)));
+    v = _mm256_add_pd(v, _mm256_set1_pd(32512));
+    return _mm256_cvttpd_epi32(_mm256_div_pd(v, _mm256_set1_pd(65025)));
+}
+
+static void AVX2 blend_const16_avx2(uint16_t *dst, uint16_t srcp,
+                                    const uint8_t *srca, uint8_t srcamul, int w)
+{
+    const __m256i mul = _mm256_set1_epi32(srcamul);
+    const __m256d srcpd = _mm256_set1_pd(srcp);
+    int x = 0;
+    for (; x + 8 <= w; x += 8) {
+        __m128i a8 = _mm_loadl_epi64((const __m128i *)(srca + x));
+        if (_mm_testz_si128(a8, a8))
+            continue;
+        __m256i srcap = _mm256_mullo_epi32(_mm256_cvtepu8_epi32(a8), mul);
+        __m256i d = _mm256_cvtepu16_epi32(
+                        _mm_loadu_si128((const __m128i *)(dst + x)));
+        __m128i lo = blend_const16x4_avx2(srcpd, _mm256_castsi256_si128(d),
+                                          _mm256_castsi256_si128(srcap));
+        __m128i hi = blend_const16x4_avx2(srcpd, _mm256_extracti128_si256(d, 1),
+                                          _mm256_extracti128_si256(srcap, 1));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi32(lo, hi));
+    }
+    blend_const16_row(dst + x, srcp, srca + x, srcamul, w - x);
+}
+
+static const struct blend_funcs blend_funcs_avx2 = {
+    .const8 = blend_const8_avx2,
+    .const16 = blend_const16_avx2,
+    .src8 = blend_src8_avx2,
+    .src16 = blend_src16_avx2,
+};
+
+#endif /* HAVE_X86_BLEND */
+
+static const struct blend_funcs *get_blend_funcs(void)
+{
+#if HAVE_X86_BLEND
+    int flags = av_get_cpu_flags();
+    if (flags & AV_CPU_FLAG_AVX2)
+        return &blend_funcs_avx2;
+    if (flags & AV_CPU_FLAG_SSE2)
+        return &blend_funcs_sse2;
+#endif
+    return &blend_funcs_c;
+}
+
+static void blend_const_alpha(void *dst, int dst_stride, int srcp,
+                              uint8_t *srca, int srca_stride, uint8_t srcamul,
+                              int w, int h, int bytes)
+{
+    if (!srcamul)
+        return;
+    const struct blend_funcs *f = get_blend_funcs();
     for (int y = 0; y < h; y++) {
-        uint8_t *dst_r = (uint8_t *)dst + dst_stride * y;
-        uint8_t *src_r = (uint8_t *)src + src_stride * y;
+        void *dst_r = (uint8_t *)dst + dst_stride * y;
         uint8_t *srca_r = srca + srca_stride * y;
-        for (int x = 0; x < w; x++) {
-            uint16_t srcap = srca_r[x];
-#ifdef CONDITIONAL
-            if (!srcap)
-                continue;
-#endif
-#ifdef ACCURATE
-            dst_r[x] = (src_r[x] * srcap + dst_r[x] * (255 - srcap) + 127) / 255;
-#else
-            dst_r[x] = (src_r[x] * srcap + dst_r[x] * (255 - srcap) + 255) >> 8;
-#endif
+        if (bytes == 2) {
+            f->const16(dst_r, srcp, srca_r, srcamul, w);
+        } else if (bytes == 1) {
+            f->const8(dst_r, srcp, srca_r, srcamul, w);
         }
     }
 }
@@ -173,12 +488,16 @@ static void blend_src_alpha(void *dst, int dst_stride, void *src,
                             int src_stride, uint8_t *srca, int srca_stride,
                             int w, int h, int bytes)
 {
-    if (bytes == 2) {
-        blend_src16_alpha(dst, dst_stride, src, src_stride, srca, srca_stride,
-                          w, h);
-    } else if (bytes == 1) {
-        blend_src8_alpha(dst, dst_stride, src, src_stride, srca, srca_stride,
-                         w, h);
+    const struct blend_funcs *f = get_blend_funcs();
+    for (int y = 0; y < h; y++) {
+        void *dst_r = (uint8_t *)dst + dst_stride * y;
+        void *src_r = (uint8_t *)src + src_stride * y;
+        uint8_t *srca_r = srca + srca_stride * y;
+        if (bytes == 2) {
+            f->src16(dst_r, src_r, srca_r, w);
+        } else if (bytes == 1) {
+            f->src8(dst_r, src_r, srca_r, w);
+        }
     }
 }
 
@@ -330,6 +649,109 @@ static void draw_ass(struct mp_draw_sub_cache *cache, struct mp_rect bb,
     }
 }
 
+// Whether libass bitmaps can be blended into img as it is (see
+// draw_ass_direct()), and with how many bits per component.
+static bool get_direct_blend_bits(struct mp_image *img, int *out_bits)
+{
+    int flags = img->fmt.flags;
+    if (!(flags & MP_IMGFLAG_YUV_P) || !(flags & MP_IMGFLAG_NE))
+        return false;
+    *out_bits = img->fmt.plane_bits;
+    return true;
+}
+
+// Average the alpha over the area of each chroma sample of rc (with the given
+// chroma shifts). Pixels of the area outside of rc count as transparent.
+static uint8_t *downsample_alpha(struct mp_draw_sub_cache *cache, uint8_t *a,
+                                 int a_stride, struct mp_rect rc, int xs,
+                                 int ys, int *out_stride)
+{
+    int cx0 = rc.x0 >> xs, cy0 = rc.y0 >> ys;
+    int cw = ((rc.x1 + (1 << xs) - 1) >> xs) - cx0;
+    int ch = ((rc.y1 + (1 << ys) - 1) >> ys) - cy0;
+    uint16_t *sum = talloc_zero_array(NULL, uint16_t, cw);
+    cache->chroma_alpha = talloc_realloc(cache, cache->chroma_alpha, uint8_t,
+                                         cw * ch);
+    int shift = xs + ys;
+    for (int cy = 0; cy < ch; cy++) {
+        memset(sum, 0, cw * sizeof(sum[0]));
+        for (int dy = 0; dy < (1 << ys); dy++) {
+            int y = ((cy0 + cy) << ys) + dy;
+            if (y < rc.y0 || y >= rc.y1)
+                continue;
+            uint8_t *row = a + (y - rc.y0) * a_stride;
+            for (int x = rc.x0; x < rc.x1; x++)
+                sum[(x >> xs) - cx0] += row[x - rc.x0];
+        }
+        uint8_t *out = cache->chroma_alpha + cy * cw;
+        for (int cx = 0; cx < cw; cx++)
+            out[cx] = (sum[cx] + (1 << shift >> 1)) >> shift;
+    }
+    talloc_free(sum);
+    *out_stride = cw;
+    return cache->chroma_alpha;
+}
+
+// Blend libass bitmaps into planar YUV without converting it to 4:4:4 first.
+// Since the color is constant, blending a chroma sample with the alpha
+// averaged over its area is the same as upsampling, blending and area
+// downsampling (up to rounding), but only touches the covered samples.
+static void draw_ass_direct(struct mp_draw_sub_cache *cache,
+                            struct mp_image *dst, int bits,
+                            struct sub_bitmaps *sbs)
+{
+    struct mp_csp_params cspar = MP_CSP_PARAMS_DEFAULTS;
+    mp_csp_set_image_params(&cspar, &dst->params);
+    cspar.levels_out = MP_CSP_LEVELS_PC; // RGB (libass.color)
+    cspar.int_bits_in = bits;
+    cspar.int_bits_out = 8;
+
+    struct mp_cmat yuv2rgb, rgb2yuv;
+    mp_get_yuv2rgb_coeffs(&cspar, &yuv2rgb);
+    mp_invert_yuv2rgb(&rgb2yuv, &yuv2rgb);
+
+    int bytes = (bits + 7) / 8;
+    int xs = dst->fmt.chroma_xs, ys = dst->fmt.chroma_ys;
+    for (int i = 0; i < sbs->num_parts; ++i) {
+        struct sub_bitmap *sb = &sbs->parts[i];
+
+        struct mp_rect rc = {sb->x, sb->y, sb->x + sb->dw, sb->y + sb->dh};
+        if (!mp_rect_intersection(&rc, &(struct mp_rect){0, 0, dst->w, dst->h}))
+            continue;
+
+        int color_yuv[3] = {
+            (sb->libass.color >> 24) & 0xFF,
+            (sb->libass.color >> 16) & 0xFF,
+            (sb->libass.color >> 8) & 0xFF,
+        };
+        int a = 255 - (sb->libass.color & 0xFF);
+        mp_map_int_color(&rgb2yuv, bits, color_yuv);
+
+        uint8_t *alpha_p = (uint8_t *)sb->bitmap + (rc.y0 - sb->y) * sb->stride
+                           + (rc.x0 - sb->x);
+        blend_const_alpha(dst->planes[0] + rc.y0 * dst->stride[0] + rc.x0 * bytes,
+                          dst->stride[0], color_yuv[0], alpha_p, sb->stride, a,
+                          rc.x1 - rc.x0, rc.y1 - rc.y0, bytes);
+        if (dst->num_planes < 3)
+            continue;
+
+        int a_stride = sb->stride;
+        if (xs || ys)
+            alpha_p = downsample_alpha(cache, alpha_p, sb->stride, rc, xs, ys,
+                                       &a_stride);
+        struct mp_rect crc = {rc.x0 >> xs, rc.y0 >> ys,
+                              (rc.x1 + (1 << xs) - 1) >> xs,
+                              (rc.y1 + (1 << ys) - 1) >> ys};
+        for (int p = 1; p < 3; p++) {
+            uint8_t *plane = dst->planes[p] + crc.y0 * dst->stride[p]
+                             + crc.x0 * bytes;
+            blend_const_alpha(plane, dst->stride[p], color_yuv[p], alpha_p,
+                              a_stride, a, crc.x1 - crc.x0, crc.y1 - crc.y0,
+                              bytes);
+        }
+    }
+}
+
 static void get_swscale_alignment(const struct mp_image *img, int *out_xstep,
                                   int *out_ystep)
 {
@@ -541,6 +963,11 @@ void mp_draw_sub_bitmaps(struct mp_draw_sub_cache **cache, struct mp_image *dst,
         cache_ = talloc_zero(NULL, struct mp_draw_sub_cache);
 
     int format, bits;
+    if (sbs->format == SUBBITMAP_LIBASS && get_direct_blend_bits(dst, &bits)) {
+        draw_ass_direct(cache_, dst, bits, sbs);
+        goto done;
+    }
+
     get_closest_y444_format(dst->imgfmt, &format, &bits);
 
     struct mp_rect rc_list[MP_SUB_BB_LIST_MAX];
@@ -550,7 +977,7 @@ void mp_draw_sub_bitmaps(struct mp_draw_sub_cache **cache, struct mp_image *dst,
         struct mp_rect bb = rc_list[r];
 
         if (!align_bbox_for_swscale(dst, &bb))
-            return;
+            continue;
 
         struct mp_image dst_region = *dst;
         mp_image_crop_rc(&dst_region, bb);
@@ -567,6 +994,7 @@ void mp_draw_sub_bitmaps(struct mp_draw_sub_cache **cache, struct mp_image *dst,
         chroma_down(&dst_region, temp);
     }
 
+done:
     if (cache) {
         *cache = cache_;
     } else {
@@ -0,0 +1,354 @@
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "osdep/timer.h"
+#include "sub/osd.h"
+#include "video/out/bitmap_packer.h"
+
+#define TEX_SIZE 4096
+#define KARAOKE_FRAMES 240
+
+static struct bitmap_packer *create_packer(void *ctx, bool incremental,
+                                           int padding)
+{
+    struct bitmap_packer *packer = talloc_zero(ctx, struct bitmap_packer);
+    packer->w_max = packer->h_max = TEX_SIZE;
+    packer->incremental = incremental;
+    packer->padding = padding;
+    return packer;
+}
+
+static void *new_bitmap(void *ctx, int w, int h)
+{
+    uint8_t *data = talloc_size(ctx, w * h);
+    for (int n = 0; n < w * h; n++)
+        data[n] = 1 + rand() % 255;
+    return data;
+}
+
+static void set_part(void *ctx, struct sub_bitmap *sb, int w, int h)
+{
+    *sb = (struct sub_bitmap){
+        .bitmap = new_bitmap(ctx, w, h), .stride = w,
+        .w = w, .h = h, .dw = w, .dh = h,
+    };
+}
+
+static struct sub_bitmaps *make_subs(void *ctx, int num_parts, int max_size)
+{
+    struct sub_bitmaps *sbs = talloc_zero(ctx, struct sub_bitmaps);
+    sbs->format = SUBBITMAP_LIBASS;
+    sbs->num_parts = num_parts;
+    sbs->parts = talloc_zero_array(sbs, struct sub_bitmap, num_parts);
+    for (int n = 0; n < num_parts; n++)
+        set_part(sbs, &sbs->parts[n], 1 + rand() % max_size, 1 + rand() % max_size);
+    return sbs;
+}
+
+// All rectangles are within the surface, and only those with the same bitmap
+// overlap.
+static void check_layout(struct bitmap_packer *packer, struct sub_bitmaps *sbs)
+{
+    assert_int_equal(packer->count, sbs->num_parts);
+    for (int a = 0; a < packer->count; a++) {
+        struct pos pa = packer->result[a];
+        struct sub_bitmap *sa = &sbs->parts[a];
+        assert_true(pa.x >= 0 && pa.x + sa->w <= packer->w);
+        assert_true(pa.y >= 0 && pa.y + sa->h <= packer->h);
+        assert_true(pa.x + sa->w <= packer->used_width);
+        assert_true(pa.y + sa->h <= packer->used_height);
+        for (int b = a + 1; b < packer->count; b++) {
+            struct pos pb = packer->result[b];
+            struct sub_bitmap *sb = &sbs->parts[b];
+            if (sa->bitmap == sb->bitmap)
+                continue;
+            bool apart = pa.x + packer->in[a].x <= pb.x ||
+                         pb.x + packer->in[b].x <= pa.x ||
+                         pa.y + packer->in[a].y <= pb.y ||
+                         pb.y + packer->in[b].y <= pa.y;
+            assert_true(apart);
+        }
+    }
+}
+
+// Copies the dirty bitmaps to the persistent surface, and checks that all
+// bitmaps (and their padding) are there afterwards.
+static void check_copy(struct bitmap_packer *packer, struct sub_bitmaps *sbs,
+                       uint8_t *surface)
+{
+    int stride = TEX_SIZE;
+    if (packer->repacked)
+        memset(surface, 0x55, TEX_SIZE * TEX_SIZE);
+    packer_copy_subbitmaps(packer, sbs, surface, 1, stride);
+    for (int n = 0; n < packer->count; n++) {
+        struct sub_bitmap *s = &sbs->parts[n];
+        struct pos p = packer->result[n];
+        for (int y = 0; y < s->h; y++) {
+            assert_memory_equal(surface + (p.y + y) * stride + p.x,
+                                (uint8_t *)s->bitmap + y * s->stride, s->w);
+        }
+        struct pos rc[2];
+        packer_get_rect(packer, n, rc);
+        for (int y = rc[0].y; y < rc[1].y; y++) {
+            for (int x = rc[0].x; x < rc[1].x; x++) {
+                if (x >= p.x + s->w || y >= p.y + s->h)
+                    assert_int_equal(surface[y * stride + x], 0);
+            }
+        }
+    }
+}
+
+static void test_full(void **state)
+{
+    srand(1);
+    void *ctx = talloc_new(NULL);
+    struct bitmap_packer *packer = create_packer(ctx, false, 1);
+    for (int i = 0; i < 20; i++) {
+        struct sub_bitmaps *sbs = make_subs(ctx, 1 + rand() % 300, 100);
+        assert_true(packer_pack_from_subbitmaps(packer, sbs) >= 0);
+        check_layout(packer, sbs);
+        assert_true(packer->repacked);
+        assert_int_equal(packer->num_dirty, packer->count);
+    }
+    talloc_free(ctx);
+}
+
+static void test_incremental(void **state)
+{
+    srand(2);
+    void *ctx = talloc_new(NULL);
+    struct bitmap_packer *packer = create_packer(ctx, true, 0);
+    struct sub_bitmaps *sbs = make_subs(ctx, 100, 60);
+    assert_true(packer_pack_from_subbitmaps(packer, sbs) >= 0);
+    check_layout(packer, sbs);
+    assert_int_equal(packer->num_dirty, 100);
+    struct pos *old = talloc_memdup(ctx, packer->result, 100 * sizeof(old[0]));
+
+    // one bitmap replaced, one removed, one added
+    set_part(sbs, &sbs->parts[10], 20, 20);
+    sbs->parts[50] = sbs->parts[--sbs->num_parts];
+    MP_TARRAY_APPEND(sbs, sbs->parts, sbs->num_parts, sbs->parts[0]);
+    set_part(sbs, &sbs->parts[sbs->num_parts - 1], 30, 10);
+    assert_int_equal(packer_pack_from_subbitmaps(packer, sbs), 0);
+    check_layout(packer, sbs);
+    assert_false(packer->repacked);
+    assert_int_equal(packer->num_dirty, 2);
+    for (int n = 0; n < 99; n++) {
+        if (n != 10 && n != 50)
+            assert_memory_equal(&packer->result[n], &old[n], sizeof(old[n]));
+    }
+
+    // nothing changed
+    assert_int_equal(packer_pack_from_subbitmaps(packer, sbs), 0);
+    assert_false(packer->repacked);
+    assert_int_equal(packer->num_dirty, 0);
+    talloc_free(ctx);
+}
+
+// The memory of a bitmap may be reused for different contents.
+static void test_reused_memory(void **state)
+{
+    srand(3);
+    void *ctx = talloc_new(NULL);
+    struct bitmap_packer *packer = create_packer(ctx, true, 0);
+    struct sub_bitmaps *sbs = make_subs(ctx, 10, 60);
+    packer_pack_from_subbitmaps(packer, sbs);
+    ((uint8_t *)sbs->parts[3].bitmap)[sbs->parts[3].w * sbs->parts[3].h - 1]++;
+    packer_pack_from_subbitmaps(packer, sbs);
+    assert_int_equal(packer->num_dirty, 1);
+    assert_int_equal(packer->dirty[0], 3);
+    talloc_free(ctx);
+}
+
+// Parts with the same bitmap share the place on the surface.
+static void test_duplicates(void **state)
+{
+    srand(4);
+    void *ctx = talloc_new(NULL);
+    struct bitmap_packer *packer = create_packer(ctx, true, 0);
+    struct sub_bitmaps *sbs = make_subs(ctx, 10, 60);
+    sbs->parts[7] = sbs->parts[2];
+    sbs->parts[7].x = 100;
+    packer_pack_from_subbitmaps(packer, sbs);
+    check_layout(packer, sbs);
+    assert_memory_equal(&packer->result[7], &packer->result[2],
+                        sizeof(struct pos));
+    assert_int_equal(packer->num_dirty, 9);
+    talloc_free(ctx);
+}
+
+// Random changes which often overflow the surface, so that it is packed again
+// and grows. The surface must contain the right data all the time.
+static void test_churn(void **state)
+{
+    srand(5);
+    void *ctx = talloc_new(NULL);
+    uint8_t *surface = talloc_size(ctx, TEX_SIZE * TEX_SIZE);
+    for (int padding = 0; padding < 2; padding++) {
+        struct bitmap_packer *packer = create_packer(ctx, true, padding);
+        struct sub_bitmaps *sbs = make_subs(ctx, 50, 40);
+        int repacked = 0;
+        for (int i = 0; i < 300; i++) {
+            for (int n = 0; n < sbs->num_parts; n++) {
+                if (rand() % 8 == 0)
+                    set_part(sbs, &sbs->parts[n], 1 + rand() % 40, 1 + rand() % 40);
+            }
+            if (rand() % 4 == 0 && sbs->num_parts < 500) {
+                MP_TARRAY_APPEND(sbs, sbs->parts, sbs->num_parts,
+                                 (struct sub_bitmap){0});
+                set_part(sbs, &sbs->parts[sbs->num_parts - 1],
+                         1 + rand() % 80, 1 + rand() % 80);
+            }
+            assert_true(packer_pack_from_subbitmaps(packer, sbs) >= 0);
+            check_layout(packer, sbs);
+            check_copy(packer, sbs, surface);
+            repacked += packer->repacked;
+        }
+        assert_true(repacked > 1 && repacked < 100);
+    }
+    talloc_free(ctx);
+}
+
+/* Bitmap lists as libass renders them for a karaoke script: for each event
+ * there are glyph, outline and shadow images, which stay the same until the
+ * event changes. In the karaoke lines the highlighted syllable is split into
+ * two images (at the \kf position), which are new in each frame. Sizes and
+ * counts are those of a typical 1080p karaoke script.
+ */
+struct event {
+    int w, h, syllables;
+    int start, end; // frames
+};
+
+static const struct event karaoke[] = {
+    {1210, 62, 9, 0, 96},   {980, 62, 7, 0, 120},  {1340, 58, 11, 96, 240},
+    {1120, 58, 8, 120, 240},
+};
+
+static const struct event dialogue[] = {
+    {1450, 54, 0, 0, 60},   {860, 54, 0, 0, 60},   {1290, 54, 0, 60, 150},
+    {1610, 54, 0, 150, 240}, {740, 54, 0, 150, 240}, {420, 180, 0, 30, 200},
+    {310, 96, 0, 0, 240},   {96, 40, 0, 0, 240},
+};
+
+struct recording {
+    struct sub_bitmaps **frames;
+    int num_frames;
+};
+
+// Images of one event as libass would output them: shadow, outline, glyphs,
+// with glyph runs split into words.
+static void add_event(void *ctx, struct sub_bitmaps *sbs, void **cache,
+                      const struct event *ev, int frame)
+{
+    if (frame < ev->start || frame >= ev->end)
+        return;
+    int words = ev->syllables ? ev->syllables : 1 + ev->w / 200;
+    int word_w = ev->w / words;
+    for (int layer = 0; layer < 3; layer++) {
+        for (int n = 0; n < words; n++) {
+            int w = word_w + (layer < 2 ? 6 : 0), h = ev->h + (layer < 2 ? 6 : 0);
+            void **bitmap = &cache[layer * words + n];
+            if (!*bitmap)
+                *bitmap = new_bitmap(ctx, w, h);
+            MP_TARRAY_APPEND(sbs, sbs->parts, sbs->num_parts, (struct sub_bitmap){
+                .bitmap = *bitmap, .stride = w, .w = w, .h = h, .dw = w, .dh = h,
+                .x = 200 + n * word_w, .y = 900,
+            });
+        }
+    }
+    if (!ev->syllables)
+        return;
+    // the syllable being sung, split at the fill position
+    int progress = (frame - ev->start) * ev->w / (ev->end - ev->start);
+    int split = progress % word_w;
+    for (int n = 0; n < 2; n++) {
+        int w = n ? word_w - split : split;
+        if (w <= 0)
+            continue;
+        MP_TARRAY_APPEND(sbs, sbs->parts, sbs->num_parts, (struct sub_bitmap){
+            .bitmap = new_bitmap(sbs, w, ev->h), .stride = w,
+            .w = w, .h = ev->h, .dw = w, .dh = ev->h,
+        });
+    }
+}
+
+static struct recording *record_karaoke(void *ctx)
+{
+    struct recording *rec = talloc_zero(ctx, struct recording);
+    int num_events = MP_ARRAY_SIZE(karaoke) + MP_ARRAY_SIZE(dialogue);
+    void ***caches = talloc_zero_array(rec, void **, num_events);
+    for (int n = 0; n < num_events; n++)
+        caches[n] = talloc_zero_array(caches, void *, 64);
+    for (int frame = 0; frame < KARAOKE_FRAMES; frame++) {
+        struct sub_bitmaps *sbs = talloc_zero(rec, struct sub_bitmaps);
+        sbs->format = SUBBITMAP_LIBASS;
+        for (int n = 0; n < MP_ARRAY_SIZE(dialogue); n++)
+            add_event(rec, sbs, caches[n], &dialogue[n], frame);
+        for (int n = 0; n < MP_ARRAY_SIZE(karaoke); n++) {
+            add_event(rec, sbs, caches[MP_ARRAY_SIZE(dialogue) + n],
+                      &karaoke[n], frame);
+        }
+        MP_TARRAY_APPEND(rec, rec->frames, rec->num_frames, sbs);
+    }
+    return rec;
+}
+
+static void replay(struct recording *rec, bool incremental, double *ms,
+                   int64_t *uploaded, double *occupancy)
+{
+    void *ctx = talloc_new(NULL);
+    struct bitmap_packer *packer = create_packer(ctx, incremental, 0);
+    *uploaded = 0;
+    *occupancy = 0;
+    int64_t start = mp_time_us();
+    for (int f = 0; f < rec->num_frames; f++) {
+        struct sub_bitmaps *sbs = rec->frames[f];
+        assert_true(packer_pack_from_subbitmaps(packer, sbs) >= 0);
+        int64_t area = 0;
+        for (int n = 0; n < packer->num_dirty; n++) {
+            struct sub_bitmap *s = &sbs->parts[packer->dirty[n]];
+            *uploaded += s->w * s->h;
+        }
+        for (int n = 0; n < sbs->num_parts; n++)
+            area += sbs->parts[n].w * sbs->parts[n].h;
+        *occupancy += area / (double)(packer->used_width * packer->used_height);
+    }
+    *ms = (mp_time_us() - start) / 1e3 / rec->num_frames;
+    *occupancy /= rec->num_frames;
+    talloc_free(ctx);
+}
+
+static void test_karaoke(void **state)
+{
+    srand(6);
+    mp_time_init();
+    void *ctx = talloc_new(NULL);
+    struct recording *rec = record_karaoke(ctx);
+    double full_ms, inc_ms, full_occ, inc_occ;
+    int64_t full_px, inc_px;
+    replay(rec, false, &full_ms, &full_px, &full_occ);
+    replay(rec, true, &inc_ms, &inc_px, &inc_occ);
+    printf("karaoke, %d frames: full packing %.3f ms, %.1f%% occupancy, "
+           "%"PRId64" px/frame uploaded; incremental %.3f ms, %.1f%% "
+           "occupancy, %"PRId64" px/frame uploaded\n", rec->num_frames,
+           full_ms, full_occ * 100, full_px / rec->num_frames,
+           inc_ms, inc_occ * 100, inc_px / rec->num_frames);
+    assert_true(inc_px * 10 < full_px);
+    talloc_free(ctx);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_full),
+        cmocka_unit_test(test_incremental),
+        cmocka_unit_test(test_reused_memory),
+        cmocka_unit_test(test_duplicates),
+        cmocka_unit_test(test_churn),
+        cmocka_unit_test(test_karaoke),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
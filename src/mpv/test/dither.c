@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "options/path.h"
+#include "osdep/timer.h"
+#include "talloc.h"
+#include "video/out/dither.h"
+
+// The matrix must contain each threshold exactly once.
+static void check_matrix(const float *matrix, int sizeb)
+{
+    int size2 = 1 << (sizeb * 2);
+    bool *seen = talloc_zero_array(NULL, bool, size2);
+    for (int n = 0; n < size2; n++) {
+        int rank = lrintf(matrix[n] * size2);
+        assert_true(rank >= 0 && rank < size2);
+        assert_false(seen[rank]);
+        seen[rank] = true;
+    }
+    talloc_free(seen);
+}
+
+static void test_fruit_matrix(void **state)
+{
+    float matrix[64 * 64];
+    for (int sizeb = 1; sizeb <= 6; sizeb++) {
+        mp_make_fruit_dither_matrix(matrix, sizeb);
+        check_matrix(matrix, sizeb);
+    }
+}
+
+static void test_cache(void **state)
+{
+    float matrix[16 * 16];
+    mp_make_fruit_dither_matrix(matrix, 4);
+    const float *a = mp_get_fruit_dither_matrix(4, NULL);
+    const float *b = mp_get_fruit_dither_matrix(4, NULL);
+    assert_ptr_equal(a, b);
+    assert_memory_equal(a, matrix, sizeof(matrix));
+}
+
+static void test_cache_dir(void **state)
+{
+    char dir[] = "/tmp/mpv-test-dither-XXXXXX";
+    assert_non_null(mkdtemp(dir));
+    const float *matrix = mp_get_fruit_dither_matrix(5, dir);
+    check_matrix(matrix, 5);
+
+    char *file = mp_path_join(NULL, dir, "fruit-dither-5");
+    struct stat st;
+    assert_int_equal(stat(file, &st), 0);
+    assert_int_equal(st.st_size, 32 * 32 * sizeof(uint16_t));
+    FILE *in = fopen(file, "rb");
+    assert_non_null(in);
+    for (int n = 0; n < 32 * 32; n++) {
+        uint16_t rank;
+        assert_int_equal(fread(&rank, sizeof(rank), 1, in), 1);
+        assert_int_equal(rank, lrintf(matrix[n] * 32 * 32));
+    }
+    fclose(in);
+    unlink(file);
+    rmdir(dir);
+    talloc_free(file);
+}
+
+// Prints how long the sizes worth using take to generate.
+static void test_timing(void **state)
+{
+    mp_time_init();
+    float *matrix = talloc_array(NULL, float, 256 * 256);
+    for (int sizeb = 6; sizeb <= 8; sizeb++) {
+        int64_t start = mp_time_us();
+        mp_make_fruit_dither_matrix(matrix, sizeb);
+        printf("fruit dither matrix %dx%d: %.3f ms\n", 1 << sizeb, 1 << sizeb,
+               (mp_time_us() - start) / 1e3);
+    }
+    talloc_free(matrix);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_fruit_matrix),
+        cmocka_unit_test(test_cache),
+        cmocka_unit_test(test_cache_dir),
+        cmocka_unit_test(test_timing),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
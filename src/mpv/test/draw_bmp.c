@@ -0,0 +1,223 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavutil/cpu.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "osdep/timer.h"
+#include "sub/draw_bmp.h"
+#include "video/mp_image.h"
+
+#define BENCH_W 3840
+#define BENCH_H 2160
+#define BENCH_PARTS 600
+#define BENCH_FRAMES 10
+
+static void fill_image(struct mp_image *img)
+{
+    int bits = img->fmt.plane_bits;
+    for (int p = 0; p < img->num_planes; p++) {
+        int bytes = img->fmt.bytes[p];
+        for (int y = 0; y < mp_image_plane_h(img, p); y++) {
+            uint8_t *row = img->planes[p] + y * img->stride[p];
+            for (int x = 0; x < mp_image_plane_w(img, p); x++) {
+                if (bytes == 2) {
+                    ((uint16_t *)row)[x] = rand() & ((1 << bits) - 1);
+                } else {
+                    row[x] = rand();
+                }
+            }
+        }
+    }
+}
+
+static bool images_equal(struct mp_image *a, struct mp_image *b)
+{
+    for (int p = 0; p < a->num_planes; p++) {
+        int size = mp_image_plane_w(a, p) * a->fmt.bytes[p];
+        for (int y = 0; y < mp_image_plane_h(a, p); y++) {
+            if (memcmp(a->planes[p] + y * a->stride[p],
+                       b->planes[p] + y * b->stride[p], size) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Glyph-like bitmaps: mostly transparent, with opaque cores and soft edges.
+static uint8_t random_alpha(void)
+{
+    int r = rand() % 8;
+    return r < 4 ? 0 : r < 6 ? 255 : rand();
+}
+
+static struct sub_bitmaps *make_subs(void *ta_ctx, enum sub_bitmap_format fmt,
+                                     int num_parts, int w, int h, int max_size)
+{
+    struct sub_bitmaps *sbs = talloc_zero(ta_ctx, struct sub_bitmaps);
+    sbs->format = fmt;
+    sbs->change_id = 1;
+    sbs->num_parts = num_parts;
+    sbs->parts = talloc_zero_array(sbs, struct sub_bitmap, num_parts);
+    for (int n = 0; n < num_parts; n++) {
+        struct sub_bitmap *sb = &sbs->parts[n];
+        sb->w = sb->dw = 1 + rand() % max_size;
+        sb->h = sb->dh = 1 + rand() % max_size;
+        // RGBA bitmaps may go outside of the image, libass ones are clipped
+        if (fmt == SUBBITMAP_RGBA) {
+            sb->x = rand() % (w + 16) - 8;
+            sb->y = rand() % (h + 16) - 8;
+        } else {
+            sb->w = sb->dw = MPMIN(sb->w, w);
+            sb->h = sb->dh = MPMIN(sb->h, h);
+            sb->x = rand() % (w - sb->w + 1);
+            sb->y = rand() % (h - sb->h + 1);
+        }
+        int bpp = fmt == SUBBITMAP_RGBA ? 4 : 1;
+        sb->stride = sb->w * bpp + rand() % 8;
+        uint8_t *data = talloc_size(sbs, sb->stride * sb->h);
+        for (int y = 0; y < sb->h; y++) {
+            uint8_t *row = data + y * sb->stride;
+            for (int x = 0; x < sb->w; x++) {
+                uint8_t a = random_alpha();
+                if (fmt == SUBBITMAP_RGBA) {
+                    // premultiplied
+                    for (int c = 0; c < 3; c++)
+                        row[x * 4 + c] = a ? rand() % (a + 1) : 0;
+                    row[x * 4 + 3] = a;
+                } else {
+                    row[x] = a;
+                }
+            }
+        }
+        sb->bitmap = data;
+        sb->libass.color = ((uint32_t)rand() << 8) | (rand() % 4 ? 0 : rand() & 0xFF);
+    }
+    return sbs;
+}
+
+// Draws sbs with the C blend functions and with the ones for this CPU. The
+// same cache is used, so that the scaled RGBA bitmaps are the same.
+static void check_exact(int imgfmt, enum sub_bitmap_format fmt, int w, int h)
+{
+    void *ctx = talloc_new(NULL);
+    struct mp_image *ref = talloc_steal(ctx, mp_image_alloc(imgfmt, w, h));
+    assert_non_null(ref);
+    fill_image(ref);
+    struct mp_image *img = talloc_steal(ctx, mp_image_new_copy(ref));
+    struct sub_bitmaps *sbs = make_subs(ctx, fmt, 40, w, h, 80);
+
+    struct mp_draw_sub_cache *cache = NULL;
+    av_force_cpu_flags(0);
+    mp_draw_sub_bitmaps(&cache, ref, sbs);
+    av_force_cpu_flags(-1);
+    mp_draw_sub_bitmaps(&cache, img, sbs);
+    assert_true(images_equal(ref, img));
+
+    talloc_free(cache);
+    talloc_free(ctx);
+}
+
+static void test_exact_libass(void **state)
+{
+    srand(1);
+    check_exact(IMGFMT_420P, SUBBITMAP_LIBASS, 333, 191);
+    check_exact(IMGFMT_444P, SUBBITMAP_LIBASS, 333, 191);
+    check_exact(IMGFMT_420P10, SUBBITMAP_LIBASS, 333, 191);
+    check_exact(IMGFMT_444P16, SUBBITMAP_LIBASS, 333, 191);
+    check_exact(IMGFMT_GBRP, SUBBITMAP_LIBASS, 333, 191);
+}
+
+static void test_exact_rgba(void **state)
+{
+    srand(2);
+    check_exact(IMGFMT_444P, SUBBITMAP_RGBA, 320, 180);
+    check_exact(IMGFMT_444P10, SUBBITMAP_RGBA, 320, 180);
+    check_exact(IMGFMT_GBRP, SUBBITMAP_RGBA, 320, 180);
+}
+
+// Blending into subsampled chroma must give the same result as 4:4:4 where a
+// chroma sample is entirely covered by an opaque bitmap.
+static void test_subsampled_chroma(void **state)
+{
+    void *ctx = talloc_new(NULL);
+    struct mp_image *img = talloc_steal(ctx, mp_image_alloc(IMGFMT_420P, 64, 64));
+    struct mp_image *full = talloc_steal(ctx, mp_image_alloc(IMGFMT_444P, 64, 64));
+    for (int p = 0; p < 3; p++) {
+        memset(img->planes[p], 128, img->stride[p] * mp_image_plane_h(img, p));
+        memset(full->planes[p], 128, full->stride[p] * 64);
+    }
+    uint8_t bitmap[20 * 20];
+    memset(bitmap, 255, sizeof(bitmap));
+    struct sub_bitmap sb = {
+        .bitmap = bitmap, .stride = 20,
+        .w = 20, .h = 20, .dw = 20, .dh = 20,
+        .x = 9, .y = 9, // odd, so the edge samples are half covered
+        .libass.color = 0xE0204000,
+    };
+    struct sub_bitmaps sbs = {
+        .format = SUBBITMAP_LIBASS, .parts = &sb, .num_parts = 1,
+    };
+    mp_draw_sub_bitmaps(NULL, img, &sbs);
+    mp_draw_sub_bitmaps(NULL, full, &sbs);
+    for (int y = 0; y < 64; y++) {
+        assert_memory_equal(img->planes[0] + y * img->stride[0],
+                            full->planes[0] + y * full->stride[0], 64);
+    }
+    for (int p = 1; p < 3; p++) {
+        for (int y = 5; y < 14; y++) {
+            for (int x = 5; x < 14; x++) {
+                assert_int_equal(img->planes[p][y * img->stride[p] + x],
+                                 full->planes[p][y * 2 * full->stride[p] + x * 2]);
+            }
+        }
+        // half covered, and untouched samples
+        uint8_t edge = img->planes[p][4 * img->stride[p] + 8];
+        assert_true(edge != 128 && edge != img->planes[p][5 * img->stride[p] + 8]);
+        assert_int_equal(img->planes[p][3 * img->stride[p] + 8], 128);
+        assert_int_equal(img->planes[p][8 * img->stride[p] + 15], 128);
+    }
+    talloc_free(ctx);
+}
+
+static double bench(struct mp_image *img, struct sub_bitmaps *sbs)
+{
+    int64_t start = mp_time_us();
+    for (int n = 0; n < BENCH_FRAMES; n++)
+        mp_draw_sub_bitmaps(NULL, img, sbs);
+    return (mp_time_us() - start) / 1e3 / BENCH_FRAMES;
+}
+
+// Dense typesetting on a 4K frame, as in a screenshot with subtitles.
+static void test_throughput(void **state)
+{
+    srand(3);
+    mp_time_init();
+    void *ctx = talloc_new(NULL);
+    static const int fmts[] = {IMGFMT_420P, IMGFMT_420P10};
+    for (int n = 0; n < MP_ARRAY_SIZE(fmts); n++) {
+        struct mp_image *img =
+            talloc_steal(ctx, mp_image_alloc(fmts[n], BENCH_W, BENCH_H));
+        fill_image(img);
+        struct sub_bitmaps *sbs = make_subs(ctx, SUBBITMAP_LIBASS, BENCH_PARTS,
+                                            BENCH_W, BENCH_H, 160);
+        av_force_cpu_flags(0);
+        double c = bench(img, sbs);
+        av_force_cpu_flags(-1);
+        double simd = bench(img, sbs);
+        printf("%d-bit 4K, %d libass bitmaps: C %.2f ms, SIMD %.2f ms\n",
+               img->fmt.plane_bits, BENCH_PARTS, c, simd);
+    }
+    talloc_free(ctx);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_exact_libass),
+        cmocka_unit_test(test_exact_rgba),
+        cmocka_unit_test(test_subsampled_chroma),
+        cmocka_unit_test(test_throughput),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
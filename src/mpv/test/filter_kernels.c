@@ -0,0 +1,75 @@
+#include <string.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "osdep/timer.h"
+#include "video/out/filter_kernels.h"
+
+#define LUT_SIZE 256
+#define TIMING_ITERATIONS 1000
+
+static const int sizes[] = {2, 4, 6, 8, 12, 16, 0};
+
+static struct filter_kernel make_kernel(const char *name, double scale)
+{
+    struct filter_kernel k = *mp_find_filter_kernel(name);
+    const struct filter_window *w = mp_find_filter_window(k.window);
+    if (w)
+        k.w = *w;
+    mp_init_filter(&k, sizes, scale);
+    return k;
+}
+
+static void test_lut_matches(void **state)
+{
+    static float a[LUT_SIZE * 16], b[LUT_SIZE * 16];
+    const char *names[] = {"spline36", "lanczos", "ewa_lanczos", "mitchell"};
+    for (int n = 0; n < MP_ARRAY_SIZE(names); n++) {
+        for (double scale = 0.5; scale <= 2.0; scale *= 2) {
+            struct filter_kernel k = make_kernel(names[n], scale);
+            mp_compute_lut(&k, LUT_SIZE, a);
+            mp_get_lut(&k, LUT_SIZE, b);
+            mp_get_lut(&k, LUT_SIZE, b);
+            assert_memory_equal(a, b, sizeof(float) * LUT_SIZE * k.size);
+        }
+    }
+}
+
+// Changing a parameter must not return the cached table of the old one.
+static void test_lut_params(void **state)
+{
+    static float a[LUT_SIZE * 16], b[LUT_SIZE * 16];
+    struct filter_kernel k = make_kernel("lanczos", 1.0);
+    mp_get_lut(&k, LUT_SIZE, a);
+    k.f.blur = 1.5;
+    mp_get_lut(&k, LUT_SIZE, b);
+    assert_true(memcmp(a, b, sizeof(float) * LUT_SIZE * k.size) != 0);
+    mp_compute_lut(&k, LUT_SIZE, a);
+    assert_memory_equal(a, b, sizeof(float) * LUT_SIZE * k.size);
+}
+
+static void test_lut_timing(void **state)
+{
+    static float lut[LUT_SIZE * 16];
+    struct filter_kernel k = make_kernel("ewa_lanczossharp", 1.0);
+    mp_time_init();
+    int64_t start = mp_time_us();
+    for (int n = 0; n < TIMING_ITERATIONS; n++)
+        mp_compute_lut(&k, LUT_SIZE, lut);
+    double computed = (mp_time_us() - start) / (double)TIMING_ITERATIONS;
+    start = mp_time_us();
+    for (int n = 0; n < TIMING_ITERATIONS; n++)
+        mp_get_lut(&k, LUT_SIZE, lut);
+    double cached = (mp_time_us() - start) / (double)TIMING_ITERATIONS;
+    printf("ewa_lanczossharp LUT: computed %.2f us, cached %.2f us\n",
+           computed, cached);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_lut_matches),
+        cmocka_unit_test(test_lut_params),
+        cmocka_unit_test(test_lut_timing),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,348 @@
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "common/msg.h"
+#include "options/path.h"
+#include "osdep/timer.h"
+#include "video/out/gl_utils.h"
+
+#define BINARY_SIZE 32
+#define TIMING_ITERATIONS 20000
+
+// Stands in for a real driver: counts links and binary loads, and produces
+// program "binaries" that are only accepted by the same renderer.
+static struct {
+    const char *renderer;
+    GLuint next_id;
+    int links, loads, rejected;
+} fake;
+
+static const GLubyte *GLAPIENTRY fake_GetString(GLenum name)
+{
+    switch (name) {
+    case GL_VENDOR:   return (const GLubyte *)"mpv";
+    case GL_RENDERER: return (const GLubyte *)fake.renderer;
+    case GL_VERSION:  return (const GLubyte *)"3.3 (fake)";
+    default:          return NULL;
+    }
+}
+
+static GLuint GLAPIENTRY fake_Create(void) { return ++fake.next_id; }
+static GLuint GLAPIENTRY fake_CreateShader(GLenum type) { return ++fake.next_id; }
+static void GLAPIENTRY fake_Id(GLuint id) { }
+static void GLAPIENTRY fake_IdId(GLuint a, GLuint b) { }
+static void GLAPIENTRY fake_ShaderSource(GLuint shader, GLsizei count,
+                                         const GLchar **src, const GLint *len) { }
+static void GLAPIENTRY fake_GetInfoLog(GLuint id, GLsizei size, GLsizei *len,
+                                       GLchar *log) { }
+static void GLAPIENTRY fake_BindAttribLocation(GLuint prog, GLuint index,
+                                               const GLchar *name) { }
+static void GLAPIENTRY fake_ProgramParameteri(GLuint prog, GLenum name,
+                                              GLint value) { }
+// result of the last glProgramBinary(), or -1 after glLinkProgram()
+static GLint binary_status = -1;
+
+static void GLAPIENTRY fake_LinkProgram(GLuint prog)
+{
+    fake.links++;
+    binary_status = -1;
+}
+
+static void GLAPIENTRY fake_Getiv(GLuint id, GLenum name, GLint *value)
+{
+    switch (name) {
+    case GL_COMPILE_STATUS:
+    case GL_LINK_STATUS:            *value = 1; break;
+    case GL_PROGRAM_BINARY_LENGTH:  *value = BINARY_SIZE; break;
+    default:                        *value = 0; break;
+    }
+}
+
+static void GLAPIENTRY fake_GetProgramBinary(GLuint prog, GLsizei size,
+                                             GLsizei *len, GLenum *format,
+                                             GLvoid *data)
+{
+    memset(data, 0, size);
+    snprintf((char *)data, size, "%s", fake.renderer);
+    *len = size;
+    *format = 0x1234;
+}
+
+static void GLAPIENTRY fake_ProgramBinary(GLuint prog, GLenum format,
+                                          const GLvoid *data, GLsizei len)
+{
+    bool ok = format == 0x1234 && len == BINARY_SIZE &&
+              strcmp(data, fake.renderer) == 0;
+    fake.loads += ok;
+    fake.rejected += !ok;
+    binary_status = ok;
+}
+
+static void GLAPIENTRY fake_GetProgramiv(GLuint id, GLenum name, GLint *value)
+{
+    fake_Getiv(id, name, value);
+    if (name == GL_LINK_STATUS && binary_status >= 0)
+        *value = binary_status;
+}
+
+static void init_gl(GL *gl)
+{
+    *gl = (GL){
+        .glsl_version = 330,
+        .mpgl_caps = MPGL_CAP_PROGRAM_BINARY,
+        .GetString = fake_GetString,
+        .CreateProgram = fake_Create,
+        .CreateShader = fake_CreateShader,
+        .ShaderSource = fake_ShaderSource,
+        .CompileShader = fake_Id,
+        .GetShaderiv = fake_Getiv,
+        .GetShaderInfoLog = fake_GetInfoLog,
+        .AttachShader = fake_IdId,
+        .DeleteShader = fake_Id,
+        .BindAttribLocation = fake_BindAttribLocation,
+        .LinkProgram = fake_LinkProgram,
+        .GetProgramiv = fake_GetProgramiv,
+        .GetProgramInfoLog = fake_GetInfoLog,
+        .UseProgram = fake_Id,
+        .DeleteProgram = fake_Id,
+        .ProgramParameteri = fake_ProgramParameteri,
+        .GetProgramBinary = fake_GetProgramBinary,
+        .ProgramBinary = fake_ProgramBinary,
+    };
+}
+
+static const struct gl_vao_entry vertex_vao[] = {
+    {"position", 2, GL_FLOAT, false, 0},
+    {0}
+};
+
+struct fixture {
+    GL gl;
+    struct gl_vao vao;
+    char dir[64];
+};
+
+static int setup(void **state)
+{
+    memset(&fake, 0, sizeof(fake));
+    fake.renderer = "llvmpipe";
+    binary_status = -1;
+    struct fixture *f = talloc_zero(NULL, struct fixture);
+    init_gl(&f->gl);
+    f->vao = (struct gl_vao){.gl = &f->gl, .entries = vertex_vao};
+    snprintf(f->dir, sizeof(f->dir), "/tmp/mpv-test-shader-cache-XXXXXX");
+    assert_non_null(mkdtemp(f->dir));
+    *state = f;
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    struct fixture *f = *state;
+    DIR *d = opendir(f->dir);
+    struct dirent *ent;
+    while (d && (ent = readdir(d))) {
+        if (ent->d_name[0] != '.') {
+            char *path = mp_path_join(NULL, f->dir, ent->d_name);
+            unlink(path);
+            talloc_free(path);
+        }
+    }
+    if (d)
+        closedir(d);
+    rmdir(f->dir);
+    talloc_free(f);
+    return 0;
+}
+
+// Returns the number of files in the directory, and fails if any of them is
+// a leftover temporary file.
+static int count_files(struct fixture *f)
+{
+    int count = 0;
+    DIR *d = opendir(f->dir);
+    assert_non_null(d);
+    struct dirent *ent;
+    while ((ent = readdir(d))) {
+        if (ent->d_name[0] == '.')
+            continue;
+        assert_null(strstr(ent->d_name, ".tmp"));
+        count++;
+    }
+    closedir(d);
+    return count;
+}
+
+static struct gl_shader_cache *create_sc(struct fixture *f, bool binaries)
+{
+    struct gl_shader_cache *sc = gl_sc_create(&f->gl, mp_null_log, NULL);
+    gl_sc_set_vao(sc, &f->vao);
+    if (binaries)
+        gl_sc_set_cache_dir(sc, f->dir);
+    return sc;
+}
+
+static void draw(struct gl_shader_cache *sc, int n)
+{
+    gl_sc_addf(sc, "color = vec4(%d.0);\n", n);
+    gl_sc_gen_shader_and_reset(sc);
+}
+
+static void test_reuse(void **state)
+{
+    struct fixture *f = *state;
+    struct gl_shader_cache *sc = create_sc(f, false);
+    for (int n = 0; n < 10; n++) {
+        draw(sc, 0);
+        draw(sc, 1);
+    }
+    assert_int_equal(fake.links, 2);
+    gl_sc_destroy(sc);
+}
+
+// Programs used every frame must survive any number of others passing through.
+static void test_lru(void **state)
+{
+    struct fixture *f = *state;
+    struct gl_shader_cache *sc = create_sc(f, false);
+    for (int n = 0; n < 200; n++) {
+        draw(sc, 0);
+        draw(sc, 1 + n);
+    }
+    assert_int_equal(fake.links, 201);
+    // the most recent ones are still there
+    int links = fake.links;
+    draw(sc, 200);
+    draw(sc, 199);
+    assert_int_equal(fake.links, links);
+    gl_sc_destroy(sc);
+}
+
+static void test_binary(void **state)
+{
+    struct fixture *f = *state;
+    struct gl_shader_cache *sc = create_sc(f, true);
+    for (int n = 0; n < 4; n++)
+        draw(sc, n);
+    gl_sc_destroy(sc);
+    assert_int_equal(fake.links, 4);
+    assert_int_equal(fake.loads, 0);
+    assert_int_equal(count_files(f), 4);
+
+    // a new process with the same driver doesn't link anything
+    sc = create_sc(f, true);
+    for (int n = 0; n < 4; n++)
+        draw(sc, n);
+    gl_sc_destroy(sc);
+    assert_int_equal(fake.links, 4);
+    assert_int_equal(fake.loads, 4);
+
+    // other drivers use other files
+    fake.renderer = "other";
+    sc = create_sc(f, true);
+    draw(sc, 0);
+    gl_sc_destroy(sc);
+    assert_int_equal(fake.links, 5);
+    assert_int_equal(fake.rejected, 0);
+}
+
+// Binaries which the driver refuses are compiled from source again.
+static void test_binary_rejected(void **state)
+{
+    struct fixture *f = *state;
+    struct gl_shader_cache *sc = create_sc(f, true);
+    draw(sc, 0);
+    gl_sc_destroy(sc);
+
+    // e.g. a driver update which kept the version string
+    char *file = NULL;
+    DIR *d = opendir(f->dir);
+    struct dirent *ent;
+    while ((ent = readdir(d))) {
+        if (ent->d_name[0] != '.')
+            file = mp_path_join(NULL, f->dir, ent->d_name);
+    }
+    closedir(d);
+    assert_non_null(file);
+    FILE *out = fopen(file, "r+b");
+    assert_non_null(out);
+    fseek(out, 16, SEEK_SET);
+    fputc('x', out);
+    fclose(out);
+    talloc_free(file);
+
+    sc = create_sc(f, true);
+    draw(sc, 0);
+    gl_sc_destroy(sc);
+    assert_int_equal(fake.rejected, 1);
+    assert_int_equal(fake.links, 2);
+}
+
+// Programs with a custom shader are linked as usual, but not stored.
+static void test_no_binary_cache(void **state)
+{
+    struct fixture *f = *state;
+    struct gl_shader_cache *sc = create_sc(f, true);
+    gl_sc_no_binary_cache(sc);
+    draw(sc, 0);
+    draw(sc, 1);
+    gl_sc_destroy(sc);
+    assert_int_equal(fake.links, 2);
+    assert_int_equal(count_files(f), 1);
+}
+
+// Setting the directory trims it to the newest binaries and keeps other files.
+static void test_prune(void **state)
+{
+    struct fixture *f = *state;
+    char *other = mp_path_join(NULL, f->dir, "fruit-dither-6");
+    FILE *out = fopen(other, "wb");
+    assert_non_null(out);
+    fclose(out);
+    struct gl_shader_cache *sc = create_sc(f, true);
+    for (int n = 0; n < 300; n++)
+        draw(sc, n);
+    gl_sc_destroy(sc);
+    assert_int_equal(count_files(f), 301);
+
+    sc = create_sc(f, true);
+    gl_sc_destroy(sc);
+    assert_int_equal(count_files(f), 257);
+    assert_int_equal(access(other, F_OK), 0);
+    talloc_free(other);
+}
+
+// Prints the cost of a cache hit, which is paid for each pass of each frame.
+static void test_lookup_timing(void **state)
+{
+    struct fixture *f = *state;
+    struct gl_shader_cache *sc = create_sc(f, false);
+    for (int n = 0; n < 16; n++)
+        draw(sc, n);
+    mp_time_init();
+    int64_t start = mp_time_us();
+    for (int n = 0; n < TIMING_ITERATIONS; n++)
+        draw(sc, n % 16);
+    double secs = (mp_time_us() - start) / 1e6;
+    assert_int_equal(fake.links, 16);
+    printf("%d shader lookups with 16 programs in %.3f s (%.2f us each)\n",
+           TIMING_ITERATIONS, secs, secs * 1e6 / TIMING_ITERATIONS);
+    gl_sc_destroy(sc);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_reuse, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_lru, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_binary, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_binary_rejected, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_no_binary_cache, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_prune, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_lookup_timing, setup, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
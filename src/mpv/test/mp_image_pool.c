@@ -0,0 +1,141 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "osdep/timer.h"
+#include "video/img_format.h"
+#include "video/mp_image.h"
+#include "video/mp_image_pool.h"
+
+#define STRESS_THREADS 4
+#define STRESS_ITERATIONS 200000
+#define QUEUE_SIZE 8
+
+static void test_reuse(void **state)
+{
+    struct mp_image_pool *pool = mp_image_pool_new(4);
+    struct mp_image *a = mp_image_pool_get(pool, IMGFMT_420P, 64, 32);
+    struct mp_image *b = mp_image_pool_get(pool, IMGFMT_420P, 32, 64);
+    assert_non_null(a);
+    assert_non_null(b);
+    assert_null(mp_image_pool_get_no_alloc(pool, IMGFMT_420P, 64, 32));
+    uint8_t *data = a->planes[0];
+    talloc_free(a);
+    a = mp_image_pool_get_no_alloc(pool, IMGFMT_420P, 64, 32);
+    assert_non_null(a);
+    assert_ptr_equal(a->planes[0], data);
+    assert_null(mp_image_pool_get_no_alloc(pool, IMGFMT_RGBA, 64, 32));
+    talloc_free(a);
+    talloc_free(b);
+    talloc_free(pool);
+}
+
+static void test_lru(void **state)
+{
+    struct mp_image_pool *pool = mp_image_pool_new(4);
+    mp_image_pool_set_lru(pool);
+    struct mp_image *a = mp_image_pool_get(pool, IMGFMT_420P, 16, 16);
+    struct mp_image *b = mp_image_pool_get(pool, IMGFMT_420P, 16, 16);
+    uint8_t *first = a->planes[0];
+    talloc_free(b);
+    talloc_free(a);
+    // b was handed out last, so a is the least recently used one.
+    a = mp_image_pool_get_no_alloc(pool, IMGFMT_420P, 16, 16);
+    assert_ptr_equal(a->planes[0], first);
+    talloc_free(a);
+    talloc_free(pool);
+}
+
+// Images must stay valid when the pool goes away before them.
+static void test_outlive_pool(void **state)
+{
+    struct mp_image_pool *pool = mp_image_pool_new(2);
+    struct mp_image *a = mp_image_pool_get(pool, IMGFMT_420P, 16, 16);
+    struct mp_image *b = mp_image_pool_get(pool, IMGFMT_420P, 16, 16);
+    talloc_free(b);
+    talloc_free(pool);
+    memset(a->planes[0], 0, a->stride[0] * a->h);
+    talloc_free(a);
+}
+
+struct queue {
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    struct mp_image *images[QUEUE_SIZE];
+    int num_images;
+    bool eof;
+};
+
+static void *unref_thread(void *ptr)
+{
+    struct queue *q = ptr;
+    pthread_mutex_lock(&q->lock);
+    while (q->num_images || !q->eof) {
+        if (!q->num_images) {
+            pthread_cond_wait(&q->wakeup, &q->lock);
+            continue;
+        }
+        struct mp_image *img = q->images[--q->num_images];
+        pthread_cond_broadcast(&q->wakeup);
+        pthread_mutex_unlock(&q->lock);
+        talloc_free(img);
+        pthread_mutex_lock(&q->lock);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+// The decoder thread allocates frames from its pool, and other threads (filters,
+// VO) drop the last reference. Prints get/unref throughput.
+static void test_stress(void **state)
+{
+    static const int sizes[][2] = {{64, 32}, {32, 32}, {64, 64}};
+    struct queue q = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .wakeup = PTHREAD_COND_INITIALIZER,
+    };
+    pthread_t threads[STRESS_THREADS];
+    for (int n = 0; n < STRESS_THREADS; n++)
+        assert_int_equal(pthread_create(&threads[n], NULL, unref_thread, &q), 0);
+
+    mp_time_init();
+    struct mp_image_pool *pool = mp_image_pool_new(QUEUE_SIZE * 2);
+    int64_t start = mp_time_us();
+    for (int n = 0; n < STRESS_ITERATIONS; n++) {
+        const int *size = sizes[n % MP_ARRAY_SIZE(sizes)];
+        struct mp_image *img = mp_image_pool_get(pool, IMGFMT_420P,
+                                                 size[0], size[1]);
+        assert_non_null(img);
+        img->planes[0][0] = n;
+        pthread_mutex_lock(&q.lock);
+        while (q.num_images == QUEUE_SIZE)
+            pthread_cond_wait(&q.wakeup, &q.lock);
+        q.images[q.num_images++] = img;
+        pthread_cond_broadcast(&q.wakeup);
+        pthread_mutex_unlock(&q.lock);
+        if (n == STRESS_ITERATIONS / 2)
+            mp_image_pool_clear(pool);
+    }
+    pthread_mutex_lock(&q.lock);
+    q.eof = true;
+    pthread_cond_broadcast(&q.wakeup);
+    pthread_mutex_unlock(&q.lock);
+    talloc_free(pool);
+    for (int n = 0; n < STRESS_THREADS; n++)
+        pthread_join(threads[n], NULL);
+    double secs = (mp_time_us() - start) / 1e6;
+    printf("%d get/unref pairs with %d unref threads in %.3f s (%.0f/s)\n",
+           STRESS_ITERATIONS, STRESS_THREADS, secs,
+           STRESS_ITERATIONS / MPMAX(secs, 1e-9));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_reuse),
+        cmocka_unit_test(test_lru),
+        cmocka_unit_test(test_outlive_pool),
+        cmocka_unit_test(test_stress),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
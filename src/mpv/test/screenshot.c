@@ -0,0 +1,196 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "libmpv/client.h"
+#include "osdep/timer.h"
+
+#define VIDEO "av://lavfi:testsrc=size=3840x2160:rate=24"
+#define CAPTURES 16
+
+static mpv_event *wait_for(mpv_handle *h, mpv_event_id id)
+{
+    while (1) {
+        mpv_event *ev = mpv_wait_event(h, 10);
+        assert_int_not_equal(ev->event_id, MPV_EVENT_NONE); // timeout
+        assert_int_not_equal(ev->event_id, MPV_EVENT_END_FILE);
+        assert_int_not_equal(ev->event_id, MPV_EVENT_SHUTDOWN);
+        if (ev->event_id == id)
+            return ev;
+    }
+}
+
+static int setup(void **state)
+{
+    mpv_handle *h = mpv_create();
+    assert_non_null(h);
+    mpv_set_option_string(h, "vo", "null");
+    mpv_set_option_string(h, "aid", "no");
+    assert_int_equal(mpv_initialize(h), 0);
+    const char *cmd[] = {"loadfile", VIDEO, NULL};
+    assert_int_equal(mpv_command(h, cmd), 0);
+    wait_for(h, MPV_EVENT_PLAYBACK_RESTART);
+    *state = h;
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    mpv_terminate_destroy(*state);
+    return 0;
+}
+
+static void check_reply(mpv_event *ev, uint64_t ud, int w, int h)
+{
+    assert_int_equal(ev->error, 0);
+    assert_int_equal(ev->reply_userdata, ud);
+    mpv_event_screenshot_raw *shot = ev->data;
+    assert_int_equal(shot->w, w);
+    assert_int_equal(shot->h, h);
+    assert_true(shot->stride >= w * 4);
+    assert_string_equal(shot->format, "bgr0");
+    assert_non_null(shot->data);
+}
+
+static void test_sizes(void **state)
+{
+    mpv_handle *h = *state;
+    assert_int_equal(mpv_screenshot_raw_async(h, 1, "video", 0, 0), 0);
+    check_reply(wait_for(h, MPV_EVENT_SCREENSHOT_RAW_REPLY), 1, 3840, 2160);
+    assert_int_equal(mpv_screenshot_raw_async(h, 2, NULL, 320, 0), 0);
+    check_reply(wait_for(h, MPV_EVENT_SCREENSHOT_RAW_REPLY), 2, 320, 180);
+    assert_int_equal(mpv_screenshot_raw_async(h, 3, "subtitles", -1, 90), 0);
+    check_reply(wait_for(h, MPV_EVENT_SCREENSHOT_RAW_REPLY), 3, 160, 90);
+    assert_int_equal(mpv_screenshot_raw_async(h, 4, "video", 100, 100), 0);
+    check_reply(wait_for(h, MPV_EVENT_SCREENSHOT_RAW_REPLY), 4, 100, 100);
+    assert_int_equal(mpv_screenshot_raw_async(h, 5, "bogus", 0, 0),
+                     MPV_ERROR_INVALID_PARAMETER);
+}
+
+// The image must survive its event if a reference is held.
+static void test_ref(void **state)
+{
+    mpv_handle *h = *state;
+    assert_int_equal(mpv_screenshot_raw_async(h, 1, "video", 64, 36), 0);
+    mpv_event *ev = wait_for(h, MPV_EVENT_SCREENSHOT_RAW_REPLY);
+    check_reply(ev, 1, 64, 36);
+    mpv_event_screenshot_raw *shot = ev->data;
+    int size = shot->stride * shot->h;
+    uint8_t *copy = talloc_memdup(NULL, shot->data, size);
+    uint8_t *data = shot->data;
+    mpv_raw_frame *frame = mpv_raw_frame_ref(shot->frame);
+    assert_non_null(frame);
+
+    assert_int_equal(mpv_screenshot_raw_async(h, 2, "video", 64, 36), 0);
+    wait_for(h, MPV_EVENT_SCREENSHOT_RAW_REPLY);
+    mpv_wait_event(h, 0); // releases the second event too
+    assert_memory_equal(data, copy, size);
+
+    mpv_raw_frame_unref(frame);
+    talloc_free(copy);
+}
+
+// Reads a property in a loop from a second client, and records how long each
+// access had to wait for the playloop.
+struct probe {
+    mpv_handle *client;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    bool stop;
+    int64_t max_us, total_us;
+    int count;
+};
+
+static void *probe_thread(void *p)
+{
+    struct probe *pr = p;
+    while (1) {
+        pthread_mutex_lock(&pr->lock);
+        bool stop = pr->stop;
+        pthread_mutex_unlock(&pr->lock);
+        if (stop)
+            break;
+        int64_t start = mp_time_us();
+        double pos;
+        mpv_get_property(pr->client, "time-pos", MPV_FORMAT_DOUBLE, &pos);
+        int64_t t = mp_time_us() - start;
+        pthread_mutex_lock(&pr->lock);
+        pr->max_us = MPMAX(pr->max_us, t);
+        pr->total_us += t;
+        pr->count++;
+        pthread_mutex_unlock(&pr->lock);
+        mp_sleep_us(1000);
+    }
+    return NULL;
+}
+
+static void probe_start(struct probe *pr, mpv_handle *h)
+{
+    *pr = (struct probe){ .client = mpv_create_client(h, "probe") };
+    assert_non_null(pr->client);
+    for (int n = 0; mpv_event_name(n); n++)
+        mpv_request_event(pr->client, n, 0);
+    pthread_mutex_init(&pr->lock, NULL);
+    assert_int_equal(pthread_create(&pr->thread, NULL, probe_thread, pr), 0);
+}
+
+static void probe_stop(struct probe *pr, const char *name)
+{
+    pthread_mutex_lock(&pr->lock);
+    pr->stop = true;
+    pthread_mutex_unlock(&pr->lock);
+    pthread_join(pr->thread, NULL);
+    pthread_mutex_destroy(&pr->lock);
+    mpv_detach_destroy(pr->client);
+    printf("%s: playloop stall max %.1f ms, mean %.2f ms (%d probes)\n",
+           name, pr->max_us / 1e3, pr->total_us / 1e3 / MPMAX(pr->count, 1),
+           pr->count);
+}
+
+// Prints how long the playloop is blocked while 4K captures are running, with
+// the screenshot_raw command and with the asynchronous API.
+static void test_stall(void **state)
+{
+    mpv_handle *h = *state;
+    mp_time_init();
+    struct probe pr;
+
+    probe_start(&pr, h);
+    mp_sleep_us(200 * 1000);
+    probe_stop(&pr, "idle");
+
+    probe_start(&pr, h);
+    mpv_node items[2] = {
+        {.format = MPV_FORMAT_STRING, .u.string = "screenshot_raw"},
+        {.format = MPV_FORMAT_STRING, .u.string = "video"},
+    };
+    mpv_node_list list = {.num = 2, .values = items};
+    mpv_node args = {.format = MPV_FORMAT_NODE_ARRAY, .u.list = &list};
+    for (int n = 0; n < CAPTURES; n++) {
+        mpv_node res;
+        assert_int_equal(mpv_command_node(h, &args, &res), 0);
+        mpv_free_node_contents(&res);
+    }
+    probe_stop(&pr, "screenshot_raw");
+
+    for (int size = 0; size <= 512; size += 512) {
+        probe_start(&pr, h);
+        for (int n = 0; n < CAPTURES; n++)
+            assert_int_equal(mpv_screenshot_raw_async(h, n, "video", size, 0), 0);
+        for (int n = 0; n < CAPTURES; n++) {
+            mpv_event *ev = wait_for(h, MPV_EVENT_SCREENSHOT_RAW_REPLY);
+            assert_int_equal(ev->error, 0);
+        }
+        probe_stop(&pr, size ? "async 512px" : "async");
+    }
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sizes, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_ref, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_stall, setup, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
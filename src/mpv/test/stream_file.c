@@ -0,0 +1,259 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "common/global.h"
+#include "demux/demux.h"
+#include "demux/packet.h"
+#include "options/m_config.h"
+#include "options/options.h"
+#include "osdep/timer.h"
+#include "stream/stream.h"
+
+#define TEST_FILE_SIZE (3 * 1024 * 1024 + 123)
+
+struct fixture {
+    struct mpv_global *global;
+    char *path;
+};
+
+static unsigned char pattern(int64_t pos)
+{
+    return (pos * 7 + (pos >> 11)) & 0xFF;
+}
+
+// Files modified just now are not mapped, so pretend the file is old.
+static void make_old(const char *path)
+{
+    struct timeval tv[2];
+    gettimeofday(&tv[0], NULL);
+    tv[0].tv_sec -= 60;
+    tv[1] = tv[0];
+    assert_int_equal(utimes(path, tv), 0);
+}
+
+static void write_file(struct fixture *f)
+{
+    FILE *fp = fopen(f->path, "wb");
+    assert_non_null(fp);
+    for (int64_t n = 0; n < TEST_FILE_SIZE; n++)
+        fputc(pattern(n), fp);
+    fclose(fp);
+    make_old(f->path);
+}
+
+static int setup(void **state)
+{
+    struct fixture *f = talloc_zero(NULL, struct fixture);
+    f->global = talloc_zero(f, struct mpv_global);
+    f->global->log = mp_null_log;
+    struct m_config *cfg = m_config_new(f, mp_null_log, sizeof(struct MPOpts),
+                                        &mp_default_opts, mp_opts);
+    f->global->opts = cfg->optstruct;
+
+    f->path = talloc_strdup(f, "/tmp/mpv-test-stream-file-XXXXXX");
+    int fd = mkstemp(f->path);
+    assert_true(fd >= 0);
+    close(fd);
+    write_file(f);
+
+    *state = f;
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    struct fixture *f = *state;
+    unlink(f->path);
+    talloc_free(f);
+    return 0;
+}
+
+static struct stream *open_file(struct fixture *f, const char *path, int mmap)
+{
+    f->global->opts->stream_file_mmap = mmap;
+    struct stream *s = stream_open(path, f->global);
+    assert_non_null(s);
+    return s;
+}
+
+static void check_range(struct stream *s, int64_t pos, int len)
+{
+    char buf[8192];
+    assert_true(len <= sizeof(buf));
+    assert_true(stream_seek(s, pos));
+    int got = stream_read(s, buf, len);
+    assert_int_equal(got, MPMIN(len, TEST_FILE_SIZE - pos));
+    for (int n = 0; n < got; n++)
+        assert_int_equal((unsigned char)buf[n], pattern(pos + n));
+}
+
+static void run_consistency(struct fixture *f, int mmap)
+{
+    struct stream *s = open_file(f, f->path, mmap);
+    assert_int_equal(!!s->peek_direct, mmap);
+
+    bstr peek = stream_peek(s, STREAM_MAX_BUFFER_SIZE);
+    assert_int_equal(peek.len, STREAM_MAX_BUFFER_SIZE);
+    for (int n = 0; n < peek.len; n += 4093)
+        assert_int_equal(peek.start[n], pattern(n));
+    assert_int_equal(stream_tell(s), 0);
+
+    check_range(s, 0, 100);
+    check_range(s, 100, 8192);
+    check_range(s, 2 * 1024 * 1024 - 5, 4000);
+    check_range(s, 17, 1);
+    check_range(s, TEST_FILE_SIZE - 100, 8192);
+    assert_true(stream_seek(s, 12345));
+    assert_int_equal(stream_read_char(s), pattern(12345));
+    assert_true(stream_skip(s, 100000));
+    assert_int_equal(stream_read_char(s), pattern(12346 + 100000));
+
+    free_stream(s);
+}
+
+// Must run before the tests which set the option.
+static void test_mmap_off_by_default(void **state)
+{
+    struct fixture *f = *state;
+    struct stream *s = stream_open(f->path, f->global);
+    assert_non_null(s);
+    assert_null(s->peek_direct);
+    free_stream(s);
+}
+
+static void test_read_consistency_mmap(void **state)
+{
+    run_consistency(*state, 1);
+}
+
+static void test_read_consistency_read(void **state)
+{
+    run_consistency(*state, 0);
+}
+
+static void test_peek_zero_copy(void **state)
+{
+    struct fixture *f = *state;
+    struct stream *s = open_file(f, f->path, 1);
+    assert_true(stream_seek(s, 1000));
+    bstr peek = stream_peek(s, 1024 * 1024);
+    assert_int_equal(peek.len, 1024 * 1024);
+    // Must point into the mapping, not the stream's own buffer.
+    assert_false(peek.start >= s->buffer &&
+                 peek.start < s->buffer + STREAM_MAX_BUFFER_SIZE);
+    assert_int_equal(peek.start[0], pattern(1000));
+    assert_int_equal(stream_tell(s), 1000);
+    free_stream(s);
+}
+
+static void test_growing_file(void **state)
+{
+    struct fixture *f = *state;
+    struct stream *s = open_file(f, f->path, 1);
+    FILE *fp = fopen(f->path, "ab");
+    assert_non_null(fp);
+    for (int64_t n = TEST_FILE_SIZE; n < TEST_FILE_SIZE + 5000; n++)
+        fputc(pattern(n), fp);
+    fclose(fp);
+    char buf[6000];
+    assert_true(stream_seek(s, TEST_FILE_SIZE - 1000));
+    assert_int_equal(stream_read(s, buf, sizeof(buf)), 6000);
+    for (int n = 0; n < 6000; n++)
+        assert_int_equal((unsigned char)buf[n], pattern(TEST_FILE_SIZE - 1000 + n));
+    free_stream(s);
+    assert_int_equal(truncate(f->path, TEST_FILE_SIZE), 0);
+    make_old(f->path);
+}
+
+// A file truncated while mapped must not be read through the mapping any
+// more, since touching pages past its end would raise SIGBUS.
+static void test_truncated_file(void **state)
+{
+    struct fixture *f = *state;
+    struct stream *s = open_file(f, f->path, 1);
+    assert_non_null(s->peek_direct);
+    check_range(s, 0, 100);
+    assert_int_equal(truncate(f->path, 1024 * 1024), 0);
+    char buf[4096];
+    assert_true(stream_seek(s, 1024 * 1024 - 100));
+    assert_int_equal(stream_read(s, buf, sizeof(buf)), 100);
+    for (int n = 0; n < 100; n++)
+        assert_int_equal((unsigned char)buf[n], pattern(1024 * 1024 - 100 + n));
+    assert_true(stream_seek(s, 2 * 1024 * 1024));
+    assert_int_equal(stream_read(s, buf, sizeof(buf)), 0);
+    free_stream(s);
+    write_file(f);
+}
+
+static void test_recent_file(void **state)
+{
+    struct fixture *f = *state;
+    assert_int_equal(utimes(f->path, NULL), 0);
+    struct stream *s = open_file(f, f->path, 1);
+    assert_null(s->peek_direct);
+    check_range(s, 12345, 4000);
+    free_stream(s);
+    make_old(f->path);
+}
+
+static void test_pipe_fallback(void **state)
+{
+    struct fixture *f = *state;
+    char *fifo = talloc_asprintf(f, "%s.fifo", f->path);
+    assert_int_equal(mkfifo(fifo, 0600), 0);
+    struct stream *s = open_file(f, fifo, 1);
+    assert_null(s->peek_direct);
+    free_stream(s);
+    unlink(fifo);
+}
+
+// Not a pass/fail test: set MPV_TEST_MKV to a local Matroska file to compare
+// demux_mkv throughput with and without the memory mapped read path.
+static void test_demux_mkv_throughput(void **state)
+{
+    struct fixture *f = *state;
+    const char *file = getenv("MPV_TEST_MKV");
+    if (!file)
+        skip();
+    mp_time_init();
+    for (int mmap = 0; mmap < 2; mmap++) {
+        struct stream *s = open_file(f, file, mmap);
+        int64_t start = mp_time_us();
+        struct demuxer_params params = { .force_format = "mkv" };
+        struct demuxer *demuxer = demux_open(s, &params, f->global);
+        assert_non_null(demuxer);
+        for (int n = 0; n < demuxer->num_streams; n++)
+            demuxer_select_track(demuxer, demuxer->streams[n], true);
+        int64_t bytes = 0, packets = 0;
+        struct demux_packet *pkt;
+        while ((pkt = demux_read_any_packet(demuxer))) {
+            bytes += pkt->len;
+            packets++;
+            talloc_free(pkt);
+        }
+        double secs = (mp_time_us() - start) / 1e6;
+        printf("%s: %"PRId64" packets, %.1f MiB in %.3f s (%.1f MiB/s)\n",
+               mmap ? "mmap" : "read", packets, bytes / 1048576.0, secs,
+               bytes / 1048576.0 / MPMAX(secs, 1e-9));
+        free_demuxer_and_stream(demuxer);
+    }
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_mmap_off_by_default),
+        cmocka_unit_test(test_read_consistency_mmap),
+        cmocka_unit_test(test_read_consistency_read),
+        cmocka_unit_test(test_peek_zero_copy),
+        cmocka_unit_test(test_growing_file),
+        cmocka_unit_test(test_truncated_file),
+        cmocka_unit_test(test_recent_file),
+        cmocka_unit_test(test_pipe_fallback),
+        cmocka_unit_test(test_demux_mkv_throughput),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
@@ -0,0 +1,183 @@
+#include <pthread.h>
+#include <string.h>
+
+#include <libswscale/swscale.h>
+
+#include "test_helpers.h"
+#include "common/common.h"
+#include "osdep/timer.h"
+#include "video/mp_image.h"
+#include "video/sws_utils.h"
+
+#define SRC_W 1920
+#define SRC_H 1080
+#define ITERATIONS 60
+#define THREADS 4
+
+// thumbnail sizes, as when a screenshot and a preview run at the same time
+static const int sizes[][2] = {{320, 180}, {640, 360}, {1280, 720}};
+
+static struct mp_image *make_src(void *ta_ctx)
+{
+    struct mp_image *img = talloc_steal(ta_ctx, mp_image_alloc(IMGFMT_420P,
+                                                               SRC_W, SRC_H));
+    assert_non_null(img);
+    for (int p = 0; p < img->num_planes; p++) {
+        for (int y = 0; y < mp_image_plane_h(img, p); y++) {
+            uint8_t *row = img->planes[p] + y * img->stride[p];
+            for (int x = 0; x < mp_image_plane_w(img, p); x++)
+                row[x] = (x * 3 + y * 5 + p * 64) & 0xFF;
+        }
+    }
+    mp_image_params_guess_csp(&img->params);
+    return img;
+}
+
+static struct mp_image *make_dst(void *ta_ctx, int n)
+{
+    const int *s = sizes[n % MP_ARRAY_SIZE(sizes)];
+    return talloc_steal(ta_ctx, mp_image_alloc(IMGFMT_BGR0, s[0], s[1]));
+}
+
+static bool images_equal(struct mp_image *a, struct mp_image *b)
+{
+    for (int y = 0; y < a->h; y++) {
+        if (memcmp(a->planes[0] + y * a->stride[0],
+                   b->planes[0] + y * b->stride[0], a->w * 4) != 0)
+            return false;
+    }
+    return true;
+}
+
+// The uncached path, as mp_image_swscale() was before the cache.
+static int scale_uncached(struct mp_image *dst, struct mp_image *src)
+{
+    struct mp_sws_context *ctx = mp_sws_alloc(NULL);
+    ctx->flags = mp_sws_hq_flags;
+    int r = mp_sws_scale(ctx, dst, src);
+    talloc_free(ctx);
+    return r;
+}
+
+static void test_hits(void **state)
+{
+    void *ctx = talloc_new(NULL);
+    struct mp_image *src = make_src(ctx);
+    mp_sws_cache_clear();
+    for (int n = 0; n < ITERATIONS; n++) {
+        struct mp_image *dst = make_dst(ctx, n);
+        assert_int_equal(mp_image_swscale(dst, src, mp_sws_hq_flags), 0);
+        struct mp_image *ref = make_dst(ctx, n);
+        assert_int_equal(scale_uncached(ref, src), 0);
+        assert_true(images_equal(dst, ref));
+        talloc_free(dst);
+        talloc_free(ref);
+    }
+    struct mp_sws_cache_stats st;
+    mp_sws_cache_get_stats(&st);
+    assert_int_equal(st.misses, MP_ARRAY_SIZE(sizes));
+    assert_int_equal(st.hits, ITERATIONS - MP_ARRAY_SIZE(sizes));
+    assert_int_equal(st.entries, MP_ARRAY_SIZE(sizes));
+
+    // other flags are other contexts
+    struct mp_image *dst = make_dst(ctx, 0);
+    assert_int_equal(mp_image_swscale(dst, src, mp_sws_fast_flags), 0);
+    mp_sws_cache_get_stats(&st);
+    assert_int_equal(st.misses, MP_ARRAY_SIZE(sizes) + 1);
+
+    mp_sws_cache_clear();
+    talloc_free(ctx);
+}
+
+// Many distinct conversions must not grow the cache without bound.
+static void test_bounded(void **state)
+{
+    void *ctx = talloc_new(NULL);
+    struct mp_image *src = make_src(ctx);
+    mp_sws_cache_clear();
+    for (int n = 0; n < 40; n++) {
+        struct mp_image *dst = talloc_steal(ctx,
+                mp_image_alloc(IMGFMT_BGR0, 16 + n * 2, 16));
+        assert_int_equal(mp_image_swscale(dst, src, SWS_POINT), 0);
+    }
+    struct mp_sws_cache_stats st;
+    mp_sws_cache_get_stats(&st);
+    assert_int_equal(st.misses, 40);
+    assert_true(st.entries < 40);
+    assert_int_equal(st.evictions, 40 - st.entries);
+    mp_sws_cache_clear();
+    talloc_free(ctx);
+}
+
+static void *convert_thread(void *p)
+{
+    struct mp_image *src = p;
+    void *ctx = talloc_new(NULL);
+    for (int n = 0; n < ITERATIONS; n++) {
+        struct mp_image *dst = make_dst(ctx, n);
+        if (mp_image_swscale(dst, src, mp_sws_hq_flags) < 0)
+            abort();
+        talloc_free(dst);
+    }
+    talloc_free(ctx);
+    return NULL;
+}
+
+static void test_threads(void **state)
+{
+    void *ctx = talloc_new(NULL);
+    struct mp_image *src = make_src(ctx);
+    mp_sws_cache_clear();
+    pthread_t threads[THREADS];
+    for (int n = 0; n < THREADS; n++)
+        assert_int_equal(pthread_create(&threads[n], NULL, convert_thread, src), 0);
+    for (int n = 0; n < THREADS; n++)
+        pthread_join(threads[n], NULL);
+    struct mp_sws_cache_stats st;
+    mp_sws_cache_get_stats(&st);
+    assert_int_equal(st.hits + st.misses, THREADS * ITERATIONS);
+    // at most one context per size and thread
+    assert_true(st.misses <= THREADS * MP_ARRAY_SIZE(sizes));
+    mp_sws_cache_clear();
+    talloc_free(ctx);
+}
+
+// Prints the cost of alternating between sizes with and without the cache.
+static void test_benchmark(void **state)
+{
+    void *ctx = talloc_new(NULL);
+    struct mp_image *src = make_src(ctx);
+    struct mp_image *dst[MP_ARRAY_SIZE(sizes)];
+    for (int n = 0; n < MP_ARRAY_SIZE(sizes); n++)
+        dst[n] = make_dst(ctx, n);
+    mp_time_init();
+    mp_sws_cache_clear();
+
+    int64_t start = mp_time_us();
+    for (int n = 0; n < ITERATIONS; n++)
+        scale_uncached(dst[n % MP_ARRAY_SIZE(sizes)], src);
+    double uncached = (mp_time_us() - start) / 1e3 / ITERATIONS;
+
+    start = mp_time_us();
+    for (int n = 0; n < ITERATIONS; n++)
+        mp_image_swscale(dst[n % MP_ARRAY_SIZE(sizes)], src, mp_sws_hq_flags);
+    double cached = (mp_time_us() - start) / 1e3 / ITERATIONS;
+
+    struct mp_sws_cache_stats st;
+    mp_sws_cache_get_stats(&st);
+    printf("1080p to 3 alternating sizes: %.2f ms uncached, %.2f ms cached "
+           "(%d hits, %d misses)\n", uncached, cached, (int)st.hits,
+           (int)st.misses);
+    mp_sws_cache_clear();
+    talloc_free(ctx);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_hits),
+        cmocka_unit_test(test_bounded),
+        cmocka_unit_test(test_threads),
+        cmocka_unit_test(test_benchmark),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -20,6 +20,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <assert.h>
 
@@ -209,6 +210,35 @@ bool video_init_best_codec(struct dec_video *d_video, char* video_decoders)
     return !!d_video->vd_driver;
 }
 
+static void add_decode_time(struct dec_video *d_video, double secs)
+{
+    d_video->decode_times[d_video->decode_time_pos] = secs;
+    d_video->decode_time_pos =
+        (d_video->decode_time_pos + 1) % VIDEO_DECODE_TIME_SAMPLES;
+    d_video->num_decode_times =
+        MPMIN(d_video->num_decode_times + 1, VIDEO_DECODE_TIME_SAMPLES);
+}
+
+static int compare_double(const void *pa, const void *pb)
+{
+    double a = *(const double *)pa, b = *(const double *)pb;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+// Return the p-th percentile (0-100) of the recent decode call times, or -1
+// if nothing was decoded yet.
+double video_decode_time_percentile(struct dec_video *d_video, double p)
+{
+    int num = d_video->num_decode_times;
+    if (!num)
+        return -1;
+    double times[VIDEO_DECODE_TIME_SAMPLES];
+    memcpy(times, d_video->decode_times, num * sizeof(times[0]));
+    qsort(times, num, sizeof(times[0]), compare_double);
+    int n = MPCLAMP((int)(p / 100.0 * num + 0.5) - 1, 0, num - 1);
+    return times[n];
+}
+
 static void add_pts_to_sort(struct dec_video *d_video, double pts)
 {
     if (pts != MP_NOPTS_VALUE) {
@@ -316,7 +346,10 @@ struct mp_image *video_decode(struct dec_video *d_video,
 
     MP_STATS(d_video, "start decode video");
 
+    int64_t decode_start = mp_time_us();
     struct mp_image *mpi = d_video->vd_driver->decode(d_video, packet, drop_frame);
+    if (packet && !drop_frame)
+        add_decode_time(d_video, (mp_time_us() - decode_start) / 1e6);
 
     MP_STATS(d_video, "end decode video");
 
@@ -27,6 +27,8 @@
 struct mp_decoder_list;
 struct vo;
 
+#define VIDEO_DECODE_TIME_SAMPLES 256
+
 struct dec_video {
     struct mp_log *log;
     struct mpv_global *global;
@@ -74,6 +76,10 @@ struct dec_video {
     float fps;            // FPS from demuxer or from user override
     float initial_decoder_aspect;
 
+    // Wall clock time of the last decode calls, in seconds (ring buffer)
+    double decode_times[VIDEO_DECODE_TIME_SAMPLES];
+    int num_decode_times, decode_time_pos;
+
     // State used only by player/video.c
     double last_pts;
 };
@@ -92,6 +98,7 @@ int video_get_colors(struct dec_video *d_video, const char *item, int *value);
 int video_set_colors(struct dec_video *d_video, const char *item, int value);
 void video_reset_decoding(struct dec_video *d_video);
 int video_vd_control(struct dec_video *d_video, int cmd, void *arg);
+double video_decode_time_percentile(struct dec_video *d_video, double p);
 
 int video_reconfig_filters(struct dec_video *d_video,
                            const struct mp_image_params *params);
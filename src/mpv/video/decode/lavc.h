@@ -21,6 +21,13 @@ typedef struct lavc_ctx {
     const char *software_fallback_decoder;
     bool hwdec_failed;
 
+    // Software decoding thread tuning
+    const char *decoder;        // decoder used for the current avctx
+    int extra_threads;          // added because decoding was too slow
+    double load_time;           // sum of decode call times in this window
+    int load_frames;            // number of decode calls in this window
+    bool retune_threads;        // reinit with more threads on next reset
+
     // From VO
     struct mp_hwdec_info *hwdec_info;
 
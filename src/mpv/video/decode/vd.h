@@ -45,6 +45,12 @@ enum vd_ctrl {
     VDCTRL_QUERY_UNSEEN_FRAMES, // current decoder lag
     VDCTRL_FORCE_HWDEC_FALLBACK, // force software decoding fallback
     VDCTRL_GET_HWDEC,
+    VDCTRL_GET_THREADS, // struct vd_threads*
+};
+
+struct vd_threads {
+    int count;
+    const char *type;   // "frame", "slice" or "none"
 };
 
 #endif /* MPLAYER_VD_H */
@@ -26,6 +26,7 @@
 #include <libavutil/opt.h>
 #include <libavutil/intreadwrite.h>
 #include <libavutil/pixdesc.h>
+#include <libavutil/cpu.h>
 
 #include "talloc.h"
 #include "config.h"
@@ -34,6 +35,7 @@
 #include "misc/bstr.h"
 #include "common/av_common.h"
 #include "common/codecs.h"
+#include "osdep/timer.h"
 
 #include "video/fmt-conversion.h"
 
@@ -72,6 +74,7 @@ struct vd_lavc_params {
     int skip_frame;
     int framedrop;
     int threads;
+    int thread_type;
     int bitexact;
     int check_hw_profile;
     char **avopts;
@@ -99,6 +102,10 @@ const struct m_sub_options vd_lavc_conf = {
         OPT_DISCARD("skipframe", skip_frame, 0),
         OPT_DISCARD("framedrop", framedrop, 0),
         OPT_INTRANGE("threads", threads, 0, 0, 16),
+        OPT_CHOICE("thread-type", thread_type, 0,
+                   ({"auto", 0},
+                    {"frame", FF_THREAD_FRAME},
+                    {"slice", FF_THREAD_SLICE})),
         OPT_FLAG("bitexact", bitexact, 0),
         OPT_FLAG("check-hw-profile", check_hw_profile, 0),
         OPT_KEYVALUELIST("o", avopts, 0),
@@ -266,6 +273,97 @@ static void uninit(struct dec_video *vd)
     talloc_free(vd->priv);
 }
 
+#define MAX_THREADS 16
+// Number of decode calls averaged before deciding whether decoding keeps up.
+#define LOAD_WINDOW 64
+
+// Pick threading mode and thread count for software decoding. Frame threading
+// adds thread_count - 1 frames of decoding delay, so small pictures, which
+// decode quickly anyway, are limited to fewer threads.
+static void set_threads(struct dec_video *vd, AVCodecContext *avctx,
+                        AVCodec *codec)
+{
+    vd_ffmpeg_ctx *ctx = vd->priv;
+    struct vd_lavc_params *lavc_param = vd->opts->vd_lavc_params;
+
+    int type = lavc_param->thread_type;
+    if (!type) {
+        type = FF_THREAD_SLICE;
+        if (codec->capabilities & CODEC_CAP_FRAME_THREADS)
+            type |= FF_THREAD_FRAME; // preferred by libavcodec if both are set
+    }
+    avctx->thread_type = type;
+
+    if (lavc_param->threads) {
+        mp_set_avcodec_threads(vd->log, avctx, lavc_param->threads);
+        return;
+    }
+
+    int cores = av_cpu_count();
+    if (cores < 1) {
+        MP_WARN(vd, "Could not determine thread count to use, defaulting to 1.\n");
+        cores = 1;
+    }
+    int pixels = vd->header->video->disp_w * vd->header->video->disp_h;
+    int limit = MAX_THREADS;
+    if (pixels > 0 && pixels <= 1024 * 576) {
+        limit = 4;
+    } else if (pixels > 0 && pixels <= 2048 * 1152) {
+        limit = 8;
+    }
+    // These are much more expensive to decode at the same resolution.
+    if (codec->id == AV_CODEC_ID_HEVC || codec->id == AV_CODEC_ID_VP9)
+        limit *= 2;
+    // One extra thread for better load balancing.
+    int threads = cores > 1 ? cores + 1 : 1;
+    threads = MPMIN(threads, limit) + ctx->extra_threads;
+    threads = MPMIN(threads, MAX_THREADS);
+    MP_VERBOSE(vd, "Detected %d logical cores, requesting %d threads for "
+               "decoding.\n", cores, threads);
+    avctx->thread_count = threads;
+}
+
+// Called after each decode call during normal playback. If decoding takes
+// longer than the frame duration on average, the decoder is reopened with
+// more threads on the next reset (seek), where no decoded frames get lost.
+// Reopening it anywhere else would drop the frames still queued in the frame
+// threads, so a file played without seeking keeps its initial thread count.
+static void update_load(struct dec_video *vd, double secs)
+{
+    vd_ffmpeg_ctx *ctx = vd->priv;
+    struct vd_lavc_params *lavc_param = vd->opts->vd_lavc_params;
+
+    ctx->load_time += secs;
+    if (++ctx->load_frames < LOAD_WINDOW)
+        return;
+    double avg = ctx->load_time / ctx->load_frames;
+    ctx->load_time = 0;
+    ctx->load_frames = 0;
+    if (ctx->hwdec || lavc_param->threads || vd->fps <= 0 ||
+        ctx->avctx->thread_count >= MAX_THREADS || ctx->retune_threads)
+        return;
+    if (avg > 1.0 / vd->fps) {
+        MP_VERBOSE(vd, "Decoding takes %.1f ms per frame (frame duration "
+                   "%.1f ms), adding threads on next seek.\n",
+                   avg * 1e3, 1e3 / vd->fps);
+        ctx->retune_threads = true;
+    }
+}
+
+static void retune_threads(struct dec_video *vd)
+{
+    vd_ffmpeg_ctx *ctx = vd->priv;
+    ctx->retune_threads = false;
+    int extra_threads = ctx->extra_threads;
+    ctx->extra_threads += MPMAX(av_cpu_count() / 2, 1);
+    uninit_avctx(vd);
+    init_avctx(vd, ctx->decoder, NULL);
+    if (!ctx->avctx) {
+        ctx->extra_threads = extra_threads;
+        init_avctx(vd, ctx->decoder, NULL);
+    }
+}
+
 static int init(struct dec_video *vd, const char *decoder)
 {
     vd_ffmpeg_ctx *ctx;
@@ -339,6 +437,11 @@ static void init_avctx(struct dec_video *vd, const char *decoder,
 
     assert(!ctx->avctx);
 
+    if (!hwdec && decoder != ctx->decoder)
+        ctx->decoder = talloc_strdup(ctx, decoder);
+    ctx->load_time = 0;
+    ctx->load_frames = 0;
+
     if (strcmp(decoder, "mp-rawvideo") == 0) {
         mp_rawvideo = true;
         decoder = "rawvideo";
@@ -374,7 +477,7 @@ static void init_avctx(struct dec_video *vd, const char *decoder,
         if (ctx->hwdec->init(ctx) < 0)
             goto error;
     } else {
-        mp_set_avcodec_threads(vd->log, avctx, lavc_param->threads);
+        set_threads(vd, avctx, lavc_codec);
     }
 
     avctx->flags |= lavc_param->bitexact ? CODEC_FLAG_BITEXACT : 0;
@@ -617,9 +720,12 @@ static int decode(struct dec_video *vd, struct demux_packet *packet,
 
     mp_set_av_packet(&pkt, packet, NULL);
 
+    int64_t start = mp_time_us();
     hwdec_lock(ctx);
     ret = avcodec_decode_video2(avctx, ctx->pic, &got_picture, &pkt);
     hwdec_unlock(ctx);
+    if (!flags && packet)
+        update_load(vd, (mp_time_us() - start) / 1e6);
 
     if (ctx->hwdec_failed || ret < 0) {
         if (ret < 0)
@@ -695,6 +801,10 @@ static int control(struct dec_video *vd, int cmd, void *arg)
     AVCodecContext *avctx = ctx->avctx;
     switch (cmd) {
     case VDCTRL_RESET:
+        if (ctx->retune_threads) {
+            retune_threads(vd);
+            return ctx->avctx ? CONTROL_TRUE : CONTROL_ERROR;
+        }
         avcodec_flush_buffers(avctx);
         return CONTROL_TRUE;
     case VDCTRL_QUERY_UNSEEN_FRAMES:;
@@ -713,6 +823,20 @@ static int control(struct dec_video *vd, int cmd, void *arg)
     }
     case VDCTRL_FORCE_HWDEC_FALLBACK:
         return force_fallback(vd);
+    case VDCTRL_GET_THREADS: {
+        // reinit after a failed retune or fallback can leave no decoder
+        if (!avctx)
+            return CONTROL_ERROR;
+        struct vd_threads *threads = arg;
+        threads->count = avctx->thread_count;
+        threads->type = "none";
+        if (avctx->active_thread_type & FF_THREAD_FRAME) {
+            threads->type = "frame";
+        } else if (avctx->active_thread_type & FF_THREAD_SLICE) {
+            threads->type = "slice";
+        }
+        return CONTROL_TRUE;
+    }
     }
     return CONTROL_UNKNOWN;
 }
@@ -26,23 +26,36 @@
 
 #include "common/common.h"
 #include "video/mp_image.h"
+#include "osdep/atomics.h"
 
 #include "mp_image_pool.h"
 
+#if !HAVE_ATOMICS
 static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
 #define pool_lock() pthread_mutex_lock(&pool_mutex)
 #define pool_unlock() pthread_mutex_unlock(&pool_mutex)
+#endif
 
 // Thread-safety: the pool itself is not thread-safe, but pool-allocated images
 // can be referenced and unreferenced from other threads. (As long as the image
-// destructors are thread-safe.)
+// destructors are thread-safe.) Unreferencing doesn't take any lock; the two
+// ownership flags of an image are updated atomically instead.
+
+// All images of one format/size.
+struct pool_bucket {
+    int fmt, w, h;
+    struct mp_image **images;
+    int num_images;
+};
 
 struct mp_image_pool {
     int max_count;
-
-    struct mp_image **images;
     int num_images;
 
+    struct pool_bucket *buckets;
+    int num_buckets;
+    int last_bucket;            // index of the most recently used bucket
+
     mp_image_allocator allocator;
     void *allocator_ctx;
 
@@ -52,13 +65,29 @@ struct mp_image_pool {
 
 // Used to gracefully handle the case when the pool is freed while image
 // references allocated from the image pool are still held by someone.
+#define IMAGE_REFERENCED 1      // outside mp_image reference exists
+#define IMAGE_POOL_ALIVE 2      // the mp_image_pool references this
+
 struct image_flags {
-    // If both of these are false, the image must be freed.
-    bool referenced;            // outside mp_image reference exists
-    bool pool_alive;            // the mp_image_pool references this
+    // If both flags are cleared, the image must be freed.
+    atomic_int state;
     unsigned int order;         // for LRU allocation (basically a timestamp)
 };
 
+// Set or clear the given flag, and return the flags as they were before.
+static int image_flags_update(struct image_flags *it, int flag, bool set)
+{
+#if !HAVE_ATOMICS
+    pool_lock();
+#endif
+    int state = set ? atomic_fetch_or(&it->state, flag)
+                    : atomic_fetch_and(&it->state, ~flag);
+#if !HAVE_ATOMICS
+    pool_unlock();
+#endif
+    return state;
+}
+
 static void image_pool_destructor(void *ptr)
 {
     struct mp_image_pool *pool = ptr;
@@ -77,18 +106,19 @@ struct mp_image_pool *mp_image_pool_new(int max_count)
 
 void mp_image_pool_clear(struct mp_image_pool *pool)
 {
-    for (int n = 0; n < pool->num_images; n++) {
-        struct mp_image *img = pool->images[n];
-        struct image_flags *it = img->priv;
-        bool referenced;
-        pool_lock();
-        assert(it->pool_alive);
-        it->pool_alive = false;
-        referenced = it->referenced;
-        pool_unlock();
-        if (!referenced)
-            talloc_free(img);
+    for (int b = 0; b < pool->num_buckets; b++) {
+        struct pool_bucket *bucket = &pool->buckets[b];
+        for (int n = 0; n < bucket->num_images; n++) {
+            struct mp_image *img = bucket->images[n];
+            int state = image_flags_update(img->priv, IMAGE_POOL_ALIVE, false);
+            assert(state & IMAGE_POOL_ALIVE);
+            if (!(state & IMAGE_REFERENCED))
+                talloc_free(img);
+        }
+        talloc_free(bucket->images);
     }
+    pool->num_buckets = 0;
+    pool->last_bucket = 0;
     pool->num_images = 0;
 }
 
@@ -97,51 +127,78 @@ void mp_image_pool_clear(struct mp_image_pool *pool)
 static void unref_image(void *ptr)
 {
     struct mp_image *img = ptr;
-    struct image_flags *it = img->priv;
-    bool alive;
-    pool_lock();
-    assert(it->referenced);
-    it->referenced = false;
-    alive = it->pool_alive;
-    pool_unlock();
-    if (!alive)
+    int state = image_flags_update(img->priv, IMAGE_REFERENCED, false);
+    assert(state & IMAGE_REFERENCED);
+    if (!(state & IMAGE_POOL_ALIVE))
         talloc_free(img);
 }
 
+static struct pool_bucket *find_bucket(struct mp_image_pool *pool, int fmt,
+                                       int w, int h)
+{
+    // Usually a pool serves a single format/size, so check the last hit first.
+    for (int i = 0; i < pool->num_buckets; i++) {
+        int b = (pool->last_bucket + i) % pool->num_buckets;
+        struct pool_bucket *bucket = &pool->buckets[b];
+        if (bucket->fmt == fmt && bucket->w == w && bucket->h == h) {
+            pool->last_bucket = b;
+            return bucket;
+        }
+    }
+    return NULL;
+}
+
 // Return a new image of given format/size. Unlike mp_image_pool_get(), this
 // returns NULL if there is no free image of this format/size.
 struct mp_image *mp_image_pool_get_no_alloc(struct mp_image_pool *pool, int fmt,
                                             int w, int h)
 {
+    struct pool_bucket *bucket = find_bucket(pool, fmt, w, h);
+    if (!bucket)
+        return NULL;
     struct mp_image *new = NULL;
-    pool_lock();
-    for (int n = 0; n < pool->num_images; n++) {
-        struct mp_image *img = pool->images[n];
+    for (int n = 0; n < bucket->num_images; n++) {
+        struct mp_image *img = bucket->images[n];
         struct image_flags *img_it = img->priv;
-        assert(img_it->pool_alive);
-        if (!img_it->referenced) {
-            if (img->imgfmt == fmt && img->w == w && img->h == h) {
-                if (pool->use_lru) {
-                    struct image_flags *new_it = new ? new->priv : NULL;
-                    if (!new_it || new_it->order > img_it->order)
-                        new = img;
-                } else {
+        // Only this thread can set IMAGE_REFERENCED, so a cleared flag stays
+        // cleared until we set it below.
+        int state = atomic_load(&img_it->state);
+        assert(state & IMAGE_POOL_ALIVE);
+        if (!(state & IMAGE_REFERENCED)) {
+            if (pool->use_lru) {
+                struct image_flags *new_it = new ? new->priv : NULL;
+                if (!new_it || new_it->order > img_it->order)
                     new = img;
-                    break;
-                }
+            } else {
+                new = img;
+                break;
             }
         }
     }
-    pool_unlock();
     if (!new)
         return NULL;
     struct image_flags *it = new->priv;
-    assert(!it->referenced && it->pool_alive);
-    it->referenced = true;
+    int state = image_flags_update(it, IMAGE_REFERENCED, true);
+    assert(state == IMAGE_POOL_ALIVE);
     it->order = ++pool->lru_counter;
     return mp_image_new_custom_ref(new, new, unref_image);
 }
 
+static void pool_add(struct mp_image_pool *pool, struct mp_image *img)
+{
+    struct pool_bucket *bucket = find_bucket(pool, img->imgfmt, img->w, img->h);
+    if (!bucket) {
+        MP_TARRAY_APPEND(pool, pool->buckets, pool->num_buckets,
+                         (struct pool_bucket) {
+                            .fmt = img->imgfmt, .w = img->w, .h = img->h,
+                         });
+        pool->last_bucket = pool->num_buckets - 1;
+        bucket = &pool->buckets[pool->last_bucket];
+    }
+    MP_TARRAY_APPEND(pool, bucket->images, bucket->num_images, img);
+    pool->num_images++;
+}
+
 // Return a new image of given format/size. The only difference to
 // mp_image_alloc() is that there is a transparent mechanism to recycle image
 // data allocations through this pool.
@@ -165,9 +222,11 @@ struct mp_image *mp_image_pool_get(struct mp_image_pool *pool, int fmt,
         if (!new)
             return NULL;
         struct image_flags *it = talloc_ptrtype(new, it);
-        *it = (struct image_flags) { .pool_alive = true };
+        *it = (struct image_flags) {
+            .state = ATOMIC_VAR_INIT(IMAGE_POOL_ALIVE),
+        };
         new->priv = it;
-        MP_TARRAY_APPEND(pool, pool->images, pool->num_images, new);
+        pool_add(pool, new);
         new = mp_image_pool_get_no_alloc(pool, fmt, w, h);
     }
     return new;
@@ -22,6 +22,8 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+#include <limits.h>
 
 #include <libavutil/common.h>
 
@@ -33,12 +35,30 @@
 
 #define IS_POWER_OF_2(x) (((x) > 0) && !(((x) - 1) & (x)))
 
+// Segment of the upper edge of the packed rectangles. The segments cover the
+// whole width of the surface from left to right.
+struct skyline_node {
+    int x, y, w;
+};
+
+// A bitmap that has a place on the surface (incremental packing only).
+struct packer_entry {
+    const void *bitmap;
+    int stride;
+    struct pos size;    // as in packer->in
+    struct pos pos;     // x < 0 if not placed yet
+    void *data;         // copy of the contents, as the memory can be reused
+    bool used;          // by the current sub_bitmaps
+    bool dirty;
+};
+
 void packer_reset(struct bitmap_packer *packer)
 {
     struct bitmap_packer old = *packer;
     *packer = (struct bitmap_packer) {
         .w_max = old.w_max,
         .h_max = old.h_max,
+        .incremental = old.incremental,
     };
     talloc_free_children(packer);
 }
@@ -52,92 +72,149 @@ void packer_get_bb(struct bitmap_packer *packer, struct pos out_bb[2])
     };
 }
 
-#define HEIGHT_SORT_BITS 4
-static int size_index(int s)
+void packer_get_rect(struct bitmap_packer *packer, int n, struct pos out_rc[2])
+{
+    struct pos p = packer->result[n];
+    out_rc[0] = p;
+    out_rc[1] = (struct pos) {
+        FFMIN(p.x + packer->in[n].x, packer->w),
+        FFMIN(p.y + packer->in[n].y, packer->h),
+    };
+}
+
+static void skyline_init(struct bitmap_packer *packer, int w)
 {
-    int n = av_log2_16bit(s);
-    return (n << HEIGHT_SORT_BITS)
-       + ((- 1 - (s << HEIGHT_SORT_BITS >> n)) & ((1 << HEIGHT_SORT_BITS) - 1));
+    packer->num_skyline = 0;
+    MP_TARRAY_APPEND(packer, packer->skyline, packer->num_skyline,
+                     (struct skyline_node){0, 0, w});
 }
 
-/* Pack the given rectangles into an area of size w * h.
- * The size of each rectangle is read from in[i].x / in[i].y.
- * The height of each rectangle must be less than 65536.
- * 'scratch' must point to work memory for num_rects+16 ints.
- * The packed position for rectangle number i is set in out[i].
- * Return 0 on success, -1 if the rectangles did not fit in w*h.
+// Return the y at which a rectangle of width w rests if its left edge is at
+// node i, or -1 if it doesn't fit horizontally.
+static int skyline_fit(struct bitmap_packer *packer, int i, int w)
+{
+    struct skyline_node *nodes = packer->skyline;
+    struct skyline_node *last = &nodes[packer->num_skyline - 1];
+    if (nodes[i].x + w > last->x + last->w)
+        return -1;
+    int y = 0;
+    for (int left = w; left > 0; i++) {
+        y = FFMAX(y, nodes[i].y);
+        left -= nodes[i].w;
+    }
+    return y;
+}
+
+/* Place a rectangle of the given size on the skyline such that its bottom edge
+ * is as high up as possible, preferring the narrowest gap on ties. Return
+ * false if there is no place where its bottom edge is within h.
  *
- * The rectangles are placed in rows in order approximately sorted by
- * height (the approximate sorting is simpler than a full one would be,
- * and allows the algorithm to work in linear time). Additionally, to
- * reduce wasted space when there are a few tall rectangles, empty
- * lower-right parts of rows are filled recursively when the size of
- * rectangles in the row drops past a power-of-two threshold. So if a
- * row starts with rectangles of size 3x50, 10x40 and 5x20 then the
- * free rectangle with corners (13, 20)-(w, 50) is filled recursively.
+ * Unlike packing in rows, rectangles fill up the space left next to taller
+ * ones, and new rectangles can be added to an existing packing at any time.
+ * Space below the skyline which isn't covered by rectangles is lost.
  */
-static int pack_rectangles(struct pos *in, struct pos *out, int num_rects,
-                           int w, int h, int *scratch, int *used_width)
-{
-    int bins[16 << HEIGHT_SORT_BITS];
-    int sizes[16 << HEIGHT_SORT_BITS] = { 0 };
-    for (int i = 0; i < num_rects; i++)
-        sizes[size_index(in[i].y)]++;
-    int idx = 0;
-    for (int i = 0; i < 16 << HEIGHT_SORT_BITS; i += 1 << HEIGHT_SORT_BITS) {
-        for (int j = 0; j < 1 << HEIGHT_SORT_BITS; j++) {
-            bins[i + j] = idx;
-            idx += sizes[i + j];
+static bool skyline_alloc(struct bitmap_packer *packer, struct pos size, int h,
+                          struct pos *out)
+{
+    struct skyline_node *nodes = packer->skyline;
+    int best = -1, best_y = 0, best_bottom = INT_MAX, best_w = INT_MAX;
+    for (int i = 0; i < packer->num_skyline; i++) {
+        int y = skyline_fit(packer, i, size.x);
+        if (y < 0)
+            break;
+        int bottom = y + size.y;
+        if (bottom <= h && (bottom < best_bottom ||
+                            (bottom == best_bottom && nodes[i].w < best_w)))
+        {
+            best = i;
+            best_y = y;
+            best_bottom = bottom;
+            best_w = nodes[i].w;
+        }
+    }
+    if (best < 0)
+        return false;
+    *out = (struct pos){nodes[best].x, best_y};
+
+    MP_TARRAY_INSERT_AT(packer, packer->skyline, packer->num_skyline, best,
+                        (struct skyline_node){out->x, best_bottom, size.x});
+    nodes = packer->skyline;
+    // Cut away what the new node covers.
+    int right = out->x + size.x;
+    int i = best + 1;
+    while (i < packer->num_skyline && nodes[i].x < right) {
+        int cut = right - nodes[i].x;
+        if (cut < nodes[i].w) {
+            nodes[i].x += cut;
+            nodes[i].w -= cut;
+            break;
         }
-        scratch[idx++] = -1;
-    }
-    for (int i = 0; i < num_rects; i++)
-        scratch[bins[size_index(in[i].y)]++] = i;
-    for (int i = 0; i < 16; i++)
-        bins[i] = bins[i << HEIGHT_SORT_BITS] - sizes[i << HEIGHT_SORT_BITS];
-    struct {
-        int size, x, bottom;
-    } stack[16] = {{15, 0, h}}, s = {};
-    int stackpos = 1;
-    int y;
-    while (stackpos) {
-        y = s.bottom;
-        s = stack[--stackpos];
-        s.size++;
-        while (s.size--) {
-            int maxy = -1;
-            int obj;
-            while ((obj = scratch[bins[s.size]]) >= 0) {
-                int bottom = y + in[obj].y;
-                if (bottom > s.bottom)
-                    break;
-                int right = s.x + in[obj].x;
-                if (right > w)
-                    break;
-                bins[s.size]++;
-                out[obj] = (struct pos){s.x, y};
-                num_rects--;
-                if (maxy < 0)
-                    stack[stackpos++] = s;
-                s.x = right;
-                maxy = FFMAX(maxy, bottom);
-            }
-            *used_width = FFMAX(*used_width, s.x);
-            if (maxy > 0)
-                s.bottom = maxy;
+        MP_TARRAY_REMOVE_AT(nodes, packer->num_skyline, i);
+    }
+    for (i = 1; i < packer->num_skyline;) {
+        if (nodes[i - 1].y == nodes[i].y) {
+            nodes[i - 1].w += nodes[i].w;
+            MP_TARRAY_REMOVE_AT(nodes, packer->num_skyline, i);
+        } else {
+            i++;
         }
     }
-    return num_rects ? -1 : y;
+    return true;
 }
 
-int packer_pack(struct bitmap_packer *packer)
+static void skyline_update_used(struct bitmap_packer *packer)
+{
+    int used_width = 0, used_height = 0;
+    for (int i = 0; i < packer->num_skyline; i++) {
+        struct skyline_node *node = &packer->skyline[i];
+        if (node->y > 0) {
+            used_width = FFMAX(used_width, node->x + node->w);
+            used_height = FFMAX(used_height, node->y);
+        }
+    }
+    // No padding at edges
+    packer->used_width = FFMIN(used_width, packer->w);
+    packer->used_height = FFMIN(used_height, packer->h);
+}
+
+// Sorting by decreasing height (then width) gives a much flatter skyline than
+// packing in the given order. The index goes into the lower bits.
+static uint64_t size_key(struct pos size, int index)
+{
+    return (uint64_t)(65535 - size.y) << 48 | (uint64_t)(65535 - size.x) << 32
+           | (uint32_t)index;
+}
+
+static int cmp_key(const void *a, const void *b)
+{
+    uint64_t ka = *(const uint64_t *)a, kb = *(const uint64_t *)b;
+    return ka < kb ? -1 : ka > kb;
+}
+
+// Pack the rectangles in the order given by packer->scratch into an empty
+// surface of the current size.
+static bool pack_sorted(struct bitmap_packer *packer, struct pos *in,
+                        struct pos *out, int num)
+{
+    skyline_init(packer, packer->w + packer->padding);
+    for (int i = 0; i < num; i++) {
+        int n = (uint32_t)packer->scratch[i];
+        out[n] = (struct pos){0, 0};
+        if (in[n].x && !skyline_alloc(packer, in[n],
+                                      packer->h + packer->padding, &out[n]))
+            return false;
+    }
+    return true;
+}
+
+// Pack the given rectangles from scratch, increasing w and h as necessary.
+// Return value as with packer_pack().
+static int pack_all(struct bitmap_packer *packer, struct pos *in,
+                    struct pos *out, int num)
 {
-    if (packer->count == 0)
-        return 0;
     int w_orig = packer->w, h_orig = packer->h;
-    struct pos *in = packer->in;
     int xmax = 0, ymax = 0;
-    for (int i = 0; i < packer->count; i++) {
+    for (int i = 0; i < num; i++) {
         if (in[i].x <= packer->padding || in[i].y <= packer->padding)
             in[i] = (struct pos){0, 0};
         if (in[i].x < 0 || in [i].x > 65535 || in[i].y < 0 || in[i].y > 65535) {
@@ -146,7 +223,9 @@ int packer_pack(struct bitmap_packer *packer)
         }
         xmax = FFMAX(xmax, in[i].x);
         ymax = FFMAX(ymax, in[i].y);
+        packer->scratch[i] = size_key(in[i], i);
     }
+    qsort(packer->scratch, num, sizeof(packer->scratch[0]), cmp_key);
     xmax = FFMAX(0, xmax - packer->padding);
     ymax = FFMAX(0, ymax - packer->padding);
     if (xmax > packer->w)
@@ -154,15 +233,8 @@ int packer_pack(struct bitmap_packer *packer)
     if (ymax > packer->h)
         packer->h = 1 << (av_log2(ymax - 1) + 1);
     while (1) {
-        int used_width = 0;
-        int y = pack_rectangles(in, packer->result, packer->count,
-                                packer->w + packer->padding,
-                                packer->h + packer->padding,
-                                packer->scratch, &used_width);
-        if (y >= 0) {
-            // No padding at edges
-            packer->used_width = FFMIN(used_width, packer->w);
-            packer->used_height = FFMIN(y, packer->h);
+        if (pack_sorted(packer, in, out, num)) {
+            skyline_update_used(packer);
             assert(packer->w == 0 || IS_POWER_OF_2(packer->w));
             assert(packer->h == 0 || IS_POWER_OF_2(packer->h));
             return packer->w != w_orig || packer->h != h_orig;
@@ -174,11 +246,235 @@ int packer_pack(struct bitmap_packer *packer)
         else {
             packer->w = w_orig;
             packer->h = h_orig;
+            packer->num_skyline = 0;
             return -1;
         }
     }
 }
 
+static void drop_entries(struct bitmap_packer *packer)
+{
+    for (int i = 0; i < packer->num_entries; i++)
+        talloc_free(packer->entries[i].data);
+    packer->num_entries = 0;
+    if (packer->hash)
+        memset(packer->hash, 0, packer->hash_size * sizeof(packer->hash[0]));
+}
+
+int packer_pack(struct bitmap_packer *packer)
+{
+    drop_entries(packer);
+    packer->repacked = true;
+    packer->num_dirty = 0;
+    if (packer->count == 0)
+        return 0;
+    int r = pack_all(packer, packer->in, packer->result, packer->count);
+    if (r >= 0) {
+        for (int n = 0; n < packer->count; n++)
+            packer->dirty[packer->num_dirty++] = n;
+    }
+    return r;
+}
+
+static unsigned int entry_hash(const void *bitmap, int stride, struct pos size)
+{
+    uint64_t h = (uintptr_t)bitmap;
+    h ^= (h >> 29) ^ ((uint64_t)stride << 32) ^ size.x ^ ((uint64_t)size.y << 16);
+    return (h * 0x9E3779B97F4A7C15ULL) >> 32;
+}
+
+// Return the hash table slot which refers to the entry for the bitmap, or the
+// empty slot where it would be inserted. Slots contain entry index + 1.
+static int *find_slot(struct bitmap_packer *packer, const void *bitmap,
+                      int stride, struct pos size)
+{
+    unsigned int mask = packer->hash_size - 1;
+    unsigned int i = entry_hash(bitmap, stride, size) & mask;
+    for (;; i = (i + 1) & mask) {
+        int *slot = &packer->hash[i];
+        if (!*slot)
+            return slot;
+        struct packer_entry *e = &packer->entries[*slot - 1];
+        if (e->bitmap == bitmap && e->stride == stride &&
+            e->size.x == size.x && e->size.y == size.y)
+            return slot;
+    }
+}
+
+static void rebuild_hash(struct bitmap_packer *packer, int capacity)
+{
+    if (packer->hash_size < capacity * 2) {
+        int size = 64;
+        while (size < capacity * 2)
+            size *= 2;
+        packer->hash = talloc_realloc(packer, packer->hash, int, size);
+        packer->hash_size = size;
+    }
+    memset(packer->hash, 0, packer->hash_size * sizeof(packer->hash[0]));
+    for (int i = 0; i < packer->num_entries; i++) {
+        struct packer_entry *e = &packer->entries[i];
+        *find_slot(packer, e->bitmap, e->stride, e->size) = i + 1;
+    }
+}
+
+static bool entry_equals(struct packer_entry *e, struct sub_bitmap *s, int bpp)
+{
+    int bytes = s->w * bpp;
+    for (int y = 0; y < s->h; y++) {
+        if (memcmp((uint8_t *)e->data + y * bytes,
+                   (uint8_t *)s->bitmap + y * s->stride, bytes) != 0)
+            return false;
+    }
+    return true;
+}
+
+static void entry_set_data(struct bitmap_packer *packer, struct packer_entry *e,
+                           struct sub_bitmap *s, int bpp)
+{
+    int bytes = s->w * bpp;
+    if (!e->data)
+        e->data = talloc_size(packer, bytes * s->h);
+    memcpy_pic(e->data, s->bitmap, bytes, s->h, bytes, s->stride);
+}
+
+// Forget the bitmaps which are not used anymore, and pack the others from
+// scratch.
+static int repack_entries(struct bitmap_packer *packer)
+{
+    int *map = talloc_array(NULL, int, packer->num_entries);
+    int num = 0;
+    for (int i = 0; i < packer->num_entries; i++) {
+        struct packer_entry *e = &packer->entries[i];
+        map[i] = e->used ? num : -1;
+        if (e->used) {
+            packer->entries[num++] = *e;
+        } else {
+            talloc_free(e->data);
+        }
+    }
+    packer->num_entries = num;
+    for (int n = 0; n < packer->count; n++) {
+        if (packer->part_entry[n] >= 0)
+            packer->part_entry[n] = map[packer->part_entry[n]];
+    }
+    rebuild_hash(packer, num);
+
+    struct pos *in = talloc_array(map, struct pos, num);
+    struct pos *out = talloc_array(map, struct pos, num);
+    int64_t area = 0;
+    for (int i = 0; i < num; i++) {
+        in[i] = packer->entries[i].size;
+        area += in[i].x * in[i].y;
+    }
+    int w_orig = packer->w, h_orig = packer->h;
+    int r = pack_all(packer, in, out, num);
+    // Leave space for new bitmaps, or the next change would repack again.
+    if (r >= 0 && area * 2 > (int64_t)packer->w * packer->h) {
+        int w = packer->w, h = packer->h;
+        if (w <= h && w < packer->w_max)
+            packer->w = FFMIN(w * 2, packer->w_max);
+        else if (h < packer->h_max)
+            packer->h = FFMIN(h * 2, packer->h_max);
+        if (!pack_sorted(packer, in, out, num)) {
+            packer->w = w;
+            packer->h = h;
+            pack_sorted(packer, in, out, num);
+        }
+        skyline_update_used(packer);
+        r = packer->w != w_orig || packer->h != h_orig;
+    }
+    for (int i = 0; i < num; i++) {
+        packer->entries[i].pos = out[i];
+        packer->entries[i].dirty = true;
+    }
+    talloc_free(map);
+    return r;
+}
+
+static int pack_incremental(struct bitmap_packer *packer, struct sub_bitmaps *b)
+{
+    int bpp = b->format == SUBBITMAP_RGBA ? 4 : 1;
+    if (packer->entries_format != b->format ||
+        packer->entries_padding != packer->padding)
+    {
+        drop_entries(packer);
+        packer->num_skyline = 0;
+    }
+    packer->entries_format = b->format;
+    packer->entries_padding = packer->padding;
+    if (packer->hash_size < (packer->num_entries + packer->count) * 2)
+        rebuild_hash(packer, packer->num_entries + packer->count);
+
+    for (int i = 0; i < packer->num_entries; i++)
+        packer->entries[i].used = false;
+    int num_new = 0;
+    for (int n = 0; n < packer->count; n++) {
+        struct sub_bitmap *s = &b->parts[n];
+        struct pos size = packer->in[n];
+        packer->part_entry[n] = -1;
+        if (size.x <= packer->padding || size.y <= packer->padding) {
+            packer->in[n] = (struct pos){0, 0};
+            continue;
+        }
+        int *slot = find_slot(packer, s->bitmap, s->stride, size);
+        bool added = !*slot;
+        if (added) {
+            MP_TARRAY_APPEND(packer, packer->entries, packer->num_entries,
+                             (struct packer_entry){
+                                 .bitmap = s->bitmap,
+                                 .stride = s->stride,
+                                 .size = size,
+                             });
+            *slot = packer->num_entries;
+        }
+        struct packer_entry *e = &packer->entries[*slot - 1];
+        if (added) {
+            entry_set_data(packer, e, s, bpp);
+            e->pos = (struct pos){-1, -1};
+            packer->scratch[num_new++] = size_key(size, *slot - 1);
+        } else if (!e->used && !entry_equals(e, s, bpp)) {
+            // Same memory and size, but new contents: reuse the place.
+            entry_set_data(packer, e, s, bpp);
+            e->dirty = true;
+        }
+        // Parts with the same bitmap in the same list share the place.
+        e->used = true;
+        packer->part_entry[n] = *slot - 1;
+    }
+
+    // Place the new bitmaps around the old ones. Space of bitmaps that aren't
+    // used anymore is reclaimed only if everything has to be packed again.
+    bool ok = packer->num_skyline > 0;
+    qsort(packer->scratch, num_new, sizeof(packer->scratch[0]), cmp_key);
+    for (int i = 0; i < num_new && ok; i++) {
+        struct packer_entry *e = &packer->entries[(uint32_t)packer->scratch[i]];
+        ok = skyline_alloc(packer, e->size, packer->h + packer->padding,
+                           &e->pos);
+        e->dirty = true;
+    }
+    int r = 0;
+    packer->repacked = !ok;
+    if (!ok) {
+        r = repack_entries(packer);
+        if (r < 0) {
+            drop_entries(packer);
+            return r;
+        }
+    }
+    skyline_update_used(packer);
+
+    packer->num_dirty = 0;
+    for (int n = 0; n < packer->count; n++) {
+        int i = packer->part_entry[n];
+        packer->result[n] = i >= 0 ? packer->entries[i].pos : (struct pos){0};
+        if (i >= 0 && packer->entries[i].dirty) {
+            packer->entries[i].dirty = false;
+            packer->dirty[packer->num_dirty++] = n;
+        }
+    }
+    return r;
+}
+
 void packer_set_size(struct bitmap_packer *packer, int size)
 {
     packer->count = size;
@@ -187,23 +483,31 @@ void packer_set_size(struct bitmap_packer *packer, int size)
     packer->asize = FFMAX(packer->asize * 2, size);
     talloc_free(packer->result);
     talloc_free(packer->scratch);
+    talloc_free(packer->dirty);
+    talloc_free(packer->part_entry);
     packer->in = talloc_realloc(packer, packer->in, struct pos, packer->asize);
     packer->result = talloc_array_ptrtype(packer, packer->result,
                                           packer->asize);
     packer->scratch = talloc_array_ptrtype(packer, packer->scratch,
-                                           packer->asize + 16);
+                                           packer->asize);
+    packer->dirty = talloc_array_ptrtype(packer, packer->dirty, packer->asize);
+    packer->part_entry = talloc_array_ptrtype(packer, packer->part_entry,
+                                              packer->asize);
 }
 
 int packer_pack_from_subbitmaps(struct bitmap_packer *packer,
                                 struct sub_bitmaps *b)
 {
     packer->count = 0;
+    packer->num_dirty = 0;
     if (b->format == SUBBITMAP_EMPTY)
         return 0;
     packer_set_size(packer, b->num_parts);
     int a = packer->padding;
     for (int i = 0; i < b->num_parts; i++)
         packer->in[i] = (struct pos){b->parts[i].w + a, b->parts[i].h + a};
+    if (packer->incremental && b->format != SUBBITMAP_INDEXED)
+        return pack_incremental(packer, b);
     return packer_pack(packer);
 }
 
@@ -211,16 +515,23 @@ void packer_copy_subbitmaps(struct bitmap_packer *packer, struct sub_bitmaps *b,
                             void *data, int pixel_stride, int stride)
 {
     assert(packer->count == b->num_parts);
-    if (packer->padding) {
+    if (packer->padding && packer->repacked) {
         struct pos bb[2];
         packer_get_bb(packer, bb);
         memset_pic(data, 0, bb[1].x * pixel_stride, bb[1].y, stride);
     }
-    for (int n = 0; n < packer->count; n++) {
+    for (int i = 0; i < packer->num_dirty; i++) {
+        int n = packer->dirty[i];
         struct sub_bitmap *s = &b->parts[n];
         struct pos p = packer->result[n];
 
         void *pdata = (uint8_t *)data + p.y * stride + p.x * pixel_stride;
+        if (packer->padding && !packer->repacked) {
+            struct pos rc[2];
+            packer_get_rect(packer, n, rc);
+            memset_pic(pdata, 0, (rc[1].x - rc[0].x) * pixel_stride,
+                       rc[1].y - rc[0].y, stride);
+        }
         memcpy_pic(pdata, s->bitmap, s->w * pixel_stride, s->h,
                    stride, s->stride);
     }
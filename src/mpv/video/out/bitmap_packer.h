@@ -1,6 +1,9 @@
 #ifndef MPLAYER_PACK_RECTANGLES_H
 #define MPLAYER_PACK_RECTANGLES_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 struct pos {
     int x;
     int y;
@@ -17,22 +20,46 @@ struct bitmap_packer {
     struct pos *result;
     int used_width;
     int used_height;
+    // If set, packer_pack_from_subbitmaps() leaves bitmaps which were packed
+    // by a previous call at the same place, and packs only new bitmaps into
+    // the remaining space.
+    bool incremental;
+    // Set by packing: indexes of the rectangles whose contents have to be
+    // copied to the surface. Without incremental, these are all rectangles.
+    int *dirty;
+    int num_dirty;
+    // Set by packing if rectangles were moved. Then all of them are dirty, and
+    // the area outside of them is undefined.
+    bool repacked;
 
     // internal
-    int *scratch;
+    uint64_t *scratch;
+    int *part_entry;
     int asize;
+    struct skyline_node *skyline;
+    int num_skyline;
+    struct packer_entry *entries;
+    int num_entries;
+    int *hash;
+    int hash_size;
+    int entries_format;
+    int entries_padding;
 };
 
 struct ass_image;
 struct sub_bitmaps;
 
-// Clear all internal state. Leave the following fields: w_max, h_max
+// Clear all internal state. Leave the following fields: w_max, h_max,
+// incremental
 void packer_reset(struct bitmap_packer *packer);
 
 // Get the bounding box used for bitmap data (including padding).
 // The bounding box doesn't exceed (0,0)-(packer->w,packer->h).
 void packer_get_bb(struct bitmap_packer *packer, struct pos out_bb[2]);
 
+// Get the area used by rectangle n (including padding), in the same way.
+void packer_get_rect(struct bitmap_packer *packer, int n, struct pos out_rc[2]);
+
 /* Reallocate packer->in for at least to desired number of items.
  * Also sets packer->count to the same value.
  */
@@ -52,6 +79,9 @@ int packer_pack(struct bitmap_packer *packer);
 /* Like above, but packer->count will be automatically set and
  * packer->in will be reallocated if needed and filled from the
  * given image list.
+ * If packer->incremental is set, bitmaps with the same memory and contents
+ * as in the previous call keep their position, and only new ones are dirty.
+ * Everything is packed again if the new ones don't fit.
  */
 int packer_pack_from_subbitmaps(struct bitmap_packer *packer,
                                 struct sub_bitmaps *b);
@@ -61,6 +91,7 @@ int packer_pack_from_subbitmaps(struct bitmap_packer *packer,
 // The image has the given stride (bytes between (x, y) to (x, y + 1)), and the
 // pixel format used by both the sub-bitmaps and the image uses pixel_stride
 // bytes per pixel (bytes between (x, y) to (x + 1, y)).
+// Only the dirty sub-bitmaps are copied.
 // If packer->padding is set, the padding borders are cleared with 0.
 void packer_copy_subbitmaps(struct bitmap_packer *packer, struct sub_bitmaps *b,
                             void *data, int pixel_stride, int stride);
@@ -32,10 +32,13 @@
 #include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 
 #include <libavutil/lfg.h>
 
 #include "talloc.h"
+#include "options/path.h"
+#include "osdep/io.h"
 #include "dither.h"
 
 #define MAX_SIZEB 8
@@ -105,20 +108,14 @@ static void makegauss(struct ctx *k, unsigned int sizeb)
     }
 }
 
-static void setbit(struct ctx *k, index_t c)
+// Picks one of the resnum candidates collected in randomat.
+static index_t pickmin(struct ctx *k, index_t resnum)
 {
-    if (k->calcmat[c])
-        return;
-    k->calcmat[c] = true;
-    uint64_t *m = k->gaussmat;
-    uint64_t *me = k->gaussmat + k->size2;
-    uint64_t *g = k->gauss + WRAP_SIZE2(k, k->gauss_middle + k->size2 - c);
-    uint64_t *ge = k->gauss + k->size2;
-    while (g < ge)
-        *m++ += *g++;
-    g = k->gauss;
-    while (m < me)
-        *m++ += *g++;
+    if (resnum == 1)
+        return k->randomat[0];
+    if (resnum == k->size2)
+        return k->size2 / 2;
+    return k->randomat[av_lfg_get(&k->avlfg) % resnum];
 }
 
 static index_t getmin(struct ctx *k)
@@ -138,20 +135,43 @@ static index_t getmin(struct ctx *k)
             k->randomat[resnum++] = c;
         }
     }
-    if (resnum == 1)
-        return k->randomat[0];
-    if (resnum == size2)
-        return size2 / 2;
-    return k->randomat[av_lfg_get(&k->avlfg) % resnum];
+    return pickmin(k, resnum);
+}
+
+// Add the gaussian centered on c to gaussmat, and return the next minimum.
+// This is the same as setbit() followed by getmin(), but does both in a single
+// pass over the matrix, which is what dominates the run time.
+static index_t setbit_getmin(struct ctx *k, index_t c)
+{
+    k->calcmat[c] = true;
+    uint64_t min = UINT64_MAX;
+    index_t resnum = 0;
+    unsigned int size2 = k->size2;
+    index_t offset = WRAP_SIZE2(k, k->gauss_middle + size2 - c);
+    uint64_t *gaussmat = k->gaussmat;
+    const uint64_t *gauss = k->gauss;
+    const bool *calcmat = k->calcmat;
+    for (index_t n = 0; n < size2; n++) {
+        uint64_t total = gaussmat[n] += gauss[WRAP_SIZE2(k, offset + n)];
+        if (total <= min && !calcmat[n]) {
+            if (total != min) {
+                min = total;
+                resnum = 0;
+            }
+            k->randomat[resnum++] = n;
+        }
+    }
+    return pickmin(k, resnum);
 }
 
 static void makeuniform(struct ctx *k)
 {
     unsigned int size2 = k->size2;
+    index_t r = getmin(k);
     for (index_t c = 0; c < size2; c++) {
-        index_t r = getmin(k);
-        setbit(k, r);
         k->unimat[r] = c;
+        if (c + 1 < size2)
+            r = setbit_getmin(k, r);
     }
 }
 
@@ -169,6 +189,76 @@ void mp_make_fruit_dither_matrix(float *out_matrix, int size)
     talloc_free(k);
 }
 
+// Matrices are stored as their ranks, which is what makeuniform() produces.
+// A file is only accepted if it contains every rank exactly once.
+static bool load_fruit_matrix(const char *file, float *out_matrix, int size)
+{
+    unsigned int size2 = 1u << (size * 2);
+    uint16_t *ranks = talloc_array(NULL, uint16_t, size2);
+    bool *seen = talloc_zero_array(ranks, bool, size2);
+    bool ok = false;
+    FILE *in = fopen(file, "rb");
+    if (!in)
+        goto done;
+    ok = fread(ranks, sizeof(ranks[0]), size2, in) == size2 && fgetc(in) == EOF;
+    fclose(in);
+    for (index_t c = 0; ok && c < size2; c++) {
+        ok = ranks[c] < size2 && !seen[ranks[c]];
+        if (ok)
+            seen[ranks[c]] = true;
+    }
+    for (index_t c = 0; ok && c < size2; c++)
+        out_matrix[c] = ranks[c] / (float)size2;
+done:
+    talloc_free(ranks);
+    return ok;
+}
+
+static void save_fruit_matrix(const char *file, const float *matrix, int size)
+{
+    unsigned int size2 = 1u << (size * 2);
+    uint16_t *ranks = talloc_array(NULL, uint16_t, size2);
+    for (index_t c = 0; c < size2; c++)
+        ranks[c] = lrintf(matrix[c] * size2);
+    FILE *out = fopen(file, "wb");
+    if (out) {
+        fwrite(ranks, sizeof(ranks[0]), size2, out);
+        fclose(out);
+    }
+    talloc_free(ranks);
+}
+
+static pthread_mutex_t fruit_lock = PTHREAD_MUTEX_INITIALIZER;
+static float *fruit_matrices[MAX_SIZEB + 1];
+
+// Return the same matrix as mp_make_fruit_dither_matrix(). It's computed only
+// once per process (the memory is never freed), and if cache_dir is not NULL,
+// stored there and loaded on later runs.
+const float *mp_get_fruit_dither_matrix(int size, const char *cache_dir)
+{
+    assert(size >= 1 && size <= MAX_SIZEB);
+    pthread_mutex_lock(&fruit_lock);
+    float *matrix = fruit_matrices[size];
+    if (!matrix) {
+        matrix = talloc_array(NULL, float, 1 << (size * 2));
+        char *file = NULL;
+        if (cache_dir && cache_dir[0]) {
+            char name[32];
+            snprintf(name, sizeof(name), "fruit-dither-%d", size);
+            file = mp_path_join(matrix, cache_dir, name);
+        }
+        if (!file || !load_fruit_matrix(file, matrix, size)) {
+            mp_make_fruit_dither_matrix(matrix, size);
+            if (file)
+                save_fruit_matrix(file, matrix, size);
+        }
+        talloc_free(file);
+        fruit_matrices[size] = matrix;
+    }
+    pthread_mutex_unlock(&fruit_lock);
+    return matrix;
+}
+
 void mp_make_ordered_dither_matrix(unsigned char *m, int size)
 {
     m[0] = 0;
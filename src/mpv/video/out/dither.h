@@ -1,2 +1,3 @@
 void mp_make_fruit_dither_matrix(float *out_matrix, int size);
+const float *mp_get_fruit_dither_matrix(int size, const char *cache_dir);
 void mp_make_ordered_dither_matrix(unsigned char *m, int size);
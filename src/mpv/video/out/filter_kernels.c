@@ -32,10 +32,13 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
 #include <assert.h>
+#include <pthread.h>
 
+#include "talloc.h"
 #include "filter_kernels.h"
 
 // NOTE: all filters are designed for discrete convolution
@@ -157,6 +160,71 @@ void mp_compute_lut(struct filter_kernel *filter, int count, float *out_array)
     }
 }
 
+#define LUT_CACHE_ENTRIES 16
+
+struct lut_entry {
+    struct filter_kernel filter;
+    int count;
+    float *data;
+    uint64_t last_use;
+};
+
+static pthread_mutex_t lut_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct lut_entry lut_cache[LUT_CACHE_ENTRIES];
+static uint64_t lut_use_counter;
+
+static bool window_equal(const struct filter_window *a,
+                         const struct filter_window *b)
+{
+    // compared bitwise, so that unset (NAN) parameters match
+    double va[] = {a->radius, a->params[0], a->params[1], a->blur};
+    double vb[] = {b->radius, b->params[0], b->params[1], b->blur};
+    return a->weight == b->weight && memcmp(va, vb, sizeof(va)) == 0;
+}
+
+static bool lut_entry_matches(struct lut_entry *e, struct filter_kernel *filter,
+                              int count)
+{
+    return e->data && e->count == count && e->filter.polar == filter->polar &&
+           e->filter.size == filter->size &&
+           e->filter.inv_scale == filter->inv_scale &&
+           window_equal(&e->filter.f, &filter->f) &&
+           window_equal(&e->filter.w, &filter->w);
+}
+
+// Same as mp_compute_lut(), but the result is shared by all users in the
+// process, so that e.g. multiple VOs with the same scaler settings compute it
+// only once. Thread-safe.
+void mp_get_lut(struct filter_kernel *filter, int count, float *out_array)
+{
+    size_t size = sizeof(float) * count * filter->size;
+    pthread_mutex_lock(&lut_lock);
+    struct lut_entry *entry = NULL;
+    for (int n = 0; n < LUT_CACHE_ENTRIES; n++) {
+        if (lut_entry_matches(&lut_cache[n], filter, count)) {
+            entry = &lut_cache[n];
+            break;
+        }
+    }
+    if (!entry) {
+        entry = &lut_cache[0];
+        for (int n = 1; n < LUT_CACHE_ENTRIES; n++) {
+            if (lut_cache[n].last_use < entry->last_use)
+                entry = &lut_cache[n];
+        }
+        talloc_free(entry->data);
+        *entry = (struct lut_entry){
+            .filter = *filter,
+            .count = count,
+            .data = talloc_size(NULL, size),
+        };
+        mp_compute_lut(filter, count, entry->data);
+    }
+    entry->last_use = ++lut_use_counter;
+    memcpy(out_array, entry->data, size);
+    pthread_mutex_unlock(&lut_lock);
+}
+
 typedef struct filter_window params;
 
 static double box(params *p, double x)
@@ -50,5 +50,6 @@ const struct filter_kernel *mp_find_filter_kernel(const char *name);
 bool mp_init_filter(struct filter_kernel *filter, const int *sizes,
                     double scale);
 void mp_compute_lut(struct filter_kernel *filter, int count, float *out_array);
+void mp_get_lut(struct filter_kernel *filter, int count, float *out_array);
 
 #endif /* MPLAYER_FILTER_KERNELS_H */
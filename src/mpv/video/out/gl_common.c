@@ -57,6 +57,7 @@ static const struct feature features[] = {
     {MPGL_CAP_1D_TEX,           "1D textures"},
     {MPGL_CAP_3D_TEX,           "3D textures"},
     {MPGL_CAP_DEBUG,            "debugging extensions"},
+    {MPGL_CAP_PROGRAM_BINARY,   "program binaries"},
     {MPGL_CAP_SW,               "suspected software renderer"},
     {0},
 };
@@ -297,6 +298,19 @@ static const struct gl_functions gl_functions[] = {
         .extension = "GL_APPLE_rgb_422",
         .provides = MPGL_CAP_APPLE_RGB_422,
     },
+    // For the shader cache in gl_utils.c
+    {
+        .ver_core = 410,
+        .ver_es_core = 300,
+        .extension = "GL_ARB_get_program_binary",
+        .provides = MPGL_CAP_PROGRAM_BINARY,
+        .functions = (const struct gl_function[]) {
+            DEF_FN(GetProgramBinary),
+            DEF_FN(ProgramBinary),
+            DEF_FN(ProgramParameteri),
+            {0}
+        },
+    },
     {
         .ver_core = 430,
         .extension = "GL_ARB_debug_output",
@@ -63,6 +63,7 @@ enum {
     MPGL_CAP_1D_TEX             = (1 << 14),
     MPGL_CAP_3D_TEX             = (1 << 15),
     MPGL_CAP_DEBUG              = (1 << 16),
+    MPGL_CAP_PROGRAM_BINARY     = (1 << 17),    // GL_ARB_get_program_binary
     MPGL_CAP_SW                 = (1 << 30),    // indirect or sw renderer
 };
 
@@ -249,6 +250,10 @@ struct GL {
     void (GLAPIENTRY *GetProgramiv)(GLenum, GLenum, GLint *);
     const GLubyte* (GLAPIENTRY *GetStringi)(GLenum, GLuint);
     void (GLAPIENTRY *BindAttribLocation)(GLuint, GLuint, const GLchar *);
+    void (GLAPIENTRY *GetProgramBinary)(GLuint, GLsizei, GLsizei *, GLenum *,
+                                        GLvoid *);
+    void (GLAPIENTRY *ProgramBinary)(GLuint, GLenum, const GLvoid *, GLsizei);
+    void (GLAPIENTRY *ProgramParameteri)(GLuint, GLenum, GLint);
     void (GLAPIENTRY *BindFramebuffer)(GLenum, GLuint);
     void (GLAPIENTRY *GenFramebuffers)(GLsizei, GLuint *);
     void (GLAPIENTRY *DeleteFramebuffers)(GLsizei, const GLuint *);
@@ -125,6 +125,7 @@ struct mpgl_osd *mpgl_osd_init(GL *gl, struct mp_log *log, struct osd_state *osd
             .packer = talloc_struct(p, struct bitmap_packer, {
                 .w_max = max_texture_size,
                 .h_max = max_texture_size,
+                .incremental = true,
             }),
         };
         ctx->parts[n] = p;
@@ -182,14 +183,27 @@ static bool upload_pbo(struct mpgl_osd *ctx, struct mpgl_osd_part *osd,
     if (!data) {
         success = false;
     } else {
-        struct pos bb[2];
-        packer_get_bb(osd->packer, bb);
+        struct bitmap_packer *packer = osd->packer;
         size_t stride = osd->w * pix_stride;
-        packer_copy_subbitmaps(osd->packer, imgs, data, pix_stride, stride);
+        packer_copy_subbitmaps(packer, imgs, data, pix_stride, stride);
         if (!gl->UnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
             success = false;
-        glUploadTex(gl, GL_TEXTURE_2D, fmt.format, fmt.type, NULL, stride,
-                    bb[0].x, bb[0].y, bb[1].x - bb[0].x, bb[1].y - bb[0].y, 0);
+        if (packer->repacked) {
+            struct pos bb[2];
+            packer_get_bb(packer, bb);
+            glUploadTex(gl, GL_TEXTURE_2D, fmt.format, fmt.type, NULL, stride,
+                        bb[0].x, bb[0].y, bb[1].x - bb[0].x, bb[1].y - bb[0].y,
+                        0);
+        } else {
+            for (int i = 0; i < packer->num_dirty; i++) {
+                struct pos rc[2];
+                packer_get_rect(packer, packer->dirty[i], rc);
+                size_t offset = rc[0].y * stride + rc[0].x * pix_stride;
+                glUploadTex(gl, GL_TEXTURE_2D, fmt.format, fmt.type,
+                            (void *)offset, stride, rc[0].x, rc[0].y,
+                            rc[1].x - rc[0].x, rc[1].y - rc[0].y, 0);
+            }
+        }
     }
     gl->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
@@ -205,17 +219,26 @@ static void upload_tex(struct mpgl_osd *ctx, struct mpgl_osd_part *osd,
                        struct sub_bitmaps *imgs)
 {
     struct osd_fmt_entry fmt = ctx->fmt_table[imgs->format];
-    if (osd->packer->padding) {
+    struct bitmap_packer *packer = osd->packer;
+    if (packer->padding && packer->repacked) {
         struct pos bb[2];
-        packer_get_bb(osd->packer, bb);
+        packer_get_bb(packer, bb);
         glClearTex(ctx->gl, GL_TEXTURE_2D, fmt.format, fmt.type,
                    bb[0].x, bb[0].y, bb[1].x - bb[0].y, bb[1].y - bb[0].y,
                    0, &ctx->scratch);
     }
-    for (int n = 0; n < osd->packer->count; n++) {
+    for (int i = 0; i < packer->num_dirty; i++) {
+        int n = packer->dirty[i];
         struct sub_bitmap *s = &imgs->parts[n];
-        struct pos p = osd->packer->result[n];
-
+        struct pos p = packer->result[n];
+
+        if (packer->padding && !packer->repacked) {
+            struct pos rc[2];
+            packer_get_rect(packer, n, rc);
+            glClearTex(ctx->gl, GL_TEXTURE_2D, fmt.format, fmt.type,
+                       rc[0].x, rc[0].y, rc[1].x - rc[0].x, rc[1].y - rc[0].y,
+                       0, &ctx->scratch);
+        }
         glUploadTex(ctx->gl, GL_TEXTURE_2D, fmt.format, fmt.type,
                     s->bitmap, s->stride, p.x, p.y, s->w, s->h, 0);
     }
@@ -26,10 +26,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include <assert.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <libavutil/sha.h>
+#include <libavutil/mem.h>
+#include <libavutil/random_seed.h>
 
 #include "stream/stream.h"
 #include "common/common.h"
+#include "misc/ctype.h"
+#include "options/path.h"
+#include "osdep/io.h"
 #include "gl_utils.h"
 
 // GLU has this as gluErrorString (we don't use GLU, as it is legacy-OpenGL)
@@ -463,7 +474,7 @@ void gl_set_debug_logger(GL *gl, struct mp_log *log)
     }
 }
 
-#define SC_ENTRIES 16
+#define SC_ENTRIES 48
 #define SC_UNIFORM_ENTRIES 20
 #define SC_FILE_ENTRIES 10
 
@@ -494,8 +505,10 @@ struct sc_file {
 struct sc_entry {
     GLuint gl_shader;
     // the following fields define the shader's contents
+    uint64_t hash; // of key
     char *key; // vertex+frag shader (mangled)
     struct gl_vao *vao;
+    uint64_t last_use;
 };
 
 struct gl_shader_cache {
@@ -510,6 +523,14 @@ struct gl_shader_cache {
 
     struct sc_entry entries[SC_ENTRIES];
     int num_entries;
+    uint64_t use_counter;
+
+    // program binaries are stored here if not NULL
+    char *cache_dir;
+    // identifies the driver, binaries of other drivers can't be used
+    char *driver;
+    // the current program is not stored in cache_dir
+    bool no_binary;
 
     struct sc_uniform uniforms[SC_UNIFORM_ENTRIES];
     int num_uniforms;
@@ -539,6 +560,86 @@ void gl_sc_reset(struct gl_shader_cache *sc)
     for (int n = 0; n < sc->num_uniforms; n++)
         talloc_free(sc->uniforms[n].name);
     sc->num_uniforms = 0;
+    sc->no_binary = false;
+}
+
+// Keep at most this many program binaries in the cache directory.
+#define SC_BINARY_FILES 256
+
+struct sc_binary_file {
+    char *path;
+    time_t mtime;
+};
+
+static int compare_mtime(const void *a, const void *b)
+{
+    const struct sc_binary_file *fa = a, *fb = b;
+    return fa->mtime < fb->mtime ? -1 : fa->mtime > fb->mtime;
+}
+
+// Program binaries are named by a 64 digit hash, other files are left alone.
+static bool is_binary_name(const char *name)
+{
+    for (int n = 0; n < 64; n++) {
+        if (!mp_isdigit(name[n]) && !(name[n] >= 'A' && name[n] <= 'F'))
+            return false;
+    }
+    return !name[64] || name[64] == '.';
+}
+
+// Delete the least recently written binaries beyond SC_BINARY_FILES, so
+// programs which are not used anymore don't accumulate forever.
+static void prune_binaries(struct gl_shader_cache *sc)
+{
+    DIR *dir = opendir(sc->cache_dir);
+    if (!dir)
+        return;
+    void *tmp = talloc_new(NULL);
+    struct sc_binary_file *files = NULL;
+    int num_files = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir))) {
+        if (!is_binary_name(ent->d_name))
+            continue;
+        char *path = mp_path_join(tmp, sc->cache_dir, ent->d_name);
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            struct sc_binary_file file = {path, st.st_mtime};
+            MP_TARRAY_APPEND(tmp, files, num_files, file);
+        }
+    }
+    closedir(dir);
+    if (num_files > SC_BINARY_FILES) {
+        qsort(files, num_files, sizeof(files[0]), compare_mtime);
+        int excess = num_files - SC_BINARY_FILES;
+        for (int n = 0; n < excess; n++)
+            unlink(files[n].path);
+        MP_VERBOSE(sc, "removed %d old program binaries\n", excess);
+    }
+    talloc_free(tmp);
+}
+
+void gl_sc_set_cache_dir(struct gl_shader_cache *sc, const char *dir)
+{
+    talloc_free(sc->cache_dir);
+    sc->cache_dir = NULL;
+    if (!dir || !dir[0] || !(sc->gl->mpgl_caps & MPGL_CAP_PROGRAM_BINARY))
+        return;
+    if (sc->global) {
+        sc->cache_dir = mp_get_user_path(sc, sc->global, dir);
+    } else {
+        sc->cache_dir = talloc_strdup(sc, dir);
+    }
+    mp_mkdirp(sc->cache_dir);
+    prune_binaries(sc);
+}
+
+// Don't store the program generated next in the cache directory. Meant for
+// shader text which changes with user settings, and would otherwise leave a
+// new file for every change.
+void gl_sc_no_binary_cache(struct gl_shader_cache *sc)
+{
+    sc->no_binary = true;
 }
 
 static void sc_flush_cache(struct gl_shader_cache *sc)
@@ -816,10 +917,138 @@ static void link_shader(struct gl_shader_cache *sc, GLuint program)
     }
 }
 
+#define SC_BINARY_MAGIC "mpvglsc1"
+#define SC_BINARY_HEADER 16 // magic, format, length
+#define SC_BINARY_MAX (16 * 1024 * 1024)
+
+// FNV-1a
+#define SC_HASH_INIT 0xcbf29ce484222325ULL
+static uint64_t sc_hash(uint64_t hash, const char *text)
+{
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+        hash = (hash ^ *c) * 0x100000001b3ULL;
+    return hash;
+}
+
+static char *binary_file(void *ta_ctx, struct gl_shader_cache *sc,
+                         const char *vertex, const char *frag)
+{
+    GL *gl = sc->gl;
+    if (!sc->driver) {
+        sc->driver = talloc_asprintf(sc, "%s\n%s\n%s\n",
+                                     (const char *)gl->GetString(GL_VENDOR),
+                                     (const char *)gl->GetString(GL_RENDERER),
+                                     (const char *)gl->GetString(GL_VERSION));
+    }
+
+    uint8_t hash[32];
+    struct AVSHA *sha = av_sha_alloc();
+    if (!sha)
+        abort();
+    av_sha_init(sha, 256);
+    av_sha_update(sha, sc->driver, strlen(sc->driver));
+    av_sha_update(sha, vertex, strlen(vertex));
+    av_sha_update(sha, frag, strlen(frag));
+    av_sha_final(sha, hash);
+    av_free(sha);
+
+    char name[sizeof(hash) * 2 + 1];
+    for (int i = 0; i < sizeof(hash); i++)
+        snprintf(name + i * 2, 3, "%02X", hash[i]);
+    return mp_path_join(ta_ctx, sc->cache_dir, name);
+}
+
+// Returns 0 if there is no usable binary in the file.
+static GLuint load_binary(struct gl_shader_cache *sc, const char *file)
+{
+    GL *gl = sc->gl;
+    FILE *in = fopen(file, "rb");
+    if (!in)
+        return 0;
+    GLuint prog = 0;
+    uint8_t header[SC_BINARY_HEADER];
+    uint32_t format, size;
+    if (fread(header, sizeof(header), 1, in) != 1)
+        goto done;
+    memcpy(&format, header + 8, 4);
+    memcpy(&size, header + 12, 4);
+    if (memcmp(header, SC_BINARY_MAGIC, 8) != 0 || !size || size > SC_BINARY_MAX)
+        goto done;
+    void *data = talloc_size(NULL, size);
+    if (fread(data, size, 1, in) == 1) {
+        prog = gl->CreateProgram();
+        gl->ProgramBinary(prog, format, data, size);
+        // fails e.g. after driver updates which didn't change the version
+        GLint status = 0;
+        gl->GetProgramiv(prog, GL_LINK_STATUS, &status);
+        if (!status) {
+            MP_VERBOSE(sc, "program binary '%s' rejected by driver\n", file);
+            gl->DeleteProgram(prog);
+            prog = 0;
+        }
+    }
+    talloc_free(data);
+done:
+    fclose(in);
+    return prog;
+}
+
+static void save_binary(struct gl_shader_cache *sc, GLuint prog,
+                        const char *file)
+{
+    GL *gl = sc->gl;
+    GLint status = 0, size = 0;
+    gl->GetProgramiv(prog, GL_LINK_STATUS, &status);
+    if (!status)
+        return;
+    gl->GetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0 || size > SC_BINARY_MAX)
+        return;
+    uint8_t *data = talloc_size(NULL, SC_BINARY_HEADER + size);
+    GLsizei len = 0;
+    GLenum format = 0;
+    gl->GetProgramBinary(prog, size, &len, &format, data + SC_BINARY_HEADER);
+    if (len > 0) {
+        uint32_t header[2] = {format, len};
+        memcpy(data, SC_BINARY_MAGIC, 8);
+        memcpy(data + 8, header, sizeof(header));
+        // write under a temporary name, so a partial file is never loaded
+        char *part = talloc_asprintf(data, "%s.%08"PRIx32".tmp", file,
+                                     av_get_random_seed());
+        FILE *out = fopen(part, "wb");
+        if (out) {
+            bool ok = fwrite(data, SC_BINARY_HEADER + len, 1, out) == 1;
+            ok = fclose(out) == 0 && ok;
+            if (ok) {
+#ifdef _WIN32
+                unlink(file); // rename() doesn't replace files here
+#endif
+                ok = rename(part, file) == 0;
+            }
+            if (!ok) {
+                MP_VERBOSE(sc, "could not write program binary '%s'\n", file);
+                unlink(part);
+            }
+        }
+    }
+    talloc_free(data);
+}
+
 static GLuint create_program(struct gl_shader_cache *sc, const char *vertex,
                              const char *frag)
 {
     GL *gl = sc->gl;
+    void *tmp = talloc_new(NULL);
+    char *file = NULL;
+    if (sc->cache_dir && !sc->no_binary) {
+        file = binary_file(tmp, sc, vertex, frag);
+        GLuint prog = load_binary(sc, file);
+        if (prog) {
+            MP_DBG(sc, "loaded shader program from '%s'\n", file);
+            talloc_free(tmp);
+            return prog;
+        }
+    }
     MP_VERBOSE(sc, "recompiling a shader program:\n");
     if (sc->header_text[0]) {
         MP_VERBOSE(sc, "header:\n");
@@ -835,7 +1064,12 @@ static GLuint create_program(struct gl_shader_cache *sc, const char *vertex,
         snprintf(vname, sizeof(vname), "vertex_%s", sc->vao->entries[n].name);
         gl->BindAttribLocation(prog, n, vname);
     }
+    if (file)
+        gl->ProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     link_shader(sc, prog);
+    if (file)
+        save_binary(sc, prog, file);
+    talloc_free(tmp);
     return prog;
 }
 
@@ -918,20 +1152,38 @@ void gl_sc_gen_shader_and_reset(struct gl_shader_cache *sc)
     }
     ADD(frag, "}\n");
 
-    char *key = talloc_asprintf(tmp, "%s%s", vert, frag);
+    // the key is vert+frag, but it's only concatenated for new entries
+    size_t vert_len = strlen(vert);
+    uint64_t hash = sc_hash(sc_hash(SC_HASH_INIT, vert), frag);
     struct sc_entry *entry = NULL;
     for (int n = 0; n < sc->num_entries; n++) {
-        if (strcmp(key, sc->entries[n].key) == 0) {
-            entry = &sc->entries[n];
+        struct sc_entry *e = &sc->entries[n];
+        if (e->hash == hash && strncmp(e->key, vert, vert_len) == 0 &&
+            strcmp(e->key + vert_len, frag) == 0)
+        {
+            entry = e;
             break;
         }
     }
     if (!entry) {
-        if (sc->num_entries == SC_ENTRIES)
-            sc_flush_cache(sc);
-        entry = &sc->entries[sc->num_entries++];
-        *entry = (struct sc_entry){.key = talloc_strdup(NULL, key)};
+        if (sc->num_entries == SC_ENTRIES) {
+            // replace the least recently used program
+            entry = &sc->entries[0];
+            for (int n = 1; n < sc->num_entries; n++) {
+                if (sc->entries[n].last_use < entry->last_use)
+                    entry = &sc->entries[n];
+            }
+            gl->DeleteProgram(entry->gl_shader);
+            talloc_free(entry->key);
+        } else {
+            entry = &sc->entries[sc->num_entries++];
+        }
+        *entry = (struct sc_entry){
+            .hash = hash,
+            .key = talloc_asprintf(NULL, "%s%s", vert, frag),
+        };
     }
+    entry->last_use = ++sc->use_counter;
     // build vertex shader from vao
     if (!entry->gl_shader)
         entry->gl_shader = create_program(sc, vert, frag);
@@ -122,6 +122,8 @@ struct gl_shader_cache;
 struct gl_shader_cache *gl_sc_create(GL *gl, struct mp_log *log,
                                      struct mpv_global *global);
 void gl_sc_destroy(struct gl_shader_cache *sc);
+void gl_sc_set_cache_dir(struct gl_shader_cache *sc, const char *dir);
+void gl_sc_no_binary_cache(struct gl_shader_cache *sc);
 void gl_sc_add(struct gl_shader_cache *sc, const char *text);
 void gl_sc_addf(struct gl_shader_cache *sc, const char *textf, ...);
 void gl_sc_hadd(struct gl_shader_cache *sc, const char *text);
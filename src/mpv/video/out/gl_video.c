@@ -40,6 +40,7 @@
 #include "aspect.h"
 #include "bitmap_packer.h"
 #include "dither.h"
+#include "options/path.h"
 
 // Pixel width of 1D lookup textures.
 #define LOOKUP_TEXTURE_SIZE 256
@@ -219,10 +220,6 @@ struct gl_video {
     int frames_rendered;
     AVLFG lfg;
 
-    // Cached because computing it can take relatively long
-    int last_dither_matrix_size;
-    float *last_dither_matrix;
-
     struct gl_hwdec *hwdec;
     bool hwdec_active;
 };
@@ -453,6 +450,7 @@ const struct m_sub_options gl_video_conf = {
         OPT_STRING("scale-shader", scale_shader, 0),
         OPT_STRINGLIST("pre-shaders", pre_shaders, 0),
         OPT_STRINGLIST("post-shaders", post_shaders, 0),
+        OPT_STRING("shader-cache-dir", shader_cache_dir, 0),
 
         OPT_REMOVED("approx-gamma", "this is always enabled now"),
         OPT_STRING("custom-shader", custom_shader, 0),
@@ -1039,7 +1037,7 @@ static void reinit_scaler(struct gl_video *p, struct scaler *scaler,
     gl->BindTexture(target, scaler->gl_lut);
 
     float *weights = talloc_array(NULL, float, LOOKUP_TEXTURE_SIZE * size);
-    mp_compute_lut(scaler->kernel, LOOKUP_TEXTURE_SIZE, weights);
+    mp_get_lut(scaler->kernel, LOOKUP_TEXTURE_SIZE, weights);
 
     if (target == GL_TEXTURE_1D) {
         gl->TexImage1D(target, 0, fmt->internal_format, LOOKUP_TEXTURE_SIZE,
@@ -1618,8 +1616,11 @@ static void pass_convert_yuv(struct gl_video *p)
     } else if (p->opts.alpha_mode == 2) { // blend
         GLSL(color = vec4(color.rgb * color.a, 1.0);)
     }
-    if (p->opts.custom_shader && strlen(p->opts.custom_shader))
+    if (p->opts.custom_shader && strlen(p->opts.custom_shader)) {
         GLSLF("%s\n", p->opts.custom_shader);
+        // usually changes with user settings, e.g. a color matrix
+        gl_sc_no_binary_cache(p->sc);
+    }
 }
 
 static void get_scale_factors(struct gl_video *p, double xy[2])
@@ -1861,7 +1862,7 @@ static void pass_dither(struct gl_video *p)
         MP_VERBOSE(p, "Dither to %d.\n", dst_depth);
 
         int tex_size;
-        void *tex_data;
+        const void *tex_data;
         GLint tex_iformat;
         GLint tex_format;
         GLenum tex_type;
@@ -1869,20 +1870,18 @@ static void pass_dither(struct gl_video *p)
 
         if (p->opts.dither_algo == 0) {
             int sizeb = p->opts.dither_size;
-            int size = 1 << sizeb;
-
-            if (p->last_dither_matrix_size != size) {
-                p->last_dither_matrix = talloc_realloc(p, p->last_dither_matrix,
-                                                       float, size * size);
-                mp_make_fruit_dither_matrix(p->last_dither_matrix, sizeb);
-                p->last_dither_matrix_size = size;
+            char *dir = NULL;
+            if (p->opts.shader_cache_dir && p->opts.shader_cache_dir[0]) {
+                dir = mp_get_user_path(NULL, p->global, p->opts.shader_cache_dir);
+                mp_mkdirp(dir);
             }
 
-            tex_size = size;
+            tex_size = 1 << sizeb;
             tex_iformat = gl_float16_formats[0].internal_format;
             tex_format = gl_float16_formats[0].format;
             tex_type = GL_FLOAT;
-            tex_data = p->last_dither_matrix;
+            tex_data = mp_get_fruit_dither_matrix(sizeb, dir);
+            talloc_free(dir);
         } else {
             assert(sizeof(temp) >= 8 * 8);
             mp_make_ordered_dither_matrix(temp, 8);
@@ -2793,6 +2792,7 @@ void gl_video_set_options(struct gl_video *p, struct gl_video_opts *opts,
     talloc_free(p->opts.scale_shader);
     talloc_free(p->opts.pre_shaders);
     talloc_free(p->opts.post_shaders);
+    talloc_free(p->opts.shader_cache_dir);
 
     p->opts = *opts;
 
@@ -2819,6 +2819,9 @@ void gl_video_set_options(struct gl_video *p, struct gl_video_opts *opts,
     p->opts.scale_shader = talloc_strdup(p, p->opts.scale_shader);
     p->opts.pre_shaders = dup_str_array(p, p->opts.pre_shaders);
     p->opts.post_shaders = dup_str_array(p, p->opts.post_shaders);
+    p->opts.shader_cache_dir = talloc_strdup(p, p->opts.shader_cache_dir);
+
+    gl_sc_set_cache_dir(p->sc, p->opts.shader_cache_dir);
 
     check_gl_features(p);
     uninit_rendering(p);
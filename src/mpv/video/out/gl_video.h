@@ -71,6 +71,7 @@ struct gl_video_opts {
     char *scale_shader;
     char **pre_shaders;
     char **post_shaders;
+    char *shader_cache_dir;
 };
 
 extern const struct m_sub_options gl_video_conf;
@@ -41,6 +41,13 @@
 #define FRAME_DROP_CLEAR    1 // drop all frames in queue
 #define FRAME_DROP_BLOCK    2
 
+// Attached to queued frames as mp_image.priv.
+struct frame_info {
+    struct frame_timing timing; // set by draw_image_timed
+    bool timed;
+    int64_t queued;             // mp_time_us() when it entered the queue
+};
+
 struct vo_priv {
     struct vo *vo;
 
@@ -51,6 +58,7 @@ struct vo_priv {
     struct gl_video_opts *renderer_opts;
     int frame_queue_size;
     int frame_drop_mode;
+    int frame_queue_ahead;
 };
 
 struct mpv_opengl_cb_context {
@@ -83,6 +91,8 @@ struct mpv_opengl_cb_context {
     int64_t approx_vsync;
     int64_t cur_pts;
     bool vsync_timed;
+    int64_t flip_pts;       // intended time of the frame not yet flipped, or 0
+    struct mpv_opengl_cb_stats stats;
 
     // --- All of these can only be accessed from the thread where the host
     //     application's OpenGL context is current - i.e. only while the
@@ -113,11 +123,13 @@ static struct mp_image *frame_queue_pop(struct mpv_opengl_cb_context *ctx)
     return ret;
 }
 
-static void frame_queue_drop(struct mpv_opengl_cb_context *ctx)
+// dropped frames are counted in *counter, which is one of ctx->stats.dropped_*
+static void frame_queue_drop(struct mpv_opengl_cb_context *ctx, int64_t *counter)
 {
     struct mp_image *mpi = frame_queue_pop(ctx);
     if (mpi) {
         talloc_free(mpi);
+        *counter += 1;
         if (ctx->active)
             vo_increment_drop_count(ctx->active, 1);
         pthread_cond_broadcast(&ctx->wakeup);
@@ -138,6 +150,7 @@ static void frame_queue_drop_all(struct mpv_opengl_cb_context *ctx)
 {
     int frames = ctx->queued_frames;
     frame_queue_clear(ctx);
+    ctx->stats.dropped_queue_full += frames;
     if (ctx->active && frames > 0)
         vo_increment_drop_count(ctx->active, frames);
     pthread_cond_broadcast(&ctx->wakeup);
@@ -145,6 +158,10 @@ static void frame_queue_drop_all(struct mpv_opengl_cb_context *ctx)
 
 static void frame_queue_push(struct mpv_opengl_cb_context *ctx, struct mp_image *mpi)
 {
+    if (mpi) {
+        struct frame_info *info = mpi->priv;
+        info->queued = mp_time_us();
+    }
     MP_TARRAY_APPEND(ctx, ctx->frame_queue, ctx->queued_frames, mpi);
     pthread_cond_broadcast(&ctx->wakeup);
 }
@@ -153,14 +170,17 @@ static void frame_queue_shrink(struct mpv_opengl_cb_context *ctx, int size)
 {
     pthread_cond_broadcast(&ctx->wakeup);
     while (ctx->queued_frames > size)
-        frame_queue_drop(ctx);
+        frame_queue_drop(ctx, &ctx->stats.dropped_queue_full);
 }
 
+// Frames discarded here were never late, so they are not counted by the VO.
 static void forget_frames(struct mpv_opengl_cb_context *ctx)
 {
     pthread_cond_broadcast(&ctx->wakeup);
+    ctx->stats.dropped_flush += ctx->queued_frames;
     frame_queue_clear(ctx);
     mp_image_unrefp(&ctx->waiting_frame);
+    ctx->flip_pts = 0;
 }
 
 static void free_ctx(void *ptr)
@@ -346,6 +366,8 @@ int mpv_opengl_cb_draw(mpv_opengl_cb_context *ctx, int fbo, int vp_w, int vp_h)
             ctx->vsync_timed = opts->renderer_opts->interpolation;
             if (ctx->vsync_timed)
                 queue += 0.050 * 1e6; // disable video timing
+            else
+                queue += opts->frame_queue_ahead * 1000LL;
             vo_set_flip_queue_params(vo, queue, false);
             ctx->gl->debug_context = opts->use_gl_debug;
             gl_video_set_debug(ctx->renderer, opts->use_gl_debug);
@@ -363,21 +385,39 @@ int mpv_opengl_cb_draw(mpv_opengl_cb_context *ctx, int fbo, int vp_w, int vp_h)
     ctx->eq_changed = false;
     ctx->eq = *eq;
 
-    struct mp_image *mpi = frame_queue_pop(ctx);
-    if (mpi) {
-        struct frame_timing *t = mpi->priv; // set by draw_image_timed
-        if (t)
-            ctx->cur_pts = t->pts;
-    }
-
-    struct frame_timing timing = {
-        .pts = ctx->cur_pts,
-    };
+    int64_t now = mp_time_us();
+    struct frame_timing timing = {0};
     if (ctx->approx_vsync > 0) {
-        timing.prev_vsync = prev_sync(ctx, mp_time_us());
+        timing.prev_vsync = prev_sync(ctx, now);
         timing.next_vsync = timing.prev_vsync + ctx->approx_vsync;
     }
 
+    struct mp_image *mpi = frame_queue_pop(ctx);
+    // A frame is late if the next one is due before it could be flipped.
+    // With interpolation, the renderer picks frames by itself.
+    bool framedrop = vo && (vo->global->opts->frame_dropping & 1);
+    while (mpi && ctx->queued_frames && framedrop && !ctx->vsync_timed &&
+           timing.next_vsync)
+    {
+        struct mp_image *img = ctx->frame_queue[0];
+        struct frame_info *next = img ? img->priv : NULL;
+        if (!next || !next->timed || next->timing.pts > timing.next_vsync)
+            break;
+        talloc_free(mpi);
+        ctx->stats.dropped_late += 1;
+        vo_increment_drop_count(vo, 1);
+        mpi = frame_queue_pop(ctx);
+    }
+    if (mpi) {
+        struct frame_info *info = mpi->priv;
+        if (info->timed)
+            ctx->cur_pts = info->timing.pts;
+        ctx->flip_pts = info->timed ? info->timing.pts : 0;
+        ctx->stats.frames += 1;
+        ctx->stats.queue_latency = now - info->queued;
+    }
+    timing.pts = ctx->cur_pts;
+
     pthread_mutex_unlock(&ctx->lock);
 
     if (mpi)
@@ -403,11 +443,43 @@ int mpv_opengl_cb_report_flip(mpv_opengl_cb_context *ctx, int64_t time)
     if (ctx->recent_flip)
         ctx->approx_vsync = next - ctx->recent_flip;
     ctx->recent_flip = next;
+    if (ctx->flip_pts) {
+        ctx->stats.presented += 1;
+        ctx->stats.display_error = next - ctx->flip_pts;
+        ctx->flip_pts = 0;
+    }
     pthread_mutex_unlock(&ctx->lock);
 
     return 0;
 }
 
+int mpv_opengl_cb_get_stats(mpv_opengl_cb_context *ctx,
+                            mpv_opengl_cb_stats *stats)
+{
+    pthread_mutex_lock(&ctx->lock);
+    *stats = ctx->stats;
+    stats->queued = ctx->queued_frames;
+    stats->queue_size = 0;
+    if (ctx->active) {
+        struct vo_priv *p = ctx->active->priv;
+        stats->queue_size = p->frame_queue_size;
+    }
+    stats->vsync_interval = ctx->approx_vsync;
+    pthread_mutex_unlock(&ctx->lock);
+    return 0;
+}
+
+int mpv_opengl_cb_peek_frame(mpv_opengl_cb_context *ctx, int64_t *pts)
+{
+    pthread_mutex_lock(&ctx->lock);
+    int queued = ctx->queued_frames;
+    struct mp_image *mpi = queued ? ctx->frame_queue[0] : NULL;
+    struct frame_info *info = mpi ? mpi->priv : NULL;
+    *pts = info && info->timed ? info->timing.pts : 0;
+    pthread_mutex_unlock(&ctx->lock);
+    return queued;
+}
+
 static void draw_image_timed(struct vo *vo, mp_image_t *mpi,
                              struct frame_timing *t)
 {
@@ -416,9 +488,13 @@ static void draw_image_timed(struct vo *vo, mp_image_t *mpi,
     pthread_mutex_lock(&p->ctx->lock);
     mp_image_setrefp(&p->ctx->waiting_frame, mpi);
     if (p->ctx->waiting_frame) {
-        p->ctx->waiting_frame->priv =
-            t ? talloc_memdup(p->ctx->waiting_frame, t, sizeof(*t))
-              : NULL;
+        struct frame_info *info = talloc_zero(p->ctx->waiting_frame,
+                                              struct frame_info);
+        if (t) {
+            info->timing = *t;
+            info->timed = true;
+        }
+        p->ctx->waiting_frame->priv = info;
     }
     talloc_free(mpi);
     pthread_mutex_unlock(&p->ctx->lock);
@@ -496,6 +572,7 @@ static const struct m_option change_opts[] = {
                ({"pop", FRAME_DROP_POP},
                 {"clear", FRAME_DROP_CLEAR},
                 {"block", FRAME_DROP_BLOCK})),
+    OPT_INTRANGE("frame-queue-ahead", frame_queue_ahead, 0, 0, 1000),
     OPT_SUBSTRUCT("", renderer_opts, gl_video_conf, 0),
     {0}
 };
@@ -557,6 +634,12 @@ static int control(struct vo *vo, uint32_t request, void *data)
         update(p);
         pthread_mutex_unlock(&p->ctx->lock);
         return VO_TRUE;
+    case VOCTRL_RESET:
+        // seeking: frames from before the seek must not be shown after it
+        pthread_mutex_lock(&p->ctx->lock);
+        forget_frames(p->ctx);
+        pthread_mutex_unlock(&p->ctx->lock);
+        return VO_TRUE;
     case VOCTRL_SET_PANSCAN:
         pthread_mutex_lock(&p->ctx->lock);
         copy_vo_opts(vo);
@@ -634,6 +717,7 @@ static const struct m_option options[] = {
                ({"pop", FRAME_DROP_POP},
                 {"clear", FRAME_DROP_CLEAR},
                 {"block", FRAME_DROP_BLOCK}), OPTDEF_INT(FRAME_DROP_BLOCK)),
+    OPT_INTRANGE("frame-queue-ahead", frame_queue_ahead, 0, 0, 1000),
     OPT_SUBSTRUCT("", renderer_opts, gl_video_conf, 0),
     {0},
 };
@@ -16,6 +16,7 @@
  */
 
 #include <assert.h>
+#include <pthread.h>
 
 #include <libswscale/swscale.h>
 #include <libavcodec/avcodec.h>
@@ -112,6 +113,15 @@ static int mp_csp_to_sws_colorspace(enum mp_csp csp)
     return mp_csp_to_avcol_spc(csp);
 }
 
+// Reduce params to what affects the swscale context.
+static void normalize_params(struct mp_image_params *p)
+{
+    // Neutralize unsupported or ignored parameters.
+    p->d_w = p->d_h = 0;
+    p->outputlevels = MP_CSP_LEVELS_AUTO;
+    mp_image_params_guess_csp(p); // sanitize colorspace/colorlevels
+}
+
 static bool cache_valid(struct mp_sws_context *ctx)
 {
     struct mp_sws_context *old = ctx->cached;
@@ -158,10 +168,8 @@ int mp_sws_reinit(struct mp_sws_context *ctx)
     struct mp_image_params *src = &ctx->src;
     struct mp_image_params *dst = &ctx->dst;
 
-    // Neutralize unsupported or ignored parameters.
-    src->d_w = dst->d_w = 0;
-    src->d_h = dst->d_h = 0;
-    src->outputlevels = dst->outputlevels = MP_CSP_LEVELS_AUTO;
+    normalize_params(src);
+    normalize_params(dst);
 
     if (cache_valid(ctx))
         return 0;
@@ -171,9 +179,6 @@ int mp_sws_reinit(struct mp_sws_context *ctx)
     if (!ctx->sws)
         return -1;
 
-    mp_image_params_guess_csp(src); // sanitize colorspace/colorlevels
-    mp_image_params_guess_csp(dst);
-
     struct mp_imgfmt_desc src_fmt = mp_imgfmt_get_desc(src->imgfmt);
     struct mp_imgfmt_desc dst_fmt = mp_imgfmt_get_desc(dst->imgfmt);
     if (!src_fmt.id || !dst_fmt.id)
@@ -268,13 +273,98 @@ int mp_sws_scale(struct mp_sws_context *ctx, struct mp_image *dst,
     return 0;
 }
 
+// Contexts used by mp_image_swscale(). The same conversions tend to repeat
+// (subtitle bitmaps, screenshots and thumbnails of the same video), and for
+// small images, initializing swscale costs more than the conversion itself.
+// A context is taken out of the cache while it's in use, so that concurrent
+// callers never share one.
+// The cache is shared by all player instances in the process. mp_destroy()
+// clears it, so a library user doesn't keep the contexts after the last
+// instance is gone.
+#define SWS_CACHE_SIZE 16
+
+static pthread_mutex_t sws_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct mp_sws_context *sws_cache[SWS_CACHE_SIZE]; // least recent first
+static int sws_cache_num;
+static struct mp_sws_cache_stats sws_cache_stats;
+
+static struct mp_sws_context *sws_cache_take(struct mp_image *dst,
+                                             struct mp_image *src, int flags)
+{
+    struct mp_image_params s = src->params, d = dst->params;
+    normalize_params(&s);
+    normalize_params(&d);
+
+    struct mp_sws_context *ctx = NULL;
+    pthread_mutex_lock(&sws_cache_lock);
+    for (int n = sws_cache_num - 1; n >= 0; n--) {
+        struct mp_sws_context *c = sws_cache[n];
+        if (c->flags == flags && mp_image_params_equal(&c->cached->src, &s) &&
+            mp_image_params_equal(&c->cached->dst, &d))
+        {
+            ctx = c;
+            MP_TARRAY_REMOVE_AT(sws_cache, sws_cache_num, n);
+            break;
+        }
+    }
+    if (ctx) {
+        sws_cache_stats.hits++;
+    } else {
+        sws_cache_stats.misses++;
+    }
+    pthread_mutex_unlock(&sws_cache_lock);
+
+    if (!ctx) {
+        ctx = mp_sws_alloc(NULL);
+        ctx->flags = flags;
+    }
+    return ctx;
+}
+
+static void sws_cache_put(struct mp_sws_context *ctx)
+{
+    struct mp_sws_context *evicted = NULL;
+    pthread_mutex_lock(&sws_cache_lock);
+    if (sws_cache_num == SWS_CACHE_SIZE) {
+        evicted = sws_cache[0];
+        MP_TARRAY_REMOVE_AT(sws_cache, sws_cache_num, 0);
+        sws_cache_stats.evictions++;
+    }
+    sws_cache[sws_cache_num++] = ctx;
+    pthread_mutex_unlock(&sws_cache_lock);
+    talloc_free(evicted);
+}
+
+void mp_sws_cache_get_stats(struct mp_sws_cache_stats *stats)
+{
+    pthread_mutex_lock(&sws_cache_lock);
+    *stats = sws_cache_stats;
+    stats->entries = sws_cache_num;
+    pthread_mutex_unlock(&sws_cache_lock);
+}
+
+void mp_sws_cache_clear(void)
+{
+    pthread_mutex_lock(&sws_cache_lock);
+    for (int n = 0; n < sws_cache_num; n++)
+        talloc_free(sws_cache[n]);
+    sws_cache_num = 0;
+    sws_cache_stats = (struct mp_sws_cache_stats){0};
+    pthread_mutex_unlock(&sws_cache_lock);
+}
+
+// Convert with a context from the shared cache, which is initialized only if
+// no context for the same parameters and flags is cached.
 int mp_image_swscale(struct mp_image *dst, struct mp_image *src,
                      int my_sws_flags)
 {
-    struct mp_sws_context *ctx = mp_sws_alloc(NULL);
-    ctx->flags = my_sws_flags;
+    struct mp_sws_context *ctx = sws_cache_take(dst, src, my_sws_flags);
     int res = mp_sws_scale(ctx, dst, src);
-    talloc_free(ctx);
+    if (res < 0) {
+        talloc_free(ctx);
+    } else {
+        sws_cache_put(ctx);
+    }
     return res;
 }
 
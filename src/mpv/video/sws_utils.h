@@ -2,6 +2,7 @@
 #define MPLAYER_SWS_UTILS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "mp_image.h"
 
@@ -21,6 +22,16 @@ bool mp_sws_supported_format(int imgfmt);
 int mp_image_swscale(struct mp_image *dst, struct mp_image *src,
                      int my_sws_flags);
 
+struct mp_sws_cache_stats {
+    uint64_t hits, misses, evictions;
+    int entries;
+};
+
+// Statistics of the context cache used by mp_image_swscale().
+void mp_sws_cache_get_stats(struct mp_sws_cache_stats *stats);
+// Free all cached contexts, and reset the statistics.
+void mp_sws_cache_clear(void);
+
 int mp_image_sw_blur_scale(struct mp_image *dst, struct mp_image *src,
                            float gblur);
 